@@ -1,41 +1,97 @@
 #include "app.h"
 #include "controllers/database.h"
+#include "controllers/settings_store.h"
 #include "utils/logger.h"
 #include "utils/theme_manager.h"
 #include "views/mainwindow.h"
-#include "controllers/notificationmanager.h"
+#include "controllers/maintenance_worker.h"
+#include "controllers/reminder_scheduler.h"
+#include "controllers/change_journal.h"
+#include "utils/single_instance.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
 #include <QSettings>
-#include <QDateTime>
-#include <QTimer>
 #include <QMessageBox>
 #include <QCoreApplication>
 #include <QFont>
 #include "utils/style_utils.h"
 
+namespace {
+void setupCommandLine(QCommandLineParser &parser)
+{
+    parser.setApplicationDescription("ToDoList 任务管理");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption(QCommandLineOption({"a", "add"}, "快速添加任务，可重复指定", "title"));
+    parser.addOption(QCommandLineOption({"s", "search"}, "打开后按关键字搜索", "text"));
+}
+} // namespace
+
 App::App(QObject *parent)
     : QObject(parent)
-    , m_maintenanceTimer(new QTimer(this))
+    , m_maintenance(new MaintenanceWorker(this))
+    , m_instance(nullptr)
+    , m_window(nullptr)
 {
-    m_maintenanceTimer->setInterval(6 * 60 * 60 * 1000);
-    connect(m_maintenanceTimer, &QTimer::timeout, this, &App::runMaintenance);
 }
 
 App::~App()
 {
 }
 
-void App::init()
+bool App::claimInstance()
 {
+    // 先在本进程里处理 --help、--version 和无效参数，不必转发
+    QCommandLineParser parser;
+    setupCommandLine(parser);
+    parser.process(QCoreApplication::arguments());
+
+    // 加锁和转发失败要写进日志，日志级别先按设置生效
     initLogger();
+
+    m_instance = new SingleInstance(QDir::currentPath() + "/data", this);
+    if (m_instance->acquire()) {
+        connect(m_instance, &SingleInstance::commandReceived, this, &App::onCommandReceived);
+        return true;
+    }
+
+    // 没有锁就无法阻止第二个进程同时写数据库，由用户决定是否冒险启动
+    if (!m_instance->lastError().isEmpty()) {
+        const QMessageBox::StandardButton reply = QMessageBox::warning(
+            nullptr,
+            "ToDoList",
+            QString("无法创建实例锁，不能确认是否已有其他实例在使用同一份数据。\n"
+                    "同时运行两个实例可能造成数据写入冲突。\n\n详情: %1\n\n是否仍然启动？")
+                .arg(m_instance->lastError()),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::No);
+        if (reply != QMessageBox::Yes) {
+            return false;
+        }
+        LOG_WARNING("App", "Starting without an instance lock at the user's request");
+        return true;
+    }
+
+    if (!m_instance->forward(QCoreApplication::arguments())) {
+        QMessageBox::warning(nullptr, "ToDoList", "已有一个实例正在运行，但没有响应。\n请稍后重试，或结束该进程后再启动。");
+    }
+    return false;
+}
+
+void App::init()
+{
+    LOG_INFO("Logger", QString("Logger initialized with level: %1").arg(Logger::levelToString(Logger::instance().minLevel())));
     if (!initDatabase()) {
         return;
     }
     initSettings();
     initTheme();
     initWindow();
-    runMaintenance();
-    scheduleMaintenance();
+    m_maintenance->start();
+    ReminderScheduler::instance().start();
+    ChangeJournal::instance().startPolling();
+    handleCommand(QCoreApplication::arguments(), false);
 
     LOG_INFO("App", "Application initialized successfully");
 }
@@ -48,8 +104,6 @@ void App::initLogger()
     QString minLevelStr = settings.value("log_level", "INFO").toString();
     Logger::Level minLevel = Logger::stringToLevel(minLevelStr);
     logger.setMinLevel(minLevel);
-
-    LOG_INFO("Logger", QString("Logger initialized with level: %1").arg(Logger::levelToString(minLevel)));
 }
 
 bool App::initDatabase()
@@ -72,6 +126,7 @@ bool App::initDatabase()
         return false;
     }
 
+    SettingsStore::instance().load();
     LOG_INFO("Database", "Database initialized successfully");
     return true;
 }
@@ -92,7 +147,7 @@ void App::initSettings()
         settings.setValue("window_height", 720);
     }
 
-    int fontSize = Database::instance().getSetting("appearance_font_size", "14").toInt();
+    int fontSize = SettingsStore::instance().intValue("appearance_font_size", 14);
     QFont appFont = qApp->font();
     appFont.setPointSize(fontSize);
     qApp->setFont(appFont);
@@ -104,7 +159,7 @@ void App::initTheme()
 {
     ThemeManager &manager = ThemeManager::instance();
     manager.applyTheme();
-    int radius = Database::instance().getSetting("appearance_corner_radius", "8").toInt();
+    int radius = SettingsStore::instance().intValue("appearance_corner_radius", 8);
     manager.setCustomStyleSheet(StyleUtils::buildCornerRadiusStyle(radius));
 
     LOG_INFO("Theme", QString("Theme initialized: %1").arg(manager.themeName(manager.currentTheme())));
@@ -112,47 +167,40 @@ void App::initTheme()
 
 void App::initWindow()
 {
-    MainWindow *window = new MainWindow();
-    window->show();
+    m_window = new MainWindow();
+    // 清理时的删除已记入变更日志，各视图只处理受影响的部分
+    connect(m_maintenance, &MaintenanceWorker::dataPurged, &ChangeJournal::instance(), &ChangeJournal::check);
+    m_window->show();
 
     LOG_INFO("Window", "Main window created and shown");
 }
 
-void App::runMaintenance()
+void App::onCommandReceived(const QStringList &arguments)
 {
-    Database &db = Database::instance();
-    int cleanupDays = db.getSetting("delete_cleanup_days", "14").toInt();
-    bool autoCleanup = db.getSetting("delete_auto_cleanup", "1") == "1";
-
-    if (autoCleanup) {
-        NotificationManager::instance().checkDeletionWarnings(cleanupDays);
-        int removed = db.cleanupDeletedTasks(cleanupDays);
-        if (removed > 0) {
-            LOG_INFO("App", QString("Auto-cleaned %1 deleted tasks").arg(removed));
-        }
-    }
+    LOG_INFO_F("App", "Command forwarded from another instance: %1", arguments.mid(1).join(' '));
+    handleCommand(arguments, true);
+}
 
-    int notificationRetentionDays = db.getSetting("notifications_cleanup_days", "30").toInt();
-    if (notificationRetentionDays > 0) {
-        int removedNotifications = db.cleanupOldNotifications(notificationRetentionDays);
-        if (removedNotifications > 0) {
-            LOG_INFO("App", QString("Auto-cleaned %1 old notifications").arg(removedNotifications));
-        }
+void App::handleCommand(const QStringList &arguments, bool forwarded)
+{
+    if (!m_window) {
+        return;
     }
 
-    const QDateTime now = QDateTime::currentDateTime();
-    const QString lastVacuumStr = db.getSetting("db_last_vacuum", "");
-    const QDateTime lastVacuum = QDateTime::fromString(lastVacuumStr, Qt::ISODate);
-    if (!lastVacuum.isValid() || lastVacuum.daysTo(now) >= 7) {
-        db.vacuum();
-        db.setSetting("db_last_vacuum", now.toString(Qt::ISODate));
-        LOG_INFO("App", "Database vacuum completed");
+    QCommandLineParser parser;
+    setupCommandLine(parser);
+    if (!parser.parse(arguments)) {
+        LOG_WARNING_F("App", "Ignored command: %1", parser.errorText());
+        return;
     }
-}
 
-void App::scheduleMaintenance()
-{
-    if (!m_maintenanceTimer->isActive()) {
-        m_maintenanceTimer->start();
+    if (forwarded) {
+        m_window->bringToFront();
+    }
+    for (const QString &title : parser.values("add")) {
+        m_window->addQuickTask(title);
+    }
+    if (parser.isSet("search")) {
+        m_window->setSearchText(parser.value("search"));
     }
 }
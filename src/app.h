@@ -2,8 +2,11 @@
 #define APP_H
 
 #include <QObject>
+#include <QStringList>
 
-class QTimer;
+class MaintenanceWorker;
+class MainWindow;
+class SingleInstance;
 
 class App : public QObject
 {
@@ -13,18 +16,24 @@ public:
     explicit App(QObject *parent = nullptr);
     ~App();
 
+    // 已有实例在运行时把命令行转发过去并返回 false，调用方应直接退出
+    bool claimInstance();
     void init();
 
+private slots:
+    void onCommandReceived(const QStringList &arguments);
+
 private:
     bool initDatabase();
     void initLogger();
     void initSettings();
     void initTheme();
     void initWindow();
-    void runMaintenance();
-    void scheduleMaintenance();
+    void handleCommand(const QStringList &arguments, bool forwarded);
 
-    QTimer *m_maintenanceTimer;
+    MaintenanceWorker *m_maintenance;
+    SingleInstance *m_instance;
+    MainWindow *m_window;
 };
 
 #endif // APP_H
@@ -0,0 +1,91 @@
+#include "background_job.h"
+#include <QTimer>
+#include <QMetaMethod>
+#include <QAtomicInt>
+
+namespace {
+QAtomicInt jobConnectionCounter;
+} // namespace
+
+BackgroundJob::BackgroundJob(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_pollTimer(new QTimer(this))
+    , m_handled(true)
+{
+    m_pollTimer->setInterval(ProgressPollIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &BackgroundJob::progressTick);
+}
+
+BackgroundJob::~BackgroundJob()
+{
+    wait();
+    delete m_thread;
+}
+
+bool BackgroundJob::start(const std::function<void()> &work, QThread::Priority priority)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    if (m_thread) {
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_handled = false;
+    m_thread = QThread::create(work);
+    connect(m_thread, &QThread::finished, this, &BackgroundJob::onThreadFinished);
+
+    m_elapsed.start();
+    m_thread->start(priority);
+    // 没有人读进度时不必定时唤醒
+    if (isSignalConnected(QMetaMethod::fromSignal(&BackgroundJob::progressTick))) {
+        m_pollTimer->start();
+    }
+    return true;
+}
+
+bool BackgroundJob::isRunning() const
+{
+    return m_thread && !m_handled;
+}
+
+void BackgroundJob::waitForFinished()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    m_thread->wait();
+    onThreadFinished();
+}
+
+void BackgroundJob::wait()
+{
+    if (m_thread) {
+        m_thread->wait();
+    }
+}
+
+qint64 BackgroundJob::elapsedMs() const
+{
+    return m_elapsed.isValid() ? m_elapsed.elapsed() : 0;
+}
+
+QString BackgroundJob::connectionName(const QString &prefix)
+{
+    return QString("%1_%2").arg(prefix).arg(jobConnectionCounter.fetchAndAddRelaxed(1));
+}
+
+void BackgroundJob::onThreadFinished()
+{
+    // 上一轮排队的 finished 可能在新一轮启动后才送达
+    if (m_handled || (m_thread && m_thread->isRunning())) {
+        return;
+    }
+    m_handled = true;
+    m_pollTimer->stop();
+    emit finished();
+}
@@ -0,0 +1,52 @@
+#ifndef BACKGROUND_JOB_H
+#define BACKGROUND_JOB_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QElapsedTimer>
+#include <functional>
+
+class QTimer;
+
+// 导出、导入、快照和维护共用的工作线程骨架：在独立线程里执行一次任务，
+// 运行期间定时发出 progressTick 供持有者读取进度，线程结束后在本线程发出一次 finished
+class BackgroundJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int ProgressPollIntervalMs = 100;
+    // 工作线程的独立连接等待主连接写锁的上限
+    static constexpr int BusyTimeoutMs = 5000;
+
+    explicit BackgroundJob(QObject *parent = nullptr);
+    ~BackgroundJob();
+
+    // 上一轮还没处理完时返回 false
+    bool start(const std::function<void()> &work, QThread::Priority priority = QThread::LowPriority);
+    bool isRunning() const;
+    // 阻塞到线程结束并立即发出 finished
+    void waitForFinished();
+    // 只等线程退出，不发出 finished；持有者析构时使用
+    void wait();
+    qint64 elapsedMs() const;
+
+    // 工作线程的连接名在进程内唯一，前缀便于在日志中区分来源
+    static QString connectionName(const QString &prefix);
+
+signals:
+    void progressTick();
+    void finished();
+
+private slots:
+    void onThreadFinished();
+
+private:
+    QThread *m_thread;
+    QTimer *m_pollTimer;
+    bool m_handled;
+    QElapsedTimer m_elapsed;
+};
+
+#endif // BACKGROUND_JOB_H
@@ -0,0 +1,297 @@
+#include "backup_archive.h"
+#include "../utils/binary_codec.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QVector>
+
+const QString BackupArchive::FILE_EXTENSION = ".tdlz";
+
+namespace {
+constexpr quint32 HeaderMagic = 0x54444C5A;  // "TDLZ"
+constexpr quint32 IndexMagic = 0x54444C49;   // "TDLI"
+constexpr quint32 TrailerMagic = 0x54444C45; // "TDLE"
+constexpr quint16 ArchiveVersion = 1;
+constexpr int BlockSize = 1024 * 1024;
+constexpr int CompressionLevel = 6;
+constexpr int TrailerSize = 16;
+constexpr int IndexEntrySize = 20;
+
+struct BlockEntry {
+    qint64 offset;
+    quint32 compressedLength;
+    quint32 rawLength;
+    quint32 checksum;
+};
+
+struct Footer {
+    QVector<BlockEntry> blocks;
+    quint32 blockCount = 0;
+    qint64 createdAtMs = 0;
+    qint64 rawTotal = 0;
+    qint64 compressedTotal = 0;
+    QString description;
+};
+
+using BinaryCodec::crc32;
+
+bool readFooter(QFile &file, Footer *footer, bool withIndex)
+{
+    const qint64 fileSize = file.size();
+    if (fileSize < TrailerSize || !file.seek(fileSize - TrailerSize)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    qint64 footerOffset = 0;
+    quint32 blockCount = 0;
+    quint32 trailerMagic = 0;
+    in >> footerOffset >> blockCount >> trailerMagic;
+    if (in.status() != QDataStream::Ok || trailerMagic != TrailerMagic
+        || footerOffset <= 0 || footerOffset >= fileSize - TrailerSize
+        || static_cast<qint64>(blockCount) * IndexEntrySize > fileSize) {
+        return false;
+    }
+
+    if (!file.seek(footerOffset)) {
+        return false;
+    }
+
+    quint32 indexMagic = 0;
+    in >> indexMagic;
+    if (indexMagic != IndexMagic) {
+        return false;
+    }
+
+    footer->blocks.clear();
+    if (withIndex) {
+        footer->blocks.reserve(static_cast<int>(blockCount));
+        for (quint32 i = 0; i < blockCount; ++i) {
+            BlockEntry entry;
+            in >> entry.offset >> entry.compressedLength >> entry.rawLength >> entry.checksum;
+            footer->blocks.append(entry);
+        }
+    } else if (in.skipRawData(static_cast<int>(blockCount) * IndexEntrySize) < 0) {
+        return false;
+    }
+
+    in >> footer->createdAtMs >> footer->rawTotal >> footer->compressedTotal >> footer->description;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    footer->blockCount = blockCount;
+    return true;
+}
+} // namespace
+
+bool BackupArchive::write(const QString &sourceFile, const QString &archivePath, const QString &description,
+                          WriteStats *stats, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile source(sourceFile);
+    if (!source.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = source.errorString();
+        }
+        return false;
+    }
+
+    QSaveFile archive(archivePath);
+    if (!archive.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = archive.errorString();
+        }
+        return false;
+    }
+
+    QDataStream out(&archive);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << HeaderMagic << ArchiveVersion << quint16(0) << quint32(BlockSize);
+
+    Footer footer;
+    while (!source.atEnd()) {
+        const QByteArray raw = source.read(BlockSize);
+        if (raw.isEmpty()) {
+            break;
+        }
+
+        const QByteArray compressed = qCompress(raw, CompressionLevel);
+        BlockEntry entry;
+        entry.offset = archive.pos();
+        entry.compressedLength = static_cast<quint32>(compressed.size());
+        entry.rawLength = static_cast<quint32>(raw.size());
+        entry.checksum = crc32(compressed);
+
+        out << entry.compressedLength << entry.rawLength << entry.checksum;
+        out.writeRawData(compressed.constData(), compressed.size());
+        if (out.status() != QDataStream::Ok) {
+            if (error) {
+                *error = archive.errorString();
+            }
+            archive.cancelWriting();
+            return false;
+        }
+
+        footer.blocks.append(entry);
+        footer.rawTotal += raw.size();
+        footer.compressedTotal += compressed.size();
+    }
+
+    if (source.error() != QFileDevice::NoError) {
+        if (error) {
+            *error = source.errorString();
+        }
+        archive.cancelWriting();
+        return false;
+    }
+
+    const qint64 footerOffset = archive.pos();
+    out << IndexMagic;
+    for (const BlockEntry &entry : footer.blocks) {
+        out << entry.offset << entry.compressedLength << entry.rawLength << entry.checksum;
+    }
+    out << QDateTime::currentMSecsSinceEpoch() << footer.rawTotal << footer.compressedTotal << description;
+    out << footerOffset << static_cast<quint32>(footer.blocks.size()) << TrailerMagic;
+
+    if (out.status() != QDataStream::Ok || !archive.commit()) {
+        if (error) {
+            *error = archive.errorString();
+        }
+        return false;
+    }
+
+    if (stats) {
+        stats->rawBytes = footer.rawTotal;
+        stats->compressedBytes = footer.compressedTotal;
+        stats->elapsedMs = timer.elapsed();
+    }
+    return true;
+}
+
+bool BackupArchive::extract(const QString &archivePath, const QString &destination, QString *error)
+{
+    QFile archive(archivePath);
+    if (!archive.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = archive.errorString();
+        }
+        return false;
+    }
+
+    Footer footer;
+    if (!readFooter(archive, &footer, true)) {
+        if (error) {
+            *error = QString("Invalid or truncated archive %1").arg(archivePath);
+        }
+        return false;
+    }
+
+    QSaveFile output(destination);
+    if (!output.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = output.errorString();
+        }
+        return false;
+    }
+
+    QDataStream in(&archive);
+    in.setVersion(QDataStream::Qt_5_15);
+    qint64 rawTotal = 0;
+
+    // 逐块校验并解压，内存占用只与块大小有关
+    for (int i = 0; i < footer.blocks.size(); ++i) {
+        const BlockEntry &entry = footer.blocks.at(i);
+        quint32 compressedLength = 0;
+        quint32 rawLength = 0;
+        quint32 checksum = 0;
+
+        if (!archive.seek(entry.offset)) {
+            break;
+        }
+        in >> compressedLength >> rawLength >> checksum;
+        if (compressedLength != entry.compressedLength || rawLength != entry.rawLength || checksum != entry.checksum) {
+            if (error) {
+                *error = QString("Block %1 header does not match index").arg(i);
+            }
+            output.cancelWriting();
+            return false;
+        }
+
+        const QByteArray compressed = archive.read(compressedLength);
+        if (static_cast<quint32>(compressed.size()) != compressedLength || crc32(compressed) != checksum) {
+            if (error) {
+                *error = QString("Block %1 checksum mismatch").arg(i);
+            }
+            output.cancelWriting();
+            return false;
+        }
+
+        const QByteArray raw = qUncompress(compressed);
+        if (static_cast<quint32>(raw.size()) != rawLength || output.write(raw) != raw.size()) {
+            if (error) {
+                *error = QString("Block %1 could not be decompressed").arg(i);
+            }
+            output.cancelWriting();
+            return false;
+        }
+        rawTotal += raw.size();
+    }
+
+    if (rawTotal != footer.rawTotal) {
+        if (error) {
+            *error = QString("Archive size mismatch: %1 of %2 bytes").arg(rawTotal).arg(footer.rawTotal);
+        }
+        output.cancelWriting();
+        return false;
+    }
+
+    if (!output.commit()) {
+        if (error) {
+            *error = output.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+BackupArchive::Info BackupArchive::readInfo(const QString &archivePath)
+{
+    Info info;
+    QFile archive(archivePath);
+    if (!archive.open(QIODevice::ReadOnly)) {
+        return info;
+    }
+
+    QDataStream in(&archive);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != HeaderMagic || version != ArchiveVersion) {
+        return info;
+    }
+
+    Footer footer;
+    if (!readFooter(archive, &footer, false)) {
+        return info;
+    }
+
+    info.valid = true;
+    info.createdAt = QDateTime::fromMSecsSinceEpoch(footer.createdAtMs);
+    info.rawSize = footer.rawTotal;
+    info.compressedSize = footer.compressedTotal;
+    info.blockCount = static_cast<int>(footer.blockCount);
+    info.description = footer.description;
+    return info;
+}
+
+bool BackupArchive::isArchiveFile(const QString &path)
+{
+    return path.endsWith(FILE_EXTENSION, Qt::CaseInsensitive);
+}
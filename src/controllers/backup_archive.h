@@ -0,0 +1,38 @@
+#ifndef BACKUP_ARCHIVE_H
+#define BACKUP_ARCHIVE_H
+
+#include <QString>
+#include <QDateTime>
+
+// 压缩备份容器：按块 qCompress 压缩，每块带 CRC32，文件尾部保存块索引和元数据
+class BackupArchive
+{
+public:
+    struct Info {
+        bool valid = false;
+        QDateTime createdAt;
+        qint64 rawSize = 0;
+        qint64 compressedSize = 0;
+        int blockCount = 0;
+        QString description;
+    };
+
+    struct WriteStats {
+        qint64 rawBytes = 0;
+        qint64 compressedBytes = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    static bool write(const QString &sourceFile, const QString &archivePath, const QString &description,
+                      WriteStats *stats, QString *error);
+    static bool extract(const QString &archivePath, const QString &destination, QString *error);
+    static Info readInfo(const QString &archivePath);
+    static bool isArchiveFile(const QString &path);
+
+    static const QString FILE_EXTENSION;
+
+private:
+    BackupArchive() = default;
+};
+
+#endif // BACKUP_ARCHIVE_H
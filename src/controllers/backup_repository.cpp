@@ -0,0 +1,562 @@
+#include "backup_repository.h"
+#include "background_job.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QThread>
+#include <QSet>
+#include <array>
+
+const QString BackupRepository::MANIFEST_EXTENSION = ".manifest";
+
+namespace {
+constexpr quint32 ManifestMagic = 0x54444C4D; // "TDLM"
+constexpr quint16 ManifestVersion = 1;
+constexpr int MinChunkSize = 16 * 1024;
+constexpr int MaxChunkSize = 256 * 1024;
+constexpr int ReadBlockSize = 1024 * 1024;
+// 取高 16 位判断切点，平均块约 64 KiB，且切点取决于最近 64 字节
+constexpr quint64 ChunkBoundaryMask = 0xFFFF000000000000ULL;
+// 写入持续不断时拿不到空 WAL 的读事务，重试几次后退回 VACUUM INTO
+constexpr int ConsistentReadAttempts = 3;
+constexpr int ConsistentReadRetryMs = 200;
+const char *SourceStateFile = "source.state";
+
+const std::array<quint64, 256> &gearTable()
+{
+    static const std::array<quint64, 256> table = []() {
+        std::array<quint64, 256> values{};
+        quint64 state = 0x9E3779B97F4A7C15ULL;
+        for (quint64 &value : values) {
+            state += 0x9E3779B97F4A7C15ULL;
+            quint64 z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// 基于 gear 滚动哈希的内容定义切块，插入数据只影响附近的块
+int findCutPoint(const uchar *data, int size)
+{
+    if (size <= MinChunkSize) {
+        return size;
+    }
+
+    const std::array<quint64, 256> &gear = gearTable();
+    const int limit = qMin(size, MaxChunkSize);
+    quint64 hash = 0;
+    for (int i = MinChunkSize; i < limit; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & ChunkBoundaryMask) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+QByteArray chunkHash(const char *data, int length)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(data, length), QCryptographicHash::Md5);
+}
+} // namespace
+
+BackupRepository::BackupRepository(const QString &rootPath)
+    : m_rootPath(rootPath)
+{
+}
+
+QString BackupRepository::rootPath() const
+{
+    return m_rootPath;
+}
+
+QString BackupRepository::snapshotDirectory() const
+{
+    return QDir(m_rootPath).filePath("snapshots");
+}
+
+bool BackupRepository::ensureDirectories() const
+{
+    QDir root(m_rootPath);
+    return root.mkpath("snapshots") && root.mkpath("chunks");
+}
+
+bool BackupRepository::storeSnapshot(const QString &databaseFile, const QString &manifestPath, const QString &description,
+                                     StoreStats *stats, QString *error) const
+{
+    StoreStats localStats;
+
+    if (!ensureDirectories()) {
+        if (error) {
+            *error = QString("Cannot create repository at %1").arg(m_rootPath);
+        }
+        return false;
+    }
+
+    QFile source(databaseFile);
+    if (!source.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = source.errorString();
+        }
+        return false;
+    }
+
+    QVector<ChunkRef> chunks;
+    QByteArray pending;
+    pending.reserve(ReadBlockSize + MaxChunkSize);
+    int offset = 0;
+    bool atEnd = false;
+
+    while (true) {
+        if (!atEnd && pending.size() - offset < MaxChunkSize) {
+            pending.remove(0, offset);
+            offset = 0;
+            const QByteArray block = source.read(ReadBlockSize);
+            if (block.isEmpty()) {
+                atEnd = true;
+            } else {
+                pending.append(block);
+            }
+            continue;
+        }
+
+        const int available = pending.size() - offset;
+        if (available <= 0) {
+            break;
+        }
+
+        const char *data = pending.constData() + offset;
+        const int length = findCutPoint(reinterpret_cast<const uchar *>(data), available);
+        const QByteArray hash = chunkHash(data, length);
+
+        bool created = false;
+        if (!writeChunk(hash, data, length, &created, error)) {
+            return false;
+        }
+
+        chunks.append({hash, static_cast<quint32>(length)});
+        localStats.chunkCount++;
+        localStats.totalBytes += length;
+        if (created) {
+            localStats.newChunks++;
+            localStats.storedBytes += length;
+        }
+        offset += length;
+    }
+
+    if (source.error() != QFileDevice::NoError) {
+        if (error) {
+            *error = source.errorString();
+        }
+        return false;
+    }
+
+    if (!writeManifest(manifestPath, description, chunks, localStats.totalBytes, error)) {
+        return false;
+    }
+
+    localStats.storedBytes += QFileInfo(manifestPath).size();
+    if (stats) {
+        *stats = localStats;
+    }
+    return true;
+}
+
+bool BackupRepository::storeDatabase(const QString &databasePath, const QString &manifestPath, const QString &description,
+                                     StoreStats *stats, QString *error) const
+{
+    if (!ensureDirectories()) {
+        if (error) {
+            *error = QString("Cannot create repository at %1").arg(m_rootPath);
+        }
+        return false;
+    }
+
+    bool stored = false;
+    const QString connectionName = BackgroundJob::connectionName("backup_store");
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(databasePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BackgroundJob::BusyTimeoutMs));
+        if (!database.open()) {
+            if (error) {
+                *error = database.lastError().text();
+            }
+        } else {
+            stored = storeConsistent(database, databasePath, manifestPath, description, stats, error);
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return stored;
+}
+
+bool BackupRepository::storeConsistent(QSqlDatabase &database, const QString &databasePath, const QString &manifestPath,
+                                       const QString &description, StoreStats *stats, QString *error) const
+{
+    QSqlQuery query(database);
+    for (int attempt = 0; attempt < ConsistentReadAttempts; ++attempt) {
+        if (attempt > 0) {
+            QThread::msleep(ConsistentReadRetryMs);
+        }
+
+        // TRUNCATE 把 WAL 全部写回主文件并清空。此后 WAL 仍为空时开始的读事务只读主文件，
+        // 它结束前检查点不能再改写主文件，主文件就是这一刻的完整数据库
+        if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+            continue;
+        }
+        query.finish();
+        if (!query.exec("BEGIN") || !query.exec("SELECT seq FROM sqlite_sequence WHERE name = 'change_log'")) {
+            query.exec("ROLLBACK");
+            continue;
+        }
+        const qint64 changeSeq = query.next() ? query.value(0).toLongLong() : 0;
+        query.finish();
+
+        if (QFileInfo(databasePath + "-wal").size() > 0) {
+            query.exec("COMMIT");
+            continue;
+        }
+
+        const QFileInfo fileInfo(databasePath);
+        SourceState current;
+        current.databasePath = fileInfo.absoluteFilePath();
+        current.size = fileInfo.size();
+        current.modifiedMs = fileInfo.lastModified().toMSecsSinceEpoch();
+        current.changeSeq = changeSeq;
+
+        const SourceState previous = readSourceState();
+        bool stored = previous == current && reuseManifest(previous, manifestPath, description, stats);
+        if (!stored) {
+            stored = storeSnapshot(databasePath, manifestPath, description, stats, error);
+        }
+        query.exec("COMMIT");
+
+        if (stored) {
+            current.manifestPath = manifestPath;
+            writeSourceState(current);
+        }
+        return stored;
+    }
+
+    const QString copyPath = QDir(m_rootPath).filePath("snapshot.tmp");
+    QFile::remove(copyPath);
+    query.prepare("VACUUM INTO ?");
+    query.addBindValue(copyPath);
+    if (!query.exec()) {
+        if (error) {
+            *error = query.lastError().text();
+        }
+        QFile::remove(copyPath);
+        return false;
+    }
+    query.finish();
+
+    const bool stored = storeSnapshot(copyPath, manifestPath, description, stats, error);
+    QFile::remove(copyPath);
+    return stored;
+}
+
+bool BackupRepository::reuseManifest(const SourceState &previous, const QString &manifestPath, const QString &description,
+                                     StoreStats *stats) const
+{
+    QVector<ChunkRef> chunks;
+    QString error;
+    if (!readManifest(previous.manifestPath, &chunks, &error)) {
+        return false;
+    }
+
+    qint64 totalBytes = 0;
+    for (const ChunkRef &chunk : chunks) {
+        totalBytes += chunk.length;
+    }
+    if (!writeManifest(manifestPath, description, chunks, totalBytes, &error)) {
+        return false;
+    }
+
+    if (stats) {
+        stats->chunkCount = chunks.size();
+        stats->newChunks = 0;
+        stats->totalBytes = totalBytes;
+        stats->storedBytes = QFileInfo(manifestPath).size();
+    }
+    return true;
+}
+
+bool BackupRepository::restoreSnapshot(const QString &manifestPath, const QString &destination, QString *error) const
+{
+    QVector<ChunkRef> chunks;
+    if (!readManifest(manifestPath, &chunks, error)) {
+        return false;
+    }
+
+    QSaveFile output(destination);
+    if (!output.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = output.errorString();
+        }
+        return false;
+    }
+
+    for (const ChunkRef &chunk : chunks) {
+        QFile chunkFile(chunkPath(chunk.hash));
+        if (!chunkFile.open(QIODevice::ReadOnly)) {
+            if (error) {
+                *error = QString("Missing chunk %1").arg(QString::fromLatin1(chunk.hash.toHex()));
+            }
+            output.cancelWriting();
+            return false;
+        }
+
+        const QByteArray data = chunkFile.readAll();
+        if (static_cast<quint32>(data.size()) != chunk.length
+            || QCryptographicHash::hash(data, QCryptographicHash::Md5) != chunk.hash) {
+            if (error) {
+                *error = QString("Corrupted chunk %1").arg(QString::fromLatin1(chunk.hash.toHex()));
+            }
+            output.cancelWriting();
+            return false;
+        }
+
+        if (output.write(data) != data.size()) {
+            if (error) {
+                *error = output.errorString();
+            }
+            output.cancelWriting();
+            return false;
+        }
+    }
+
+    if (!output.commit()) {
+        if (error) {
+            *error = output.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+QStringList BackupRepository::snapshotList() const
+{
+    QStringList snapshots;
+    QDir dir(snapshotDirectory());
+    if (!dir.exists()) {
+        return snapshots;
+    }
+
+    const QFileInfoList files = dir.entryInfoList(QStringList() << "*" + MANIFEST_EXTENSION, QDir::Files, QDir::Name);
+    for (const QFileInfo &fileInfo : files) {
+        snapshots.append(fileInfo.absoluteFilePath());
+    }
+    return snapshots;
+}
+
+int BackupRepository::collectGarbage(qint64 *freedBytes) const
+{
+    if (freedBytes) {
+        *freedBytes = 0;
+    }
+
+    QSet<QString> referenced;
+    for (const QString &manifestPath : snapshotList()) {
+        QVector<ChunkRef> chunks;
+        QString error;
+        // 任一清单无法读取时不回收，避免误删仍被引用的数据块
+        if (!readManifest(manifestPath, &chunks, &error)) {
+            return 0;
+        }
+        for (const ChunkRef &chunk : chunks) {
+            referenced.insert(QString::fromLatin1(chunk.hash.toHex()));
+        }
+    }
+
+    int removed = 0;
+    QDirIterator it(QDir(m_rootPath).filePath("chunks"), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QFileInfo fileInfo = it.fileInfo();
+        if (referenced.contains(fileInfo.fileName())) {
+            continue;
+        }
+
+        const qint64 size = fileInfo.size();
+        if (QFile::remove(path)) {
+            removed++;
+            if (freedBytes) {
+                *freedBytes += size;
+            }
+        }
+    }
+    return removed;
+}
+
+bool BackupRepository::isManifestFile(const QString &path)
+{
+    return path.endsWith(MANIFEST_EXTENSION, Qt::CaseInsensitive);
+}
+
+QString BackupRepository::repositoryForManifest(const QString &manifestPath)
+{
+    QDir dir = QFileInfo(manifestPath).absoluteDir();
+    dir.cdUp();
+    return dir.absolutePath();
+}
+
+bool BackupRepository::readManifest(const QString &path, QVector<ChunkRef> *chunks, QString *error) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint64 createdAt = 0;
+    QString description;
+    qint64 totalBytes = 0;
+    quint32 count = 0;
+    in >> magic >> version >> createdAt >> description >> totalBytes >> count;
+
+    if (in.status() != QDataStream::Ok || magic != ManifestMagic || version != ManifestVersion) {
+        if (error) {
+            *error = QString("Invalid manifest %1").arg(path);
+        }
+        return false;
+    }
+
+    chunks->clear();
+    chunks->reserve(static_cast<int>(count));
+    qint64 summed = 0;
+    for (quint32 i = 0; i < count; ++i) {
+        ChunkRef chunk;
+        chunk.hash.resize(16);
+        if (in.readRawData(chunk.hash.data(), chunk.hash.size()) != chunk.hash.size()) {
+            break;
+        }
+        in >> chunk.length;
+        summed += chunk.length;
+        chunks->append(chunk);
+    }
+
+    if (in.status() != QDataStream::Ok || chunks->size() != static_cast<int>(count) || summed != totalBytes) {
+        if (error) {
+            *error = QString("Truncated manifest %1").arg(path);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BackupRepository::writeManifest(const QString &path, const QString &description, const QVector<ChunkRef> &chunks,
+                                     qint64 totalBytes, QString *error) const
+{
+    QSaveFile manifest(path);
+    if (!manifest.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = manifest.errorString();
+        }
+        return false;
+    }
+
+    QDataStream out(&manifest);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << ManifestMagic << ManifestVersion
+        << QDateTime::currentMSecsSinceEpoch() << description
+        << totalBytes << static_cast<quint32>(chunks.size());
+    for (const ChunkRef &chunk : chunks) {
+        out.writeRawData(chunk.hash.constData(), chunk.hash.size());
+        out << chunk.length;
+    }
+
+    if (out.status() != QDataStream::Ok || !manifest.commit()) {
+        if (error) {
+            *error = manifest.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BackupRepository::SourceState::operator==(const SourceState &other) const
+{
+    return databasePath == other.databasePath && size == other.size && modifiedMs == other.modifiedMs
+        && changeSeq == other.changeSeq;
+}
+
+BackupRepository::SourceState BackupRepository::readSourceState() const
+{
+    SourceState state;
+    QFile file(QDir(m_rootPath).filePath(SourceStateFile));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return state;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    in >> state.databasePath >> state.size >> state.modifiedMs >> state.changeSeq >> state.manifestPath;
+    if (in.status() != QDataStream::Ok) {
+        return SourceState();
+    }
+    return state;
+}
+
+void BackupRepository::writeSourceState(const SourceState &state) const
+{
+    QSaveFile file(QDir(m_rootPath).filePath(SourceStateFile));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << state.databasePath << state.size << state.modifiedMs << state.changeSeq << state.manifestPath;
+    if (out.status() == QDataStream::Ok) {
+        file.commit();
+    }
+}
+
+bool BackupRepository::writeChunk(const QByteArray &hash, const char *data, int length, bool *created, QString *error) const
+{
+    *created = false;
+    const QString path = chunkPath(hash);
+    if (QFile::exists(path)) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data, length) != length || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    *created = true;
+    return true;
+}
+
+QString BackupRepository::chunkPath(const QByteArray &hash) const
+{
+    const QString hex = QString::fromLatin1(hash.toHex());
+    return QDir(m_rootPath).filePath(QString("chunks/%1/%2").arg(hex.left(2), hex));
+}
@@ -0,0 +1,76 @@
+#ifndef BACKUP_REPOSITORY_H
+#define BACKUP_REPOSITORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+
+class QSqlDatabase;
+
+// 内容寻址的增量备份仓库：快照按内容定义切块，相同数据块只保存一次
+// 块以 MD5 寻址：Qt 5 自带的摘要里它最快，单核吞吐高于顺序读盘，瓶颈在读文件而不在哈希；
+// 128 位地址在千万级块数下也不会碰撞，仓库只防意外损坏，不需要抗碰撞攻击
+class BackupRepository
+{
+public:
+    struct StoreStats {
+        int chunkCount = 0;
+        int newChunks = 0;
+        qint64 totalBytes = 0;
+        qint64 storedBytes = 0;
+    };
+
+    explicit BackupRepository(const QString &rootPath);
+
+    QString rootPath() const;
+    QString snapshotDirectory() const;
+    bool ensureDirectories() const;
+
+    bool storeSnapshot(const QString &databaseFile, const QString &manifestPath, const QString &description,
+                       StoreStats *stats, QString *error) const;
+    // 直接对在用的数据库切块，不先复制一份；自上次入库后主文件未变时只写一份清单
+    bool storeDatabase(const QString &databasePath, const QString &manifestPath, const QString &description,
+                       StoreStats *stats, QString *error) const;
+    bool restoreSnapshot(const QString &manifestPath, const QString &destination, QString *error) const;
+    QStringList snapshotList() const;
+    int collectGarbage(qint64 *freedBytes = nullptr) const;
+
+    static bool isManifestFile(const QString &path);
+    static QString repositoryForManifest(const QString &manifestPath);
+
+    static const QString MANIFEST_EXTENSION;
+
+private:
+    struct ChunkRef {
+        QByteArray hash;
+        quint32 length;
+    };
+
+    // 上次入库时主文件的状态，与当前一致时说明内容没有变化
+    struct SourceState {
+        QString databasePath;
+        qint64 size = -1;
+        qint64 modifiedMs = -1;
+        qint64 changeSeq = -1;
+        QString manifestPath;
+
+        bool operator==(const SourceState &other) const;
+    };
+
+    bool storeConsistent(QSqlDatabase &database, const QString &databasePath, const QString &manifestPath,
+                         const QString &description, StoreStats *stats, QString *error) const;
+    bool reuseManifest(const SourceState &previous, const QString &manifestPath, const QString &description,
+                       StoreStats *stats) const;
+    bool readManifest(const QString &path, QVector<ChunkRef> *chunks, QString *error) const;
+    bool writeManifest(const QString &path, const QString &description, const QVector<ChunkRef> &chunks,
+                       qint64 totalBytes, QString *error) const;
+    SourceState readSourceState() const;
+    void writeSourceState(const SourceState &state) const;
+    bool writeChunk(const QByteArray &hash, const char *data, int length, bool *created, QString *error) const;
+    QString chunkPath(const QByteArray &hash) const;
+
+    QString m_rootPath;
+};
+
+#endif // BACKUP_REPOSITORY_H
@@ -1,8 +1,11 @@
 #include "backupmanager.h"
 #include "database.h"
+#include "database_snapshot.h"
+#include "settings_store.h"
 #include "../models/notification.h"
 #include "../controllers/notificationmanager.h"
 #include "../utils/file_utils.h"
+#include "../utils/logger.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
@@ -13,16 +16,38 @@
 #include <QStorageInfo>
 #include <QSqlQuery>
 #include <QSqlDatabase>
+#include <QPair>
+#include <algorithm>
+
+namespace {
+BackupManager::BackupResult classifySnapshotError(const QString &error)
+{
+    if (error.contains("full", Qt::CaseInsensitive)) {
+        return BackupManager::FailedDiskFull;
+    }
+    if (error.contains("locked", Qt::CaseInsensitive) || error.contains("busy", Qt::CaseInsensitive)) {
+        return BackupManager::FailedDatabaseLocked;
+    }
+    if (error.contains("unable to open", Qt::CaseInsensitive)
+        || error.contains("readonly", Qt::CaseInsensitive)
+        || error.contains("permission", Qt::CaseInsensitive)) {
+        return BackupManager::FailedPermission;
+    }
+    return BackupManager::FailedUnknown;
+}
+} // namespace
 
 const QString BackupManager::BACKUP_FILENAME_PREFIX = "todolist_backup_";
 const QString BackupManager::BACKUP_FILE_EXTENSION = ".db";
 const QString BackupManager::DEFAULT_BACKUP_DIR = "backup";
+const QString BackupManager::REPOSITORY_DIR = "repository";
 const QTime BackupManager::DEFAULT_BACKUP_TIME = QTime(2, 0);
 
 BackupManager::BackupManager(QObject *parent)
     : QObject(parent)
     , m_database(nullptr)
     , m_backupTimer(new QTimer(this))
+    , m_snapshot(new DatabaseSnapshot(this))
     , m_backupInProgress(false)
     , m_backupProgress(0)
     , m_backupFrequency(DEFAULT_FREQUENCY)
@@ -30,14 +55,23 @@ BackupManager::BackupManager(QObject *parent)
     , m_backupTime(DEFAULT_BACKUP_TIME)
     , m_backupOnExit(false)
     , m_autoBackupEnabled(true)
+    , m_backupFormat(FullCopy)
 {
     connect(m_backupTimer, &QTimer::timeout, this, &BackupManager::onBackupTimer);
+    connect(m_snapshot, &DatabaseSnapshot::progressChanged, this, &BackupManager::onSnapshotProgress);
+    connect(m_snapshot, &DatabaseSnapshot::finished, this, &BackupManager::onSnapshotFinished);
 }
 
 BackupManager::~BackupManager()
 {
+    // 退出时窗口已销毁，只等待快照写完并记录历史
+    blockSignals(true);
+    m_snapshot->waitForFinished();
+
     if (m_backupOnExit && !m_backupInProgress) {
-        performBackup(tr("Backup on exit"));
+        if (performBackup(tr("Backup on exit")) == Success) {
+            m_snapshot->waitForFinished();
+        }
     }
 }
 
@@ -45,18 +79,17 @@ bool BackupManager::initialize()
 {
     m_database = &Database::instance();
 
-    m_backupLocation = m_database->getSetting("backup_location", QDir::currentPath() + "/" + DEFAULT_BACKUP_DIR);
-
-    QString frequencyStr = m_database->getSetting("backup_frequency", QString::number(DEFAULT_FREQUENCY));
-    m_backupFrequency = static_cast<BackupFrequency>(frequencyStr.toInt());
-
-    m_backupRetention = m_database->getSetting("backup_retention", QString::number(DEFAULT_RETENTION)).toInt();
+    SettingsStore &settings = SettingsStore::instance();
+    m_backupLocation = settings.value("backup_location", QDir::currentPath() + "/" + DEFAULT_BACKUP_DIR);
+    m_backupFrequency = static_cast<BackupFrequency>(settings.intValue("backup_frequency", DEFAULT_FREQUENCY));
+    m_backupRetention = settings.intValue("backup_retention", DEFAULT_RETENTION);
 
-    QString timeStr = m_database->getSetting("backup_time", DEFAULT_BACKUP_TIME.toString("HH:mm"));
+    QString timeStr = settings.value("backup_time", DEFAULT_BACKUP_TIME.toString("HH:mm"));
     m_backupTime = QTime::fromString(timeStr, "HH:mm");
 
-    m_backupOnExit = m_database->getSetting("backup_on_exit", "0").toInt() == 1;
-    m_autoBackupEnabled = m_database->getSetting("auto_backup_enabled", "1").toInt() == 1;
+    m_backupOnExit = settings.boolValue("backup_on_exit", false);
+    m_autoBackupEnabled = settings.boolValue("auto_backup_enabled", true);
+    m_backupFormat = static_cast<BackupFormat>(settings.intValue("backup_format", FullCopy));
 
     if (!ensureBackupDirectory()) {
         qDebug() << "Failed to ensure backup directory";
@@ -94,7 +127,7 @@ bool BackupManager::setBackupLocation(const QString &path)
     }
 
     m_backupLocation = normalizedPath;
-    m_database->setSetting("backup_location", m_backupLocation);
+    SettingsStore::instance().setValue("backup_location", m_backupLocation);
     return true;
 }
 
@@ -106,7 +139,7 @@ BackupManager::BackupFrequency BackupManager::backupFrequency() const
 bool BackupManager::setBackupFrequency(BackupFrequency frequency)
 {
     m_backupFrequency = frequency;
-    m_database->setSetting("backup_frequency", QString::number(static_cast<int>(frequency)));
+    SettingsStore::instance().setInt("backup_frequency", static_cast<int>(frequency));
 
     if (m_autoBackupEnabled) {
         scheduleNextBackup();
@@ -127,7 +160,7 @@ bool BackupManager::setBackupRetention(int count)
     }
 
     m_backupRetention = count;
-    m_database->setSetting("backup_retention", QString::number(count));
+    SettingsStore::instance().setInt("backup_retention", count);
     cleanupOldBackups();
     return true;
 }
@@ -144,7 +177,7 @@ bool BackupManager::setBackupTime(const QTime &time)
     }
 
     m_backupTime = time;
-    m_database->setSetting("backup_time", time.toString("HH:mm"));
+    SettingsStore::instance().setValue("backup_time", time.toString("HH:mm"));
 
     if (m_autoBackupEnabled) {
         scheduleNextBackup();
@@ -161,7 +194,7 @@ bool BackupManager::backupOnExit() const
 bool BackupManager::setBackupOnExit(bool enabled)
 {
     m_backupOnExit = enabled;
-    m_database->setSetting("backup_on_exit", enabled ? "1" : "0");
+    SettingsStore::instance().setBool("backup_on_exit", enabled);
     return true;
 }
 
@@ -173,7 +206,7 @@ bool BackupManager::autoBackupEnabled() const
 bool BackupManager::setAutoBackupEnabled(bool enabled)
 {
     m_autoBackupEnabled = enabled;
-    m_database->setSetting("auto_backup_enabled", enabled ? "1" : "0");
+    SettingsStore::instance().setBool("auto_backup_enabled", enabled);
 
     if (enabled) {
         scheduleNextBackup();
@@ -184,6 +217,23 @@ bool BackupManager::setAutoBackupEnabled(bool enabled)
     return true;
 }
 
+BackupManager::BackupFormat BackupManager::backupFormat() const
+{
+    return m_backupFormat;
+}
+
+bool BackupManager::setBackupFormat(BackupFormat format)
+{
+    m_backupFormat = format;
+    SettingsStore::instance().setInt("backup_format", static_cast<int>(format));
+    return true;
+}
+
+QString BackupManager::repositoryLocation() const
+{
+    return QDir(m_backupLocation).filePath(REPOSITORY_DIR);
+}
+
 BackupManager::BackupResult BackupManager::performBackup(const QString &description)
 {
     if (m_backupInProgress) {
@@ -205,12 +255,95 @@ BackupManager::BackupResult BackupManager::performBackup(const QString &descript
 
     QString backupFileName = getBackupFileName(QDateTime::currentDateTime());
     QString backupPath = QDir(m_backupLocation).filePath(backupFileName);
+    QString snapshotPath = backupPath;
+    DatabaseSnapshot::Finalizer finalizer;
+    m_lastStoreStats = BackupRepository::StoreStats();
+    m_lastArchiveStats = BackupArchive::WriteStats();
+
+    if (m_backupFormat == Incremental) {
+        // 在工作线程中直接对数据库文件切块入库，只写入新的数据块，不再先复制整库
+        BackupRepository repository(repositoryLocation());
+        if (!repository.ensureDirectories()) {
+            m_currentBackupFile = repository.rootPath();
+            finishBackup(FailedInvalidPath);
+            return FailedInvalidPath;
+        }
+        backupPath = QDir(repository.snapshotDirectory()).filePath(
+            QFileInfo(backupFileName).completeBaseName() + BackupRepository::MANIFEST_EXTENSION);
+        snapshotPath.clear();
+        finalizer = [repository, backupPath, description](const QString &databasePath, QVariantMap *details) {
+            BackupRepository::StoreStats stats;
+            QString error;
+            if (!repository.storeDatabase(databasePath, backupPath, description, &stats, &error)) {
+                return error.isEmpty() ? QString("Failed to store snapshot") : error;
+            }
+            details->insert("chunkCount", stats.chunkCount);
+            details->insert("newChunks", stats.newChunks);
+            details->insert("totalBytes", stats.totalBytes);
+            details->insert("storedBytes", stats.storedBytes);
+            return QString();
+        };
+    } else if (m_backupFormat == Compressed) {
+        // 快照写到临时文件后流式压缩成归档，临时文件随即删除
+        backupPath = QDir(m_backupLocation).filePath(
+            QFileInfo(backupFileName).completeBaseName() + BackupArchive::FILE_EXTENSION);
+        snapshotPath = backupPath + ".tmp";
+        finalizer = [backupPath, description](const QString &path, QVariantMap *details) {
+            BackupArchive::WriteStats stats;
+            QString error;
+            const bool written = BackupArchive::write(path, backupPath, description, &stats, &error);
+            QFile::remove(path);
+            if (!written) {
+                return error.isEmpty() ? QString("Failed to write archive") : error;
+            }
+            details->insert("rawBytes", stats.rawBytes);
+            return QString();
+        };
+    }
+
     m_currentBackupFile = backupPath;
+    m_currentDescription = description;
 
-    BackupResult result = copyDatabase(backupPath);
+    const bool started = snapshotPath.isEmpty() ? m_snapshot->startInPlace(finalizer)
+                                                : m_snapshot->start(snapshotPath, finalizer);
+    if (!started) {
+        qDebug() << "Failed to start backup:" << m_snapshot->lastError();
+        BackupResult result = classifySnapshotError(m_snapshot->lastError());
+        finishBackup(result);
+        return result;
+    }
+
+    return Success;
+}
+
+void BackupManager::finishBackup(BackupResult result)
+{
+    const QString backupPath = m_currentBackupFile;
+    const QString backupFileName = QFileInfo(backupPath).fileName();
 
     if (result == Success) {
-        saveBackupHistory(backupPath, description);
+        qint64 rawBytes = QFileInfo(backupPath).size();
+        qint64 storedBytes = rawBytes;
+        if (BackupRepository::isManifestFile(backupPath)) {
+            LOG_INFO("BackupManager", QString("Incremental backup: %1 chunks, %2 new, %3 of %4 bytes written")
+                                          .arg(m_lastStoreStats.chunkCount)
+                                          .arg(m_lastStoreStats.newChunks)
+                                          .arg(m_lastStoreStats.storedBytes)
+                                          .arg(m_lastStoreStats.totalBytes));
+            rawBytes = m_lastStoreStats.totalBytes;
+            storedBytes = m_lastStoreStats.storedBytes;
+        } else if (BackupArchive::isArchiveFile(backupPath)) {
+            rawBytes = m_lastArchiveStats.rawBytes;
+        }
+
+        const qint64 elapsedMs = qMax<qint64>(1, m_snapshot->elapsedMs());
+        const double ratio = storedBytes > 0 ? static_cast<double>(rawBytes) / storedBytes : 0.0;
+        const double throughput = (rawBytes / (1024.0 * 1024.0)) / (elapsedMs / 1000.0);
+        LOG_INFO("BackupManager", QString("Backup written: %1 (ratio %2, %3 MB/s)")
+                                      .arg(backupFileName)
+                                      .arg(ratio, 0, 'f', 2)
+                                      .arg(throughput, 0, 'f', 1));
+        saveBackupHistory(backupPath, m_currentDescription, storedBytes, ratio, throughput);
         cleanupOldBackups();
         sendBackupNotification(QString::fromUtf8("\xE5\xA4\x87\xE4\xBB\xBD\xE5\xAE\x8C\xE6\x88\x90\xEF\xBC\x9A\x25\x31").arg(backupFileName), true);
     } else {
@@ -238,15 +371,18 @@ BackupManager::BackupResult BackupManager::performBackup(const QString &descript
     m_backupInProgress = false;
     m_backupProgress = 100;
     m_currentBackupFile.clear();
+    m_currentDescription.clear();
 
     emit backupFinished(result == Success, backupPath, result);
     emit backupProgressChanged(100);
-
-    return result;
 }
 
 bool BackupManager::restoreBackup(const QString &backupPath)
 {
+    if (m_backupInProgress) {
+        return false;
+    }
+
     if (!QFile::exists(backupPath)) {
         return false;
     }
@@ -259,28 +395,39 @@ bool BackupManager::restoreBackup(const QString &backupPath)
     QString dbDir = QFileInfo(dbPath).absolutePath();
 
     QString tempPath = dbDir + "/temp_restore.db";
+    QString sourcePath = tempPath;
 
-    if (!FileUtils::copyFile(backupPath, tempPath)) {
-        return false;
+    if (BackupRepository::isManifestFile(backupPath)) {
+        BackupRepository repository(BackupRepository::repositoryForManifest(backupPath));
+        QString error;
+        if (!repository.restoreSnapshot(backupPath, tempPath, &error)) {
+            qDebug() << "Failed to restore snapshot:" << error;
+            return false;
+        }
+    } else if (BackupArchive::isArchiveFile(backupPath)) {
+        QString error;
+        if (!BackupArchive::extract(backupPath, tempPath, &error)) {
+            qDebug() << "Failed to extract backup archive:" << error;
+            return false;
+        }
+    } else {
+        sourcePath = backupPath;
     }
 
-    m_database->close();
-
-    if (QFile::exists(dbPath)) {
-        QFile::remove(dbPath + ".bak");
-        QFile::rename(dbPath, dbPath + ".bak");
+    // 在现有连接上整体替换数据，不关闭数据库
+    bool success = m_database->replaceContentsFrom(sourcePath, dbPath + ".bak");
+    if (!success) {
+        qDebug() << "Failed to restore backup:" << m_database->lastError();
     }
 
-    bool success = QFile::rename(tempPath, dbPath);
-
-    if (!success) {
-        if (QFile::exists(dbPath + ".bak")) {
-            QFile::rename(dbPath + ".bak", dbPath);
-        }
+    if (sourcePath == tempPath) {
+        QFile::remove(tempPath);
     }
 
-    m_database->open();
     emit backupRestored(backupPath, success);
+    if (success) {
+        emit datasetReplaced();
+    }
 
     return success;
 }
@@ -295,12 +442,33 @@ QStringList BackupManager::getBackupList() const
     }
 
     QStringList filters;
-    filters << BACKUP_FILENAME_PREFIX + "*" + BACKUP_FILE_EXTENSION;
+    filters << BACKUP_FILENAME_PREFIX + "*" + BACKUP_FILE_EXTENSION
+            << BACKUP_FILENAME_PREFIX + "*" + BackupArchive::FILE_EXTENSION;
 
-    QFileInfoList files = backupDir.entryInfoList(filters, QDir::Files, QDir::Time | QDir::Reversed);
+    QFileInfoList files = backupDir.entryInfoList(filters, QDir::Files);
+    files += QDir(BackupRepository(repositoryLocation()).snapshotDirectory())
+                 .entryInfoList(QStringList() << BACKUP_FILENAME_PREFIX + "*" + BackupRepository::MANIFEST_EXTENSION, QDir::Files);
 
+    // 压缩归档只读取尾部元数据，不完整的归档不计入列表
+    QList<QPair<QDateTime, QString>> entries;
     for (const QFileInfo &fileInfo : files) {
-        backups.append(fileInfo.absoluteFilePath());
+        QDateTime backupTime = fileInfo.lastModified();
+        if (BackupArchive::isArchiveFile(fileInfo.fileName())) {
+            BackupArchive::Info info = BackupArchive::readInfo(fileInfo.absoluteFilePath());
+            if (!info.valid) {
+                continue;
+            }
+            backupTime = info.createdAt;
+        }
+        entries.append(qMakePair(backupTime, fileInfo.absoluteFilePath()));
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const QPair<QDateTime, QString> &a, const QPair<QDateTime, QString> &b) {
+        return a.first < b.first;
+    });
+
+    for (const auto &entry : entries) {
+        backups.append(entry.second);
     }
 
     return backups;
@@ -323,14 +491,39 @@ bool BackupManager::deleteBackup(const QString &backupPath)
 
 void BackupManager::cleanupOldBackups()
 {
+    // 归档经 QSaveFile 原子写入，读不出头部或尾部的只可能已经损坏，无法恢复也不会进入列表，直接删除
+    QDir backupDir(m_backupLocation);
+    const QFileInfoList archives = backupDir.entryInfoList(
+        QStringList() << BACKUP_FILENAME_PREFIX + "*" + BackupArchive::FILE_EXTENSION, QDir::Files);
+    for (const QFileInfo &fileInfo : archives) {
+        if (!BackupArchive::readInfo(fileInfo.absoluteFilePath()).valid) {
+            const bool removed = deleteBackup(fileInfo.absoluteFilePath());
+            LOG_WARNING("BackupManager", QString("%1 damaged backup archive: %2")
+                                             .arg(removed ? "Removed" : "Failed to remove")
+                                             .arg(fileInfo.fileName()));
+        }
+    }
+
     QStringList backups = getBackupList();
+    bool removedSnapshot = false;
 
     while (backups.size() > m_backupRetention) {
         QString oldestBackup = backups.takeFirst();
         if (!deleteBackup(oldestBackup)) {
             qDebug() << "Failed to delete old backup:" << oldestBackup;
+        } else if (BackupRepository::isManifestFile(oldestBackup)) {
+            removedSnapshot = true;
         }
     }
+
+    // 入库过程中新写入的数据块尚未被清单引用，不能回收
+    if (removedSnapshot && !m_snapshot->isRunning()) {
+        qint64 freedBytes = 0;
+        int removedChunks = BackupRepository(repositoryLocation()).collectGarbage(&freedBytes);
+        LOG_INFO("BackupManager", QString("Backup repository GC removed %1 chunks (%2 bytes)")
+                                      .arg(removedChunks)
+                                      .arg(freedBytes));
+    }
 }
 
 bool BackupManager::isBackupInProgress() const
@@ -360,7 +553,11 @@ bool BackupManager::isValidBackupFile(const QString &path)
     }
 
     QFileInfo fileInfo(path);
-    if (fileInfo.suffix().toLower() != "db") {
+    if (BackupArchive::isArchiveFile(path)) {
+        if (!BackupArchive::readInfo(path).valid) {
+            return false;
+        }
+    } else if (fileInfo.suffix().toLower() != "db" && !BackupRepository::isManifestFile(path)) {
         return false;
     }
 
@@ -377,17 +574,38 @@ void BackupManager::onBackupTimer()
     if (!m_autoBackupEnabled) {
         return;
     }
+    // 正在整体替换数据时备份只会读到替换前的内容，稍后再试
+    if (m_database->isRestoring()) {
+        m_backupTimer->start(60000);
+        return;
+    }
 
     performBackup(tr("Scheduled backup"));
     scheduleNextBackup();
 }
 
-void BackupManager::onBackupProgress(qint64 bytesSent, qint64 bytesTotal)
+void BackupManager::onSnapshotProgress(int progress)
+{
+    m_backupProgress = progress;
+    emit backupProgressChanged(m_backupProgress);
+}
+
+void BackupManager::onSnapshotFinished(bool success, const QString &error, const QVariantMap &details)
 {
-    if (bytesTotal > 0) {
-        m_backupProgress = static_cast<int>((bytesSent * 100) / bytesTotal);
-        emit backupProgressChanged(m_backupProgress);
+    if (!m_backupInProgress) {
+        return;
     }
+
+    if (!success) {
+        qDebug() << "Backup failed:" << error;
+    }
+    // 统计由工作线程写入 details，在这里才落到成员上
+    m_lastStoreStats.chunkCount = details.value("chunkCount").toInt();
+    m_lastStoreStats.newChunks = details.value("newChunks").toInt();
+    m_lastStoreStats.totalBytes = details.value("totalBytes").toLongLong();
+    m_lastStoreStats.storedBytes = details.value("storedBytes").toLongLong();
+    m_lastArchiveStats.rawBytes = details.value("rawBytes").toLongLong();
+    finishBackup(success ? Success : classifySnapshotError(error));
 }
 
 bool BackupManager::ensureBackupDirectory()
@@ -401,65 +619,6 @@ bool BackupManager::ensureBackupDirectory()
     return true;
 }
 
-BackupManager::BackupResult BackupManager::copyDatabase(const QString &destination)
-{
-    QString sourcePath = m_database->database().databaseName();
-
-    if (!QFile::exists(sourcePath)) {
-        return FailedUnknown;
-    }
-
-    if (QFile::exists(destination)) {
-        if (!QFile::remove(destination)) {
-            return FailedPermission;
-        }
-    }
-
-    QFile sourceFile(sourcePath);
-    if (!sourceFile.open(QIODevice::ReadOnly)) {
-        return FailedDatabaseLocked;
-    }
-
-    qint64 fileSize = sourceFile.size();
-    m_backupProgress = 0;
-
-    QFile destFile(destination);
-    if (!destFile.open(QIODevice::WriteOnly)) {
-        sourceFile.close();
-        return FailedPermission;
-    }
-
-    const qint64 chunkSize = 1024 * 1024;
-    qint64 bytesCopied = 0;
-    char *buffer = new char[chunkSize];
-
-    while (!sourceFile.atEnd()) {
-        qint64 bytesRead = sourceFile.read(buffer, chunkSize);
-        qint64 bytesWritten = destFile.write(buffer, bytesRead);
-
-        if (bytesWritten != bytesRead) {
-            delete[] buffer;
-            sourceFile.close();
-            destFile.close();
-            destFile.remove();
-            return FailedDiskFull;
-        }
-
-        bytesCopied += bytesWritten;
-        onBackupProgress(bytesCopied, fileSize);
-    }
-
-    delete[] buffer;
-    sourceFile.close();
-    destFile.close();
-
-    if (destFile.size() != fileSize) {
-        return FailedDiskFull;
-    }
-
-    return Success;
-}
-
 void BackupManager::scheduleNextBackup()
 {
     m_backupTimer->stop();
@@ -517,20 +676,22 @@ QDateTime BackupManager::getNextBackupTime() const
     return nextBackup;
 }
 
-void BackupManager::saveBackupHistory(const QString &backupPath, const QString &description)
+void BackupManager::saveBackupHistory(const QString &backupPath, const QString &description, qint64 storedBytes,
+                                      double compressionRatio, double throughput)
 {
-    QFileInfo fileInfo(backupPath);
     QString historyMessage = description.isEmpty() ? tr("Manual backup") : description;
 
     QSqlQuery query(m_database->database());
     query.prepare(R"(
-        INSERT INTO backup_history (file_path, file_size, backup_time, description)
-        VALUES (?, ?, ?, ?)
+        INSERT INTO backup_history (file_path, file_size, backup_time, description, compression_ratio, throughput)
+        VALUES (?, ?, ?, ?, ?, ?)
     )");
     query.addBindValue(backupPath);
-    query.addBindValue(fileInfo.size());
+    query.addBindValue(storedBytes);
     query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
     query.addBindValue(historyMessage);
+    query.addBindValue(compressionRatio);
+    query.addBindValue(throughput);
     query.exec();
 }
 
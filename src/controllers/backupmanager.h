@@ -7,9 +7,13 @@
 #include <QString>
 #include <QStringList>
 #include <QFileInfo>
+#include <QVariantMap>
+#include "backup_repository.h"
+#include "backup_archive.h"
 
 class Database;
 class Notification;
+class DatabaseSnapshot;
 
 class BackupManager : public QObject
 {
@@ -23,6 +27,12 @@ public:
         Manual
     };
 
+    enum BackupFormat {
+        FullCopy,
+        Incremental,
+        Compressed
+    };
+
     enum BackupResult {
         Success,
         FailedDiskFull,
@@ -55,6 +65,10 @@ public:
     bool autoBackupEnabled() const;
     bool setAutoBackupEnabled(bool enabled);
 
+    BackupFormat backupFormat() const;
+    bool setBackupFormat(BackupFormat format);
+    QString repositoryLocation() const;
+
     BackupResult performBackup(const QString &description = QString());
     bool restoreBackup(const QString &backupPath);
     QStringList getBackupList() const;
@@ -74,24 +88,31 @@ signals:
     void backupFinished(bool success, const QString &backupPath, BackupResult result);
     void backupProgressChanged(int progress);
     void backupRestored(const QString &backupPath, bool success);
+    void datasetReplaced();
 
 private slots:
     void onBackupTimer();
-    void onBackupProgress(qint64 bytesSent, qint64 bytesTotal);
+    void onSnapshotProgress(int progress);
+    void onSnapshotFinished(bool success, const QString &error, const QVariantMap &details);
 
 private:
     bool ensureBackupDirectory();
-    BackupResult copyDatabase(const QString &destination);
+    void finishBackup(BackupResult result);
     void scheduleNextBackup();
     QDateTime getNextBackupTime() const;
-    void saveBackupHistory(const QString &backupPath, const QString &description);
+    void saveBackupHistory(const QString &backupPath, const QString &description, qint64 storedBytes,
+                           double compressionRatio, double throughput);
     bool sendBackupNotification(const QString &message, bool success);
 
     Database *m_database;
     QTimer *m_backupTimer;
+    DatabaseSnapshot *m_snapshot;
     bool m_backupInProgress;
     int m_backupProgress;
     QString m_currentBackupFile;
+    QString m_currentDescription;
+    BackupRepository::StoreStats m_lastStoreStats;
+    BackupArchive::WriteStats m_lastArchiveStats;
 
     QString m_backupLocation;
     BackupFrequency m_backupFrequency;
@@ -99,6 +120,7 @@ private:
     QTime m_backupTime;
     bool m_backupOnExit;
     bool m_autoBackupEnabled;
+    BackupFormat m_backupFormat;
 
     static constexpr int DEFAULT_RETENTION = 7;
     static constexpr BackupFrequency DEFAULT_FREQUENCY = Daily;
@@ -106,6 +128,7 @@ private:
     static const QString BACKUP_FILENAME_PREFIX;
     static const QString BACKUP_FILE_EXTENSION;
     static const QString DEFAULT_BACKUP_DIR;
+    static const QString REPOSITORY_DIR;
 };
 
 #endif // BACKUPMANAGER_H
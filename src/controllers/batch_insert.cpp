@@ -0,0 +1,98 @@
+#include "batch_insert.h"
+#include <QSqlError>
+#include <QStringList>
+
+namespace {
+constexpr int BatchRows = 100;
+// 旧版 SQLite 单条语句最多 999 个绑定参数
+constexpr int MaxBindVariables = 999;
+} // namespace
+
+BatchInsert::BatchInsert(QSqlDatabase database, const QString &head, int columns)
+    : m_database(database)
+    , m_head(head)
+    , m_columns(qMax(1, columns))
+    , m_rows(qMax(1, qMin(BatchRows, MaxBindVariables / m_columns)))
+    , m_full(database)
+    , m_prepared(false)
+{
+    m_values.reserve(m_rows * m_columns);
+}
+
+bool BatchInsert::add(std::initializer_list<QVariant> values)
+{
+    for (const QVariant &value : values) {
+        m_values.append(value);
+    }
+    return rowAdded();
+}
+
+bool BatchInsert::add(const QVector<QVariant> &values)
+{
+    m_values.append(values);
+    return rowAdded();
+}
+
+bool BatchInsert::flush()
+{
+    if (m_values.isEmpty()) {
+        return true;
+    }
+
+    QSqlQuery query(m_database);
+    if (!query.prepare(sql(m_values.size() / m_columns))) {
+        m_error = query.lastError().text();
+        return false;
+    }
+    return execute(query);
+}
+
+QString BatchInsert::error() const
+{
+    return m_error;
+}
+
+bool BatchInsert::rowAdded()
+{
+    if (m_values.size() < m_rows * m_columns) {
+        return true;
+    }
+
+    if (!m_prepared) {
+        if (!m_full.prepare(sql(m_rows))) {
+            m_error = m_full.lastError().text();
+            return false;
+        }
+        m_prepared = true;
+    }
+    return execute(m_full);
+}
+
+QString BatchInsert::sql(int rows) const
+{
+    QString row = "(?";
+    for (int i = 1; i < m_columns; ++i) {
+        row += ", ?";
+    }
+    row += ")";
+
+    QStringList values;
+    values.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        values.append(row);
+    }
+    return QString("%1 VALUES %2").arg(m_head, values.join(", "));
+}
+
+bool BatchInsert::execute(QSqlQuery &query)
+{
+    for (int i = 0; i < m_values.size(); ++i) {
+        query.bindValue(i, m_values.at(i));
+    }
+    m_values.clear();
+    if (!query.exec()) {
+        m_error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef BATCH_INSERT_H
+#define BATCH_INSERT_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <initializer_list>
+
+// 多行 INSERT：攒满一批后用同一条预编译语句写入，不足一批的在 flush() 时写入
+// head 为 "INSERT INTO t (a, b)" 这样不带 VALUES 的语句头
+class BatchInsert
+{
+public:
+    BatchInsert(QSqlDatabase database, const QString &head, int columns);
+
+    bool add(std::initializer_list<QVariant> values);
+    bool add(const QVector<QVariant> &values);
+    bool flush();
+
+    QString error() const;
+
+private:
+    bool rowAdded();
+    QString sql(int rows) const;
+    bool execute(QSqlQuery &query);
+
+    QSqlDatabase m_database;
+    QString m_head;
+    int m_columns;
+    int m_rows;
+    QSqlQuery m_full;
+    bool m_prepared;
+    QVector<QVariant> m_values;
+    QString m_error;
+};
+
+#endif // BATCH_INSERT_H
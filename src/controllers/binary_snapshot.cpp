@@ -0,0 +1,1113 @@
+#include "binary_snapshot.h"
+#include "database.h"
+#include "settings_store.h"
+#include "batch_insert.h"
+#include "background_job.h"
+#include "../utils/binary_codec.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDate>
+#include <QDateTime>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+const QString BinarySnapshot::FILE_EXTENSION = ".tdls";
+
+namespace {
+constexpr quint32 SnapshotMagic = 0x54444C53; // "TDLS"
+constexpr quint16 SnapshotVersion = 1;
+constexpr int HeaderSize = 32;
+constexpr int BlockHeaderSize = 12;
+constexpr int RowsPerBlock = 16384;
+constexpr int MaxRowsPerBlock = 1 << 20;
+constexpr qint64 UnixEpochJulianDay = 2440588;
+constexpr qint64 MsPerDay = 24 * 60 * 60 * 1000;
+const char *CancelledError = "Snapshot cancelled";
+
+enum BlockKind : quint8 {
+    SchemaBlock = 1,
+    RowBlock = 2,
+    EndBlock = 3
+};
+
+// 列编码按块选择：同一列在某一块里出现不符合的值时，这一块退回到更宽的编码
+enum ColumnEncoding : quint8 {
+    IntegerColumn = 1,
+    RealColumn = 2,
+    DateColumn = 3,
+    TextColumn = 4
+};
+
+struct TableSchema {
+    QString name;
+    QStringList columns;
+    QStringList types;
+    bool withoutRowid = false;
+};
+
+using BinaryCodec::appendVarint;
+using BinaryCodec::crc32;
+using BinaryCodec::unzigzag;
+using BinaryCodec::zigzag;
+
+void appendBytes(QByteArray &out, const QByteArray &bytes)
+{
+    appendVarint(out, static_cast<quint64>(bytes.size()));
+    out.append(bytes);
+}
+
+QString quoted(const QString &identifier)
+{
+    return QString("\"%1\"").arg(QString(identifier).replace('"', "\"\""));
+}
+
+// 日期按固定宽度的 ISO 文本换算成纪元毫秒，低 3 位记录原文写法（分隔符、毫秒、Z），解码后逐字符还原
+// 不带 Z 的墙上时间同样按 UTC 换算，换到其他时区的机器上也不会被平移
+bool parseDate(const QString &text, qint64 *ms, int *style)
+{
+    const int size = text.size();
+    if (size < 19 || size > 24) {
+        return false;
+    }
+
+    const QChar *chars = text.constData();
+    auto digits = [chars](int from, int count, int *value) {
+        int result = 0;
+        for (int i = 0; i < count; ++i) {
+            const ushort c = chars[from + i].unicode();
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            result = result * 10 + (c - '0');
+        }
+        *value = result;
+        return true;
+    };
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, msec = 0;
+    if (!digits(0, 4, &year) || chars[4] != '-' || !digits(5, 2, &month) || chars[7] != '-'
+        || !digits(8, 2, &day) || (chars[10] != 'T' && chars[10] != ' ') || !digits(11, 2, &hour)
+        || chars[13] != ':' || !digits(14, 2, &minute) || chars[16] != ':' || !digits(17, 2, &second)) {
+        return false;
+    }
+
+    int pos = 19;
+    int suffix = 0;
+    if (size >= 23 && chars[19] == '.') {
+        if (!digits(20, 3, &msec)) {
+            return false;
+        }
+        pos = 23;
+        suffix = 2;
+    }
+    if (pos == size - 1 && chars[pos] == 'Z') {
+        suffix |= 1;
+        ++pos;
+    }
+    if (pos != size) {
+        return false;
+    }
+
+    const QDate date(year, month, day);
+    if (!date.isValid() || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    const qint64 days = date.toJulianDay() - UnixEpochJulianDay;
+    *ms = (((days * 24 + hour) * 60 + minute) * 60 + second) * 1000 + msec;
+    *style = (chars[10] == ' ' ? 1 : 0) | (suffix << 1);
+    return true;
+}
+
+bool formatDate(qint64 ms, int style, QString *text)
+{
+    qint64 days = ms / MsPerDay;
+    qint64 rest = ms % MsPerDay;
+    if (rest < 0) {
+        rest += MsPerDay;
+        --days;
+    }
+
+    const QDate date = QDate::fromJulianDay(days + UnixEpochJulianDay);
+    if (!date.isValid() || date.year() < 1 || date.year() > 9999) {
+        return false;
+    }
+
+    const int msec = static_cast<int>(rest % 1000);
+    const int seconds = static_cast<int>(rest / 1000);
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d%c%02d:%02d:%02d",
+                               date.year(), date.month(), date.day(), (style & 1) ? ' ' : 'T',
+                               seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    if (style & 4) {
+        length += std::snprintf(buffer + length, sizeof(buffer) - length, ".%03d", msec);
+    } else if (msec != 0) {
+        return false;
+    }
+    if (style & 2) {
+        buffer[length++] = 'Z';
+    }
+    *text = QString::fromLatin1(buffer, length);
+    return true;
+}
+
+// 在映射区上按边界检查读取，越界或格式不对时只返回 false，不会读出范围
+class ByteReader
+{
+public:
+    ByteReader(const uchar *data, int size)
+        : m_data(data)
+        , m_pos(0)
+        , m_size(size)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return m_pos == m_size;
+    }
+
+    int remaining() const
+    {
+        return m_size - m_pos;
+    }
+
+    bool readByte(quint8 *value)
+    {
+        if (m_pos >= m_size) {
+            return false;
+        }
+        *value = m_data[m_pos++];
+        return true;
+    }
+
+    bool readVarint(quint64 *value)
+    {
+        return BinaryCodec::readVarint(m_data, m_size, &m_pos, value);
+    }
+
+    bool readCount(int limit, int *value)
+    {
+        quint64 count = 0;
+        if (!readVarint(&count) || count > static_cast<quint64>(limit)) {
+            return false;
+        }
+        *value = static_cast<int>(count);
+        return true;
+    }
+
+    bool readBytes(const uchar **bytes, int *length)
+    {
+        if (!readCount(remaining(), length)) {
+            return false;
+        }
+        *bytes = m_data + m_pos;
+        m_pos += *length;
+        return true;
+    }
+
+    bool readString(QString *text)
+    {
+        const uchar *bytes = nullptr;
+        int length = 0;
+        if (!readBytes(&bytes, &length)) {
+            return false;
+        }
+        *text = QString::fromUtf8(reinterpret_cast<const char *>(bytes), length);
+        return true;
+    }
+
+    bool readDouble(double *value)
+    {
+        if (remaining() < 8) {
+            return false;
+        }
+        const quint64 bits = qFromLittleEndian<quint64>(m_data + m_pos);
+        std::memcpy(value, &bits, sizeof(bits));
+        m_pos += 8;
+        return true;
+    }
+
+private:
+    const uchar *m_data;
+    int m_pos;
+    int m_size;
+};
+
+// ---- 导出 ----
+
+QList<TableSchema> loadTables(QSqlDatabase &database, QString *error)
+{
+    QList<TableSchema> tables;
+    QStringList virtualTables;
+    QSqlQuery query(database);
+    if (!query.exec("SELECT name, sql FROM sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%' ORDER BY rowid")) {
+        *error = query.lastError().text();
+        return tables;
+    }
+
+    while (query.next()) {
+        const QString name = query.value(0).toString();
+        const QString sql = query.value(1).toString();
+        if (sql.startsWith("CREATE VIRTUAL TABLE", Qt::CaseInsensitive)) {
+            virtualTables.append(name);
+        } else if (!name.startsWith("json_import_") && name != "change_log") {
+            // 变更日志只对本库的序号有意义，恢复时由目标库追加一条重置记录
+            TableSchema table;
+            table.name = name;
+            table.withoutRowid = sql.contains("WITHOUT ROWID", Qt::CaseInsensitive);
+            tables.append(table);
+        }
+    }
+
+    // FTS 的影子表由 rebuild 重新生成，不进快照
+    for (const QString &virtualTable : virtualTables) {
+        tables.erase(std::remove_if(tables.begin(), tables.end(), [&](const TableSchema &table) {
+            return table.name.startsWith(virtualTable + "_");
+        }), tables.end());
+    }
+
+    for (TableSchema &table : tables) {
+        if (!query.exec(QString("PRAGMA table_info(%1)").arg(quoted(table.name)))) {
+            *error = query.lastError().text();
+            return QList<TableSchema>();
+        }
+        while (query.next()) {
+            table.columns.append(query.value(1).toString());
+            table.types.append(query.value(2).toString());
+        }
+    }
+    return tables;
+}
+
+class BlockWriter
+{
+public:
+    explicit BlockWriter(QSaveFile *file)
+        : m_file(file)
+        , m_ok(true)
+    {
+    }
+
+    void writeHeader()
+    {
+        uchar header[HeaderSize] = {};
+        qToLittleEndian<quint32>(SnapshotMagic, header);
+        qToLittleEndian<quint16>(SnapshotVersion, header + 4);
+        qToLittleEndian<quint16>(HeaderSize, header + 6);
+        qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+        write(header, HeaderSize);
+    }
+
+    void writeBlock(BlockKind kind, const QByteArray &payload)
+    {
+        uchar header[BlockHeaderSize] = {};
+        header[0] = kind;
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header + 4);
+        qToLittleEndian<quint32>(crc32(reinterpret_cast<const uchar *>(payload.constData()), payload.size()), header + 8);
+        write(header, BlockHeaderSize);
+        write(reinterpret_cast<const uchar *>(payload.constData()), payload.size());
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+private:
+    void write(const uchar *data, int size)
+    {
+        m_ok = m_ok && m_file->write(reinterpret_cast<const char *>(data), size) == size;
+    }
+
+    QSaveFile *m_file;
+    bool m_ok;
+};
+
+class StringTable
+{
+public:
+    quint64 index(const QString &text)
+    {
+        auto it = m_indexes.constFind(text);
+        if (it != m_indexes.constEnd()) {
+            return it.value();
+        }
+        const quint64 index = static_cast<quint64>(m_indexes.size());
+        m_indexes.insert(text, index);
+        appendBytes(m_bytes, text.toUtf8());
+        return index;
+    }
+
+    int count() const
+    {
+        return m_indexes.size();
+    }
+
+    const QByteArray &bytes() const
+    {
+        return m_bytes;
+    }
+
+private:
+    QHash<QString, quint64> m_indexes;
+    QByteArray m_bytes;
+};
+
+bool isInteger(const QVariant &value)
+{
+    return value.type() == QVariant::LongLong || value.type() == QVariant::Int;
+}
+
+ColumnEncoding chooseEncoding(const QVector<QVariant> &values)
+{
+    bool integers = true;
+    bool reals = true;
+    bool dates = true;
+    qint64 ms = 0;
+    int style = 0;
+    for (const QVariant &value : values) {
+        if (value.isNull()) {
+            continue;
+        }
+        integers = integers && isInteger(value);
+        reals = reals && value.type() == QVariant::Double;
+        dates = dates && value.type() == QVariant::String && parseDate(value.toString(), &ms, &style);
+        if (!integers && !reals && !dates) {
+            return TextColumn;
+        }
+    }
+    if (integers) {
+        return IntegerColumn;
+    }
+    return reals ? RealColumn : (dates ? DateColumn : TextColumn);
+}
+
+// 整数和日期列中 0 表示 NULL，其余为与上一个非空值之差的 zigzag 加 1
+bool encodeColumn(const QVector<QVariant> &values, ColumnEncoding encoding, StringTable *strings, QByteArray *out)
+{
+    out->clear();
+    qint64 previous = 0;
+    switch (encoding) {
+        case IntegerColumn:
+            for (const QVariant &value : values) {
+                if (value.isNull()) {
+                    out->append('\0');
+                    continue;
+                }
+                const qint64 current = value.toLongLong();
+                const quint64 encoded = zigzag(static_cast<qint64>(static_cast<quint64>(current) - static_cast<quint64>(previous)));
+                if (encoded == std::numeric_limits<quint64>::max()) {
+                    return false;
+                }
+                appendVarint(*out, encoded + 1);
+                previous = current;
+            }
+            break;
+        case RealColumn:
+            for (const QVariant &value : values) {
+                if (value.isNull()) {
+                    out->append('\0');
+                    continue;
+                }
+                const double number = value.toDouble();
+                quint64 bits = 0;
+                std::memcpy(&bits, &number, sizeof(bits));
+                uchar bytes[8];
+                qToLittleEndian<quint64>(bits, bytes);
+                out->append('\1');
+                out->append(reinterpret_cast<const char *>(bytes), 8);
+            }
+            break;
+        case DateColumn:
+            for (const QVariant &value : values) {
+                qint64 ms = 0;
+                int style = 0;
+                if (value.isNull() || !parseDate(value.toString(), &ms, &style)) {
+                    out->append('\0');
+                    continue;
+                }
+                appendVarint(*out, ((zigzag(ms - previous) << 3) | static_cast<quint64>(style)) + 1);
+                previous = ms;
+            }
+            break;
+        case TextColumn:
+            for (const QVariant &value : values) {
+                appendVarint(*out, value.isNull() ? 0 : strings->index(value.toString()) + 1);
+            }
+            break;
+    }
+    return true;
+}
+
+QByteArray encodeSchema(const QList<TableSchema> &tables)
+{
+    QByteArray payload;
+    appendVarint(payload, static_cast<quint64>(tables.size()));
+    for (const TableSchema &table : tables) {
+        appendBytes(payload, table.name.toUtf8());
+        appendVarint(payload, static_cast<quint64>(table.columns.size()));
+        for (int i = 0; i < table.columns.size(); ++i) {
+            appendBytes(payload, table.columns.at(i).toUtf8());
+            appendBytes(payload, table.types.at(i).toUtf8());
+        }
+    }
+    return payload;
+}
+
+QByteArray encodeRows(int tableIndex, const QVector<QVector<QVariant>> &columns, int rowCount)
+{
+    StringTable strings;
+    QByteArray body;
+    for (const QVector<QVariant> &values : columns) {
+        ColumnEncoding encoding = chooseEncoding(values);
+        QByteArray encoded;
+        if (!encodeColumn(values, encoding, &strings, &encoded)) {
+            encoding = TextColumn;
+            encodeColumn(values, encoding, &strings, &encoded);
+        }
+        body.append(static_cast<char>(encoding));
+        appendBytes(body, encoded);
+    }
+
+    QByteArray payload;
+    appendVarint(payload, static_cast<quint64>(tableIndex));
+    appendVarint(payload, static_cast<quint64>(rowCount));
+    appendVarint(payload, static_cast<quint64>(strings.count()));
+    payload.append(strings.bytes());
+    payload.append(body);
+    return payload;
+}
+
+QString writeSnapshot(QSqlDatabase &database, const QString &destination, std::atomic<int> *processed,
+                      std::atomic<int> *total, std::atomic<int> *taskCount, const std::atomic<bool> *cancelled)
+{
+    QString error;
+    const QList<TableSchema> tables = loadTables(database, &error);
+    if (!error.isEmpty()) {
+        return error;
+    }
+
+    QSqlQuery query(database);
+    QVector<int> rowCounts;
+    int rowTotal = 0;
+    for (const TableSchema &table : tables) {
+        const int rows = query.exec(QString("SELECT COUNT(*) FROM %1").arg(quoted(table.name))) && query.next()
+            ? query.value(0).toInt() : 0;
+        rowCounts.append(rows);
+        rowTotal += rows;
+        if (table.name == "tasks") {
+            taskCount->store(rows);
+        }
+    }
+    query.finish();
+    total->store(qMax(1, rowTotal));
+
+    QSaveFile file(destination);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return file.errorString();
+    }
+
+    BlockWriter writer(&file);
+    writer.writeHeader();
+    writer.writeBlock(SchemaBlock, encodeSchema(tables));
+
+    QVector<int> written(tables.size(), 0);
+    for (int t = 0; t < tables.size() && writer.ok(); ++t) {
+        const TableSchema &table = tables.at(t);
+        QStringList columns;
+        for (const QString &column : table.columns) {
+            columns.append(quoted(column));
+        }
+
+        // 按 rowid 顺序读出，自增 ID 的差值基本都是 1，编码后只占一个字节
+        query.setForwardOnly(true);
+        if (!query.exec(QString("SELECT %1 FROM %2%3").arg(columns.join(", "), quoted(table.name),
+                                                           table.withoutRowid ? QString() : QString(" ORDER BY rowid")))) {
+            file.cancelWriting();
+            return query.lastError().text();
+        }
+
+        QVector<QVector<QVariant>> values(table.columns.size());
+        int rows = 0;
+        auto flushBlock = [&]() {
+            if (rows > 0) {
+                writer.writeBlock(RowBlock, encodeRows(t, values, rows));
+                written[t] += rows;
+                processed->fetch_add(rows, std::memory_order_relaxed);
+            }
+            for (QVector<QVariant> &column : values) {
+                column.clear();
+            }
+            rows = 0;
+        };
+
+        while (query.next()) {
+            for (int c = 0; c < values.size(); ++c) {
+                values[c].append(query.value(c));
+            }
+            if (++rows == RowsPerBlock) {
+                flushBlock();
+                if (cancelled->load(std::memory_order_relaxed)) {
+                    file.cancelWriting();
+                    return CancelledError;
+                }
+            }
+        }
+        flushBlock();
+        query.finish();
+    }
+
+    // 结尾块记录各表行数，导入时据此发现被截断的文件
+    QByteArray end;
+    appendVarint(end, static_cast<quint64>(tables.size()));
+    for (int count : written) {
+        appendVarint(end, static_cast<quint64>(count));
+    }
+    writer.writeBlock(EndBlock, end);
+
+    if (!writer.ok()) {
+        file.cancelWriting();
+        return file.errorString();
+    }
+    if (!file.commit()) {
+        return file.errorString();
+    }
+    return QString();
+}
+
+QString runExport(const QString &sourcePath, const QString &destination, const QString &connectionName,
+                  std::atomic<int> *processed, std::atomic<int> *total, std::atomic<int> *taskCount,
+                  const std::atomic<bool> *cancelled)
+{
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(sourcePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1;QSQLITE_OPEN_READONLY").arg(BackgroundJob::BusyTimeoutMs));
+
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            // 与 JSON 导出相同，在一个读事务里取得一致的快照
+            database.transaction();
+            error = writeSnapshot(database, destination, processed, total, taskCount, cancelled);
+            database.rollback();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return error;
+}
+
+// ---- 导入 ----
+
+class SnapshotDecoder
+{
+public:
+    SnapshotDecoder(QSqlDatabase database, std::atomic<int> *taskCount)
+        : m_database(database)
+        , m_taskCount(taskCount)
+        , m_tasksTable(-1)
+        , m_taskIdColumn(-1)
+        , m_taskTitleColumn(-1)
+        , m_settingsTable(-1)
+        , m_settingsKeyColumn(-1)
+        , m_lastTaskId(0)
+    {
+    }
+
+    bool decodeSchema(const uchar *data, int size)
+    {
+        ByteReader reader(data, size);
+        int tableCount = 0;
+        if (!reader.readCount(reader.remaining(), &tableCount)) {
+            return corrupt();
+        }
+
+        QSqlQuery query(m_database);
+        for (int t = 0; t < tableCount; ++t) {
+            TableSchema table;
+            int columnCount = 0;
+            if (!reader.readString(&table.name) || !reader.readCount(reader.remaining(), &columnCount)) {
+                return corrupt();
+            }
+            for (int c = 0; c < columnCount; ++c) {
+                QString column;
+                QString type;
+                if (!reader.readString(&column) || !reader.readString(&type)) {
+                    return corrupt();
+                }
+                table.columns.append(column);
+                table.types.append(type);
+            }
+            if (table.name.isEmpty() || table.name.startsWith("sqlite_", Qt::CaseInsensitive) || columnCount == 0) {
+                m_error = QString("快照中的表 %1 无效").arg(table.name);
+                return false;
+            }
+
+            // 临时表不声明列类型，值按解码出的类型原样保存，复制进主库时再按主库的列类型转换
+            QStringList names;
+            for (const QString &column : table.columns) {
+                names.append(quoted(column));
+            }
+            if (!query.exec(QString("CREATE TABLE %1 (%2)").arg(quoted(table.name), names.join(", ")))) {
+                m_error = query.lastError().text();
+                return false;
+            }
+
+            if (table.name == "tasks") {
+                m_tasksTable = t;
+                m_taskIdColumn = table.columns.indexOf("id");
+                m_taskTitleColumn = table.columns.indexOf("title");
+            } else if (table.name == "settings") {
+                m_settingsTable = t;
+                m_settingsKeyColumn = table.columns.indexOf("key");
+            }
+            m_tables.append(table);
+            m_rowCounts.append(0);
+        }
+
+        if (!reader.atEnd()) {
+            return corrupt();
+        }
+        if (m_tasksTable < 0 || m_taskIdColumn < 0 || m_taskTitleColumn < 0) {
+            m_error = "快照中缺少任务数据";
+            return false;
+        }
+        return true;
+    }
+
+    bool decodeRows(const uchar *data, int size)
+    {
+        ByteReader reader(data, size);
+        int tableIndex = 0;
+        int rowCount = 0;
+        int stringCount = 0;
+        if (!reader.readCount(m_tables.size() - 1, &tableIndex) || !reader.readCount(MaxRowsPerBlock, &rowCount)
+            || !reader.readCount(reader.remaining(), &stringCount)) {
+            return corrupt();
+        }
+
+        // 字符串在块内只解码一次，列里按序号引用
+        QVector<QString> strings(stringCount);
+        for (int i = 0; i < stringCount; ++i) {
+            if (!reader.readString(&strings[i])) {
+                return corrupt();
+            }
+        }
+
+        const TableSchema &table = m_tables.at(tableIndex);
+        QVector<QVector<QVariant>> columns(table.columns.size());
+        for (QVector<QVariant> &values : columns) {
+            quint8 encoding = 0;
+            const uchar *bytes = nullptr;
+            int length = 0;
+            if (!reader.readByte(&encoding) || !reader.readBytes(&bytes, &length)
+                || !decodeColumn(static_cast<ColumnEncoding>(encoding), bytes, length, rowCount, strings, &values)) {
+                return corrupt();
+            }
+        }
+        if (!reader.atEnd()) {
+            return corrupt();
+        }
+
+        if (!validateRows(tableIndex, columns, rowCount)) {
+            return false;
+        }
+
+        QStringList names;
+        for (const QString &column : table.columns) {
+            names.append(quoted(column));
+        }
+        BatchInsert insert(m_database, QString("INSERT INTO %1 (%2)").arg(quoted(table.name), names.join(", ")),
+                           names.size());
+        QVector<QVariant> row(columns.size());
+        for (int r = 0; r < rowCount; ++r) {
+            for (int c = 0; c < columns.size(); ++c) {
+                row[c] = columns.at(c).at(r);
+            }
+            if (!insert.add(row)) {
+                m_error = insert.error();
+                return false;
+            }
+        }
+        if (!insert.flush()) {
+            m_error = insert.error();
+            return false;
+        }
+
+        m_rowCounts[tableIndex] += rowCount;
+        if (tableIndex == m_tasksTable) {
+            m_taskCount->fetch_add(rowCount, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool decodeEnd(const uchar *data, int size)
+    {
+        ByteReader reader(data, size);
+        int tableCount = 0;
+        if (!reader.readCount(reader.remaining(), &tableCount) || tableCount != m_tables.size()) {
+            return corrupt();
+        }
+        for (int t = 0; t < tableCount; ++t) {
+            quint64 count = 0;
+            if (!reader.readVarint(&count) || count != static_cast<quint64>(m_rowCounts.at(t))) {
+                m_error = QString("快照数据不完整：表 %1 的行数不符").arg(m_tables.at(t).name);
+                return false;
+            }
+        }
+        return reader.atEnd() || corrupt();
+    }
+
+    QString error() const
+    {
+        return m_error;
+    }
+
+private:
+    bool decodeColumn(ColumnEncoding encoding, const uchar *data, int size, int rowCount,
+                      const QVector<QString> &strings, QVector<QVariant> *values)
+    {
+        ByteReader reader(data, size);
+        values->reserve(rowCount);
+        qint64 previous = 0;
+        for (int r = 0; r < rowCount; ++r) {
+            quint64 encoded = 0;
+            switch (encoding) {
+                case IntegerColumn:
+                    if (!reader.readVarint(&encoded)) {
+                        return false;
+                    }
+                    if (encoded == 0) {
+                        values->append(QVariant(QVariant::LongLong));
+                    } else {
+                        previous = static_cast<qint64>(static_cast<quint64>(previous) + static_cast<quint64>(unzigzag(encoded - 1)));
+                        values->append(previous);
+                    }
+                    break;
+                case RealColumn: {
+                    quint8 present = 0;
+                    double number = 0.0;
+                    if (!reader.readByte(&present) || present > 1 || (present && !reader.readDouble(&number))) {
+                        return false;
+                    }
+                    values->append(present ? QVariant(number) : QVariant(QVariant::Double));
+                    break;
+                }
+                case DateColumn: {
+                    if (!reader.readVarint(&encoded)) {
+                        return false;
+                    }
+                    if (encoded == 0) {
+                        values->append(QVariant(QVariant::String));
+                        break;
+                    }
+                    previous = static_cast<qint64>(static_cast<quint64>(previous) + static_cast<quint64>(unzigzag((encoded - 1) >> 3)));
+                    QString text;
+                    if (!formatDate(previous, static_cast<int>((encoded - 1) & 7), &text)) {
+                        return false;
+                    }
+                    values->append(text);
+                    break;
+                }
+                case TextColumn:
+                    if (!reader.readVarint(&encoded) || encoded > static_cast<quint64>(strings.size())) {
+                        return false;
+                    }
+                    values->append(encoded == 0 ? QVariant(QVariant::String) : QVariant(strings.at(static_cast<int>(encoded - 1))));
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return reader.atEnd();
+    }
+
+    // 与 JSON 导入相同的底线：任务 ID 为正且不重复、标题不为空、设置项有键名
+    bool validateRows(int tableIndex, const QVector<QVector<QVariant>> &columns, int rowCount)
+    {
+        if (tableIndex == m_tasksTable) {
+            const QVector<QVariant> &ids = columns.at(m_taskIdColumn);
+            const QVector<QVariant> &titles = columns.at(m_taskTitleColumn);
+            for (int r = 0; r < rowCount; ++r) {
+                // 导出按 rowid 顺序写出，ID 严格递增即可保证不重复
+                const QVariant &id = ids.at(r);
+                if (id.isNull() || !isInteger(id) || id.toLongLong() <= m_lastTaskId) {
+                    m_error = QString("任务 ID 无效或重复：%1").arg(id.toString());
+                    return false;
+                }
+                m_lastTaskId = id.toLongLong();
+                if (titles.at(r).isNull()) {
+                    m_error = QString("任务 %1 缺少标题").arg(m_lastTaskId);
+                    return false;
+                }
+            }
+        } else if (tableIndex == m_settingsTable && m_settingsKeyColumn >= 0) {
+            for (const QVariant &key : columns.at(m_settingsKeyColumn)) {
+                if (key.isNull() || key.toString().isEmpty()) {
+                    m_error = "设置项缺少键名";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool corrupt()
+    {
+        m_error = "快照文件已损坏";
+        return false;
+    }
+
+    QSqlDatabase m_database;
+    std::atomic<int> *m_taskCount;
+    QList<TableSchema> m_tables;
+    QVector<int> m_rowCounts;
+    int m_tasksTable;
+    int m_taskIdColumn;
+    int m_taskTitleColumn;
+    int m_settingsTable;
+    int m_settingsKeyColumn;
+    qint64 m_lastTaskId;
+    QString m_error;
+};
+
+QString decodeSnapshot(const uchar *data, qint64 size, QSqlDatabase &database, std::atomic<int> *processed,
+                       std::atomic<int> *taskCount, const std::atomic<bool> *cancelled)
+{
+    if (size < HeaderSize || qFromLittleEndian<quint32>(data) != SnapshotMagic) {
+        return "不是有效的快照文件";
+    }
+    const quint16 headerSize = qFromLittleEndian<quint16>(data + 6);
+    if (qFromLittleEndian<quint16>(data + 4) != SnapshotVersion || headerSize < HeaderSize || headerSize > size) {
+        return "快照版本不受支持";
+    }
+
+    SnapshotDecoder decoder(database, taskCount);
+    qint64 pos = headerSize;
+    int blockIndex = 0;
+    bool ended = false;
+    while (pos < size) {
+        if (ended || size - pos < BlockHeaderSize) {
+            return "快照文件已损坏";
+        }
+
+        const quint8 kind = data[pos];
+        const quint32 length = qFromLittleEndian<quint32>(data + pos + 4);
+        const quint32 checksum = qFromLittleEndian<quint32>(data + pos + 8);
+        const uchar *payload = data + pos + BlockHeaderSize;
+        if (static_cast<qint64>(length) > size - pos - BlockHeaderSize || length > static_cast<quint32>(std::numeric_limits<int>::max())
+            || crc32(payload, static_cast<int>(length)) != checksum) {
+            return QString("快照文件已损坏：第 %1 个数据块校验失败").arg(blockIndex + 1);
+        }
+
+        // 第一块必须是表结构，之后是行块，最后一块是行数汇总
+        bool ok = false;
+        if (blockIndex == 0) {
+            ok = kind == SchemaBlock && decoder.decodeSchema(payload, static_cast<int>(length));
+        } else if (kind == RowBlock) {
+            ok = decoder.decodeRows(payload, static_cast<int>(length));
+        } else if (kind == EndBlock) {
+            ok = decoder.decodeEnd(payload, static_cast<int>(length));
+            ended = true;
+        }
+        if (!ok) {
+            return decoder.error().isEmpty() ? QString("快照文件已损坏") : decoder.error();
+        }
+
+        pos += BlockHeaderSize + length;
+        ++blockIndex;
+        processed->store(static_cast<int>(pos / 1024), std::memory_order_relaxed);
+        if (cancelled->load(std::memory_order_relaxed)) {
+            return CancelledError;
+        }
+    }
+
+    if (!ended) {
+        return "快照数据不完整";
+    }
+    return QString();
+}
+
+QString runImport(const QString &source, const QString &decodedPath, const QString &connectionName,
+                  std::atomic<int> *processed, std::atomic<int> *total, std::atomic<int> *taskCount,
+                  const std::atomic<bool> *cancelled)
+{
+    QFile file(source);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return file.errorString();
+    }
+    const qint64 size = file.size();
+    total->store(static_cast<int>(qMax<qint64>(1, size / 1024)));
+
+    // 整个文件映射进内存，块和字符串都直接在映射区上解码，不经过读缓冲
+    uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        return size > 0 ? file.errorString() : QString("不是有效的快照文件");
+    }
+
+    QFile::remove(decodedPath);
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(decodedPath);
+
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            // 临时库只用来承接解码结果，不需要日志和落盘同步
+            QSqlQuery query(database);
+            query.exec("PRAGMA journal_mode = OFF");
+            query.exec("PRAGMA synchronous = OFF");
+            query.exec("BEGIN");
+            error = decodeSnapshot(data, size, database, processed, taskCount, cancelled);
+            if (!query.exec(error.isEmpty() ? "COMMIT" : "ROLLBACK") && error.isEmpty()) {
+                error = query.lastError().text();
+            }
+            query.finish();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    file.unmap(data);
+
+    if (!error.isEmpty()) {
+        QFile::remove(decodedPath);
+    }
+    return error;
+}
+} // namespace
+
+BinarySnapshot::BinarySnapshot(QObject *parent)
+    : QObject(parent)
+    , m_job(new BackgroundJob(this))
+    , m_processed(0)
+    , m_total(0)
+    , m_taskCount(0)
+    , m_cancelRequested(false)
+    , m_lastProcessed(-1)
+{
+    connect(m_job, &BackgroundJob::progressTick, this, &BinarySnapshot::onPollProgress);
+    connect(m_job, &BackgroundJob::finished, this, &BinarySnapshot::onThreadFinished);
+}
+
+BinarySnapshot::~BinarySnapshot()
+{
+    m_cancelRequested.store(true);
+    m_job->wait();
+}
+
+bool BinarySnapshot::startExport(const QString &destination)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    const QString sourcePath = database.databaseName();
+    if (!database.isOpen() || !QFile::exists(sourcePath)) {
+        m_error = "Database is not open";
+        return false;
+    }
+    SettingsStore::instance().flush();
+
+    return launch("snapshot_export", [this, sourcePath, destination](const QString &connectionName) {
+        return runExport(sourcePath, destination, connectionName, &m_processed, &m_total, &m_taskCount,
+                         &m_cancelRequested);
+    });
+}
+
+bool BinarySnapshot::startImport(const QString &source, const QString &decodedDatabase)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    return launch("snapshot_import", [this, source, decodedDatabase](const QString &connectionName) {
+        return runImport(source, decodedDatabase, connectionName, &m_processed, &m_total, &m_taskCount,
+                         &m_cancelRequested);
+    });
+}
+
+void BinarySnapshot::cancel()
+{
+    m_cancelRequested.store(true);
+}
+
+bool BinarySnapshot::isRunning() const
+{
+    return m_job->isRunning();
+}
+
+void BinarySnapshot::waitForFinished()
+{
+    m_job->waitForFinished();
+}
+
+QString BinarySnapshot::lastError() const
+{
+    return m_error;
+}
+
+bool BinarySnapshot::wasCancelled() const
+{
+    return m_error == CancelledError;
+}
+
+int BinarySnapshot::taskCount() const
+{
+    return m_taskCount.load();
+}
+
+qint64 BinarySnapshot::elapsedMs() const
+{
+    return m_job->elapsedMs();
+}
+
+bool BinarySnapshot::launch(const QString &connectionPrefix, const std::function<QString(const QString &)> &job)
+{
+    m_error.clear();
+    m_processed.store(0);
+    m_total.store(0);
+    m_taskCount.store(0);
+    m_cancelRequested.store(false);
+    m_lastProcessed = -1;
+
+    const QString connectionName = BackgroundJob::connectionName(connectionPrefix);
+    return m_job->start([this, job, connectionName]() {
+        m_error = job(connectionName);
+    });
+}
+
+void BinarySnapshot::onPollProgress()
+{
+    const int total = m_total.load();
+    const int processed = qMin(m_processed.load(), total);
+    if (!isRunning() || total <= 0 || processed == m_lastProcessed) {
+        return;
+    }
+
+    m_lastProcessed = processed;
+    emit progressChanged(processed, total);
+}
+
+void BinarySnapshot::onThreadFinished()
+{
+    const bool success = m_error.isEmpty();
+    if (success) {
+        const int total = m_total.load();
+        emit progressChanged(total, total);
+    }
+    emit finished(success, m_error);
+}
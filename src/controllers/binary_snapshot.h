@@ -0,0 +1,56 @@
+#ifndef BINARY_SNAPSHOT_H
+#define BINARY_SNAPSHOT_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+class BackgroundJob;
+
+// 紧凑的列式二进制快照（.tdls），用于在机器之间迁移整个数据集
+// 每张表按行块分列存储：块内字符串去重，整数按差值变长编码，日期存为纪元毫秒，每块带 CRC32
+// 导入时把文件映射到内存直接解码，全部校验通过后写入临时数据库，再由调用方整体替换
+class BinarySnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const QString FILE_EXTENSION;
+
+    explicit BinarySnapshot(QObject *parent = nullptr);
+    ~BinarySnapshot();
+
+    bool startExport(const QString &destination);
+    // decodedDatabase 为解码出的临时 SQLite 文件，成功后交给 Database::replaceContentsFrom
+    bool startImport(const QString &source, const QString &decodedDatabase);
+    void cancel();
+    bool isRunning() const;
+    void waitForFinished();
+
+    QString lastError() const;
+    bool wasCancelled() const;
+    int taskCount() const;
+    qint64 elapsedMs() const;
+
+signals:
+    void progressChanged(int processed, int total);
+    void finished(bool success, const QString &error);
+
+private slots:
+    void onPollProgress();
+    void onThreadFinished();
+
+private:
+    bool launch(const QString &connectionPrefix, const std::function<QString(const QString &)> &job);
+
+    BackgroundJob *m_job;
+    QString m_error;
+    std::atomic<int> m_processed;
+    std::atomic<int> m_total;
+    std::atomic<int> m_taskCount;
+    std::atomic<bool> m_cancelRequested;
+    int m_lastProcessed;
+};
+
+#endif // BINARY_SNAPSHOT_H
@@ -0,0 +1,264 @@
+#include "change_journal.h"
+#include "database.h"
+#include "../utils/logger.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+namespace {
+// 一次增量超过这么多行时，逐行处理不如整体重新加载
+constexpr int MaxDeltaRows = 2000;
+constexpr int PollIntervalMs = 1000;
+// 轮询本身的耗时按这么多次汇总记一次日志，超过预算时升为警告
+constexpr int PollReportTicks = 600;
+constexpr qint64 PollBudgetNs = 50000;
+
+ChangeJournal::Operation operationFromCode(const QString &code)
+{
+    if (code == QLatin1String("I")) {
+        return ChangeJournal::Insert;
+    }
+    if (code == QLatin1String("D")) {
+        return ChangeJournal::Delete;
+    }
+    if (code == QLatin1String("R")) {
+        return ChangeJournal::Reset;
+    }
+    return ChangeJournal::Update;
+}
+} // namespace
+
+bool ChangeJournal::Delta::touches(const QStringList &tables) const
+{
+    if (reset) {
+        return true;
+    }
+    for (const Change &change : changes) {
+        if (tables.contains(change.table)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QSet<int> ChangeJournal::Delta::rowIds(const QString &table) const
+{
+    QSet<int> ids;
+    for (const Change &change : changes) {
+        if (change.table == table) {
+            ids.insert(change.rowId);
+        }
+    }
+    return ids;
+}
+
+ChangeJournal& ChangeJournal::instance()
+{
+    static ChangeJournal instance;
+    return instance;
+}
+
+ChangeJournal::ChangeJournal(QObject *parent)
+    : QObject(parent)
+    , m_latestSeq(0)
+    , m_pollTimer(new QTimer(this))
+    , m_dataVersion(-1)
+    , m_totalChanges(-1)
+    , m_pollTicks(0)
+    , m_pollTotalNs(0)
+    , m_pollMaxNs(0)
+{
+    m_pollTimer->setInterval(PollIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &ChangeJournal::poll);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &ChangeJournal::stopPolling);
+    }
+}
+
+ChangeJournal::~ChangeJournal()
+{
+}
+
+void ChangeJournal::registerConsumer(QObject *consumer)
+{
+    if (!consumer || m_cursors.contains(consumer)) {
+        return;
+    }
+
+    m_latestSeq = queryLatestSeq();
+    m_cursors.insert(consumer, m_latestSeq);
+    connect(consumer, &QObject::destroyed, this, [this](QObject *object) {
+        m_cursors.remove(object);
+    });
+}
+
+void ChangeJournal::unregisterConsumer(QObject *consumer)
+{
+    m_cursors.remove(consumer);
+}
+
+ChangeJournal::Delta ChangeJournal::pull(QObject *consumer)
+{
+    Delta delta;
+    auto it = m_cursors.find(consumer);
+    if (it == m_cursors.end()) {
+        return delta;
+    }
+
+    const qint64 cursor = it.value();
+    const qint64 latest = queryLatestSeq();
+    if (latest == cursor) {
+        return delta;
+    }
+    // 序号倒退说明数据库文件被整体换掉了
+    if (latest < cursor) {
+        delta.reset = true;
+        it.value() = latest;
+        return delta;
+    }
+
+    QSqlQuery query(Database::instance().database());
+    query.setForwardOnly(true);
+    query.prepare("SELECT seq, table_name, row_id, op FROM change_log WHERE seq > ? ORDER BY seq LIMIT ?");
+    query.addBindValue(cursor);
+    query.addBindValue(MaxDeltaRows + 1);
+    if (!query.exec()) {
+        LOG_WARNING_F("ChangeJournal", "Failed to read change log: %1", query.lastError().text());
+        delta.reset = true;
+        it.value() = latest;
+        return delta;
+    }
+
+    qint64 expected = cursor + 1;
+    while (query.next()) {
+        Change change;
+        change.seq = query.value(0).toLongLong();
+        change.table = query.value(1).toString();
+        change.rowId = query.value(2).toInt();
+        change.op = operationFromCode(query.value(3).toString());
+
+        // 序号连续分配，出现空缺说明游标之后的记录已被压缩掉
+        if (change.seq != expected || change.op == Reset || delta.changes.size() >= MaxDeltaRows) {
+            delta.reset = true;
+            break;
+        }
+        delta.changes.append(change);
+        ++expected;
+    }
+
+    if (delta.reset) {
+        delta.changes.clear();
+        it.value() = latest;
+    } else {
+        it.value() = delta.changes.isEmpty() ? latest : delta.changes.last().seq;
+    }
+    return delta;
+}
+
+qint64 ChangeJournal::compactionFloor() const
+{
+    qint64 floor = queryLatestSeq();
+    for (auto it = m_cursors.constBegin(); it != m_cursors.constEnd(); ++it) {
+        floor = qMin(floor, it.value());
+    }
+    return floor;
+}
+
+qint64 ChangeJournal::latestSeq() const
+{
+    return m_latestSeq;
+}
+
+void ChangeJournal::startPolling()
+{
+    QSqlDatabase &database = Database::instance().database();
+    if (!database.isOpen() || m_pollTimer->isActive()) {
+        return;
+    }
+
+    // data_version 只在其他连接提交后变化，total_changes 覆盖本连接的写入；
+    // 两者不变时一次轮询只是执行一条预编译语句，不读任何表
+    m_versionQuery = QSqlQuery(database);
+    m_versionQuery.setForwardOnly(true);
+    if (!m_versionQuery.prepare("SELECT data_version, total_changes() FROM pragma_data_version")) {
+        LOG_WARNING_F("ChangeJournal", "Failed to prepare data_version query: %1", m_versionQuery.lastError().text());
+        return;
+    }
+    m_dataVersion = -1;
+    m_totalChanges = -1;
+    poll();
+    m_pollTimer->start();
+}
+
+void ChangeJournal::stopPolling()
+{
+    m_pollTimer->stop();
+    m_versionQuery = QSqlQuery();
+}
+
+void ChangeJournal::poll()
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_versionQuery.exec() || !m_versionQuery.next()) {
+        return;
+    }
+    const qint64 dataVersion = m_versionQuery.value(0).toLongLong();
+    const qint64 totalChanges = m_versionQuery.value(1).toLongLong();
+    m_versionQuery.finish();
+
+    if (dataVersion == m_dataVersion && totalChanges == m_totalChanges) {
+        recordPollCost(timer.nsecsElapsed());
+        return;
+    }
+    m_dataVersion = dataVersion;
+    m_totalChanges = totalChanges;
+    check();
+}
+
+void ChangeJournal::recordPollCost(qint64 nsecs)
+{
+    // 只统计没有变化的轮询，有变化时的开销属于后续的增量刷新
+    ++m_pollTicks;
+    m_pollTotalNs += nsecs;
+    m_pollMaxNs = qMax(m_pollMaxNs, nsecs);
+    if (m_pollTicks < PollReportTicks) {
+        return;
+    }
+
+    const qint64 averageNs = m_pollTotalNs / m_pollTicks;
+    if (averageNs > PollBudgetNs) {
+        LOG_WARNING_F("ChangeJournal", "Idle poll over budget: avg %1 us, max %2 us over %3 ticks",
+                      averageNs / 1000.0, m_pollMaxNs / 1000.0, m_pollTicks);
+    } else {
+        LOG_DEBUG_F("ChangeJournal", "Idle poll cost: avg %1 us, max %2 us over %3 ticks",
+                    averageNs / 1000.0, m_pollMaxNs / 1000.0, m_pollTicks);
+    }
+    m_pollTicks = 0;
+    m_pollTotalNs = 0;
+    m_pollMaxNs = 0;
+}
+
+void ChangeJournal::check()
+{
+    const qint64 latest = queryLatestSeq();
+    if (latest == m_latestSeq) {
+        return;
+    }
+    m_latestSeq = latest;
+    emit changesAvailable();
+}
+
+qint64 ChangeJournal::queryLatestSeq() const
+{
+    // AUTOINCREMENT 的高水位记在 sqlite_sequence 里，压缩删掉全部记录后也不会回退
+    QSqlQuery query(Database::instance().database());
+    query.setForwardOnly(true);
+    if (query.exec("SELECT seq FROM sqlite_sequence WHERE name = 'change_log'") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
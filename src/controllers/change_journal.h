@@ -0,0 +1,89 @@
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QSqlQuery>
+
+class QTimer;
+
+// change_log 表的读取端。表由触发器维护，记录每一行的增删改和单调递增的序号
+// 消费者各自保存读到的序号，收到 changesAvailable 后只取之后的增量
+class ChangeJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation {
+        Insert,
+        Update,
+        Delete,
+        Reset
+    };
+
+    struct Change {
+        qint64 seq = 0;
+        QString table;
+        int rowId = 0;
+        Operation op = Update;
+    };
+
+    struct Delta {
+        // 中间的记录已被压缩，或者数据集被整体替换；消费者需要整体重新加载
+        bool reset = false;
+        QList<Change> changes;
+
+        bool isEmpty() const { return !reset && changes.isEmpty(); }
+        bool touches(const QStringList &tables) const;
+        QSet<int> rowIds(const QString &table) const;
+    };
+
+    static ChangeJournal& instance();
+
+    // 新消费者从当前最新的序号开始，对象销毁时自动注销
+    void registerConsumer(QObject *consumer);
+    void unregisterConsumer(QObject *consumer);
+    // 取出消费者游标之后的变更并把游标移到最新
+    Delta pull(QObject *consumer);
+    // 所有消费者都已读过的序号，维护线程只压缩不超过它的记录
+    qint64 compactionFloor() const;
+    qint64 latestSeq() const;
+    // 定时检查其他连接（维护线程、另一个进程）以及绕过控制器的写入
+    void startPolling();
+    void stopPolling();
+
+public slots:
+    // 有新记录时发出 changesAvailable；本连接提交事务、维护清理或外部写入后调用
+    void check();
+
+signals:
+    void changesAvailable();
+
+private slots:
+    void poll();
+
+private:
+    explicit ChangeJournal(QObject *parent = nullptr);
+    ~ChangeJournal();
+
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    qint64 queryLatestSeq() const;
+    void recordPollCost(qint64 nsecs);
+
+    QHash<QObject*, qint64> m_cursors;
+    qint64 m_latestSeq;
+    QTimer *m_pollTimer;
+    QSqlQuery m_versionQuery;
+    qint64 m_dataVersion;
+    qint64 m_totalChanges;
+    int m_pollTicks;
+    qint64 m_pollTotalNs;
+    qint64 m_pollMaxNs;
+};
+
+#endif // CHANGE_JOURNAL_H
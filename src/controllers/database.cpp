@@ -1,15 +1,23 @@
 #include "database.h"
+#include "settings_store.h"
+#include "database_snapshot.h"
 #include "../models/task.h"
 #include "../models/task_step.h"
 #include "../models/tag.h"
 #include "../models/notification.h"
 #include "../models/folder.h"
+#include "../utils/order_key.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDir>
+#include <QFile>
 #include <QDebug>
 #include <QDateTime>
+#include <QEventLoop>
+#include <QHash>
+#include <QMap>
 #include <functional>
+#include <algorithm>
 
 namespace {
 bool columnExists(QSqlDatabase &database, const QString &tableName, const QString &columnName)
@@ -44,6 +52,182 @@ bool ensureTasksFilePathColumn(QSqlDatabase &database)
     return true;
 }
 
+// 手动排序用的分数索引键，同一父任务下按字节序排列；旧数据由 assignMissingSortKeys 补齐
+bool ensureTasksSortKeyColumn(QSqlDatabase &database)
+{
+    if (columnExists(database, "tasks", "sort_key")) {
+        return true;
+    }
+
+    QSqlQuery query(database);
+    if (!query.exec("ALTER TABLE tasks ADD COLUMN sort_key TEXT")) {
+        qDebug() << "Failed to add sort_key column:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+// 去重键配合唯一索引 (type, task_id, dedupe_key) 使用；普通通知为 NULL，不参与去重
+bool ensureNotificationDedupeColumn(QSqlDatabase &database)
+{
+    if (columnExists(database, "notifications", "dedupe_key")) {
+        return true;
+    }
+
+    QSqlQuery query(database);
+    if (!query.exec("ALTER TABLE notifications ADD COLUMN dedupe_key TEXT")) {
+        qDebug() << "Failed to add dedupe_key column:" << query.lastError().text();
+        return false;
+    }
+
+    // 升级前发出的删除提醒补上去重键，否则同一任务会再提醒一次；剩余天数只能从消息里取。
+    // 旧版按消息去重，任务改名后可能有重复的行，每组只给最早的一条补键，以免唯一索引建不起来
+    const QString remaining = "CASE WHEN message LIKE '%将在 3 天后永久删除%' THEN 3 ELSE 1 END";
+    query.prepare(QString(R"(
+        UPDATE notifications
+        SET dedupe_key = %1 || ':' || (SELECT deleted_at FROM tasks WHERE tasks.id = notifications.task_id)
+        WHERE id IN (
+            SELECT MIN(n.id) FROM notifications n
+            JOIN tasks t ON t.id = n.task_id AND t.is_deleted = 1 AND t.deleted_at IS NOT NULL
+            WHERE n.type = ? AND n.dedupe_key IS NULL
+            GROUP BY n.task_id, %1
+        )
+    )").arg(remaining));
+    query.addBindValue(static_cast<int>(Notification::DeleteWarning));
+    if (!query.exec()) {
+        qDebug() << "Failed to backfill dedupe_key:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+bool ensureBackupHistoryStatsColumns(QSqlDatabase &database)
+{
+    const QStringList columns = {"compression_ratio", "throughput"};
+    for (const QString &column : columns) {
+        if (columnExists(database, "backup_history", column)) {
+            continue;
+        }
+
+        QSqlQuery query(database);
+        if (!query.exec(QString("ALTER TABLE backup_history ADD COLUMN %1 REAL").arg(column))) {
+            qDebug() << "Failed to add backup_history column:" << column << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QStringList ftsTriggerStatements()
+{
+    return {
+        R"(
+            CREATE TRIGGER IF NOT EXISTS tasks_ai AFTER INSERT ON tasks BEGIN
+                INSERT INTO tasks_fts(rowid, title, description)
+                VALUES (new.id, new.title, new.description);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS tasks_ad AFTER DELETE ON tasks BEGIN
+                DELETE FROM tasks_fts WHERE rowid = old.id;
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS tasks_au AFTER UPDATE ON tasks BEGIN
+                UPDATE tasks_fts SET title = new.title, description = new.description
+                WHERE rowid = new.id;
+            END
+        )"
+    };
+}
+
+// 记入 change_log 的表，以及每张表里代表“哪一行变了”的列；关联表记所属任务
+const QList<QPair<QString, QString>> &journaledTables()
+{
+    static const QList<QPair<QString, QString>> tables = {
+        {"tasks", "id"},
+        {"task_steps", "task_id"},
+        {"task_tags", "task_id"},
+        {"task_dependencies", "task_id"},
+        {"task_files", "task_id"},
+        {"task_folders", "task_id"},
+        {"tags", "id"},
+        {"folders", "id"},
+        {"notifications", "id"}
+    };
+    return tables;
+}
+
+QStringList changeLogTriggerNames()
+{
+    QStringList names;
+    for (const auto &table : journaledTables()) {
+        names << QString("change_log_%1_ai").arg(table.first)
+              << QString("change_log_%1_au").arg(table.first)
+              << QString("change_log_%1_ad").arg(table.first);
+    }
+    return names;
+}
+
+QStringList changeLogTriggerStatements()
+{
+    QStringList statements;
+    const QString trigger = QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS change_log_%1_%2 AFTER %3 ON %1 BEGIN "
+        "INSERT INTO change_log (table_name, row_id, op) VALUES ('%1', %4.%5, '%6'); "
+        "END");
+    for (const auto &table : journaledTables()) {
+        statements << trigger.arg(table.first, "ai", "INSERT", "new", table.second, "I")
+                   << trigger.arg(table.first, "au", "UPDATE", "new", table.second, "U")
+                   << trigger.arg(table.first, "ad", "DELETE", "old", table.second, "D");
+    }
+    return statements;
+}
+
+QStringList tableColumns(QSqlDatabase &database, const QString &schema, const QString &tableName)
+{
+    QStringList columns;
+    QSqlQuery query(database);
+    if (!query.exec(QString("PRAGMA %1.table_info(\"%2\")").arg(schema, tableName))) {
+        return columns;
+    }
+
+    while (query.next()) {
+        columns.append(query.value(1).toString());
+    }
+    return columns;
+}
+
+// 普通数据表，跳过 sqlite 内部表、虚表及其影子表
+QStringList dataTables(QSqlDatabase &database, const QString &schema)
+{
+    QStringList virtualTables;
+    QStringList tables;
+    QSqlQuery query(database);
+    if (!query.exec(QString("SELECT name, sql FROM %1.sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%' ORDER BY rowid").arg(schema))) {
+        return tables;
+    }
+
+    while (query.next()) {
+        const QString name = query.value(0).toString();
+        if (query.value(1).toString().startsWith("CREATE VIRTUAL TABLE", Qt::CaseInsensitive)) {
+            virtualTables.append(name);
+        } else {
+            tables.append(name);
+        }
+    }
+
+    for (const QString &virtualTable : virtualTables) {
+        tables.erase(std::remove_if(tables.begin(), tables.end(), [&](const QString &name) {
+            return name.startsWith(virtualTable + "_");
+        }), tables.end());
+    }
+    return tables;
+}
+
 QList<QString> loadTaskFilePaths(QSqlDatabase &database, int taskId)
 {
     QList<QString> filePaths;
@@ -59,6 +243,115 @@ QList<QString> loadTaskFilePaths(QSqlDatabase &database, int taskId)
 
     return filePaths;
 }
+
+// action：0 子任务挂到上一级，1 连同子任务一起删除，其他值把子任务移到根级
+bool deleteTaskPermanently(QSqlDatabase &database, int id, int action)
+{
+    int parentId = 0;
+    {
+        QSqlQuery parentQuery(database);
+        parentQuery.prepare("SELECT parent_id FROM tasks WHERE id = ?");
+        parentQuery.addBindValue(id);
+        if (parentQuery.exec() && parentQuery.next()) {
+            parentId = parentQuery.value(0).toInt();
+            if (parentId < 0) {
+                parentId = 0;
+            }
+        }
+    }
+
+    if (action == 1) {
+        QSqlQuery childQuery(database);
+        childQuery.prepare("SELECT id FROM tasks WHERE parent_id = ?");
+        childQuery.addBindValue(id);
+        if (childQuery.exec()) {
+            while (childQuery.next()) {
+                int childId = childQuery.value(0).toInt();
+                if (!deleteTaskPermanently(database, childId, action)) {
+                    return false;
+                }
+            }
+        }
+    } else if (action == 0) {
+        QSqlQuery reparentQuery(database);
+        reparentQuery.prepare("UPDATE tasks SET parent_id = ?, updated_at = ? WHERE parent_id = ?");
+        reparentQuery.addBindValue(parentId);
+        reparentQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+        reparentQuery.addBindValue(id);
+        if (!reparentQuery.exec()) {
+            return false;
+        }
+    } else {
+        QSqlQuery reparentQuery(database);
+        reparentQuery.prepare("UPDATE tasks SET parent_id = 0, updated_at = ? WHERE parent_id = ?");
+        reparentQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+        reparentQuery.addBindValue(id);
+        if (!reparentQuery.exec()) {
+            return false;
+        }
+    }
+
+    QSqlQuery cleanupQuery(database);
+    cleanupQuery.prepare("DELETE FROM task_steps WHERE task_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    cleanupQuery.prepare("DELETE FROM task_tags WHERE task_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    cleanupQuery.prepare("DELETE FROM task_files WHERE task_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    cleanupQuery.prepare("DELETE FROM task_folders WHERE task_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    cleanupQuery.prepare("DELETE FROM task_dependencies WHERE task_id = ? OR depends_on_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    cleanupQuery.prepare("DELETE FROM notifications WHERE task_id = ?");
+    cleanupQuery.addBindValue(id);
+    cleanupQuery.exec();
+
+    QSqlQuery query(database);
+    query.prepare("DELETE FROM tasks WHERE id = ?");
+    query.addBindValue(id);
+
+    return query.exec();
+}
+
+// 批量语句里的 id 集合直接写成整数列表，省去逐个绑定
+QString idList(const QList<int> &ids)
+{
+    QStringList parts;
+    parts.reserve(ids.size());
+    for (int id : ids) {
+        if (id > 0) {
+            parts.append(QString::number(id));
+        }
+    }
+    parts.removeDuplicates();
+    return parts.join(',');
+}
+
+QList<int> selectIds(QSqlQuery &query, QList<int> *secondColumn = nullptr)
+{
+    QList<int> ids;
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+        if (secondColumn) {
+            const int value = query.value(1).toInt();
+            if (value > 0 && !secondColumn->contains(value)) {
+                secondColumn->append(value);
+            }
+        }
+    }
+    return ids;
+}
 } // namespace
 
 Database& Database::instance()
@@ -71,6 +364,7 @@ Database::Database()
 {
     m_databasePath = QDir::currentPath() + "/data/todolist.db";
     m_isCorrupted = false;
+    m_restoring = false;
 }
 
 Database::~Database()
@@ -92,6 +386,7 @@ bool Database::open()
 
     m_database = QSqlDatabase::addDatabase("QSQLITE");
     m_database.setDatabaseName(m_databasePath);
+    m_database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
 
     if (!m_database.open()) {
         m_lastError = m_database.lastError().text();
@@ -99,6 +394,17 @@ bool Database::open()
         return false;
     }
 
+    // 只对还没写过文件头的新库立即生效，所以要在切换 WAL 之前设置；旧库由维护线程在空闲时用一次 VACUUM 切换
+    QSqlQuery journalQuery(m_database);
+    if (!journalQuery.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
+        qDebug() << "Failed to set auto_vacuum:" << journalQuery.lastError().text();
+    }
+
+    // WAL 模式下备份连接读取快照时不会阻塞主连接写入
+    if (!journalQuery.exec("PRAGMA journal_mode=WAL")) {
+        qDebug() << "Failed to enable WAL mode:" << journalQuery.lastError().text();
+    }
+
     QSqlQuery integrityQuery(m_database);
     if (!integrityQuery.exec("PRAGMA integrity_check")) {
         m_lastError = integrityQuery.lastError().text();
@@ -171,6 +477,7 @@ bool Database::createTables()
             deleted_at TEXT,
             created_at TEXT DEFAULT CURRENT_TIMESTAMP,
             updated_at TEXT DEFAULT CURRENT_TIMESTAMP,
+            sort_key TEXT,
             FOREIGN KEY (parent_id) REFERENCES tasks(id)
         )
     )";
@@ -257,6 +564,7 @@ bool Database::createTables()
             task_id INTEGER,
             read INTEGER DEFAULT 0,
             created_at TEXT DEFAULT CURRENT_TIMESTAMP,
+            dedupe_key TEXT,
             FOREIGN KEY (task_id) REFERENCES tasks(id) ON DELETE CASCADE
         )
     )";
@@ -275,7 +583,19 @@ bool Database::createTables()
             file_path TEXT NOT NULL,
             file_size INTEGER,
             backup_time TEXT DEFAULT CURRENT_TIMESTAMP,
-            description TEXT
+            description TEXT,
+            compression_ratio REAL,
+            throughput REAL
+        )
+    )";
+
+    // 序号只增不减；消费者保存读到的序号，维护线程压缩所有消费者都读过的部分
+    QString changeLogTable = R"(
+        CREATE TABLE IF NOT EXISTS change_log (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            table_name TEXT NOT NULL,
+            row_id INTEGER NOT NULL,
+            op TEXT NOT NULL
         )
     )";
 
@@ -283,7 +603,7 @@ bool Database::createTables()
         tasksTable, taskStepsTable, tagsTable, taskTagsTable,
         taskDependenciesTable, taskFilesTable, foldersTable,
         taskFoldersTable, notificationsTable, settingsTable,
-        backupHistoryTable
+        backupHistoryTable, changeLogTable
     };
 
     for (const QString &tableSql : tables) {
@@ -299,6 +619,31 @@ bool Database::createTables()
         return false;
     }
 
+    if (!ensureBackupHistoryStatsColumns(m_database)) {
+        m_lastError = "Failed to ensure backup_history stats columns";
+        return false;
+    }
+
+    if (!ensureNotificationDedupeColumn(m_database)) {
+        m_lastError = "Failed to ensure notifications dedupe_key column";
+        return false;
+    }
+
+    if (!ensureTasksSortKeyColumn(m_database) || !assignMissingSortKeys(m_database, &m_lastError)) {
+        if (m_lastError.isEmpty()) {
+            m_lastError = "Failed to ensure tasks sort_key column";
+        }
+        return false;
+    }
+
+    for (const QString &trigger : changeLogTriggerStatements()) {
+        if (!query.exec(trigger)) {
+            m_lastError = query.lastError().text();
+            qDebug() << "Failed to create change_log trigger:" << m_lastError;
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -308,16 +653,19 @@ bool Database::createIndexes()
 
     QStringList indexes = {
         "CREATE INDEX IF NOT EXISTS idx_tasks_parent_id ON tasks(parent_id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_parent_sort ON tasks(parent_id, sort_key)",
         "CREATE INDEX IF NOT EXISTS idx_tasks_due_date ON tasks(due_date)",
         "CREATE INDEX IF NOT EXISTS idx_tasks_priority ON tasks(priority)",
         "CREATE INDEX IF NOT EXISTS idx_tasks_is_deleted ON tasks(is_deleted)",
         "CREATE INDEX IF NOT EXISTS idx_tasks_completed ON tasks(completed)",
         "CREATE INDEX IF NOT EXISTS idx_tasks_created_at ON tasks(created_at)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_deleted_at ON tasks(deleted_at) WHERE is_deleted = 1",
         "CREATE INDEX IF NOT EXISTS idx_task_steps_task_id ON task_steps(task_id)",
         "CREATE INDEX IF NOT EXISTS idx_task_files_task_id ON task_files(task_id)",
         "CREATE INDEX IF NOT EXISTS idx_task_dependencies_depends_on_id ON task_dependencies(depends_on_id)",
         "CREATE INDEX IF NOT EXISTS idx_notifications_read ON notifications(read)",
         "CREATE INDEX IF NOT EXISTS idx_notifications_created_at ON notifications(created_at)",
+        "CREATE UNIQUE INDEX IF NOT EXISTS idx_notifications_dedupe ON notifications(type, task_id, dedupe_key)",
         "CREATE INDEX IF NOT EXISTS idx_task_tags_tag_id ON task_tags(tag_id)",
         "CREATE INDEX IF NOT EXISTS idx_task_folders_folder_id ON task_folders(folder_id)"
     };
@@ -364,27 +712,7 @@ bool Database::createFTS5Table()
         }
     }
 
-    QString triggers[] = {
-        R"(
-            CREATE TRIGGER IF NOT EXISTS tasks_ai AFTER INSERT ON tasks BEGIN
-                INSERT INTO tasks_fts(rowid, title, description)
-                VALUES (new.id, new.title, new.description);
-            END
-        )",
-        R"(
-            CREATE TRIGGER IF NOT EXISTS tasks_ad AFTER DELETE ON tasks BEGIN
-                DELETE FROM tasks_fts WHERE rowid = old.id;
-            END
-        )",
-        R"(
-            CREATE TRIGGER IF NOT EXISTS tasks_au AFTER UPDATE ON tasks BEGIN
-                UPDATE tasks_fts SET title = new.title, description = new.description
-                WHERE rowid = new.id;
-            END
-        )"
-    };
-
-    for (const QString &trigger : triggers) {
+    for (const QString &trigger : ftsTriggerStatements()) {
         if (!query.exec(trigger)) {
             qDebug() << "Failed to create FTS5 trigger:" << query.lastError().text();
         }
@@ -393,55 +721,201 @@ bool Database::createFTS5Table()
     return true;
 }
 
-bool Database::setSetting(const QString &key, const QString &value)
+bool Database::replaceContentsFrom(const QString &sourcePath, const QString &safetyCopyPath)
 {
-    QSqlQuery query(m_database);
-
-    query.prepare(R"(
-        INSERT OR REPLACE INTO settings (key, value, updated_at)
-        VALUES (?, ?, ?)
-    )");
-    query.addBindValue(key);
-    query.addBindValue(value);
-    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    m_lastError.clear();
+    // 挂起的设置先落盘，保留副本里才包含它们，也不会在替换后覆盖新数据
+    SettingsStore::instance().flush();
 
-    return query.exec();
+    // 等待保留副本期间事件循环仍在运行，定时备份、空闲维护和设置写入按这个标志让开
+    m_restoring = true;
+    const bool success = keepSafetyCopy(safetyCopyPath) && copyContentsFrom(sourcePath);
+    m_restoring = false;
+    return success;
 }
 
-QString Database::getSetting(const QString &key, const QString &defaultValue)
+bool Database::isRestoring() const
 {
-    QSqlQuery query(m_database);
-
-    query.prepare("SELECT value FROM settings WHERE key = ?");
-    query.addBindValue(key);
+    return m_restoring;
+}
 
-    if (!query.exec() || !query.next()) {
-        return defaultValue;
+// 保留替换前的数据，作用与原先改名得到的 .bak 相同；副本没写成就不能继续替换。
+// 整库复制交给工作线程的独立连接，等待期间界面照常重绘
+bool Database::keepSafetyCopy(const QString &safetyCopyPath)
+{
+    if (safetyCopyPath.isEmpty()) {
+        return true;
     }
 
-    return query.value(0).toString();
+    DatabaseSnapshot safetyCopy;
+    QEventLoop loop;
+    QObject::connect(&safetyCopy, &DatabaseSnapshot::finished, &loop, &QEventLoop::quit);
+    if (safetyCopy.start(safetyCopyPath)) {
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    } else if (safetyCopy.lastError().isEmpty()) {
+        m_lastError = "Failed to start pre-restore copy";
+        return false;
+    }
+    if (!safetyCopy.lastError().isEmpty()) {
+        m_lastError = QString("Failed to keep pre-restore copy: %1").arg(safetyCopy.lastError());
+        qDebug() << m_lastError;
+        return false;
+    }
+    return true;
 }
 
-void Database::vacuum()
+bool Database::copyContentsFrom(const QString &sourcePath)
 {
-    QSqlQuery query(m_database);
-    query.exec("VACUUM");
+    QSqlQuery attachQuery(m_database);
+    attachQuery.prepare("ATTACH DATABASE ? AS restore_src");
+    attachQuery.addBindValue(sourcePath);
+    if (!attachQuery.exec()) {
+        m_lastError = attachQuery.lastError().text();
+        qDebug() << "Failed to attach restore source:" << m_lastError;
+        return false;
+    }
+
+    bool success = copyAttachedContents("restore_src");
+
+    QSqlQuery detachQuery(m_database);
+    if (!detachQuery.exec("DETACH DATABASE restore_src")) {
+        qDebug() << "Failed to detach restore source:" << detachQuery.lastError().text();
+    }
+
+    return success;
 }
 
-QList<Task> Database::getAllTasks()
+bool Database::copyAttachedContents(const QString &schema)
 {
-    QList<Task> tasks;
     QSqlQuery query(m_database);
-    query.prepare(R"(
-        SELECT t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at,
-               CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = t.id AND child.is_deleted = 0) THEN 1 ELSE 0 END as has_children
-        FROM tasks t
-        WHERE t.is_deleted = 0
-        ORDER BY t.created_at DESC
-    )");
 
-    if (query.exec()) {
-        while (query.next()) {
+    if (!query.exec(QString("PRAGMA %1.quick_check").arg(schema)) || !query.next()
+        || query.value(0).toString().compare("ok", Qt::CaseInsensitive) != 0) {
+        m_lastError = QString("Source database failed quick_check");
+        return false;
+    }
+    query.finish();
+
+    const QStringList sourceTables = dataTables(m_database, schema);
+    if (!sourceTables.contains("tasks")) {
+        m_lastError = QString("Source is not a ToDoList database");
+        return false;
+    }
+    const QStringList tables = dataTables(m_database, "main");
+
+    // 整个替换在一个写事务里完成，其他连接只会看到替换前或替换后的数据
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+
+    auto fail = [this](QSqlQuery &failed) {
+        m_lastError = failed.lastError().text();
+        qDebug() << "Hot restore failed:" << m_lastError << failed.lastQuery();
+        QSqlQuery rollback(m_database);
+        rollback.exec("ROLLBACK");
+        return false;
+    };
+
+    if (!query.exec("PRAGMA defer_foreign_keys = ON")) {
+        return fail(query);
+    }
+
+    // 逐行维护 FTS 和变更日志都没有意义，先去掉触发器，数据复制完再整体重建
+    for (const QString &trigger : {"tasks_ai", "tasks_ad", "tasks_au"}) {
+        if (!query.exec(QString("DROP TRIGGER IF EXISTS %1").arg(trigger))) {
+            return fail(query);
+        }
+    }
+    if (!suspendChangeLog(m_database, &m_lastError)) {
+        QSqlQuery rollback(m_database);
+        rollback.exec("ROLLBACK");
+        return false;
+    }
+
+    // 变更日志属于本库，保留原有记录和序号，替换后只追加一条整体重置
+    for (const QString &table : tables) {
+        if (table == "change_log") {
+            continue;
+        }
+        if (!query.exec(QString("DELETE FROM main.\"%1\"").arg(table))) {
+            return fail(query);
+        }
+    }
+
+    for (const QString &table : tables) {
+        if (!sourceTables.contains(table) || table == "change_log") {
+            continue;
+        }
+
+        const QStringList sourceColumns = tableColumns(m_database, schema, table);
+        QStringList columns;
+        for (const QString &column : tableColumns(m_database, "main", table)) {
+            if (sourceColumns.contains(column, Qt::CaseInsensitive)) {
+                columns.append(QString("\"%1\"").arg(column));
+            }
+        }
+        if (columns.isEmpty()) {
+            continue;
+        }
+
+        const QString columnList = columns.join(", ");
+        if (!query.exec(QString("INSERT INTO main.\"%1\" (%2) SELECT %2 FROM %3.\"%1\"")
+                            .arg(table, columnList, schema))) {
+            return fail(query);
+        }
+    }
+
+    // 旧版本的备份没有 sort_key 列
+    if (!assignMissingSortKeys(m_database, &m_lastError)) {
+        QSqlQuery rollback(m_database);
+        rollback.exec("ROLLBACK");
+        return false;
+    }
+
+    if (!query.exec("INSERT INTO tasks_fts(tasks_fts) VALUES('rebuild')")) {
+        return fail(query);
+    }
+
+    for (const QString &trigger : ftsTriggerStatements()) {
+        if (!query.exec(trigger)) {
+            return fail(query);
+        }
+    }
+
+    if (!resumeChangeLog(m_database, &m_lastError)) {
+        QSqlQuery rollback(m_database);
+        rollback.exec("ROLLBACK");
+        return false;
+    }
+
+    if (!query.exec("COMMIT")) {
+        return fail(query);
+    }
+
+    return true;
+}
+
+void Database::vacuum()
+{
+    QSqlQuery query(m_database);
+    query.exec("VACUUM");
+}
+
+QList<Task> Database::getAllTasks()
+{
+    QList<Task> tasks;
+    QSqlQuery query(m_database);
+    query.prepare(R"(
+        SELECT t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at,
+               CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = t.id AND child.is_deleted = 0) THEN 1 ELSE 0 END as has_children
+        FROM tasks t
+        WHERE t.is_deleted = 0
+        ORDER BY t.created_at DESC
+    )");
+
+    if (query.exec()) {
+        while (query.next()) {
             Task task;
             task.setId(query.value(0).toInt());
             task.setTitle(query.value(1).toString());
@@ -470,7 +944,7 @@ QList<Task> Database::getTasksByParentId(int parentId)
                CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = t.id AND child.is_deleted = 0) THEN 1 ELSE 0 END as has_children
         FROM tasks t
         WHERE t.is_deleted = 0 AND t.parent_id = ?
-        ORDER BY t.created_at ASC
+        ORDER BY t.sort_key, t.created_at ASC
     )");
     query.addBindValue(parentId);
 
@@ -540,11 +1014,11 @@ QList<Task> Database::getTaskHierarchy(int rootId)
     
     QString recursiveQuery = QString::fromUtf8(
         "WITH RECURSIVE task_tree AS ("
-        "SELECT id, title, description, priority, due_date, completed, progress, parent_id, created_at, updated_at, 0 as level "
+        "SELECT id, title, description, priority, due_date, completed, progress, parent_id, created_at, updated_at, sort_key, 0 as level "
         "FROM tasks "
         "WHERE is_deleted = 0 AND (parent_id = ? OR (? = 0 AND parent_id = 0)) "
         "UNION ALL "
-        "SELECT t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at, tt.level + 1 "
+        "SELECT t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at, t.sort_key, tt.level + 1 "
         "FROM tasks t "
         "INNER JOIN task_tree tt ON t.parent_id = tt.id "
         "WHERE t.is_deleted = 0 "
@@ -552,7 +1026,7 @@ QList<Task> Database::getTaskHierarchy(int rootId)
         "SELECT id, title, description, priority, due_date, completed, progress, parent_id, created_at, updated_at, level, "
         "CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = id AND child.is_deleted = 0) THEN 1 ELSE 0 END as has_children "
         "FROM task_tree "
-        "ORDER BY level, created_at"
+        "ORDER BY level, sort_key, created_at"
     );
     
     query.prepare(recursiveQuery);
@@ -584,9 +1058,17 @@ bool Database::insertTask(Task &task)
 {
     QString primaryFilePath = task.filePaths().isEmpty() ? QString() : task.filePaths().first();
     QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    // 顶层任务排在最前，子任务排在同级最后，与原先按创建时间的顺序一致
+    const bool topLevel = task.parentId() <= 0;
+    query.prepare(QString("SELECT %1(sort_key) FROM tasks WHERE parent_id = ?").arg(topLevel ? "MIN" : "MAX"));
+    query.addBindValue(qMax(0, task.parentId()));
+    const QString boundKey = query.exec() && query.next() ? query.value(0).toString() : QString();
+    const QString sortKey = topLevel ? OrderKey::between(QString(), boundKey) : OrderKey::between(boundKey, QString());
+
     query.prepare(R"(
-        INSERT INTO tasks (title, description, file_path, priority, due_date, completed, progress, parent_id, created_at, updated_at)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        INSERT INTO tasks (title, description, file_path, priority, due_date, completed, progress, parent_id, created_at, updated_at, sort_key)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
     )");
     query.addBindValue(task.title());
     query.addBindValue(task.description());
@@ -598,6 +1080,8 @@ bool Database::insertTask(Task &task)
     query.addBindValue(task.parentId());
     query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
     query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    // 相邻键已损坏时先留空，下次打开数据库时补齐
+    query.addBindValue(sortKey.isEmpty() ? QVariant(QVariant::String) : QVariant(sortKey));
 
     if (query.exec()) {
         task.setId(query.lastInsertId().toInt());
@@ -632,7 +1116,7 @@ bool Database::updateTask(const Task &task)
 
 bool Database::deleteTask(int id)
 {
-    const int parentAction = getSetting("delete_parent_action", "0").toInt();
+    const int parentAction = SettingsStore::instance().intValue("delete_parent_action", 0);
     const QString deletedAt = QDateTime::currentDateTime().toString(Qt::ISODate);
 
     auto markDeleted = [&](int taskId) -> bool {
@@ -742,94 +1226,29 @@ bool Database::permanentlyDeleteTask(int id, int parentAction)
 {
     int action = parentAction;
     if (action < 0) {
-        action = getSetting("delete_parent_action", "0").toInt();
+        action = SettingsStore::instance().intValue("delete_parent_action", 0);
     }
+    return deleteTaskPermanently(m_database, id, action);
+}
 
-    int parentId = 0;
-    {
-        QSqlQuery parentQuery(m_database);
-        parentQuery.prepare("SELECT parent_id FROM tasks WHERE id = ?");
-        parentQuery.addBindValue(id);
-        if (parentQuery.exec() && parentQuery.next()) {
-            parentId = parentQuery.value(0).toInt();
-            if (parentId < 0) {
-                parentId = 0;
-            }
-        }
-    }
-
-    if (action == 1) {
-        QSqlQuery childQuery(m_database);
-        childQuery.prepare("SELECT id FROM tasks WHERE parent_id = ?");
-        childQuery.addBindValue(id);
-        if (childQuery.exec()) {
-            while (childQuery.next()) {
-                int childId = childQuery.value(0).toInt();
-                if (!permanentlyDeleteTask(childId, action)) {
-                    return false;
-                }
-            }
-        }
-    } else if (action == 0) {
-        QSqlQuery reparentQuery(m_database);
-        reparentQuery.prepare("UPDATE tasks SET parent_id = ?, updated_at = ? WHERE parent_id = ?");
-        reparentQuery.addBindValue(parentId);
-        reparentQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-        reparentQuery.addBindValue(id);
-        if (!reparentQuery.exec()) {
-            return false;
-        }
-    } else {
-        QSqlQuery reparentQuery(m_database);
-        reparentQuery.prepare("UPDATE tasks SET parent_id = 0, updated_at = ? WHERE parent_id = ?");
-        reparentQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-        reparentQuery.addBindValue(id);
-        if (!reparentQuery.exec()) {
-            return false;
-        }
-    }
-
-    QSqlQuery cleanupQuery(m_database);
-    cleanupQuery.prepare("DELETE FROM task_steps WHERE task_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    cleanupQuery.prepare("DELETE FROM task_tags WHERE task_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    cleanupQuery.prepare("DELETE FROM task_files WHERE task_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    cleanupQuery.prepare("DELETE FROM task_folders WHERE task_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    cleanupQuery.prepare("DELETE FROM task_dependencies WHERE task_id = ? OR depends_on_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    cleanupQuery.prepare("DELETE FROM notifications WHERE task_id = ?");
-    cleanupQuery.addBindValue(id);
-    cleanupQuery.exec();
-
-    QSqlQuery query(m_database);
-    query.prepare("DELETE FROM tasks WHERE id = ?");
-    query.addBindValue(id);
+int Database::cleanupDeletedTasks(int days)
+{
+    return cleanupDeletedTasks(m_database, days, SettingsStore::instance().intValue("delete_parent_action", 0));
+}
 
-    return query.exec();
+int Database::cleanupOldNotifications(int days)
+{
+    return cleanupOldNotifications(m_database, days);
 }
 
-int Database::cleanupDeletedTasks(int days)
+int Database::cleanupDeletedTasks(QSqlDatabase &database, int days, int parentAction)
 {
     if (days <= 0) {
         return 0;
     }
 
     QString threshold = QDateTime::currentDateTime().addDays(-days).toString(Qt::ISODate);
-    QSqlQuery query(m_database);
+    QSqlQuery query(database);
     query.prepare("SELECT id FROM tasks WHERE is_deleted = 1 AND deleted_at IS NOT NULL AND deleted_at <= ?");
     query.addBindValue(threshold);
 
@@ -842,7 +1261,7 @@ int Database::cleanupDeletedTasks(int days)
 
     int deletedCount = 0;
     for (int id : ids) {
-        if (permanentlyDeleteTask(id)) {
+        if (deleteTaskPermanently(database, id, parentAction)) {
             deletedCount++;
         }
     }
@@ -850,14 +1269,14 @@ int Database::cleanupDeletedTasks(int days)
     return deletedCount;
 }
 
-int Database::cleanupOldNotifications(int days)
+int Database::cleanupOldNotifications(QSqlDatabase &database, int days)
 {
     if (days <= 0) {
         return 0;
     }
 
     QString threshold = QDateTime::currentDateTime().addDays(-days).toString(Qt::ISODate);
-    QSqlQuery query(m_database);
+    QSqlQuery query(database);
     query.prepare("DELETE FROM notifications WHERE created_at <= ? AND read = 1");
     query.addBindValue(threshold);
 
@@ -867,7 +1286,7 @@ int Database::cleanupOldNotifications(int days)
 
     int affected = query.numRowsAffected();
     if (affected < 0) {
-        QSqlQuery changes(m_database);
+        QSqlQuery changes(database);
         if (changes.exec("SELECT changes()") && changes.next()) {
             affected = changes.value(0).toInt();
         }
@@ -876,6 +1295,565 @@ int Database::cleanupOldNotifications(int days)
     return affected < 0 ? 0 : affected;
 }
 
+int Database::compactChangeLog(QSqlDatabase &database, qint64 floorSeq, int keepRows)
+{
+    // 所有消费者都已读过，并且不在保留给其他连接的最近 keepRows 条之内
+    QSqlQuery query(database);
+    query.prepare("DELETE FROM change_log WHERE seq <= MIN(?, (SELECT COALESCE(MAX(seq), 0) FROM change_log) - ?)");
+    query.addBindValue(floorSeq);
+    query.addBindValue(qMax(0, keepRows));
+    if (!query.exec()) {
+        return -1;
+    }
+    return qMax(0, query.numRowsAffected());
+}
+
+bool Database::setTasksCompleted(const QList<int> &ids, bool completed, QList<int> *changedIds, QList<int> *parentIds)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT id, parent_id FROM tasks WHERE id IN (%1) AND is_deleted = 0 AND completed <> %2")
+                        .arg(idSet).arg(completed ? 1 : 0))) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    const QList<int> changed = selectIds(query, parentIds);
+    if (changed.isEmpty()) {
+        return true;
+    }
+
+    // 叶子任务的进度随完成状态变化，有子任务的进度仍由子任务决定
+    query.prepare(QString(R"(
+        UPDATE tasks SET completed = ?, updated_at = ?,
+            progress = CASE WHEN EXISTS (SELECT 1 FROM tasks child WHERE child.parent_id = tasks.id AND child.is_deleted = 0)
+                            THEN progress ELSE ? END
+        WHERE id IN (%1)
+    )").arg(idList(changed)));
+    query.addBindValue(completed ? 1 : 0);
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.addBindValue(completed ? 1.0 : 0.0);
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+
+    if (changedIds) {
+        *changedIds = changed;
+    }
+    return true;
+}
+
+bool Database::deleteTasks(const QList<int> &ids, QList<int> *deletedIds, QList<int> *parentIds)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+
+    const int parentAction = SettingsStore::instance().intValue("delete_parent_action", 0);
+    const QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT id, parent_id FROM tasks WHERE id IN (%1) AND is_deleted = 0").arg(idSet))) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    const QList<int> roots = selectIds(query, parentIds);
+    if (roots.isEmpty()) {
+        return true;
+    }
+    const QString rootSet = idList(roots);
+
+    if (parentAction == 1) {
+        // 连同所有未删除的子孙一起移入回收站
+        query.prepare(QString(R"(
+            WITH RECURSIVE doomed(id) AS (
+                SELECT id FROM tasks WHERE id IN (%1)
+                UNION
+                SELECT t.id FROM tasks t JOIN doomed d ON t.parent_id = d.id WHERE t.is_deleted = 0
+            )
+            UPDATE tasks SET is_deleted = 1, deleted_at = ?
+            WHERE id IN (SELECT id FROM doomed) AND is_deleted = 0
+        )").arg(rootSet));
+        query.addBindValue(now);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+    } else {
+        if (parentAction == 0) {
+            // 子任务上移到最近一个不被删除的祖先下，与逐个删除的结果相同
+            query.prepare(QString(R"(
+                WITH RECURSIVE lift(id, parent_id) AS (
+                    SELECT id, parent_id FROM tasks
+                    WHERE is_deleted = 0 AND parent_id IN (%1) AND id NOT IN (%1)
+                    UNION ALL
+                    SELECT lift.id, t.parent_id FROM lift JOIN tasks t ON t.id = lift.parent_id
+                    WHERE lift.parent_id IN (%1)
+                )
+                UPDATE tasks SET updated_at = ?,
+                    parent_id = COALESCE((SELECT l.parent_id FROM lift l
+                                          WHERE l.id = tasks.id AND l.parent_id NOT IN (%1) LIMIT 1), 0)
+                WHERE id IN (SELECT id FROM lift)
+            )").arg(rootSet));
+            query.addBindValue(now);
+            if (!query.exec()) {
+                m_lastError = query.lastError().text();
+                return false;
+            }
+        }
+
+        query.prepare(QString("UPDATE tasks SET is_deleted = 1, deleted_at = ? WHERE id IN (%1) AND is_deleted = 0")
+                          .arg(rootSet));
+        query.addBindValue(now);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+    }
+
+    if (deletedIds) {
+        *deletedIds = roots;
+    }
+    return true;
+}
+
+bool Database::assignTagToTasks(const QList<int> &ids, int tagId)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+    if (tagId <= 0) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare(QString("INSERT OR IGNORE INTO task_tags (task_id, tag_id) SELECT id, ? FROM tasks WHERE id IN (%1)")
+                      .arg(idSet));
+    query.addBindValue(tagId);
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool Database::moveTasksToFolder(const QList<int> &ids, int folderId, QList<int> *movedIds)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+
+    // 子任务跟随父任务移动，与任务对话框保存时的做法一致
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QString(R"(
+            WITH RECURSIVE moved(id) AS (
+                SELECT id FROM tasks WHERE id IN (%1)
+                UNION
+                SELECT t.id FROM tasks t JOIN moved m ON t.parent_id = m.id
+            )
+            SELECT id FROM moved
+        )").arg(idSet))) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    const QList<int> moved = selectIds(query);
+    if (moved.isEmpty()) {
+        return true;
+    }
+    const QString movedSet = idList(moved);
+
+    if (!query.exec(QString("DELETE FROM task_folders WHERE task_id IN (%1)").arg(movedSet))) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    if (folderId > 0) {
+        query.prepare(QString("INSERT INTO task_folders (task_id, folder_id) SELECT id, ? FROM tasks WHERE id IN (%1)")
+                          .arg(movedSet));
+        query.addBindValue(folderId);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+    }
+
+    if (movedIds) {
+        *movedIds = moved;
+    }
+    return true;
+}
+
+// 新父任务及其祖先都不能是被移动的任务，否则会形成环
+bool Database::canMoveUnder(const QString &idSet, int parentId)
+{
+    if (parentId <= 0) {
+        return true;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        WITH RECURSIVE up(id, parent_id, is_deleted) AS (
+            SELECT id, parent_id, is_deleted FROM tasks WHERE id = ?
+            UNION
+            SELECT t.id, t.parent_id, t.is_deleted FROM tasks t JOIN up ON t.id = up.parent_id
+        )
+        SELECT SUM(id IN (%1)), MAX(CASE WHEN id = ? THEN is_deleted END) FROM up
+    )").arg(idSet));
+    query.addBindValue(parentId);
+    query.addBindValue(parentId);
+    if (!query.exec() || !query.next()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    if (query.value(1).isNull() || query.value(1).toInt() != 0) {
+        m_lastError = QString("Parent task %1 does not exist").arg(parentId);
+        return false;
+    }
+    if (query.value(0).toInt() > 0) {
+        m_lastError = "Cannot move a task under itself or one of its subtasks";
+        return false;
+    }
+    return true;
+}
+
+bool Database::reparentTasks(const QList<int> &ids, int parentId, QList<int> *movedIds, QList<int> *parentIds)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+    parentId = qMax(0, parentId);
+
+    if (!canMoveUnder(idSet, parentId)) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT id, parent_id FROM tasks WHERE id IN (%1) AND is_deleted = 0 AND COALESCE(parent_id, 0) <> ?")
+                      .arg(idSet));
+    query.addBindValue(parentId);
+    QList<int> oldParents;
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    const QList<int> moved = selectIds(query, &oldParents);
+    if (moved.isEmpty()) {
+        return true;
+    }
+
+    query.prepare(QString("UPDATE tasks SET parent_id = ?, updated_at = ? WHERE id IN (%1)").arg(idList(moved)));
+    query.addBindValue(parentId);
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+
+    if (movedIds) {
+        *movedIds = moved;
+    }
+    if (parentIds) {
+        *parentIds = oldParents;
+        if (parentId > 0 && !parentIds->contains(parentId)) {
+            parentIds->append(parentId);
+        }
+    }
+    return true;
+}
+
+bool Database::moveTasks(const QList<int> &ids, int parentId, int previousId, int nextId, QList<int> *parentIds)
+{
+    const QString idSet = idList(ids);
+    if (idSet.isEmpty()) {
+        return true;
+    }
+    parentId = qMax(0, parentId);
+    if ((previousId > 0 && ids.contains(previousId)) || (nextId > 0 && ids.contains(nextId))) {
+        m_lastError = "Cannot position tasks relative to themselves";
+        return false;
+    }
+    if (!canMoveUnder(idSet, parentId)) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    QString previousKey;
+    QString nextKey;
+    if (previousId > 0 || nextId > 0) {
+        query.prepare("SELECT id, sort_key, COALESCE(parent_id, 0) FROM tasks WHERE id IN (?, ?) AND is_deleted = 0");
+        query.addBindValue(previousId);
+        query.addBindValue(nextId);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+        // 邻居必须是目标父任务下的子任务，否则算出的键落在别的兄弟序列里
+        int neighbours = 0;
+        while (query.next()) {
+            if (query.value(2).toInt() != parentId) {
+                m_lastError = QString("Task %1 is not a child of task %2").arg(query.value(0).toInt()).arg(parentId);
+                return false;
+            }
+            ++neighbours;
+            if (query.value(0).toInt() == previousId) {
+                previousKey = query.value(1).toString();
+            } else {
+                nextKey = query.value(1).toString();
+            }
+        }
+        if (neighbours != (previousId > 0) + (nextId > 0)) {
+            m_lastError = "Neighbour task does not exist";
+            return false;
+        }
+        // 邻居的键顺序异常时只保证排在前一个之后
+        if (!previousKey.isEmpty() && !nextKey.isEmpty() && previousKey >= nextKey) {
+            nextKey.clear();
+        }
+    } else {
+        query.prepare(QString("SELECT MAX(sort_key) FROM tasks WHERE COALESCE(parent_id, 0) = ? AND id NOT IN (%1)").arg(idSet));
+        query.addBindValue(parentId);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+        if (query.next()) {
+            previousKey = query.value(0).toString();
+        }
+    }
+
+    query.prepare(QString("SELECT id, parent_id FROM tasks WHERE id IN (%1) AND is_deleted = 0").arg(idSet));
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    QHash<int, int> oldParents;
+    while (query.next()) {
+        oldParents.insert(query.value(0).toInt(), query.value(1).toInt());
+    }
+
+    // 保持调用方给出的先后顺序
+    QList<int> moved;
+    for (int id : ids) {
+        if (oldParents.contains(id) && !moved.contains(id)) {
+            moved.append(id);
+        }
+    }
+    if (moved.isEmpty()) {
+        return true;
+    }
+
+    const QStringList keys = OrderKey::between(previousKey, nextKey, moved.size());
+    if (keys.size() != moved.size()) {
+        m_lastError = "Failed to compute sort keys";
+        return false;
+    }
+
+    // 只改被移动的行：父任务和排序键在同一条语句中更新，子任务随 parent_id 一起移动
+    QString keyCases;
+    for (int i = 0; i < moved.size(); ++i) {
+        keyCases += QString(" WHEN %1 THEN '%2'").arg(moved.at(i)).arg(keys.at(i));
+    }
+    query.prepare(QString(R"(
+        UPDATE tasks
+        SET sort_key = CASE id%1 END,
+            updated_at = CASE WHEN COALESCE(parent_id, 0) <> ? THEN ? ELSE updated_at END,
+            parent_id = ?
+        WHERE id IN (%2)
+    )").arg(keyCases, idList(moved)));
+    query.addBindValue(parentId);
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.addBindValue(parentId);
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+
+    if (parentIds) {
+        parentIds->clear();
+        for (int id : moved) {
+            const int oldParent = oldParents.value(id);
+            if (oldParent == parentId) {
+                continue;
+            }
+            if (oldParent > 0 && !parentIds->contains(oldParent)) {
+                parentIds->append(oldParent);
+            }
+            if (parentId > 0 && !parentIds->contains(parentId)) {
+                parentIds->append(parentId);
+            }
+        }
+    }
+    return true;
+}
+
+bool Database::suspendChangeLog(QSqlDatabase &database, QString *error)
+{
+    QSqlQuery query(database);
+    for (const QString &trigger : changeLogTriggerNames()) {
+        if (!query.exec(QString("DROP TRIGGER IF EXISTS main.%1").arg(trigger))) {
+            if (error) {
+                *error = query.lastError().text();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Database::resumeChangeLog(QSqlDatabase &database, QString *error)
+{
+    QSqlQuery query(database);
+    // 消费者读到 'R' 后整体重新加载，不再逐条处理这段时间的变化
+    const QStringList statements = changeLogTriggerStatements()
+        << "INSERT INTO main.change_log (table_name, row_id, op) VALUES ('*', 0, 'R')";
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            if (error) {
+                *error = query.lastError().text();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Database::assignMissingSortKeys(QSqlDatabase &database, QString *error)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, COALESCE(parent_id, 0) FROM tasks WHERE sort_key IS NULL ORDER BY created_at, id")) {
+        if (error) {
+            *error = query.lastError().text();
+        }
+        return false;
+    }
+    QMap<int, QList<int>> pending;
+    while (query.next()) {
+        pending[query.value(1).toInt()].append(query.value(0).toInt());
+    }
+    if (pending.isEmpty()) {
+        return true;
+    }
+
+    // 已处于外层事务中时直接跟随外层提交
+    const bool ownTransaction = database.transaction();
+    QSqlQuery update(database);
+    update.prepare("UPDATE tasks SET sort_key = ? WHERE id = ?");
+    bool ok = true;
+    for (auto it = pending.constBegin(); ok && it != pending.constEnd(); ++it) {
+        const bool topLevel = it.key() == 0;
+        const QList<int> &taskIds = it.value();
+
+        query.prepare("SELECT MIN(sort_key), MAX(sort_key) FROM tasks WHERE COALESCE(parent_id, 0) = ?");
+        query.addBindValue(it.key());
+        QString minKey;
+        QString maxKey;
+        if (query.exec() && query.next()) {
+            minKey = query.value(0).toString();
+            maxKey = query.value(1).toString();
+        }
+        query.finish();
+
+        // 顶层任务新建的在前，子任务先建的在前
+        QStringList keys = topLevel ? OrderKey::between(QString(), minKey, taskIds.size())
+                                    : OrderKey::between(maxKey, QString(), taskIds.size());
+        if (keys.size() != taskIds.size()) {
+            keys = OrderKey::between(QString(), QString(), taskIds.size());
+        }
+        for (int i = 0; ok && i < taskIds.size(); ++i) {
+            update.addBindValue(topLevel ? keys.at(keys.size() - 1 - i) : keys.at(i));
+            update.addBindValue(taskIds.at(i));
+            ok = update.exec();
+        }
+    }
+
+    if (!ok && error) {
+        *error = update.lastError().text();
+    }
+    if (ownTransaction) {
+        if (ok) {
+            ok = database.commit();
+            if (!ok && error) {
+                *error = database.lastError().text();
+            }
+        }
+        if (!ok) {
+            database.rollback();
+        }
+    }
+    return ok;
+}
+
+QList<int> Database::refreshProgress(const QList<int> &taskIds)
+{
+    const QString idSet = idList(taskIds);
+    if (idSet.isEmpty()) {
+        return QList<int>();
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QString(R"(
+            WITH RECURSIVE up(id, parent_id) AS (
+                SELECT id, parent_id FROM tasks WHERE id IN (%1)
+                UNION
+                SELECT t.id, t.parent_id FROM tasks t JOIN up ON t.id = up.parent_id
+            )
+            SELECT id, parent_id FROM up
+        )").arg(idSet))) {
+        m_lastError = query.lastError().text();
+        return QList<int>();
+    }
+
+    QHash<int, int> parents;
+    while (query.next()) {
+        parents.insert(query.value(0).toInt(), query.value(1).toInt());
+    }
+
+    // 按到根的距离分层，子层先算完父层才能取到新值
+    QMap<int, QList<int>> levels;
+    for (auto it = parents.constBegin(); it != parents.constEnd(); ++it) {
+        int depth = 0;
+        for (int parent = it.value(); parents.contains(parent) && depth <= parents.size(); parent = parents.value(parent)) {
+            ++depth;
+        }
+        levels[depth].append(it.key());
+    }
+
+    const QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+    QList<int> refreshed;
+    for (auto it = levels.constEnd(); it != levels.constBegin();) {
+        --it;
+        query.prepare(QString(R"(
+            UPDATE tasks SET updated_at = ?,
+                progress = COALESCE((SELECT AVG(child.progress) FROM tasks child
+                                     WHERE child.parent_id = tasks.id AND child.is_deleted = 0),
+                                    CASE WHEN completed THEN 1.0 ELSE 0.0 END)
+            WHERE id IN (%1)
+        )").arg(idList(it.value())));
+        query.addBindValue(now);
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            return refreshed;
+        }
+        refreshed.append(it.value());
+    }
+    return refreshed;
+}
+
 double Database::calculateProgress(int taskId)
 {
     QSqlQuery query(m_database);
@@ -1428,16 +2406,19 @@ Notification Database::getNotificationById(int id)
 bool Database::insertNotification(Notification &notification)
 {
     QSqlQuery query(m_database);
-    query.prepare("INSERT INTO notifications (type, title, message, task_id, read, created_at) VALUES (?, ?, ?, ?, ?, ?)");
+    query.prepare("INSERT OR IGNORE INTO notifications (type, title, message, task_id, read, created_at, dedupe_key) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?)");
     query.addBindValue(static_cast<int>(notification.type()));
     query.addBindValue(notification.title());
     query.addBindValue(notification.message());
     query.addBindValue(notification.taskId());
     query.addBindValue(notification.isRead() ? 1 : 0);
     query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.addBindValue(notification.dedupeKey().isEmpty() ? QVariant(QVariant::String) : QVariant(notification.dedupeKey()));
 
     if (query.exec()) {
-        notification.setId(query.lastInsertId().toInt());
+        // 去重键已存在时被忽略，id 保持为 0
+        notification.setId(query.numRowsAffected() > 0 ? query.lastInsertId().toInt() : 0);
         return true;
     }
 
@@ -29,10 +29,11 @@ public:
 
     QSqlDatabase& database();
 
-    bool setSetting(const QString &key, const QString &value);
-    QString getSetting(const QString &key, const QString &defaultValue = QString());
-
     void vacuum();
+    // safetyCopyPath 非空时先保留一份替换前的副本，副本写不成则不替换
+    bool replaceContentsFrom(const QString &sourcePath, const QString &safetyCopyPath = QString());
+    // 替换数据期间为 true，其他定时写入应推迟
+    bool isRestoring() const;
 
     QList<Task> getAllTasks();
     QList<Task> getTasksByParentId(int parentId);
@@ -45,9 +46,32 @@ public:
     bool permanentlyDeleteTask(int id, int parentAction = -1);
     int cleanupDeletedTasks(int days);
     int cleanupOldNotifications(int days);
+    // 与上面两个相同，但在调用方提供的连接上执行，供维护线程使用
+    static int cleanupDeletedTasks(QSqlDatabase &database, int days, int parentAction);
+    static int cleanupOldNotifications(QSqlDatabase &database, int days);
+    // 删除序号不超过 floorSeq 且不在最近 keepRows 条之内的变更日志，失败时返回 -1
+    static int compactChangeLog(QSqlDatabase &database, qint64 floorSeq, int keepRows);
+    // 为 sort_key 为空的任务（旧数据、导入或恢复的旧备份）补上排序键
+    static bool assignMissingSortKeys(QSqlDatabase &database, QString *error = nullptr);
+    // 批量替换数据前去掉变更日志触发器，写完后重建并追加一条整体重置；两者须在调用方的同一个写事务中
+    static bool suspendChangeLog(QSqlDatabase &database, QString *error = nullptr);
+    static bool resumeChangeLog(QSqlDatabase &database, QString *error = nullptr);
     double calculateProgress(int taskId);
     double calculateParentProgress(int taskId);
 
+    // 批量操作：每张表只执行一条集合语句，调用方负责把它们放进同一个事务
+    // parentIds 返回需要重新计算进度的任务，交给 refreshProgress
+    bool setTasksCompleted(const QList<int> &ids, bool completed, QList<int> *changedIds, QList<int> *parentIds);
+    bool deleteTasks(const QList<int> &ids, QList<int> *deletedIds, QList<int> *parentIds);
+    bool assignTagToTasks(const QList<int> &ids, int tagId);
+    bool moveTasksToFolder(const QList<int> &ids, int folderId, QList<int> *movedIds);
+    bool reparentTasks(const QList<int> &ids, int parentId, QList<int> *movedIds, QList<int> *parentIds);
+    // 把任务按给定顺序放到 parentId 下 previousId 与 nextId 之间（0 表示该侧没有邻居，两侧都为 0 时放到最后）
+    // 每个任务只更新自己一行的 parent_id 和 sort_key
+    bool moveTasks(const QList<int> &ids, int parentId, int previousId, int nextId, QList<int> *parentIds);
+    // 重新计算这些任务及其所有祖先的进度，由深到浅每层一条语句；返回进度被重新计算的任务
+    QList<int> refreshProgress(const QList<int> &taskIds);
+
     QList<TaskStep> getTaskSteps(int taskId);
     bool insertTaskStep(TaskStep &step);
     bool updateTaskStep(const TaskStep &step);
@@ -99,10 +123,16 @@ private:
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
 
+    bool keepSafetyCopy(const QString &safetyCopyPath);
+    bool copyContentsFrom(const QString &sourcePath);
+    bool copyAttachedContents(const QString &schema);
+    bool canMoveUnder(const QString &idSet, int parentId);
+
     QSqlDatabase m_database;
     QString m_databasePath;
     QString m_lastError;
     bool m_isCorrupted;
+    bool m_restoring;
 };
 
 #endif // DATABASE_H
@@ -0,0 +1,200 @@
+#include "database_snapshot.h"
+#include "database.h"
+#include "settings_store.h"
+#include "background_job.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+namespace {
+qint64 pragmaValue(QSqlDatabase &database, const QString &pragma)
+{
+    QSqlQuery query(database);
+    if (query.exec(QString("PRAGMA %1").arg(pragma)) && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+QString runSnapshot(const QString &sourcePath, const QString &destination, const QString &connectionName)
+{
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(sourcePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1;QSQLITE_OPEN_READONLY").arg(BackgroundJob::BusyTimeoutMs));
+
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            QSqlQuery query(database);
+            query.prepare("VACUUM INTO ?");
+            query.addBindValue(destination);
+            if (!query.exec()) {
+                error = query.lastError().text();
+            }
+            query.finish();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return error;
+}
+} // namespace
+
+DatabaseSnapshot::DatabaseSnapshot(QObject *parent)
+    : QObject(parent)
+    , m_job(new BackgroundJob(this))
+    , m_expectedBytes(0)
+    , m_pageSize(0)
+    , m_lastProgress(0)
+{
+    connect(m_job, &BackgroundJob::progressTick, this, &DatabaseSnapshot::onPollProgress);
+    connect(m_job, &BackgroundJob::finished, this, &DatabaseSnapshot::onThreadFinished);
+}
+
+DatabaseSnapshot::~DatabaseSnapshot()
+{
+    m_job->wait();
+}
+
+bool DatabaseSnapshot::start(const QString &destination, const Finalizer &finalizer)
+{
+    QString sourcePath;
+    if (!prepareStart(&sourcePath)) {
+        return false;
+    }
+
+    if (QFile::exists(destination) && !QFile::remove(destination)) {
+        m_error = QString("Cannot replace %1").arg(destination);
+        return false;
+    }
+
+    // VACUUM INTO 不写入空闲页，按有效页数估算目标文件大小
+    QSqlDatabase &database = Database::instance().database();
+    m_pageSize = pragmaValue(database, "page_size");
+    const qint64 usedPages = pragmaValue(database, "page_count") - pragmaValue(database, "freelist_count");
+    m_expectedBytes = qMax<qint64>(1, usedPages) * qMax<qint64>(1, m_pageSize);
+
+    m_destination = destination;
+    m_finalizer = finalizer;
+
+    const QString connectionName = BackgroundJob::connectionName("snapshot");
+    m_job->start([this, sourcePath, destination, connectionName, finalizer]() {
+        m_error = runSnapshot(sourcePath, destination, connectionName);
+        if (m_error.isEmpty() && finalizer) {
+            m_error = finalizer(destination, &m_details);
+        }
+    });
+    emit progressChanged(0);
+    return true;
+}
+
+bool DatabaseSnapshot::startInPlace(const Finalizer &finalizer)
+{
+    QString sourcePath;
+    if (!finalizer || !prepareStart(&sourcePath)) {
+        return false;
+    }
+
+    // 没有目标文件可以估算进度，只在开始和结束时汇报
+    m_expectedBytes = 0;
+    m_destination.clear();
+    m_finalizer = finalizer;
+
+    m_job->start([this, sourcePath, finalizer]() {
+        m_error = finalizer(sourcePath, &m_details);
+    });
+    emit progressChanged(0);
+    return true;
+}
+
+bool DatabaseSnapshot::prepareStart(QString *sourcePath)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    *sourcePath = database.databaseName();
+    if (!database.isOpen() || !QFile::exists(*sourcePath)) {
+        m_error = "Database is not open";
+        return false;
+    }
+    // 独立连接只能读到已落盘的设置
+    SettingsStore::instance().flush();
+
+    m_error.clear();
+    m_details.clear();
+    m_lastProgress = 0;
+    return true;
+}
+
+bool DatabaseSnapshot::isRunning() const
+{
+    return m_job->isRunning();
+}
+
+void DatabaseSnapshot::waitForFinished()
+{
+    m_job->waitForFinished();
+}
+
+QString DatabaseSnapshot::destination() const
+{
+    return m_destination;
+}
+
+QString DatabaseSnapshot::lastError() const
+{
+    return m_error;
+}
+
+qint64 DatabaseSnapshot::expectedBytes() const
+{
+    return m_expectedBytes;
+}
+
+qint64 DatabaseSnapshot::elapsedMs() const
+{
+    return m_job->elapsedMs();
+}
+
+void DatabaseSnapshot::onPollProgress()
+{
+    if (!isRunning() || m_expectedBytes <= 0) {
+        return;
+    }
+
+    // 目标文件按页追加写入，以已写入页数计算进度
+    const qint64 written = QFileInfo(m_destination).size();
+    const qint64 pagesWritten = m_pageSize > 0 ? written / m_pageSize : 0;
+    const qint64 totalPages = m_pageSize > 0 ? m_expectedBytes / m_pageSize : 1;
+    const int progress = static_cast<int>(qMin<qint64>(99, (pagesWritten * 100) / qMax<qint64>(1, totalPages)));
+
+    if (progress > m_lastProgress) {
+        m_lastProgress = progress;
+        emit progressChanged(progress);
+    }
+}
+
+void DatabaseSnapshot::onThreadFinished()
+{
+    // 有后续处理时快照文件由 finalizer 接管，可能已被移走
+    bool success = m_error.isEmpty() && (m_finalizer || QFile::exists(m_destination));
+    if (!success) {
+        if (m_error.isEmpty()) {
+            m_error = QString("Snapshot file was not created: %1").arg(m_destination);
+        }
+        if (!m_destination.isEmpty()) {
+            QFile::remove(m_destination);
+        }
+    } else {
+        m_lastProgress = 100;
+        emit progressChanged(100);
+    }
+
+    emit finished(success, m_error, m_details);
+}
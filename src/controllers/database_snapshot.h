@@ -0,0 +1,56 @@
+#ifndef DATABASE_SNAPSHOT_H
+#define DATABASE_SNAPSHOT_H
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <functional>
+
+class BackgroundJob;
+
+// 在工作线程中用独立连接执行 VACUUM INTO，主连接可继续读写
+class DatabaseSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 在工作线程中处理生成的快照文件，返回错误信息，空串表示成功；
+    // 写入 details 的统计随 finished 送回界面线程
+    using Finalizer = std::function<QString(const QString &snapshotPath, QVariantMap *details)>;
+
+    explicit DatabaseSnapshot(QObject *parent = nullptr);
+    ~DatabaseSnapshot();
+
+    bool start(const QString &destination, const Finalizer &finalizer = Finalizer());
+    // 不生成快照文件，直接把数据库路径交给 finalizer，由它自己保证读到一致的内容
+    bool startInPlace(const Finalizer &finalizer);
+    bool isRunning() const;
+    void waitForFinished();
+
+    QString destination() const;
+    QString lastError() const;
+    qint64 expectedBytes() const;
+    qint64 elapsedMs() const;
+
+signals:
+    void progressChanged(int progress);
+    void finished(bool success, const QString &error, const QVariantMap &details);
+
+private slots:
+    void onPollProgress();
+    void onThreadFinished();
+
+private:
+    bool prepareStart(QString *sourcePath);
+
+    BackgroundJob *m_job;
+    QString m_destination;
+    Finalizer m_finalizer;
+    QString m_error;
+    QVariantMap m_details;
+    qint64 m_expectedBytes;
+    qint64 m_pageSize;
+    int m_lastProgress;
+};
+
+#endif // DATABASE_SNAPSHOT_H
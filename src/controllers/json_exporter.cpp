@@ -0,0 +1,627 @@
+#include "json_exporter.h"
+#include "database.h"
+#include "settings_store.h"
+#include "background_job.h"
+#include "../utils/date_utils.h"
+#include "../utils/json_stream_writer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVector>
+
+namespace {
+const char *CancelledError = "Export cancelled";
+
+const char *TaskColumns = "id, title, description, priority, due_date, completed, progress, parent_id, "
+                          "is_deleted, deleted_at, created_at, updated_at, file_path";
+
+QString isoDate(const QVariant &value)
+{
+    return DateUtils::toIsoString(DateUtils::parseIsoString(value.toString()));
+}
+
+// 一次导出的游标和预编译语句；每层子任务使用各自的语句，递归时外层游标保持有效
+class ExportJob
+{
+public:
+    ExportJob(QSqlDatabase database, JsonStreamWriter *writer, std::atomic<int> *processed,
+              std::atomic<int> *exportedTasks, const std::atomic<bool> *cancelled)
+        : m_database(database)
+        , m_writer(writer)
+        , m_processed(processed)
+        , m_exportedTasks(exportedTasks)
+        , m_cancelled(cancelled)
+        , m_stepsQuery(database)
+        , m_dependenciesQuery(database)
+        , m_tagsQuery(database)
+        , m_filesQuery(database)
+    {
+    }
+
+    ~ExportJob()
+    {
+        qDeleteAll(m_childQueries);
+    }
+
+    int countRows(const JsonExporter::Options &options)
+    {
+        QStringList tables;
+        if (options.tasks) {
+            tables << "tasks" << "task_steps" << "task_files" << "task_dependencies" << "task_tags" << "tags";
+        }
+        if (options.folders) {
+            tables << "folders" << "task_folders";
+        }
+        if (options.settings) {
+            tables << "settings";
+        }
+        if (options.notifications) {
+            tables << "notifications";
+        }
+
+        int total = 0;
+        QSqlQuery query(m_database);
+        for (const QString &table : tables) {
+            if (query.exec(QString("SELECT COUNT(*) FROM %1").arg(table)) && query.next()) {
+                total += query.value(0).toInt();
+            }
+        }
+        return total;
+    }
+
+    bool writeTags()
+    {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        if (!exec(query, "SELECT id, name, color, created_at FROM tags ORDER BY created_at ASC")) {
+            return false;
+        }
+
+        m_writer->beginArray("tags");
+        while (query.next()) {
+            m_writer->beginObject();
+            m_writer->writeInt("id", query.value(0).toInt());
+            m_writer->writeString("name", query.value(1).toString());
+            m_writer->writeString("color", query.value(2).toString());
+            m_writer->writeString("created_at", isoDate(query.value(3)));
+            m_writer->endObject();
+            if (!advance()) {
+                return false;
+            }
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeTasks()
+    {
+        if (!prepare(m_stepsQuery, "SELECT id, title, completed, position, created_at FROM task_steps "
+                                   "WHERE task_id = ? ORDER BY position ASC")
+            || !prepare(m_dependenciesQuery, "SELECT depends_on_id FROM task_dependencies "
+                                             "WHERE task_id = ? ORDER BY created_at ASC")
+            || !prepare(m_tagsQuery, "SELECT tt.tag_id, t.name FROM task_tags tt "
+                                     "LEFT JOIN tags t ON t.id = tt.tag_id WHERE tt.task_id = ?")
+            || !prepare(m_filesQuery, "SELECT file_path, file_name, created_at FROM task_files "
+                                      "WHERE task_id = ? ORDER BY created_at ASC")) {
+            return false;
+        }
+
+        // 父任务不存在的任务与旧版导出一致，按根任务处理
+        QSqlQuery roots(m_database);
+        roots.setForwardOnly(true);
+        if (!exec(roots, QString("SELECT %1 FROM tasks t WHERE t.parent_id IS NULL OR t.parent_id <= 0 "
+                                 "OR NOT EXISTS (SELECT 1 FROM tasks p WHERE p.id = t.parent_id) "
+                                 "ORDER BY t.created_at ASC, t.id ASC").arg(TaskColumns))) {
+            return false;
+        }
+
+        m_writer->beginArray("tasks");
+        while (roots.next()) {
+            if (!writeTask(roots, 0)) {
+                return false;
+            }
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeFolders()
+    {
+        QSqlQuery query(m_database);
+        QSqlQuery taskQuery(m_database);
+        query.setForwardOnly(true);
+        if (!exec(query, "SELECT id, name, color, position, created_at FROM folders ORDER BY position ASC")
+            || !prepare(taskQuery, "SELECT task_id FROM task_folders WHERE folder_id = ?")) {
+            return false;
+        }
+
+        m_writer->beginArray("folders");
+        while (query.next()) {
+            const int folderId = query.value(0).toInt();
+            m_writer->beginObject();
+            m_writer->writeInt("id", folderId);
+            m_writer->writeString("name", query.value(1).toString());
+            m_writer->writeString("color", query.value(2).toString());
+            m_writer->writeInt("position", query.value(3).toInt());
+            m_writer->writeString("created_at", isoDate(query.value(4)));
+
+            m_writer->beginArray("task_ids");
+            taskQuery.bindValue(0, folderId);
+            if (!exec(taskQuery)) {
+                return false;
+            }
+            while (taskQuery.next()) {
+                m_writer->writeInt(nullptr, taskQuery.value(0).toInt());
+                if (!advance()) {
+                    return false;
+                }
+            }
+            taskQuery.finish();
+            m_writer->endArray();
+
+            m_writer->endObject();
+            if (!advance()) {
+                return false;
+            }
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeSettings()
+    {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        if (!exec(query, "SELECT key, value, updated_at FROM settings")) {
+            return false;
+        }
+
+        m_writer->beginArray("settings");
+        while (query.next()) {
+            m_writer->beginObject();
+            m_writer->writeString("key", query.value(0).toString());
+            m_writer->writeString("value", query.value(1).toString());
+            m_writer->writeString("updated_at", isoDate(query.value(2)));
+            m_writer->endObject();
+            if (!advance()) {
+                return false;
+            }
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeNotifications()
+    {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        if (!exec(query, "SELECT id, type, title, message, task_id, read, created_at FROM notifications "
+                         "ORDER BY created_at DESC")) {
+            return false;
+        }
+
+        m_writer->beginArray("notifications");
+        while (query.next()) {
+            m_writer->beginObject();
+            m_writer->writeInt("id", query.value(0).toInt());
+            m_writer->writeInt("type", query.value(1).toInt());
+            m_writer->writeString("title", query.value(2).toString());
+            m_writer->writeString("message", query.value(3).toString());
+            m_writer->writeInt("task_id", query.value(4).toInt());
+            m_writer->writeBool("read", query.value(5).toInt() == 1);
+            m_writer->writeString("created_at", isoDate(query.value(6)));
+            m_writer->endObject();
+            if (!advance()) {
+                return false;
+            }
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    QString error() const
+    {
+        return m_error;
+    }
+
+private:
+    // 子任务写在最后，导入端读到 children 时父任务字段已经完整
+    bool writeTask(QSqlQuery &row, int depth)
+    {
+        const int taskId = row.value(0).toInt();
+        const QString primaryFile = row.value(12).toString();
+
+        m_writer->beginObject();
+        m_writer->writeInt("id", taskId);
+        m_writer->writeString("title", row.value(1).toString());
+        m_writer->writeString("description", row.value(2).toString());
+        m_writer->writeInt("priority", row.value(3).toInt());
+        m_writer->writeString("due_date", isoDate(row.value(4)));
+        m_writer->writeBool("completed", row.value(5).toInt() == 1);
+        m_writer->writeInt("progress", static_cast<int>(row.value(6).toDouble()));
+        m_writer->writeInt("parent_id", row.value(7).toInt());
+        m_writer->writeBool("is_deleted", row.value(8).toInt() == 1);
+        m_writer->writeString("deleted_at", isoDate(row.value(9)));
+        m_writer->writeString("created_at", isoDate(row.value(10)));
+        m_writer->writeString("updated_at", isoDate(row.value(11)));
+
+        if (!writeTaskTags(taskId) || !writeTaskDependencies(taskId)
+            || !writeTaskFiles(taskId, primaryFile) || !writeTaskSteps(taskId)) {
+            return false;
+        }
+        m_exportedTasks->fetch_add(1, std::memory_order_relaxed);
+        if (!advance()) {
+            return false;
+        }
+
+        QSqlQuery *children = childQuery(depth);
+        if (!children) {
+            return false;
+        }
+        children->bindValue(0, taskId);
+        if (!exec(*children)) {
+            return false;
+        }
+
+        m_writer->beginArray("children");
+        while (children->next()) {
+            if (!writeTask(*children, depth + 1)) {
+                return false;
+            }
+        }
+        children->finish();
+        m_writer->endArray();
+
+        m_writer->endObject();
+        return true;
+    }
+
+    bool writeTaskTags(int taskId)
+    {
+        m_tagsQuery.bindValue(0, taskId);
+        if (!exec(m_tagsQuery)) {
+            return false;
+        }
+
+        // 单个任务的标签很少，先收集再分别写出 tag_ids 和 tags 两个数组
+        QVector<int> tagIds;
+        QStringList tagNames;
+        while (m_tagsQuery.next()) {
+            tagIds.append(m_tagsQuery.value(0).toInt());
+            const QString name = m_tagsQuery.value(1).toString();
+            if (!name.isEmpty()) {
+                tagNames.append(name);
+            }
+            m_processed->fetch_add(1, std::memory_order_relaxed);
+        }
+        m_tagsQuery.finish();
+
+        m_writer->beginArray("tags");
+        for (const QString &name : tagNames) {
+            m_writer->writeString(nullptr, name);
+        }
+        m_writer->endArray();
+
+        m_writer->beginArray("tag_ids");
+        for (int tagId : tagIds) {
+            m_writer->writeInt(nullptr, tagId);
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeTaskDependencies(int taskId)
+    {
+        m_dependenciesQuery.bindValue(0, taskId);
+        if (!exec(m_dependenciesQuery)) {
+            return false;
+        }
+
+        m_writer->beginArray("dependencies");
+        while (m_dependenciesQuery.next()) {
+            m_writer->writeInt(nullptr, m_dependenciesQuery.value(0).toInt());
+            m_processed->fetch_add(1, std::memory_order_relaxed);
+        }
+        m_dependenciesQuery.finish();
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeTaskFiles(int taskId, const QString &primaryFile)
+    {
+        m_filesQuery.bindValue(0, taskId);
+        if (!exec(m_filesQuery)) {
+            return false;
+        }
+
+        bool primaryListed = primaryFile.isEmpty();
+        m_writer->beginArray("files");
+        while (m_filesQuery.next()) {
+            const QString path = m_filesQuery.value(0).toString();
+            primaryListed = primaryListed || path == primaryFile;
+            m_writer->beginObject();
+            m_writer->writeString("path", path);
+            m_writer->writeString("name", m_filesQuery.value(1).toString());
+            m_writer->writeString("created_at", isoDate(m_filesQuery.value(2)));
+            m_writer->endObject();
+            m_processed->fetch_add(1, std::memory_order_relaxed);
+        }
+        m_filesQuery.finish();
+
+        // tasks.file_path 作为附件导出，与旧版格式保持一致
+        if (!primaryListed) {
+            m_writer->beginObject();
+            m_writer->writeString("path", primaryFile);
+            m_writer->writeString("name", QFileInfo(primaryFile).fileName());
+            m_writer->endObject();
+        }
+        m_writer->endArray();
+        return true;
+    }
+
+    bool writeTaskSteps(int taskId)
+    {
+        m_stepsQuery.bindValue(0, taskId);
+        if (!exec(m_stepsQuery)) {
+            return false;
+        }
+
+        m_writer->beginArray("steps");
+        while (m_stepsQuery.next()) {
+            m_writer->beginObject();
+            m_writer->writeInt("id", m_stepsQuery.value(0).toInt());
+            m_writer->writeString("title", m_stepsQuery.value(1).toString());
+            m_writer->writeBool("completed", m_stepsQuery.value(2).toInt() == 1);
+            m_writer->writeInt("position", m_stepsQuery.value(3).toInt());
+            m_writer->writeString("created_at", isoDate(m_stepsQuery.value(4)));
+            m_writer->endObject();
+            m_processed->fetch_add(1, std::memory_order_relaxed);
+        }
+        m_stepsQuery.finish();
+        m_writer->endArray();
+        return true;
+    }
+
+    QSqlQuery *childQuery(int depth)
+    {
+        while (m_childQueries.size() <= depth) {
+            auto *query = new QSqlQuery(m_database);
+            m_childQueries.append(query);
+            if (!prepare(*query, QString("SELECT %1 FROM tasks WHERE parent_id = ? AND id <> parent_id "
+                                         "ORDER BY created_at ASC, id ASC").arg(TaskColumns))) {
+                return nullptr;
+            }
+        }
+        return m_childQueries.at(depth);
+    }
+
+    bool advance()
+    {
+        m_processed->fetch_add(1, std::memory_order_relaxed);
+        if (m_cancelled->load(std::memory_order_relaxed)) {
+            m_error = CancelledError;
+            return false;
+        }
+        if (m_writer->hasError()) {
+            m_error = "Failed to write export file";
+            return false;
+        }
+        return true;
+    }
+
+    bool prepare(QSqlQuery &query, const QString &sql)
+    {
+        query.setForwardOnly(true);
+        if (!query.prepare(sql)) {
+            m_error = query.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    bool exec(QSqlQuery &query, const QString &sql = QString())
+    {
+        if (!(sql.isEmpty() ? query.exec() : query.exec(sql))) {
+            m_error = query.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    QSqlDatabase m_database;
+    JsonStreamWriter *m_writer;
+    std::atomic<int> *m_processed;
+    std::atomic<int> *m_exportedTasks;
+    const std::atomic<bool> *m_cancelled;
+    QSqlQuery m_stepsQuery;
+    QSqlQuery m_dependenciesQuery;
+    QSqlQuery m_tagsQuery;
+    QSqlQuery m_filesQuery;
+    QVector<QSqlQuery *> m_childQueries;
+    QString m_error;
+};
+
+QString writeExport(QSqlDatabase &database, const QString &destination, const QString &version,
+                    const JsonExporter::Options &options, std::atomic<int> *processed, std::atomic<int> *total,
+                    std::atomic<int> *exportedTasks, const std::atomic<bool> *cancelled)
+{
+    QSaveFile file(destination);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return file.errorString();
+    }
+
+    JsonStreamWriter writer(&file);
+    bool ok = true;
+    QString error;
+    {
+        ExportJob job(database, &writer, processed, exportedTasks, cancelled);
+        total->store(qMax(1, job.countRows(options)));
+
+        writer.beginObject();
+        writer.writeString("version", version);
+        writer.writeString("export_date", DateUtils::toIsoString(QDateTime::currentDateTimeUtc()));
+        writer.beginObject("data");
+        ok = (!options.tasks || (job.writeTags() && job.writeTasks()))
+            && (!options.folders || job.writeFolders())
+            && (!options.settings || job.writeSettings())
+            && (!options.notifications || job.writeNotifications());
+        writer.endObject();
+        writer.endObject();
+        error = job.error();
+    }
+
+    if (!ok) {
+        file.cancelWriting();
+        return error.isEmpty() ? QString("Export failed") : error;
+    }
+    if (!writer.flush() || !file.commit()) {
+        return file.errorString();
+    }
+    return QString();
+}
+
+QString runExport(const QString &sourcePath, const QString &destination, const QString &version,
+                  const JsonExporter::Options &options, const QString &connectionName,
+                  std::atomic<int> *processed, std::atomic<int> *total, std::atomic<int> *exportedTasks,
+                  const std::atomic<bool> *cancelled)
+{
+    QString error;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(sourcePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1;QSQLITE_OPEN_READONLY").arg(BackgroundJob::BusyTimeoutMs));
+
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else {
+            // 整个导出在同一个读事务中完成，WAL 模式下得到一致的快照且不阻塞写入
+            database.transaction();
+            error = writeExport(database, destination, version, options, processed, total, exportedTasks, cancelled);
+            database.rollback();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return error;
+}
+} // namespace
+
+JsonExporter::JsonExporter(QObject *parent)
+    : QObject(parent)
+    , m_job(new BackgroundJob(this))
+    , m_processed(0)
+    , m_total(0)
+    , m_exportedTasks(0)
+    , m_cancelRequested(false)
+    , m_lastProcessed(-1)
+{
+    connect(m_job, &BackgroundJob::progressTick, this, &JsonExporter::onPollProgress);
+    connect(m_job, &BackgroundJob::finished, this, &JsonExporter::onThreadFinished);
+}
+
+JsonExporter::~JsonExporter()
+{
+    m_cancelRequested.store(true);
+    m_job->wait();
+}
+
+bool JsonExporter::start(const QString &destination, const Options &options)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    const QString sourcePath = database.databaseName();
+    if (!database.isOpen() || !QFile::exists(sourcePath)) {
+        m_error = "Database is not open";
+        return false;
+    }
+    SettingsStore::instance().flush();
+
+    QString version = QCoreApplication::applicationVersion();
+    if (version.isEmpty()) {
+        version = "1.0.0";
+    }
+
+    m_destination = destination;
+    m_error.clear();
+    m_processed.store(0);
+    m_total.store(0);
+    m_exportedTasks.store(0);
+    m_cancelRequested.store(false);
+    m_lastProcessed = -1;
+
+    const QString connectionName = BackgroundJob::connectionName("json_export");
+    m_job->start([this, sourcePath, destination, version, options, connectionName]() {
+        m_error = runExport(sourcePath, destination, version, options, connectionName,
+                            &m_processed, &m_total, &m_exportedTasks, &m_cancelRequested);
+    });
+    return true;
+}
+
+void JsonExporter::cancel()
+{
+    m_cancelRequested.store(true);
+}
+
+bool JsonExporter::isRunning() const
+{
+    return m_job->isRunning();
+}
+
+void JsonExporter::waitForFinished()
+{
+    m_job->waitForFinished();
+}
+
+QString JsonExporter::destination() const
+{
+    return m_destination;
+}
+
+QString JsonExporter::lastError() const
+{
+    return m_error;
+}
+
+bool JsonExporter::wasCancelled() const
+{
+    return m_error == CancelledError;
+}
+
+int JsonExporter::exportedTasks() const
+{
+    return m_exportedTasks.load();
+}
+
+qint64 JsonExporter::elapsedMs() const
+{
+    return m_job->elapsedMs();
+}
+
+void JsonExporter::onPollProgress()
+{
+    const int total = m_total.load();
+    const int processed = qMin(m_processed.load(), total);
+    if (!isRunning() || total <= 0 || processed == m_lastProcessed) {
+        return;
+    }
+
+    m_lastProcessed = processed;
+    emit progressChanged(processed, total);
+}
+
+void JsonExporter::onThreadFinished()
+{
+    const bool success = m_error.isEmpty();
+    if (success) {
+        const int total = m_total.load();
+        emit progressChanged(total, total);
+    }
+    emit finished(success, m_error);
+}
@@ -0,0 +1,57 @@
+#ifndef JSON_EXPORTER_H
+#define JSON_EXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+class BackgroundJob;
+
+// 在工作线程中用独立只读连接流式导出 JSON：按游标逐行深度优先写出任务树，
+// 内存占用与数据量无关，可随时取消，取消或失败时不留下半成品文件
+class JsonExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        bool tasks = true;
+        bool folders = true;
+        bool settings = true;
+        bool notifications = true;
+    };
+
+    explicit JsonExporter(QObject *parent = nullptr);
+    ~JsonExporter();
+
+    bool start(const QString &destination, const Options &options);
+    void cancel();
+    bool isRunning() const;
+    void waitForFinished();
+
+    QString destination() const;
+    QString lastError() const;
+    bool wasCancelled() const;
+    int exportedTasks() const;
+    qint64 elapsedMs() const;
+
+signals:
+    void progressChanged(int processed, int total);
+    void finished(bool success, const QString &error);
+
+private slots:
+    void onPollProgress();
+    void onThreadFinished();
+
+private:
+    BackgroundJob *m_job;
+    QString m_destination;
+    QString m_error;
+    std::atomic<int> m_processed;
+    std::atomic<int> m_total;
+    std::atomic<int> m_exportedTasks;
+    std::atomic<bool> m_cancelRequested;
+    int m_lastProcessed;
+};
+
+#endif // JSON_EXPORTER_H
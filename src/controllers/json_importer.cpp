@@ -0,0 +1,1897 @@
+#include "json_importer.h"
+#include "database.h"
+#include "batch_insert.h"
+#include "settings_store.h"
+#include "background_job.h"
+#include "../utils/date_utils.h"
+#include "../utils/json_stream_reader.h"
+#include "../utils/logger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QVariant>
+
+namespace {
+// 暂存阶段每写入这么多任务提交一次检查点；段越大吞吐越高，取消时重做的也越多
+constexpr int CheckpointTaskCount = 5000;
+// 发布阶段每写这么多任务更新一次进度并检查取消
+constexpr int PublishProgressInterval = 1000;
+const char *CancelledError = "Import cancelled";
+
+// 解析结果先写入数据目录下单独的暂存库，按检查点提交，取消或中断后可以续传；
+// 全部解析完成后再在主库的一个事务里整体写入，失败或取消时主库保持不变
+const char *StagingFileName = "json_import.db";
+const char *StagingSchema = "import_stage";
+const char *StagingTableStatements[] = {
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_state (key TEXT PRIMARY KEY, value TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_tags (seq INTEGER PRIMARY KEY, original_id INTEGER, "
+    "name TEXT NOT NULL, color TEXT, created_at TEXT)",
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_folders (seq INTEGER PRIMARY KEY, original_id INTEGER, "
+    "name TEXT NOT NULL, color TEXT, position INTEGER, created_at TEXT)",
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_folder_tasks (folder_seq INTEGER NOT NULL, "
+    "task_id INTEGER NOT NULL)",
+    "CREATE INDEX IF NOT EXISTS import_stage.idx_json_import_folder_tasks ON json_import_folder_tasks(folder_seq)",
+    // seq 按任务在文件中出现的先后分配，last_seq 是其最后一个后代的 seq，发布时按 seq 顺序即可先父后子
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_tasks (seq INTEGER PRIMARY KEY, parent_seq INTEGER NOT NULL, "
+    "last_seq INTEGER NOT NULL, original_id INTEGER NOT NULL, has_id INTEGER NOT NULL, parent_original_id INTEGER NOT NULL, "
+    "title TEXT, description TEXT, file_path TEXT, priority INTEGER, due_date TEXT, completed INTEGER, progress INTEGER, "
+    "is_deleted INTEGER, deleted_at TEXT, created_at TEXT, updated_at TEXT, relations BLOB)",
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_settings (seq INTEGER PRIMARY KEY, key TEXT NOT NULL, "
+    "value TEXT, updated_at TEXT)",
+    "CREATE TABLE IF NOT EXISTS import_stage.json_import_notifications (seq INTEGER PRIMARY KEY, original_id INTEGER, "
+    "type INTEGER, title TEXT, message TEXT, task_id INTEGER, read INTEGER, created_at TEXT)"
+};
+// 发布时的 ID 映射和待解析引用只在这次事务里用到，放在连接自己的临时库中
+const char *PublishTableStatements[] = {
+    "CREATE TEMP TABLE IF NOT EXISTS json_import_task_map (original_id INTEGER PRIMARY KEY, final_id INTEGER NOT NULL, "
+    "update_relations INTEGER NOT NULL)",
+    "CREATE TEMP TABLE IF NOT EXISTS json_import_links (kind INTEGER NOT NULL, owner_id INTEGER NOT NULL, "
+    "target_id INTEGER NOT NULL)"
+};
+// 早期版本把暂存表建在主库里，发布时顺便清掉
+const char *LegacyStagingTables[] = {
+    "json_import_state", "json_import_task_map", "json_import_tag_map", "json_import_links", "json_import_notifications"
+};
+const char *Sections[] = {"tags", "tasks", "folders", "settings", "notifications"};
+
+enum LinkKind {
+    DependencyLink = 1,
+    FolderLink = 2
+};
+
+struct ResumeKey {
+    QString source;
+    qint64 size = 0;
+    qint64 modified = 0;
+
+    static ResumeKey forFile(const QString &path)
+    {
+        const QFileInfo info(path);
+        ResumeKey key;
+        key.source = info.absoluteFilePath();
+        key.size = info.size();
+        key.modified = info.lastModified().toMSecsSinceEpoch();
+        return key;
+    }
+};
+
+QString stagingPath(const QString &databasePath)
+{
+    return QFileInfo(databasePath).absoluteDir().filePath(StagingFileName);
+}
+
+void removeStaging(const QString &databasePath)
+{
+    const QString path = stagingPath(databasePath);
+    QFile::remove(path);
+    QFile::remove(path + "-journal");
+}
+
+bool attachStaging(QSqlDatabase &database, const QString &path, QString *error)
+{
+    QSqlQuery query(database);
+    query.prepare(QString("ATTACH DATABASE ? AS %1").arg(StagingSchema));
+    query.addBindValue(path);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QHash<QString, QString> loadState(QSqlDatabase &database, const QString &schema)
+{
+    QHash<QString, QString> state;
+    QSqlQuery query(database);
+    if (query.exec(QString("SELECT key, value FROM %1.json_import_state").arg(schema))) {
+        while (query.next()) {
+            state.insert(query.value(0).toString(), query.value(1).toString());
+        }
+    }
+    return state;
+}
+
+struct StepItem {
+    QString title;
+    bool completed = false;
+    int position = 0;
+};
+
+struct FileItem {
+    QString path;
+    QString name;
+};
+
+struct StagedTask {
+    int seq = 0;
+    int parentSeq = 0;
+    int originalId = -1;
+    int parentOriginalId = 0;
+    QString title;
+    QString description;
+    int priority = 1;
+    QDateTime dueDate;
+    bool completed = false;
+    int progress = 0;
+    bool isDeleted = false;
+    QDateTime deletedAt;
+    QDateTime createdAt;
+    QDateTime updatedAt;
+    QString primaryFile;
+    bool hasId = false;
+    bool hasTitle = false;
+    bool hasTagNames = false;
+    QStringList tagNames;
+    QVector<int> tagIds;
+    QVector<int> dependencyIds;
+    QVector<FileItem> files;
+    QVector<StepItem> steps;
+};
+
+// 任务的标签、依赖、附件和步骤在暂存表里存成一个字段，发布时原样取回
+QByteArray encodeRelations(const StagedTask &task)
+{
+    if (!task.hasTagNames && task.tagIds.isEmpty() && task.dependencyIds.isEmpty() && task.files.isEmpty()
+        && task.steps.isEmpty()) {
+        return QByteArray();
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << task.hasTagNames << task.tagNames << task.tagIds << task.dependencyIds;
+    out << static_cast<qint32>(task.files.size());
+    for (const FileItem &file : task.files) {
+        out << file.path << file.name;
+    }
+    out << static_cast<qint32>(task.steps.size());
+    for (const StepItem &step : task.steps) {
+        out << step.title << step.completed << static_cast<qint32>(step.position);
+    }
+    return data;
+}
+
+bool decodeRelations(const QByteArray &data, StagedTask *task)
+{
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_15);
+    qint32 count = 0;
+    in >> task->hasTagNames >> task->tagNames >> task->tagIds >> task->dependencyIds >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        FileItem file;
+        in >> file.path >> file.name;
+        task->files.append(file);
+    }
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        StepItem step;
+        qint32 position = 0;
+        in >> step.title >> step.completed >> position;
+        step.position = position;
+        task->steps.append(step);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// 一次导入分两个阶段：stage() 流式解析并校验，写入暂存库；publish() 把暂存的内容写入主库
+class ImportJob
+{
+public:
+    ImportJob(QSqlDatabase database, const JsonImporter::Options &options, qint64 sourceSize,
+              std::atomic<qint64> *progress, const std::atomic<bool> *cancelled)
+        : m_database(database)
+        , m_options(options)
+        , m_sourceSize(sourceSize)
+        , m_progress(progress)
+        , m_cancelled(cancelled)
+        , m_reader(nullptr)
+        , m_dataError(false)
+        , m_hasFolderData(false)
+        , m_nextTaskSeq(1)
+        , m_pendingTasks(0)
+        , m_runTasks(0)
+        , m_stageTagQuery(database)
+        , m_stageFolderQuery(database)
+        , m_stageSettingQuery(database)
+        , m_stateQuery(database)
+        , m_taskExistsQuery(database)
+        , m_insertTaskQuery(database)
+        , m_insertTaskWithIdQuery(database)
+        , m_updateTaskQuery(database)
+        , m_clearTagsQuery(database)
+        , m_clearDependenciesQuery(database)
+        , m_clearFilesQuery(database)
+        , m_clearStepsQuery(database)
+        , m_mapLookupQuery(database)
+        , m_insertTagQuery(database)
+        , m_updateTagQuery(database)
+        , m_insertFolderQuery(database)
+        , m_updateFolderQuery(database)
+        , m_folderLinksQuery(database)
+        , m_settingQuery(database)
+        , m_stagedTasks(database, "INSERT INTO import_stage.json_import_tasks (seq, parent_seq, last_seq, original_id, "
+                                  "has_id, parent_original_id, title, description, file_path, priority, due_date, "
+                                  "completed, progress, is_deleted, deleted_at, created_at, updated_at, relations)", 18)
+        , m_folderTasks(database, "INSERT INTO import_stage.json_import_folder_tasks (folder_seq, task_id)", 2)
+        , m_notifications(database, "INSERT INTO import_stage.json_import_notifications "
+                                    "(original_id, type, title, message, task_id, read, created_at)", 7)
+        , m_steps(database, "INSERT INTO task_steps (task_id, title, completed, position, created_at)", 5)
+        , m_files(database, "INSERT INTO task_files (task_id, file_path, file_name, created_at)", 4)
+        , m_taskTags(database, "INSERT OR IGNORE INTO task_tags (task_id, tag_id)", 2)
+        , m_taskMap(database, "INSERT OR REPLACE INTO temp.json_import_task_map (original_id, final_id, update_relations)", 3)
+        , m_links(database, "INSERT INTO temp.json_import_links (kind, owner_id, target_id)", 3)
+    {
+        m_now = QDateTime::currentDateTime().toString(Qt::ISODate);
+    }
+
+    bool run(QIODevice *device, const ResumeKey &key, bool resume)
+    {
+        if (!prepareStage() || !initState(key, resume)) {
+            return false;
+        }
+        if (!m_staged && !stage(device)) {
+            return false;
+        }
+        return publish();
+    }
+
+    void rollback()
+    {
+        QSqlQuery query(m_database);
+        query.exec("ROLLBACK");
+    }
+
+    JsonImporter::Summary summary() const
+    {
+        return m_summary;
+    }
+
+    int runTasks() const
+    {
+        return m_runTasks;
+    }
+
+    QString error() const
+    {
+        return m_error;
+    }
+
+    // 文件本身有问题，续传也会在同一处失败
+    bool dataError() const
+    {
+        return m_dataError;
+    }
+
+private:
+    bool prepareStage()
+    {
+        if (!exec("BEGIN")) {
+            return false;
+        }
+        for (const char *statement : StagingTableStatements) {
+            if (!exec(statement)) {
+                return false;
+            }
+        }
+        return prepare(m_stageTagQuery, "INSERT INTO import_stage.json_import_tags (original_id, name, color, created_at) "
+                                        "VALUES (?, ?, ?, ?)")
+            && prepare(m_stageFolderQuery, "INSERT INTO import_stage.json_import_folders "
+                                           "(original_id, name, color, position, created_at) VALUES (?, ?, ?, ?, ?)")
+            && prepare(m_stageSettingQuery, "INSERT INTO import_stage.json_import_settings (key, value, updated_at) "
+                                            "VALUES (?, ?, ?)")
+            && prepare(m_stateQuery, "INSERT OR REPLACE INTO import_stage.json_import_state (key, value) VALUES (?, ?)");
+    }
+
+    bool initState(const ResumeKey &key, bool resume)
+    {
+        if (resume) {
+            const QHash<QString, QString> state = loadState(m_database, StagingSchema);
+            if (state.value("source") != key.source || state.value("size").toLongLong() != key.size
+                || state.value("modified").toLongLong() != key.modified) {
+                m_error = "Resume state does not match the source file";
+                return false;
+            }
+            for (const char *section : Sections) {
+                m_sectionDone.insert(section, state.value(QString("done_%1").arg(section)).toInt());
+            }
+            m_hasFolderData = state.value("has_folders") == "1";
+            m_staged = state.value("staged") == "1";
+
+            QSqlQuery query(m_database);
+            if (!exec(query, "SELECT COALESCE(MAX(seq), 0) FROM import_stage.json_import_tasks") || !query.next()) {
+                return false;
+            }
+            m_nextTaskSeq = query.value(0).toInt() + 1;
+            query.finish();
+            return exec("COMMIT");
+        }
+
+        m_staged = false;
+        return writeState("source", key.source)
+            && writeState("size", QString::number(key.size))
+            && writeState("modified", QString::number(key.modified))
+            && writeState("mode", QString::number(m_options.mode))
+            && writeState("conflict", QString::number(m_options.conflict))
+            && exec("COMMIT");
+    }
+
+    // 暂存阶段只写暂存库；普通 BEGIN 不会去拿主库的写锁
+    bool stage(QIODevice *device)
+    {
+        if (!exec("BEGIN")) {
+            return false;
+        }
+
+        JsonStreamReader reader(device);
+        m_reader = &reader;
+        const bool ok = parseDocument(reader) && flushStaging() && saveProgress() && writeState("staged", "1")
+            && exec("COMMIT");
+        m_reader = nullptr;
+        return ok;
+    }
+
+    bool publish()
+    {
+        m_progress->store(m_sourceSize, std::memory_order_relaxed);
+        if (!exec("BEGIN IMMEDIATE")) {
+            return false;
+        }
+        for (const char *statement : PublishTableStatements) {
+            if (!exec(statement)) {
+                return false;
+            }
+        }
+        if (!preparePublish()) {
+            return false;
+        }
+        // 逐行写变更日志对几十万条任务毫无意义，视图收到一条重置后整体重新加载
+        if (!Database::suspendChangeLog(m_database, &m_error)) {
+            return false;
+        }
+
+        // 覆盖模式与其余写入在同一个事务中，失败或取消时原有数据保持不变
+        if (m_options.mode == JsonImporter::Options::Overwrite && !clearAllData()) {
+            return false;
+        }
+        if (!loadCaches() || !publishTags() || !publishFolders() || !publishTasks() || !publishSettings()
+            || !finalize()) {
+            return false;
+        }
+
+        for (const char *table : LegacyStagingTables) {
+            if (!exec(QString("DROP TABLE IF EXISTS main.%1").arg(table))) {
+                return false;
+            }
+        }
+        return Database::resumeChangeLog(m_database, &m_error) && exec("COMMIT");
+    }
+
+    bool preparePublish()
+    {
+        const QString taskColumns = "title, description, file_path, priority, due_date, completed, progress, "
+                                    "parent_id, is_deleted, deleted_at, created_at, updated_at";
+        return prepare(m_taskExistsQuery, "SELECT 1 FROM main.tasks WHERE id = ?")
+            && prepare(m_insertTaskQuery, QString("INSERT INTO main.tasks (%1) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)")
+                                              .arg(taskColumns))
+            && prepare(m_insertTaskWithIdQuery, QString("INSERT INTO main.tasks (%1, id) "
+                                                        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)")
+                                                    .arg(taskColumns))
+            && prepare(m_updateTaskQuery, "UPDATE main.tasks SET title = ?, description = ?, file_path = ?, priority = ?, "
+                                          "due_date = ?, completed = ?, progress = ?, parent_id = ?, is_deleted = ?, "
+                                          "deleted_at = ?, updated_at = ? WHERE id = ?")
+            && prepare(m_clearTagsQuery, "DELETE FROM main.task_tags WHERE task_id = ?")
+            && prepare(m_clearDependenciesQuery, "DELETE FROM main.task_dependencies WHERE task_id = ?")
+            && prepare(m_clearFilesQuery, "DELETE FROM main.task_files WHERE task_id = ?")
+            && prepare(m_clearStepsQuery, "DELETE FROM main.task_steps WHERE task_id = ?")
+            && prepare(m_mapLookupQuery, "SELECT final_id FROM temp.json_import_task_map WHERE original_id = ?")
+            && prepare(m_insertTagQuery, "INSERT INTO main.tags (name, color, created_at) VALUES (?, ?, ?)")
+            && prepare(m_updateTagQuery, "UPDATE main.tags SET color = ? WHERE id = ?")
+            && prepare(m_insertFolderQuery, "INSERT INTO main.folders (name, color, position, created_at) VALUES (?, ?, ?, ?)")
+            && prepare(m_updateFolderQuery, "UPDATE main.folders SET color = ?, position = ? WHERE id = ?")
+            && prepare(m_folderLinksQuery, QString("INSERT INTO temp.json_import_links (kind, owner_id, target_id) "
+                                                   "SELECT %1, ?, task_id FROM import_stage.json_import_folder_tasks "
+                                                   "WHERE folder_seq = ?").arg(FolderLink))
+            && prepare(m_settingQuery, "INSERT OR REPLACE INTO main.settings (key, value, updated_at) VALUES (?, ?, ?)");
+    }
+
+    bool loadCaches()
+    {
+        // 标签和文件夹数量很少，按名称匹配时直接查内存
+        QSqlQuery query(m_database);
+        if (!exec(query, "SELECT id, name FROM main.tags")) {
+            return false;
+        }
+        while (query.next()) {
+            m_tagIds.insert(query.value(1).toString(), query.value(0).toInt());
+        }
+        if (!exec(query, "SELECT id, name FROM main.folders")) {
+            return false;
+        }
+        while (query.next()) {
+            m_folderIds.insert(query.value(1).toString(), query.value(0).toInt());
+        }
+        return true;
+    }
+
+    bool clearAllData()
+    {
+        const QStringList tables = {
+            "task_tags", "task_dependencies", "task_files", "task_steps", "task_folders",
+            "notifications", "tasks", "folders", "tags", "settings", "backup_history"
+        };
+        for (const QString &table : tables) {
+            if (!exec(QString("DELETE FROM main.%1").arg(table))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseDocument(JsonStreamReader &reader)
+    {
+        if (reader.next() != JsonStreamReader::BeginObject) {
+            return reader.hasError() ? syntaxError(reader) : invalid("JSON 根节点必须为对象");
+        }
+
+        bool hasVersion = false;
+        bool hasExportDate = false;
+        bool hasData = false;
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray key = reader.utf8Text();
+            if (key == "version" || key == "export_date") {
+                if (reader.next() != JsonStreamReader::String) {
+                    return reader.hasError() ? syntaxError(reader)
+                                             : invalid(QString("%1 字段缺失或格式不正确").arg(QString::fromUtf8(key)));
+                }
+                (key == "version" ? hasVersion : hasExportDate) = true;
+            } else if (key == "data") {
+                if (reader.next() != JsonStreamReader::BeginObject) {
+                    return reader.hasError() ? syntaxError(reader) : invalid("data 字段缺失或格式不正确");
+                }
+                if (!parseData(reader)) {
+                    return false;
+                }
+                hasData = true;
+            } else if (!reader.skipCurrent()) {
+                return syntaxError(reader);
+            }
+        }
+
+        if (reader.token() != JsonStreamReader::EndObject || reader.next() != JsonStreamReader::EndOfDocument) {
+            return syntaxError(reader);
+        }
+        if (!hasVersion) {
+            return invalid("version 字段缺失或格式不正确");
+        }
+        if (!hasExportDate) {
+            return invalid("export_date 字段缺失或格式不正确");
+        }
+        if (!hasData) {
+            return invalid("data 字段缺失或格式不正确");
+        }
+        return true;
+    }
+
+    bool parseData(JsonStreamReader &reader)
+    {
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray section = reader.utf8Text();
+            bool known = false;
+            for (const char *name : Sections) {
+                known = known || section == name;
+            }
+            if (!known) {
+                if (!reader.skipCurrent()) {
+                    return syntaxError(reader);
+                }
+                continue;
+            }
+
+            if (reader.next() != JsonStreamReader::BeginArray) {
+                if (reader.hasError()) {
+                    return syntaxError(reader);
+                }
+                return invalid(section == "tasks" ? QString("tasks 字段必须为数组")
+                                                  : QString("字段 %1 必须为数组").arg(QString::fromUtf8(section)));
+            }
+            if (section == "folders" && !m_hasFolderData) {
+                m_hasFolderData = true;
+            }
+            if (!parseSection(reader, QString::fromUtf8(section))) {
+                return false;
+            }
+        }
+
+        return reader.token() == JsonStreamReader::EndObject || syntaxError(reader);
+    }
+
+    bool parseSection(JsonStreamReader &reader, const QString &section)
+    {
+        // 续传时跳过上次已经暂存的条目
+        const int committed = m_sectionDone.value(section);
+        int index = 0;
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.hasError()) {
+                return syntaxError(reader);
+            }
+            if (index < committed) {
+                if (!reader.skipCurrent()) {
+                    return syntaxError(reader);
+                }
+                ++index;
+                continue;
+            }
+
+            bool ok = true;
+            if (section == "tasks") {
+                if (reader.token() != JsonStreamReader::BeginObject) {
+                    return invalid("tasks 数组项必须为对象");
+                }
+                ok = parseTask(reader, 0);
+            } else if (reader.token() != JsonStreamReader::BeginObject) {
+                // 与旧版导入一致，其他数组中的非对象项直接忽略
+                ok = reader.skipCurrent() || syntaxError(reader);
+            } else if (section == "tags") {
+                ok = parseTag(reader);
+            } else if (section == "folders") {
+                ok = parseFolder(reader);
+            } else if (section == "settings") {
+                ok = parseSetting(reader);
+            } else {
+                ok = parseNotification(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+
+            m_sectionDone.insert(section, ++index);
+            m_progress->store(reader.offset(), std::memory_order_relaxed);
+            if (m_cancelled->load(std::memory_order_relaxed)) {
+                m_error = CancelledError;
+                return false;
+            }
+            if (m_pendingTasks >= CheckpointTaskCount && !checkpoint()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseTag(JsonStreamReader &reader)
+    {
+        int originalId = -1;
+        QString name;
+        QString color;
+        QDateTime createdAt;
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray key = reader.utf8Text();
+            bool ok = true;
+            if (key == "id") {
+                ok = readInt(reader, &originalId);
+            } else if (key == "name") {
+                ok = readString(reader, &name);
+            } else if (key == "color") {
+                ok = readString(reader, &color);
+            } else if (key == "created_at") {
+                ok = readLenientDate(reader, &createdAt);
+            } else {
+                ok = reader.skipCurrent() || syntaxError(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndObject) {
+            return syntaxError(reader);
+        }
+
+        name = name.trimmed();
+        if (name.isEmpty()) {
+            return true;
+        }
+        m_stageTagQuery.bindValue(0, originalId);
+        m_stageTagQuery.bindValue(1, name);
+        m_stageTagQuery.bindValue(2, color);
+        m_stageTagQuery.bindValue(3, DateUtils::toIsoString(createdAt));
+        return exec(m_stageTagQuery);
+    }
+
+    bool parseFolder(JsonStreamReader &reader)
+    {
+        int originalId = -1;
+        int position = 0;
+        QString name;
+        QString color;
+        QDateTime createdAt;
+        QVector<int> taskIds;
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray key = reader.utf8Text();
+            bool ok = true;
+            if (key == "id") {
+                ok = readInt(reader, &originalId);
+            } else if (key == "name") {
+                ok = readString(reader, &name);
+            } else if (key == "color") {
+                ok = readString(reader, &color);
+            } else if (key == "position") {
+                ok = readInt(reader, &position);
+            } else if (key == "created_at") {
+                ok = readLenientDate(reader, &createdAt);
+            } else if (key == "task_ids") {
+                ok = readLenientIds(reader, &taskIds);
+            } else {
+                ok = reader.skipCurrent() || syntaxError(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndObject) {
+            return syntaxError(reader);
+        }
+
+        name = name.trimmed();
+        if (name.isEmpty()) {
+            return true;
+        }
+        m_stageFolderQuery.bindValue(0, originalId);
+        m_stageFolderQuery.bindValue(1, name);
+        m_stageFolderQuery.bindValue(2, color);
+        m_stageFolderQuery.bindValue(3, position);
+        m_stageFolderQuery.bindValue(4, DateUtils::toIsoString(createdAt));
+        if (!exec(m_stageFolderQuery)) {
+            return false;
+        }
+
+        // 文件夹引用的任务可能还没导入，发布时统一解析
+        if (originalId > 0) {
+            const int folderSeq = m_stageFolderQuery.lastInsertId().toInt();
+            for (int taskId : taskIds) {
+                if (!batch(m_folderTasks, {folderSeq, taskId})) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool parseSetting(JsonStreamReader &reader)
+    {
+        QString key;
+        QString value;
+        QDateTime updatedAt;
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray name = reader.utf8Text();
+            bool ok = true;
+            if (name == "key") {
+                ok = readString(reader, &key);
+            } else if (name == "value") {
+                ok = readString(reader, &value);
+            } else if (name == "updated_at") {
+                ok = readLenientDate(reader, &updatedAt);
+            } else {
+                ok = reader.skipCurrent() || syntaxError(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndObject) {
+            return syntaxError(reader);
+        }
+
+        if (key.trimmed().isEmpty() || m_options.mode == JsonImporter::Options::Append) {
+            return true;
+        }
+        m_stageSettingQuery.bindValue(0, key);
+        m_stageSettingQuery.bindValue(1, value);
+        m_stageSettingQuery.bindValue(2, DateUtils::toIsoString(updatedAt));
+        return exec(m_stageSettingQuery);
+    }
+
+    bool parseNotification(JsonStreamReader &reader)
+    {
+        int originalId = -1;
+        int type = 0;
+        int taskId = 0;
+        bool read = false;
+        QString title;
+        QString message;
+        QDateTime createdAt;
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray key = reader.utf8Text();
+            bool ok = true;
+            if (key == "id") {
+                ok = readInt(reader, &originalId);
+            } else if (key == "type") {
+                ok = readInt(reader, &type);
+            } else if (key == "title") {
+                ok = readString(reader, &title);
+            } else if (key == "message") {
+                ok = readString(reader, &message);
+            } else if (key == "task_id") {
+                ok = readInt(reader, &taskId);
+            } else if (key == "read") {
+                ok = readBool(reader, &read);
+            } else if (key == "created_at") {
+                ok = readLenientDate(reader, &createdAt);
+            } else {
+                ok = reader.skipCurrent() || syntaxError(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndObject) {
+            return syntaxError(reader);
+        }
+
+        if (m_options.mode == JsonImporter::Options::Append) {
+            return true;
+        }
+        const QString created = DateUtils::toIsoString(createdAt.isValid() ? createdAt : QDateTime::currentDateTimeUtc());
+        return batch(m_notifications, {originalId, type, title, message, taskId, read ? 1 : 0, created});
+    }
+
+    // parentSeq 为 0 表示根任务，父任务取自 parent_id 字段；否则为父任务的暂存序号
+    bool parseTask(JsonStreamReader &reader, int parentSeq)
+    {
+        if (m_cancelled->load(std::memory_order_relaxed)) {
+            m_error = CancelledError;
+            return false;
+        }
+        m_progress->store(reader.offset(), std::memory_order_relaxed);
+
+        // 序号在读到对象开头时就分配，子任务不必等父任务的字段读完，任意字段顺序都不需要缓存子树
+        StagedTask task;
+        task.seq = m_nextTaskSeq++;
+        task.parentSeq = parentSeq;
+        bool hasChildren = false;
+
+        while (reader.next() == JsonStreamReader::Name) {
+            const QByteArray key = reader.utf8Text();
+            bool ok = true;
+            if (key == "id") {
+                if (reader.next() != JsonStreamReader::Number) {
+                    return reader.hasError() ? syntaxError(reader) : invalid("任务ID必须为数字");
+                }
+                task.originalId = static_cast<int>(reader.number());
+                task.hasId = true;
+            } else if (key == "title") {
+                if (reader.next() != JsonStreamReader::String) {
+                    return reader.hasError() ? syntaxError(reader) : invalid("任务标题缺失或格式不正确");
+                }
+                task.title = reader.text();
+                task.hasTitle = true;
+            } else if (key == "description") {
+                ok = readString(reader, &task.description);
+            } else if (key == "priority") {
+                ok = readInt(reader, &task.priority);
+            } else if (key == "completed") {
+                ok = readBool(reader, &task.completed);
+            } else if (key == "progress") {
+                ok = readInt(reader, &task.progress);
+            } else if (key == "is_deleted") {
+                ok = readBool(reader, &task.isDeleted);
+            } else if (key == "parent_id") {
+                ok = readInt(reader, &task.parentOriginalId);
+            } else if (key == "due_date") {
+                QString raw;
+                ok = readDate(reader, "due_date", &task.dueDate, &raw);
+                if (ok && !raw.trimmed().isEmpty() && !task.dueDate.isValid()) {
+                    return invalid("任务日期格式不正确");
+                }
+            } else if (key == "created_at") {
+                ok = readDate(reader, "created_at", &task.createdAt);
+            } else if (key == "updated_at") {
+                ok = readDate(reader, "updated_at", &task.updatedAt);
+            } else if (key == "deleted_at") {
+                ok = readDate(reader, "deleted_at", &task.deletedAt);
+            } else if (key == "tags") {
+                ok = readTagNames(reader, &task.tagNames);
+                task.hasTagNames = true;
+            } else if (key == "tag_ids") {
+                ok = readLenientIds(reader, &task.tagIds);
+            } else if (key == "dependencies") {
+                ok = readDependencies(reader, &task.dependencyIds);
+            } else if (key == "files") {
+                ok = readFiles(reader, &task);
+            } else if (key == "steps") {
+                ok = readSteps(reader, &task.steps);
+            } else if (key == "children") {
+                if (reader.next() != JsonStreamReader::BeginArray) {
+                    return reader.hasError() ? syntaxError(reader) : invalid("children 字段必须为数组");
+                }
+                if (task.hasId && task.originalId <= 0) {
+                    return invalid("包含子任务的任务必须提供 ID");
+                }
+                hasChildren = true;
+                ok = parseChildren(reader, task.seq);
+            } else {
+                ok = reader.skipCurrent() || syntaxError(reader);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndObject) {
+            return syntaxError(reader);
+        }
+        if (!task.hasTitle) {
+            return invalid("任务标题缺失或格式不正确");
+        }
+        if (hasChildren && task.originalId <= 0) {
+            return invalid("包含子任务的任务必须提供 ID");
+        }
+
+        ++m_pendingTasks;
+        return batch(m_stagedTasks, {
+            task.seq, task.parentSeq, m_nextTaskSeq - 1, task.originalId, task.hasId ? 1 : 0, task.parentOriginalId,
+            task.title, task.description, task.primaryFile, task.priority, DateUtils::toIsoString(task.dueDate),
+            task.completed ? 1 : 0, task.progress, task.isDeleted ? 1 : 0, DateUtils::toIsoString(task.deletedAt),
+            DateUtils::toIsoString(task.createdAt), DateUtils::toIsoString(task.updatedAt), encodeRelations(task)
+        });
+    }
+
+    bool parseChildren(JsonStreamReader &reader, int parentSeq)
+    {
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.hasError()) {
+                return syntaxError(reader);
+            }
+            if (reader.token() != JsonStreamReader::BeginObject) {
+                return invalid("children 数组项必须为对象");
+            }
+            if (!parseTask(reader, parentSeq)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool flushStaging()
+    {
+        for (BatchInsert *insert : {&m_stagedTasks, &m_folderTasks, &m_notifications}) {
+            if (!insert->flush()) {
+                m_error = insert->error();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool saveProgress()
+    {
+        for (const char *section : Sections) {
+            if (!writeState(QString("done_%1").arg(section), QString::number(m_sectionDone.value(section)))) {
+                return false;
+            }
+        }
+        return writeState("has_folders", m_hasFolderData ? "1" : "0");
+    }
+
+    // 进度和暂存数据在同一个事务里提交，续传时跳过的条目一定已经落盘
+    bool checkpoint()
+    {
+        if (!flushStaging() || !saveProgress() || !exec("COMMIT") || !exec("BEGIN")) {
+            return false;
+        }
+        m_pendingTasks = 0;
+        return true;
+    }
+
+    bool publishTags()
+    {
+        QSqlQuery staged(m_database);
+        staged.setForwardOnly(true);
+        if (!exec(staged, "SELECT original_id, name, color, created_at FROM import_stage.json_import_tags ORDER BY seq")) {
+            return false;
+        }
+
+        while (staged.next()) {
+            const int originalId = staged.value(0).toInt();
+            const QString name = staged.value(1).toString();
+            const QString color = staged.value(2).toString();
+            const QString created = staged.value(3).toString();
+            if (originalId > 0) {
+                m_tagNames.insert(originalId, name);
+            }
+
+            const QString tagColor = color.isEmpty() ? QString("#3B82F6") : color;
+            auto existing = m_tagIds.constFind(name);
+            if (existing != m_tagIds.constEnd()) {
+                if (m_options.mode != JsonImporter::Options::Append
+                    && m_options.conflict == JsonImporter::Options::OverwriteConflict) {
+                    m_updateTagQuery.bindValue(0, tagColor);
+                    m_updateTagQuery.bindValue(1, existing.value());
+                    if (!exec(m_updateTagQuery)) {
+                        return false;
+                    }
+                }
+            } else {
+                m_insertTagQuery.bindValue(0, name);
+                m_insertTagQuery.bindValue(1, tagColor);
+                m_insertTagQuery.bindValue(2, created.isEmpty() ? DateUtils::toIsoString(QDateTime::currentDateTimeUtc()) : created);
+                if (!exec(m_insertTagQuery)) {
+                    return false;
+                }
+                m_tagIds.insert(name, m_insertTagQuery.lastInsertId().toInt());
+            }
+            ++m_summary.tags;
+        }
+        return true;
+    }
+
+    bool publishFolders()
+    {
+        QSqlQuery staged(m_database);
+        staged.setForwardOnly(true);
+        if (!exec(staged, "SELECT seq, original_id, name, color, position, created_at "
+                          "FROM import_stage.json_import_folders ORDER BY seq")) {
+            return false;
+        }
+
+        while (staged.next()) {
+            const int folderSeq = staged.value(0).toInt();
+            const int originalId = staged.value(1).toInt();
+            const QString name = staged.value(2).toString();
+            const QString color = staged.value(3).toString();
+            const int position = staged.value(4).toInt();
+            const QString createdAt = staged.value(5).toString();
+
+            const QString folderColor = color.isEmpty() ? QString("#64748B") : color;
+            const QString created = createdAt.isEmpty() ? DateUtils::toIsoString(QDateTime::currentDateTimeUtc()) : createdAt;
+            auto insertFolder = [&](const QString &folderName) -> int {
+                m_insertFolderQuery.bindValue(0, folderName);
+                m_insertFolderQuery.bindValue(1, folderColor);
+                m_insertFolderQuery.bindValue(2, position);
+                m_insertFolderQuery.bindValue(3, created);
+                if (!exec(m_insertFolderQuery)) {
+                    return -1;
+                }
+                const int id = m_insertFolderQuery.lastInsertId().toInt();
+                m_folderIds.insert(folderName, id);
+                return id;
+            };
+
+            int actualId = m_folderIds.value(name, -1);
+            if (actualId < 0) {
+                actualId = insertFolder(name);
+                if (actualId < 0) {
+                    return false;
+                }
+            } else if (m_options.mode != JsonImporter::Options::Append
+                       && m_options.conflict == JsonImporter::Options::OverwriteConflict) {
+                m_updateFolderQuery.bindValue(0, folderColor);
+                m_updateFolderQuery.bindValue(1, position);
+                m_updateFolderQuery.bindValue(2, actualId);
+                if (!exec(m_updateFolderQuery)) {
+                    return false;
+                }
+            } else if (m_options.conflict == JsonImporter::Options::Regenerate) {
+                const QString baseName = name + " (imported)";
+                QString newName = baseName;
+                int counter = 1;
+                while (m_folderIds.contains(newName)) {
+                    newName = QString("%1 %2").arg(baseName).arg(counter++);
+                }
+                actualId = insertFolder(newName);
+                if (actualId < 0) {
+                    return false;
+                }
+            }
+
+            if (originalId > 0 && actualId > 0) {
+                m_folderLinksQuery.bindValue(0, actualId);
+                m_folderLinksQuery.bindValue(1, folderSeq);
+                if (!exec(m_folderLinksQuery)) {
+                    return false;
+                }
+            }
+            ++m_summary.folders;
+        }
+        return true;
+    }
+
+    struct Ancestor {
+        int seq;
+        int lastSeq;
+        int finalId;
+    };
+
+    bool publishTasks()
+    {
+        QSqlQuery count(m_database);
+        if (!exec(count, "SELECT COUNT(*) FROM import_stage.json_import_tasks") || !count.next()) {
+            return false;
+        }
+        const qint64 total = qMax<qint64>(1, count.value(0).toLongLong());
+        count.finish();
+
+        QSqlQuery staged(m_database);
+        staged.setForwardOnly(true);
+        if (!exec(staged, "SELECT seq, parent_seq, last_seq, original_id, has_id, parent_original_id, title, description, "
+                          "file_path, priority, due_date, completed, progress, is_deleted, deleted_at, created_at, "
+                          "updated_at, relations FROM import_stage.json_import_tasks ORDER BY seq")) {
+            return false;
+        }
+
+        // 按 seq 顺序是先序遍历，栈里只保留当前任务的祖先，深度之外不占内存
+        QVector<Ancestor> ancestors;
+        qint64 done = 0;
+        while (staged.next()) {
+            StagedTask task;
+            task.seq = staged.value(0).toInt();
+            task.parentSeq = staged.value(1).toInt();
+            const int lastSeq = staged.value(2).toInt();
+            task.originalId = staged.value(3).toInt();
+            task.hasId = staged.value(4).toInt() == 1;
+            task.parentOriginalId = staged.value(5).toInt();
+            task.title = staged.value(6).toString();
+            task.description = staged.value(7).toString();
+            task.primaryFile = staged.value(8).toString();
+            task.priority = staged.value(9).toInt();
+            task.dueDate = DateUtils::parseIsoString(staged.value(10).toString());
+            task.completed = staged.value(11).toInt() == 1;
+            task.progress = staged.value(12).toInt();
+            task.isDeleted = staged.value(13).toInt() == 1;
+            task.deletedAt = DateUtils::parseIsoString(staged.value(14).toString());
+            task.createdAt = DateUtils::parseIsoString(staged.value(15).toString());
+            task.updatedAt = DateUtils::parseIsoString(staged.value(16).toString());
+            if (!decodeRelations(staged.value(17).toByteArray(), &task)) {
+                m_error = QString("Corrupted staged relations for task %1").arg(task.seq);
+                return false;
+            }
+
+            while (!ancestors.isEmpty() && ancestors.last().lastSeq < task.seq) {
+                ancestors.removeLast();
+            }
+            int parentId = -1;
+            if (task.parentSeq > 0) {
+                parentId = !ancestors.isEmpty() && ancestors.last().seq == task.parentSeq ? ancestors.last().finalId : 0;
+            }
+
+            int finalId = -1;
+            bool shouldUpdate = false;
+            if (!writeTask(task, parentId, &finalId, &shouldUpdate)) {
+                return false;
+            }
+            // 标题为空的任务本身不导入，它的子任务挂到库中同 ID 的任务下（如果有）
+            if (lastSeq > task.seq) {
+                ancestors.append({task.seq, lastSeq, finalId > 0 ? finalId : resolveTask(task.originalId)});
+            }
+
+            if (++done % PublishProgressInterval == 0) {
+                m_progress->store(m_sourceSize + m_sourceSize * done / total, std::memory_order_relaxed);
+                if (m_cancelled->load(std::memory_order_relaxed)) {
+                    m_error = CancelledError;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool publishSettings()
+    {
+        QSqlQuery staged(m_database);
+        staged.setForwardOnly(true);
+        if (!exec(staged, "SELECT key, value, updated_at FROM import_stage.json_import_settings ORDER BY seq")) {
+            return false;
+        }
+        while (staged.next()) {
+            const QString updatedAt = staged.value(2).toString();
+            m_settingQuery.bindValue(0, staged.value(0));
+            m_settingQuery.bindValue(1, staged.value(1));
+            m_settingQuery.bindValue(2, updatedAt.isEmpty() ? DateUtils::toIsoString(QDateTime::currentDateTimeUtc()) : updatedAt);
+            if (!exec(m_settingQuery)) {
+                return false;
+            }
+            ++m_summary.settings;
+        }
+        return true;
+    }
+
+    int resolveParent(const StagedTask &task, int parentId)
+    {
+        if (parentId >= 0) {
+            return parentId;
+        }
+        return task.parentOriginalId > 0 ? resolveTask(task.parentOriginalId) : 0;
+    }
+
+    bool writeTask(StagedTask &task, int parentId, int *finalId, bool *shouldUpdate)
+    {
+        // 标题为空的任务与旧版一致不导入，但它的子任务仍然导入
+        if (task.title.trimmed().isEmpty()) {
+            return true;
+        }
+
+        const int parent = resolveParent(task, parentId);
+        const bool exists = m_options.mode != JsonImporter::Options::Overwrite
+            && task.hasId && task.originalId > 0 && taskExists(task.originalId);
+        bool updated = false;
+        if (exists) {
+            if (m_options.conflict == JsonImporter::Options::Skip) {
+                *finalId = task.originalId;
+            } else if (m_options.conflict == JsonImporter::Options::OverwriteConflict) {
+                if (!bindTaskRow(m_updateTaskQuery, task, parent, true, task.originalId)) {
+                    return false;
+                }
+                *finalId = task.originalId;
+                *shouldUpdate = true;
+                updated = true;
+            } else {
+                if (!bindTaskRow(m_insertTaskQuery, task, parent, false, -1)) {
+                    return false;
+                }
+                *finalId = m_insertTaskQuery.lastInsertId().toInt();
+                *shouldUpdate = true;
+            }
+        } else if (task.hasId && task.originalId > 0) {
+            if (!bindTaskRow(m_insertTaskWithIdQuery, task, parent, false, task.originalId)) {
+                return false;
+            }
+            *finalId = task.originalId;
+            *shouldUpdate = true;
+        } else {
+            if (!bindTaskRow(m_insertTaskQuery, task, parent, false, -1)) {
+                return false;
+            }
+            *finalId = m_insertTaskQuery.lastInsertId().toInt();
+            *shouldUpdate = true;
+        }
+
+        if (*finalId > 0 && task.hasId && task.originalId > 0
+            && !batch(m_taskMap, {task.originalId, *finalId, *shouldUpdate ? 1 : 0})) {
+            return false;
+        }
+
+        ++m_summary.tasks;
+        ++m_runTasks;
+        if (!*shouldUpdate || *finalId <= 0) {
+            return true;
+        }
+
+        // 新插入的任务没有旧关联，只有覆盖已有任务时才需要先清理
+        if (updated) {
+            for (QSqlQuery *query : {&m_clearTagsQuery, &m_clearDependenciesQuery, &m_clearFilesQuery, &m_clearStepsQuery}) {
+                query->bindValue(0, *finalId);
+                if (!exec(*query)) {
+                    return false;
+                }
+            }
+        }
+        return writeRelations(task, *finalId);
+    }
+
+    bool bindTaskRow(QSqlQuery &query, const StagedTask &task, int parentId, bool update, int id)
+    {
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        int index = 0;
+        query.bindValue(index++, task.title);
+        query.bindValue(index++, task.description);
+        query.bindValue(index++, task.primaryFile);
+        query.bindValue(index++, task.priority);
+        query.bindValue(index++, DateUtils::toIsoString(task.dueDate));
+        query.bindValue(index++, task.completed ? 1 : 0);
+        query.bindValue(index++, task.progress);
+        query.bindValue(index++, parentId);
+        query.bindValue(index++, task.isDeleted ? 1 : 0);
+        query.bindValue(index++, DateUtils::toIsoString(task.deletedAt));
+        if (!update) {
+            query.bindValue(index++, DateUtils::toIsoString(task.createdAt.isValid() ? task.createdAt : now));
+        }
+        query.bindValue(index++, DateUtils::toIsoString(task.updatedAt.isValid() ? task.updatedAt : now));
+        if (id > 0) {
+            query.bindValue(index++, id);
+        }
+        return exec(query);
+    }
+
+    bool writeRelations(const StagedTask &task, int taskId)
+    {
+        for (const StepItem &step : task.steps) {
+            if (!batch(m_steps, {taskId, step.title, step.completed ? 1 : 0, step.position, m_now})) {
+                return false;
+            }
+        }
+        for (const FileItem &file : task.files) {
+            const QString fileName = file.name.isEmpty() ? QFileInfo(file.path).fileName() : file.name;
+            if (!batch(m_files, {taskId, file.path, fileName, m_now})) {
+                return false;
+            }
+        }
+
+        QStringList tagNames = task.tagNames;
+        if (!task.hasTagNames) {
+            for (int tagId : task.tagIds) {
+                auto it = m_tagNames.constFind(tagId);
+                if (it != m_tagNames.constEnd()) {
+                    tagNames.append(it.value());
+                }
+            }
+        }
+        for (const QString &tagName : tagNames) {
+            const QString name = tagName.trimmed();
+            if (name.isEmpty()) {
+                continue;
+            }
+            int tagId = m_tagIds.value(name, -1);
+            if (tagId < 0) {
+                m_insertTagQuery.bindValue(0, name);
+                m_insertTagQuery.bindValue(1, "#3B82F6");
+                m_insertTagQuery.bindValue(2, m_now);
+                if (!exec(m_insertTagQuery)) {
+                    return false;
+                }
+                tagId = m_insertTagQuery.lastInsertId().toInt();
+                m_tagIds.insert(name, tagId);
+            }
+            if (!batch(m_taskTags, {taskId, tagId})) {
+                return false;
+            }
+        }
+
+        for (int dependencyId : task.dependencyIds) {
+            if (!batch(m_links, {DependencyLink, taskId, dependencyId})) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool taskExists(int taskId)
+    {
+        m_taskExistsQuery.bindValue(0, taskId);
+        if (!exec(m_taskExistsQuery)) {
+            return false;
+        }
+        const bool found = m_taskExistsQuery.next();
+        m_taskExistsQuery.finish();
+        return found;
+    }
+
+    // 与旧版一致：先查本次导入的 ID 映射，再看库中是否已有同 ID 任务
+    int resolveTask(int originalId)
+    {
+        if (originalId <= 0 || !m_taskMap.flush()) {
+            return 0;
+        }
+        m_mapLookupQuery.bindValue(0, originalId);
+        if (exec(m_mapLookupQuery) && m_mapLookupQuery.next()) {
+            const int finalId = m_mapLookupQuery.value(0).toInt();
+            m_mapLookupQuery.finish();
+            return finalId;
+        }
+        m_mapLookupQuery.finish();
+        return taskExists(originalId) ? originalId : 0;
+    }
+
+    bool flushPublish()
+    {
+        for (BatchInsert *insert : {&m_steps, &m_files, &m_taskTags, &m_taskMap, &m_links}) {
+            if (!insert->flush()) {
+                m_error = insert->error();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool finalize()
+    {
+        if (!flushPublish()) {
+            return false;
+        }
+
+        QSqlQuery query(m_database);
+        const QString resolvedTask = "COALESCE(m.final_id, t.id)";
+        const QString joins = "LEFT JOIN temp.json_import_task_map m ON m.original_id = l.target_id "
+                              "LEFT JOIN main.tasks t ON t.id = l.target_id";
+
+        query.prepare(QString("INSERT OR IGNORE INTO main.task_dependencies (task_id, depends_on_id, created_at) "
+                              "SELECT l.owner_id, %1, ? FROM temp.json_import_links l %2 "
+                              "WHERE l.kind = %3 AND %1 IS NOT NULL AND %1 <> l.owner_id")
+                          .arg(resolvedTask, joins).arg(DependencyLink));
+        query.bindValue(0, m_now);
+        if (!exec(query)) {
+            return false;
+        }
+
+        if (m_hasFolderData && !exec("DELETE FROM main.task_folders WHERE task_id IN "
+                                     "(SELECT final_id FROM temp.json_import_task_map WHERE update_relations = 1)")) {
+            return false;
+        }
+        if (!exec(QString("INSERT OR IGNORE INTO main.task_folders (task_id, folder_id) "
+                          "SELECT %1, l.owner_id FROM temp.json_import_links l %2 WHERE l.kind = %3 AND %1 IS NOT NULL")
+                      .arg(resolvedTask, joins).arg(FolderLink))) {
+            return false;
+        }
+
+        if (!importNotifications()) {
+            return false;
+        }
+        return Database::assignMissingSortKeys(m_database, &m_error);
+    }
+
+    bool importNotifications()
+    {
+        QSqlQuery staged(m_database);
+        QSqlQuery insert(m_database);
+        QSqlQuery insertWithId(m_database);
+        QSqlQuery update(m_database);
+        staged.setForwardOnly(true);
+        if (!prepare(insert, "INSERT INTO main.notifications (type, title, message, task_id, read, created_at) "
+                             "VALUES (?, ?, ?, ?, ?, ?)")
+            || !prepare(insertWithId, "INSERT INTO main.notifications (type, title, message, task_id, read, created_at, id) "
+                                      "VALUES (?, ?, ?, ?, ?, ?, ?)")
+            || !prepare(update, "UPDATE main.notifications SET type = ?, title = ?, message = ?, task_id = ?, read = ?, "
+                                "created_at = ? WHERE id = ?")
+            || !exec(staged, "SELECT n.original_id, n.type, n.title, n.message, COALESCE(m.final_id, t.id, 0), n.read, "
+                             "n.created_at, EXISTS (SELECT 1 FROM main.notifications e WHERE e.id = n.original_id) "
+                             "FROM import_stage.json_import_notifications n "
+                             "LEFT JOIN temp.json_import_task_map m ON m.original_id = n.task_id "
+                             "LEFT JOIN main.tasks t ON t.id = n.task_id AND n.task_id > 0 ORDER BY n.seq")) {
+            return false;
+        }
+
+        const bool overwrite = m_options.mode == JsonImporter::Options::Overwrite;
+        while (staged.next()) {
+            ++m_summary.notifications;
+            const int originalId = staged.value(0).toInt();
+            const bool hasId = originalId > 0;
+            const bool exists = hasId && staged.value(7).toInt() == 1;
+
+            QSqlQuery *query = nullptr;
+            if (overwrite || !exists || m_options.conflict == JsonImporter::Options::Regenerate) {
+                query = hasId && (overwrite || !exists) ? &insertWithId : &insert;
+            } else if (m_options.conflict == JsonImporter::Options::OverwriteConflict) {
+                query = &update;
+            } else {
+                continue;
+            }
+
+            for (int i = 0; i < 6; ++i) {
+                query->bindValue(i, staged.value(i + 1));
+            }
+            if (query != &insert) {
+                query->bindValue(6, originalId);
+            }
+            if (!exec(*query)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readString(JsonStreamReader &reader, QString *value)
+    {
+        if (reader.next() == JsonStreamReader::String) {
+            *value = reader.text();
+            return true;
+        }
+        return reader.skipCurrent() || syntaxError(reader);
+    }
+
+    bool readInt(JsonStreamReader &reader, int *value)
+    {
+        if (reader.next() == JsonStreamReader::Number) {
+            *value = static_cast<int>(reader.number());
+            return true;
+        }
+        return reader.skipCurrent() || syntaxError(reader);
+    }
+
+    bool readBool(JsonStreamReader &reader, bool *value)
+    {
+        if (reader.next() == JsonStreamReader::Bool) {
+            *value = reader.boolean();
+            return true;
+        }
+        return reader.skipCurrent() || syntaxError(reader);
+    }
+
+    bool readLenientDate(JsonStreamReader &reader, QDateTime *value)
+    {
+        QString raw;
+        if (!readString(reader, &raw)) {
+            return false;
+        }
+        *value = DateUtils::parseIsoString(raw);
+        return true;
+    }
+
+    bool readDate(JsonStreamReader &reader, const char *field, QDateTime *value, QString *raw = nullptr)
+    {
+        const JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::Null) {
+            *value = QDateTime();
+            return true;
+        }
+        if (token != JsonStreamReader::String) {
+            return reader.hasError() ? syntaxError(reader) : invalid(QString("%1 必须为字符串或空").arg(field));
+        }
+        const QString text = reader.text();
+        *value = DateUtils::parseIsoString(text);
+        if (raw) {
+            *raw = text;
+        }
+        return true;
+    }
+
+    bool readLenientIds(JsonStreamReader &reader, QVector<int> *ids)
+    {
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            return reader.skipCurrent() || syntaxError(reader);
+        }
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.token() == JsonStreamReader::Number) {
+                ids->append(static_cast<int>(reader.number()));
+            } else if (!reader.skipCurrent()) {
+                return syntaxError(reader);
+            }
+        }
+        return true;
+    }
+
+    bool readTagNames(JsonStreamReader &reader, QStringList *names)
+    {
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            return reader.hasError() ? syntaxError(reader) : invalid("字段 tags 必须是数组");
+        }
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.token() != JsonStreamReader::String) {
+                return reader.hasError() ? syntaxError(reader) : invalid("字段 tags 必须为字符串数组");
+            }
+            names->append(reader.text());
+        }
+        return true;
+    }
+
+    bool readDependencies(JsonStreamReader &reader, QVector<int> *ids)
+    {
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            return reader.hasError() ? syntaxError(reader) : invalid("字段 dependencies 必须是数组");
+        }
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.token() != JsonStreamReader::Number) {
+                return reader.hasError() ? syntaxError(reader) : invalid("字段 dependencies 必须为数字数组");
+            }
+            ids->append(static_cast<int>(reader.number()));
+        }
+        return true;
+    }
+
+    bool readFiles(JsonStreamReader &reader, StagedTask *task)
+    {
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            return reader.hasError() ? syntaxError(reader) : invalid("files 字段必须为数组");
+        }
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.token() != JsonStreamReader::BeginObject) {
+                return reader.hasError() ? syntaxError(reader) : invalid("files 数组项必须为对象");
+            }
+
+            FileItem file;
+            bool hasPath = false;
+            while (reader.next() == JsonStreamReader::Name) {
+                const QByteArray key = reader.utf8Text();
+                if (key == "path") {
+                    if (reader.next() != JsonStreamReader::String) {
+                        return reader.hasError() ? syntaxError(reader) : invalid("files 项缺少 path");
+                    }
+                    file.path = reader.text();
+                    hasPath = true;
+                } else if (key == "name") {
+                    if (!readString(reader, &file.name)) {
+                        return false;
+                    }
+                } else if (!reader.skipCurrent()) {
+                    return syntaxError(reader);
+                }
+            }
+            if (reader.token() != JsonStreamReader::EndObject) {
+                return syntaxError(reader);
+            }
+            if (!hasPath) {
+                return invalid("files 项缺少 path");
+            }
+            if (!file.path.trimmed().isEmpty()) {
+                if (task->primaryFile.isEmpty()) {
+                    task->primaryFile = file.path;
+                }
+                task->files.append(file);
+            }
+        }
+        return true;
+    }
+
+    bool readSteps(JsonStreamReader &reader, QVector<StepItem> *steps)
+    {
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            return reader.hasError() ? syntaxError(reader) : invalid("steps 字段必须为数组");
+        }
+        while (reader.next() != JsonStreamReader::EndArray) {
+            if (reader.token() != JsonStreamReader::BeginObject) {
+                return reader.hasError() ? syntaxError(reader) : invalid("steps 数组项必须为对象");
+            }
+
+            StepItem step;
+            bool hasTitle = false;
+            while (reader.next() == JsonStreamReader::Name) {
+                const QByteArray key = reader.utf8Text();
+                bool ok = true;
+                if (key == "title") {
+                    if (reader.next() != JsonStreamReader::String) {
+                        return reader.hasError() ? syntaxError(reader) : invalid("steps 项缺少 title");
+                    }
+                    step.title = reader.text();
+                    hasTitle = true;
+                } else if (key == "completed") {
+                    ok = readBool(reader, &step.completed);
+                } else if (key == "position") {
+                    ok = readInt(reader, &step.position);
+                } else {
+                    ok = reader.skipCurrent() || syntaxError(reader);
+                }
+                if (!ok) {
+                    return false;
+                }
+            }
+            if (reader.token() != JsonStreamReader::EndObject) {
+                return syntaxError(reader);
+            }
+            if (!hasTitle) {
+                return invalid("steps 项缺少 title");
+            }
+            if (!step.title.trimmed().isEmpty()) {
+                steps->append(step);
+            }
+        }
+        return true;
+    }
+
+    bool writeState(const QString &key, const QString &value)
+    {
+        m_stateQuery.bindValue(0, key);
+        m_stateQuery.bindValue(1, value);
+        return exec(m_stateQuery);
+    }
+
+    bool batch(BatchInsert &insert, std::initializer_list<QVariant> values)
+    {
+        if (!insert.add(values)) {
+            m_error = insert.error();
+            return false;
+        }
+        return true;
+    }
+
+    bool syntaxError(const JsonStreamReader &reader)
+    {
+        m_dataError = true;
+        m_error = QString("JSON 格式不正确：%1").arg(reader.errorString());
+        return false;
+    }
+
+    // 校验错误附带主文件中的字节位置，便于定位
+    bool invalid(const QString &message)
+    {
+        m_dataError = true;
+        m_error = QString("%1（文件位置：%2）").arg(message).arg(m_reader ? m_reader->offset() : 0);
+        return false;
+    }
+
+    bool prepare(QSqlQuery &query, const QString &sql)
+    {
+        query.setForwardOnly(true);
+        if (!query.prepare(sql)) {
+            m_error = query.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    bool exec(QSqlQuery &query, const QString &sql = QString())
+    {
+        if (!(sql.isEmpty() ? query.exec() : query.exec(sql))) {
+            m_error = query.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    bool exec(const QString &sql)
+    {
+        QSqlQuery query(m_database);
+        return exec(query, sql);
+    }
+
+    QSqlDatabase m_database;
+    JsonImporter::Options m_options;
+    qint64 m_sourceSize;
+    std::atomic<qint64> *m_progress;
+    const std::atomic<bool> *m_cancelled;
+    const JsonStreamReader *m_reader;
+    bool m_dataError;
+    bool m_staged = false;
+    bool m_hasFolderData;
+    int m_nextTaskSeq;
+    int m_pendingTasks;
+    int m_runTasks;
+    QString m_now;
+    QHash<QString, int> m_sectionDone;
+    QHash<QString, int> m_tagIds;
+    QHash<QString, int> m_folderIds;
+    QHash<int, QString> m_tagNames;
+    JsonImporter::Summary m_summary;
+    QSqlQuery m_stageTagQuery;
+    QSqlQuery m_stageFolderQuery;
+    QSqlQuery m_stageSettingQuery;
+    QSqlQuery m_stateQuery;
+    QSqlQuery m_taskExistsQuery;
+    QSqlQuery m_insertTaskQuery;
+    QSqlQuery m_insertTaskWithIdQuery;
+    QSqlQuery m_updateTaskQuery;
+    QSqlQuery m_clearTagsQuery;
+    QSqlQuery m_clearDependenciesQuery;
+    QSqlQuery m_clearFilesQuery;
+    QSqlQuery m_clearStepsQuery;
+    QSqlQuery m_mapLookupQuery;
+    QSqlQuery m_insertTagQuery;
+    QSqlQuery m_updateTagQuery;
+    QSqlQuery m_insertFolderQuery;
+    QSqlQuery m_updateFolderQuery;
+    QSqlQuery m_folderLinksQuery;
+    QSqlQuery m_settingQuery;
+    BatchInsert m_stagedTasks;
+    BatchInsert m_folderTasks;
+    BatchInsert m_notifications;
+    BatchInsert m_steps;
+    BatchInsert m_files;
+    BatchInsert m_taskTags;
+    BatchInsert m_taskMap;
+    BatchInsert m_links;
+    QString m_error;
+};
+
+QString runImport(const QString &databasePath, const QString &source, const JsonImporter::Options &options,
+                  bool resume, const QString &connectionName, std::atomic<qint64> *progress,
+                  const std::atomic<bool> *cancelled, JsonImporter::Summary *summary, double *tasksPerSecond)
+{
+    QFile file(source);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return file.errorString();
+    }
+    if (!resume) {
+        removeStaging(databasePath);
+    }
+
+    QString error;
+    bool discardStaging = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(databasePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BackgroundJob::BusyTimeoutMs));
+
+        if (!database.open()) {
+            error = database.lastError().text();
+        } else if (!attachStaging(database, stagingPath(databasePath), &error)) {
+            database.close();
+        } else {
+            QElapsedTimer timer;
+            timer.start();
+            {
+                ImportJob job(database, options, file.size(), progress, cancelled);
+                if (!job.run(&file, ResumeKey::forFile(source), resume)) {
+                    error = job.error().isEmpty() ? QString("Import failed") : job.error();
+                    job.rollback();
+                    // 取消或数据库出错时保留暂存库以便续传；文件本身有错则续传也没有意义
+                    discardStaging = job.dataError();
+                } else {
+                    discardStaging = true;
+                }
+                *summary = job.summary();
+
+                const qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+                *tasksPerSecond = job.runTasks() * 1000.0 / elapsedMs;
+                LOG_INFO_F("JsonImporter", "Imported %1 tasks in %2 ms (%3 tasks/s)",
+                           job.runTasks(), elapsedMs, qRound(*tasksPerSecond));
+            }
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    if (discardStaging) {
+        removeStaging(databasePath);
+    }
+    return error;
+}
+} // namespace
+
+JsonImporter::JsonImporter(QObject *parent)
+    : QObject(parent)
+    , m_job(new BackgroundJob(this))
+    , m_bytesRead(0)
+    , m_totalBytes(0)
+    , m_cancelRequested(false)
+    , m_lastBytesRead(-1)
+    , m_tasksPerSecond(0.0)
+{
+    connect(m_job, &BackgroundJob::progressTick, this, &JsonImporter::onPollProgress);
+    connect(m_job, &BackgroundJob::finished, this, &JsonImporter::onThreadFinished);
+}
+
+JsonImporter::~JsonImporter()
+{
+    m_cancelRequested.store(true);
+    m_job->wait();
+}
+
+bool JsonImporter::findResumableImport(const QString &source, Options *options)
+{
+    const QString path = stagingPath(Database::instance().database().databaseName());
+    if (!QFile::exists(path)) {
+        return false;
+    }
+
+    QHash<QString, QString> state;
+    const QString connectionName = BackgroundJob::connectionName("json_import_probe");
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(path);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (database.open()) {
+            state = loadState(database, "main");
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const ResumeKey key = ResumeKey::forFile(source);
+    if (state.isEmpty() || state.value("source") != key.source || state.value("size").toLongLong() != key.size
+        || state.value("modified").toLongLong() != key.modified) {
+        return false;
+    }
+
+    if (options) {
+        options->mode = static_cast<Options::Mode>(state.value("mode").toInt());
+        options->conflict = static_cast<Options::Conflict>(state.value("conflict").toInt());
+    }
+    return true;
+}
+
+void JsonImporter::discardResumableImport()
+{
+    QSqlDatabase &database = Database::instance().database();
+    removeStaging(database.databaseName());
+
+    QSqlQuery query(database);
+    for (const char *table : LegacyStagingTables) {
+        query.exec(QString("DROP TABLE IF EXISTS %1").arg(table));
+    }
+}
+
+bool JsonImporter::start(const QString &source, const Options &options, bool resume)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    const QString databasePath = database.databaseName();
+    if (!database.isOpen() || !QFile::exists(databasePath)) {
+        m_error = "Database is not open";
+        return false;
+    }
+    // 导入的设置会覆盖同名键，挂起的旧值必须先写回
+    SettingsStore::instance().flush();
+
+    m_error.clear();
+    m_summary = Summary();
+    m_bytesRead.store(0);
+    // 暂存和发布各占一半进度
+    m_totalBytes = qMax<qint64>(1, QFileInfo(source).size()) * 2;
+    m_cancelRequested.store(false);
+    m_lastBytesRead = -1;
+    m_tasksPerSecond = 0.0;
+
+    const QString connectionName = BackgroundJob::connectionName("json_import");
+    m_job->start([this, databasePath, source, options, resume, connectionName]() {
+        m_error = runImport(databasePath, source, options, resume, connectionName,
+                            &m_bytesRead, &m_cancelRequested, &m_summary, &m_tasksPerSecond);
+    });
+    return true;
+}
+
+void JsonImporter::cancel()
+{
+    m_cancelRequested.store(true);
+}
+
+bool JsonImporter::isRunning() const
+{
+    return m_job->isRunning();
+}
+
+void JsonImporter::waitForFinished()
+{
+    m_job->waitForFinished();
+}
+
+QString JsonImporter::lastError() const
+{
+    return m_error;
+}
+
+bool JsonImporter::wasCancelled() const
+{
+    return m_error == CancelledError;
+}
+
+JsonImporter::Summary JsonImporter::summary() const
+{
+    return m_summary;
+}
+
+double JsonImporter::tasksPerSecond() const
+{
+    return m_tasksPerSecond;
+}
+
+qint64 JsonImporter::elapsedMs() const
+{
+    return m_job->elapsedMs();
+}
+
+void JsonImporter::onPollProgress()
+{
+    const qint64 bytesRead = qMin(m_bytesRead.load(), m_totalBytes);
+    if (!isRunning() || bytesRead == m_lastBytesRead) {
+        return;
+    }
+
+    m_lastBytesRead = bytesRead;
+    emit progressChanged(bytesRead, m_totalBytes);
+}
+
+void JsonImporter::onThreadFinished()
+{
+    const bool success = m_error.isEmpty();
+    if (success) {
+        emit progressChanged(m_totalBytes, m_totalBytes);
+    }
+    emit finished(success, m_error);
+}
@@ -0,0 +1,78 @@
+#ifndef JSON_IMPORTER_H
+#define JSON_IMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+class BackgroundJob;
+
+// 在工作线程中用独立连接流式导入 JSON，不在内存中构建文档树。解析结果先按检查点写入
+// 数据目录下的暂存库，取消或失败后可以从上次的检查点继续；全部解析完成后才在一个事务中写入主库
+class JsonImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        enum Mode {
+            Merge,
+            Overwrite,
+            Append
+        };
+        enum Conflict {
+            Skip,
+            OverwriteConflict,
+            Regenerate
+        };
+        Mode mode = Merge;
+        Conflict conflict = OverwriteConflict;
+    };
+
+    struct Summary {
+        int tasks = 0;
+        int folders = 0;
+        int tags = 0;
+        int settings = 0;
+        int notifications = 0;
+    };
+
+    explicit JsonImporter(QObject *parent = nullptr);
+    ~JsonImporter();
+
+    // 同一文件（大小和修改时间未变）存在未完成的导入时返回 true 并给出当时的选项
+    static bool findResumableImport(const QString &source, Options *options);
+    // 删除暂存库，放弃未完成的导入
+    static void discardResumableImport();
+
+    bool start(const QString &source, const Options &options, bool resume);
+    void cancel();
+    bool isRunning() const;
+    void waitForFinished();
+
+    QString lastError() const;
+    bool wasCancelled() const;
+    Summary summary() const;
+    double tasksPerSecond() const;
+    qint64 elapsedMs() const;
+
+signals:
+    void progressChanged(qint64 bytesRead, qint64 totalBytes);
+    void finished(bool success, const QString &error);
+
+private slots:
+    void onPollProgress();
+    void onThreadFinished();
+
+private:
+    BackgroundJob *m_job;
+    QString m_error;
+    Summary m_summary;
+    std::atomic<qint64> m_bytesRead;
+    qint64 m_totalBytes;
+    std::atomic<bool> m_cancelRequested;
+    qint64 m_lastBytesRead;
+    double m_tasksPerSecond;
+};
+
+#endif // JSON_IMPORTER_H
@@ -0,0 +1,304 @@
+#include "maintenance_worker.h"
+#include "database.h"
+#include "notificationmanager.h"
+#include "settings_store.h"
+#include "change_journal.h"
+#include "background_job.h"
+#include "../utils/logger.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include <QEvent>
+#include <QFile>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <functional>
+
+namespace {
+constexpr int ScheduleIntervalMs = 6 * 60 * 60 * 1000;
+constexpr int IdleCheckIntervalMs = 60 * 1000;
+constexpr qint64 IdleThresholdMs = 2 * 60 * 1000;
+constexpr int AnalyzeIntervalDays = 7;
+// 每步最多回收的页数和步数；步与步之间让出写锁，界面线程的写入最多等一步
+constexpr int VacuumPagesPerStep = 256;
+constexpr int VacuumStepsPerRun = 64;
+constexpr int VacuumStepPauseMs = 20;
+constexpr qint64 MinFreePages = 64;
+// 切换 auto_vacuum 的 VACUUM 全程持有写锁且不能中途停下，只对不超过这个大小、很快能做完的库自动执行
+constexpr qint64 AutoVacuumConvertMaxBytes = 32 * 1024 * 1024;
+// 其他进程（例如另一个实例）按自己的游标读取变更日志，压缩时总保留最近这么多条
+constexpr int ChangeLogKeepRows = 10000;
+const char *LastAnalyzeKey = "db_last_analyze";
+
+qint64 pragmaValue(QSqlDatabase &database, const QString &pragma)
+{
+    QSqlQuery query(database);
+    if (query.exec(QString("PRAGMA %1").arg(pragma)) && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+} // namespace
+
+MaintenanceWorker::MaintenanceWorker(QObject *parent)
+    : QObject(parent)
+    , m_job(new BackgroundJob(this))
+    , m_scheduleTimer(new QTimer(this))
+    , m_idleTimer(new QTimer(this))
+    , m_cancelRequested(false)
+    , m_idleRun(false)
+{
+    connect(m_job, &BackgroundJob::finished, this, &MaintenanceWorker::onThreadFinished);
+    m_scheduleTimer->setInterval(ScheduleIntervalMs);
+    connect(m_scheduleTimer, &QTimer::timeout, this, &MaintenanceWorker::runScheduled);
+    m_idleTimer->setInterval(IdleCheckIntervalMs);
+    connect(m_idleTimer, &QTimer::timeout, this, &MaintenanceWorker::onIdleCheck);
+}
+
+MaintenanceWorker::~MaintenanceWorker()
+{
+    m_cancelRequested.store(true);
+    m_job->wait();
+}
+
+void MaintenanceWorker::start()
+{
+    m_lastInput.start();
+    QCoreApplication::instance()->installEventFilter(this);
+    runScheduled();
+    m_scheduleTimer->start();
+    m_idleTimer->start();
+}
+
+void MaintenanceWorker::runScheduled()
+{
+    if (isRunning()) {
+        return;
+    }
+
+    SettingsStore &settings = SettingsStore::instance();
+    Plan plan;
+    if (settings.boolValue("delete_auto_cleanup", true)) {
+        plan.cleanupDays = settings.intValue("delete_cleanup_days", 14);
+        plan.parentAction = settings.intValue("delete_parent_action", 0);
+        // 提醒要通过通知管理器发出信号，仍在界面线程中生成，并且先于清理
+        NotificationManager::instance().checkDeletionWarnings(plan.cleanupDays);
+    }
+    plan.notificationDays = settings.intValue("notifications_cleanup_days", 30);
+    plan.changeLogFloor = ChangeJournal::instance().compactionFloor();
+    plan.optimize = true;
+
+    const QDateTime lastAnalyze = QDateTime::fromString(settings.value(LastAnalyzeKey), Qt::ISODate);
+    plan.analyze = !lastAnalyze.isValid() || lastAnalyze.daysTo(QDateTime::currentDateTime()) >= AnalyzeIntervalDays;
+
+    launch(plan, false);
+}
+
+bool MaintenanceWorker::isRunning() const
+{
+    return m_job->isRunning();
+}
+
+QList<MaintenanceWorker::JobReport> MaintenanceWorker::lastReports() const
+{
+    return m_lastReports;
+}
+
+bool MaintenanceWorker::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::Wheel:
+        m_lastInput.restart();
+        // 用户回来了，空闲回收在当前这一步结束后停下
+        if (m_idleRun && isRunning()) {
+            m_cancelRequested.store(true);
+        }
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void MaintenanceWorker::onIdleCheck()
+{
+    if (isRunning() || m_lastInput.elapsed() < IdleThresholdMs || Database::instance().isRestoring()) {
+        return;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    if (!database.isOpen()) {
+        return;
+    }
+
+    // auto_vacuum 为 2 表示 INCREMENTAL；旧库需要一次完整 VACUUM 才能切换过去，大库保持原样
+    Plan plan;
+    const bool incremental = pragmaValue(database, "auto_vacuum") == 2;
+    const qint64 databaseBytes = pragmaValue(database, "page_count") * pragmaValue(database, "page_size");
+    plan.convertAutoVacuum = !incremental && databaseBytes <= AutoVacuumConvertMaxBytes;
+    if (!plan.convertAutoVacuum && (!incremental || pragmaValue(database, "freelist_count") < MinFreePages)) {
+        return;
+    }
+    plan.vacuumSteps = VacuumStepsPerRun;
+    launch(plan, true);
+}
+
+bool MaintenanceWorker::launch(const Plan &plan, bool idleRun)
+{
+    QSqlDatabase &database = Database::instance().database();
+    const QString databasePath = database.databaseName();
+    // VACUUM 会长时间占住写锁，替换数据的写事务等不到它结束
+    if (!database.isOpen() || !QFile::exists(databasePath) || Database::instance().isRestoring()) {
+        return false;
+    }
+    SettingsStore::instance().flush();
+
+    m_result = Result();
+    m_cancelRequested.store(false);
+    m_idleRun = idleRun;
+
+    const QString connectionName = BackgroundJob::connectionName("maintenance");
+    return m_job->start([this, databasePath, connectionName, plan]() {
+        m_result = runPlan(databasePath, connectionName, plan, &m_cancelRequested);
+    }, QThread::LowestPriority);
+}
+
+MaintenanceWorker::Result MaintenanceWorker::runPlan(const QString &databasePath, const QString &connectionName,
+                                                     const Plan &plan, const std::atomic<bool> *cancelled)
+{
+    Result result;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(databasePath);
+        database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BackgroundJob::BusyTimeoutMs));
+
+        if (!database.open()) {
+            JobReport report;
+            report.name = "open";
+            report.success = false;
+            report.detail = database.lastError().text();
+            result.reports.append(report);
+        } else {
+            QSqlQuery query(database);
+            auto runJob = [&result](const QString &name, const std::function<QString(bool *)> &job) {
+                QElapsedTimer timer;
+                timer.start();
+                JobReport report;
+                report.name = name;
+                report.detail = job(&report.success);
+                report.elapsedMs = timer.elapsed();
+                result.reports.append(report);
+            };
+
+            if (plan.cleanupDays > 0) {
+                runJob("cleanup_deleted_tasks", [&](bool *ok) {
+                    // 一个事务内删完，避免逐条提交
+                    *ok = query.exec("BEGIN IMMEDIATE");
+                    if (!*ok) {
+                        return query.lastError().text();
+                    }
+                    result.purgedTasks = Database::cleanupDeletedTasks(database, plan.cleanupDays, plan.parentAction);
+                    *ok = query.exec("COMMIT");
+                    if (!*ok) {
+                        const QString error = query.lastError().text();
+                        query.exec("ROLLBACK");
+                        result.purgedTasks = 0;
+                        return error;
+                    }
+                    return QString("%1 tasks removed").arg(result.purgedTasks);
+                });
+            }
+
+            if (plan.notificationDays > 0) {
+                runJob("cleanup_notifications", [&](bool *) {
+                    result.purgedNotifications = Database::cleanupOldNotifications(database, plan.notificationDays);
+                    return QString("%1 notifications removed").arg(result.purgedNotifications);
+                });
+            }
+
+            if (plan.changeLogFloor >= 0) {
+                runJob("compact_change_log", [&](bool *ok) {
+                    const int removed = Database::compactChangeLog(database, plan.changeLogFloor, ChangeLogKeepRows);
+                    *ok = removed >= 0;
+                    return *ok ? QString("%1 entries removed").arg(removed) : QString("Failed to compact change_log");
+                });
+            }
+
+            if (plan.analyze) {
+                runJob("analyze", [&](bool *ok) {
+                    *ok = query.exec("ANALYZE");
+                    result.analyzed = *ok;
+                    return *ok ? QString() : query.lastError().text();
+                });
+            }
+
+            if (plan.optimize) {
+                // 0x10002：新连接没有查询记录，让 optimize 自行检查所有表
+                runJob("optimize", [&](bool *ok) {
+                    *ok = query.exec("PRAGMA optimize=0x10002");
+                    return *ok ? QString() : query.lastError().text();
+                });
+            }
+
+            if (plan.convertAutoVacuum && !cancelled->load()) {
+                runJob("enable_incremental_vacuum", [&](bool *ok) {
+                    *ok = query.exec("PRAGMA auto_vacuum = INCREMENTAL") && query.exec("VACUUM");
+                    return *ok ? QString() : query.lastError().text();
+                });
+            }
+
+            if (plan.vacuumSteps > 0 && pragmaValue(database, "auto_vacuum") == 2) {
+                runJob("incremental_vacuum", [&](bool *ok) {
+                    const qint64 before = pragmaValue(database, "freelist_count");
+                    int steps = 0;
+                    while (steps < plan.vacuumSteps && !cancelled->load() && pragmaValue(database, "freelist_count") > 0) {
+                        if (!query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(VacuumPagesPerStep))) {
+                            *ok = false;
+                            return query.lastError().text();
+                        }
+                        // 读完结果集，保证这一步在让出写锁前已执行完
+                        while (query.next()) {
+                        }
+                        ++steps;
+                        QThread::msleep(VacuumStepPauseMs);
+                    }
+                    const qint64 after = pragmaValue(database, "freelist_count");
+                    return QString("%1 pages reclaimed in %2 steps, %3 free pages left")
+                        .arg(before - after).arg(steps).arg(after);
+                });
+            }
+
+            query.finish();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+void MaintenanceWorker::onThreadFinished()
+{
+    for (const JobReport &report : m_result.reports) {
+        if (report.success) {
+            LOG_INFO_F("Maintenance", "%1 finished in %2 ms %3", report.name, report.elapsedMs, report.detail);
+        } else {
+            LOG_WARNING_F("Maintenance", "%1 failed after %2 ms: %3", report.name, report.elapsedMs, report.detail);
+        }
+    }
+
+    if (m_result.analyzed) {
+        SettingsStore::instance().setValue(LastAnalyzeKey, QDateTime::currentDateTime().toString(Qt::ISODate));
+    }
+    m_lastReports = m_result.reports;
+
+    if (m_result.purgedTasks > 0 || m_result.purgedNotifications > 0) {
+        NotificationManager::instance().refresh();
+    }
+    if (m_result.purgedTasks > 0) {
+        emit dataPurged();
+    }
+    emit finished(m_lastReports);
+}
@@ -0,0 +1,81 @@
+#ifndef MAINTENANCE_WORKER_H
+#define MAINTENANCE_WORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QElapsedTimer>
+#include <atomic>
+
+class QTimer;
+class BackgroundJob;
+
+// 后台数据库维护：清理回收站和旧通知、空闲时分步回收空闲页、定期更新查询统计
+// 作业在低优先级线程中用独立连接执行，界面线程只负责调度、删除提醒和汇报耗时
+class MaintenanceWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct JobReport {
+        QString name;
+        qint64 elapsedMs = 0;
+        bool success = true;
+        QString detail;
+    };
+
+    explicit MaintenanceWorker(QObject *parent = nullptr);
+    ~MaintenanceWorker();
+
+    // 立即执行一轮定期维护，之后按固定间隔重复，并开始检测空闲
+    void start();
+    void runScheduled();
+    bool isRunning() const;
+    QList<JobReport> lastReports() const;
+
+signals:
+    // 回收站里的任务被永久删除，相应的变更日志已写入
+    void dataPurged();
+    void finished(const QList<MaintenanceWorker::JobReport> &reports);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void onIdleCheck();
+    void onThreadFinished();
+
+private:
+    struct Plan {
+        int cleanupDays = 0;
+        int parentAction = 0;
+        int notificationDays = 0;
+        bool optimize = false;
+        bool analyze = false;
+        bool convertAutoVacuum = false;
+        int vacuumSteps = 0;
+        qint64 changeLogFloor = -1;
+    };
+
+    struct Result {
+        QList<JobReport> reports;
+        int purgedTasks = 0;
+        int purgedNotifications = 0;
+        bool analyzed = false;
+    };
+
+    bool launch(const Plan &plan, bool idleRun);
+    static Result runPlan(const QString &databasePath, const QString &connectionName, const Plan &plan,
+                          const std::atomic<bool> *cancelled);
+
+    BackgroundJob *m_job;
+    QTimer *m_scheduleTimer;
+    QTimer *m_idleTimer;
+    QElapsedTimer m_lastInput;
+    Result m_result;
+    QList<JobReport> m_lastReports;
+    std::atomic<bool> m_cancelRequested;
+    bool m_idleRun;
+};
+
+#endif // MAINTENANCE_WORKER_H
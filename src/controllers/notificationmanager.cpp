@@ -1,15 +1,17 @@
 #include "notificationmanager.h"
+#include "settings_store.h"
+#include "../utils/date_utils.h"
 #include "../utils/logger.h"
 #include <QSqlQuery>
+#include <QSqlError>
 #include <QDateTime>
 #include <QApplication>
 
 namespace {
-bool settingEnabled(Database &db, const char *key, bool defaultValue)
-{
-    return db.getSetting(key, defaultValue ? "1" : "0") == "1";
-}
-}
+constexpr qint64 SecsPerDay = 24 * 60 * 60;
+// 时区偏移最多 14 小时
+constexpr qint64 MaxUtcOffsetSecs = 14 * 60 * 60;
+} // namespace
 
 NotificationManager& NotificationManager::instance()
 {
@@ -41,24 +43,28 @@ bool NotificationManager::addNotification(Notification::Type type, const QString
 
 bool NotificationManager::addNotification(const Notification &notification)
 {
-    if (!settingEnabled(m_database, "notifications_enabled", true)) {
+    if (!SettingsStore::instance().boolValue("notifications_enabled", true)) {
         return false;
     }
 
     if (notification.type() == Notification::Deadline &&
-        !settingEnabled(m_database, "notifications_reminders", true)) {
+        !SettingsStore::instance().boolValue("notifications_reminders", true)) {
         return false;
     }
 
     if (notification.type() == Notification::System &&
-        !settingEnabled(m_database, "notifications_system", true)) {
+        !SettingsStore::instance().boolValue("notifications_system", true)) {
         return false;
     }
 
     Notification notif = notification;
 
     if (m_database.insertNotification(notif)) {
-        if (settingEnabled(m_database, "notifications_sound", false)) {
+        // 去重键相同的通知已经存在
+        if (notif.id() <= 0) {
+            return false;
+        }
+        if (SettingsStore::instance().boolValue("notifications_sound", false)) {
             QApplication::beep();
         }
         updateUnreadCount();
@@ -174,43 +180,75 @@ void NotificationManager::refresh()
 
 void NotificationManager::checkDeletionWarnings(int cleanupDays)
 {
-    if (cleanupDays <= 0) {
+    if (cleanupDays <= 0 || !SettingsStore::instance().boolValue("notifications_enabled", true)) {
         return;
     }
 
+    // 剩余 3 天和 1 天的任务各对应 deleted_at 落在本地的某一天内；不适用的区间绑定 NULL，比较结果恒为假
+    const QDate today = QDate::currentDate();
+    auto dayRange = [&](int remaining, QVariant *start, QVariant *end) {
+        const int elapsed = cleanupDays - remaining;
+        if (elapsed < 0) {
+            *start = QVariant();
+            *end = QVariant();
+            return;
+        }
+        const QDate day = today.addDays(-elapsed);
+        *start = QDateTime(day, QTime(0, 0)).toSecsSinceEpoch();
+        *end = QDateTime(day.addDays(1), QTime(0, 0)).toSecsSinceEpoch();
+    };
+    QVariant threeStart, threeEnd, oneStart, oneEnd;
+    dayRange(3, &threeStart, &threeEnd);
+    dayRange(1, &oneStart, &oneEnd);
+
+    // deleted_at 是带 Z 的 UTC 文本，不能和本地时间的文本直接比较。外层按放宽的文本范围走
+    // idx_tasks_deleted_at 粗筛，内层换算成秒后精确比较
+    const qint64 todaySecs = QDateTime(today, QTime(0, 0)).toSecsSinceEpoch();
+    const QString textStart = DateUtils::toIsoString(
+        QDateTime::fromSecsSinceEpoch(todaySecs - (cleanupDays - 1) * SecsPerDay - MaxUtcOffsetSecs));
+    const QString textEnd = DateUtils::toIsoString(
+        QDateTime::fromSecsSinceEpoch(todaySecs - (cleanupDays - 3) * SecsPerDay + SecsPerDay + MaxUtcOffsetSecs));
+
+    // 候选任务和去重都在一条语句里完成：唯一索引 (type, task_id, dedupe_key) 挡掉已经提醒过的
     QSqlQuery query(m_database.database());
-    query.prepare("SELECT id, title, deleted_at FROM tasks WHERE is_deleted = 1 AND deleted_at IS NOT NULL");
+    query.prepare(R"(
+        INSERT OR IGNORE INTO notifications (type, title, message, task_id, read, created_at, dedupe_key)
+        SELECT ?, ?, printf(?, title, remaining), id, 0, ?, remaining || ':' || deleted_at
+        FROM (
+            SELECT id, title, deleted_at,
+                   CASE WHEN deleted_secs >= ? AND deleted_secs < ? THEN 3 ELSE 1 END AS remaining
+            FROM (
+                SELECT id, title, deleted_at, CAST(strftime('%s', deleted_at) AS INTEGER) AS deleted_secs
+                FROM tasks
+                WHERE is_deleted = 1 AND deleted_at >= ? AND deleted_at < ?
+            )
+            WHERE (deleted_secs >= ? AND deleted_secs < ?) OR (deleted_secs >= ? AND deleted_secs < ?)
+        )
+    )");
+    query.addBindValue(static_cast<int>(Notification::DeleteWarning));
+    query.addBindValue(QString("删除提醒"));
+    query.addBindValue(QString("任务 \"%s\" 将在 %d 天后永久删除。"));
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.addBindValue(threeStart);
+    query.addBindValue(threeEnd);
+    query.addBindValue(textStart);
+    query.addBindValue(textEnd);
+    query.addBindValue(threeStart);
+    query.addBindValue(threeEnd);
+    query.addBindValue(oneStart);
+    query.addBindValue(oneEnd);
     if (!query.exec()) {
+        LOG_ERROR("NotificationManager", QString("Failed to check deletion warnings: %1").arg(query.lastError().text()));
         return;
     }
 
-    const QDateTime now = QDateTime::currentDateTime();
-    while (query.next()) {
-        int taskId = query.value(0).toInt();
-        QString title = query.value(1).toString();
-        QString deletedAtStr = query.value(2).toString();
-        QDateTime deletedAt = QDateTime::fromString(deletedAtStr, Qt::ISODate);
-        if (!deletedAt.isValid()) {
-            continue;
-        }
-
-        int daysElapsed = deletedAt.daysTo(now);
-        int remaining = cleanupDays - daysElapsed;
-        if (remaining != 3 && remaining != 1) {
-            continue;
-        }
-
-        QString message = QString("任务 \"%1\" 将在 %2 天后永久删除。").arg(title).arg(remaining);
-        QSqlQuery existsQuery(m_database.database());
-        existsQuery.prepare("SELECT 1 FROM notifications WHERE type = ? AND task_id = ? AND message = ? LIMIT 1");
-        existsQuery.addBindValue(static_cast<int>(Notification::DeleteWarning));
-        existsQuery.addBindValue(taskId);
-        existsQuery.addBindValue(message);
-        if (existsQuery.exec() && existsQuery.next()) {
-            continue;
+    const int added = query.numRowsAffected();
+    if (added > 0) {
+        if (SettingsStore::instance().boolValue("notifications_sound", false)) {
+            QApplication::beep();
         }
-
-        addNotification(Notification::DeleteWarning, "删除提醒", message, taskId);
+        refresh();
+        LOG_INFO("NotificationManager", QString("Added %1 deletion warnings").arg(added));
     }
 }
 
@@ -0,0 +1,244 @@
+#include "reminder_scheduler.h"
+#include "database.h"
+#include "notificationmanager.h"
+#include "task_controller.h"
+#include "../utils/date_utils.h"
+#include "../utils/logger.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include <QSqlQuery>
+#include <QSqlError>
+
+namespace {
+// 提前多久提醒；截止时间已进入这段窗口的任务在装入时立即提醒
+constexpr qint64 ReminderLeadMs = 15 * 60 * 1000;
+// 每次只装入这段时间内需要提醒的任务，到达边界时再装入下一段
+constexpr qint64 LoadHorizonMs = 48 * 60 * 60 * 1000;
+// 时区偏移最多 14 小时；按文本筛选截止时间时两端各放宽这么多
+constexpr qint64 MaxUtcOffsetMs = 14 * 60 * 60 * 1000;
+// 定时器最长间隔；系统休眠或调整时钟后最多晚这么久纠正
+constexpr qint64 MaxTimerIntervalMs = 60 * 60 * 1000;
+constexpr size_t CompactSlack = 64;
+} // namespace
+
+ReminderScheduler& ReminderScheduler::instance()
+{
+    static ReminderScheduler instance;
+    return instance;
+}
+
+ReminderScheduler::ReminderScheduler(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_horizonMs(0)
+    , m_nextGeneration(0)
+    , m_started(false)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ReminderScheduler::onTimeout);
+}
+
+ReminderScheduler::~ReminderScheduler()
+{
+}
+
+void ReminderScheduler::start()
+{
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, m_timer, &QTimer::stop);
+    reload();
+}
+
+void ReminderScheduler::reload()
+{
+    if (!m_started) {
+        return;
+    }
+
+    m_heap = decltype(m_heap)();
+    m_reminders.clear();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_horizonMs = now + LoadHorizonMs;
+
+    // due_date 新数据是带 Z 的 UTC 文本，旧数据可能是不带时区的本地时间，文本比较不等于时间比较。
+    // 这里只用放宽后的文本范围走 idx_tasks_due_date，精确的范围由 schedule() 按解析后的时间判断
+    QSqlQuery query(Database::instance().database());
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, title, due_date FROM tasks WHERE due_date > ? AND due_date <= ? "
+                  "AND completed = 0 AND is_deleted = 0");
+    query.addBindValue(DateUtils::toIsoString(QDateTime::fromMSecsSinceEpoch(now - MaxUtcOffsetMs)));
+    query.addBindValue(DateUtils::toIsoString(QDateTime::fromMSecsSinceEpoch(loadLimitMs() + MaxUtcOffsetMs)));
+    if (!query.exec()) {
+        LOG_ERROR("ReminderScheduler", QString("Failed to load due tasks: %1").arg(query.lastError().text()));
+        arm();
+        return;
+    }
+
+    while (query.next()) {
+        schedule(query.value(0).toInt(), query.value(1).toString(),
+                 DateUtils::parseIsoString(query.value(2).toString()));
+    }
+    LOG_DEBUG_F("ReminderScheduler", "Loaded %1 upcoming deadlines", m_reminders.size());
+    arm();
+}
+
+void ReminderScheduler::watch(TaskController *controller)
+{
+    connect(controller, &TaskController::taskAdded, this, &ReminderScheduler::onTaskChanged);
+    connect(controller, &TaskController::taskUpdated, this, &ReminderScheduler::onTaskChanged);
+    connect(controller, &TaskController::taskDeleted, this, &ReminderScheduler::onTaskDeleted);
+    connect(controller, &TaskController::taskCompletionChanged, this, &ReminderScheduler::onTaskCompletionChanged);
+}
+
+int ReminderScheduler::pendingCount() const
+{
+    return m_reminders.size();
+}
+
+void ReminderScheduler::onTaskChanged(const Task &task)
+{
+    if (!m_started) {
+        return;
+    }
+
+    if (task.isCompleted()) {
+        unschedule(task.id());
+    } else {
+        schedule(task.id(), task.title(), task.dueDate());
+    }
+    arm();
+}
+
+void ReminderScheduler::onTaskDeleted(int taskId)
+{
+    if (!m_started) {
+        return;
+    }
+
+    unschedule(taskId);
+    arm();
+}
+
+void ReminderScheduler::onTaskCompletionChanged(int taskId, bool completed)
+{
+    if (!m_started) {
+        return;
+    }
+
+    if (completed) {
+        unschedule(taskId);
+    } else {
+        const Task task = Database::instance().getTaskById(taskId);
+        if (task.id() > 0) {
+            schedule(task.id(), task.title(), task.dueDate());
+        }
+    }
+    arm();
+}
+
+void ReminderScheduler::onTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now >= m_horizonMs) {
+        reload();
+        return;
+    }
+
+    while (!m_heap.empty() && m_heap.top().fireAtMs <= now) {
+        const Entry entry = m_heap.top();
+        m_heap.pop();
+        if (!isCurrent(entry)) {
+            continue;
+        }
+        const Reminder reminder = m_reminders.take(entry.taskId);
+        fire(entry.taskId, reminder);
+    }
+    arm();
+}
+
+void ReminderScheduler::schedule(int taskId, const QString &title, const QDateTime &dueDate)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 dueMs = dueDate.isValid() ? dueDate.toMSecsSinceEpoch() : 0;
+    if (taskId <= 0 || dueMs <= now || dueMs > loadLimitMs()) {
+        // 超出当前范围的截止时间由下一次装入处理
+        unschedule(taskId);
+        return;
+    }
+
+    auto it = m_reminders.find(taskId);
+    if (it != m_reminders.end() && it->dueDate == dueDate) {
+        it->title = title;
+        return;
+    }
+
+    Reminder reminder;
+    reminder.title = title;
+    reminder.dueDate = dueDate;
+    reminder.fireAtMs = qMax(now, dueMs - ReminderLeadMs);
+    reminder.generation = ++m_nextGeneration;
+    m_reminders.insert(taskId, reminder);
+    m_heap.push({reminder.fireAtMs, taskId, reminder.generation});
+    compact();
+}
+
+void ReminderScheduler::unschedule(int taskId)
+{
+    // 堆里的旧条目留到弹出或压缩时再丢弃
+    m_reminders.remove(taskId);
+}
+
+// 截止时间在边界之后、提醒时间在边界之前的任务也要在这一段装入，否则到下一次装入时才补发
+qint64 ReminderScheduler::loadLimitMs() const
+{
+    return m_horizonMs + ReminderLeadMs;
+}
+
+bool ReminderScheduler::isCurrent(const Entry &entry) const
+{
+    auto it = m_reminders.constFind(entry.taskId);
+    return it != m_reminders.constEnd() && it->generation == entry.generation;
+}
+
+void ReminderScheduler::compact()
+{
+    if (m_heap.size() <= static_cast<size_t>(m_reminders.size()) * 2 + CompactSlack) {
+        return;
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(m_reminders.size());
+    for (auto it = m_reminders.constBegin(); it != m_reminders.constEnd(); ++it) {
+        entries.push_back({it->fireAtMs, it.key(), it->generation});
+    }
+    m_heap = decltype(m_heap)(std::greater<Entry>(), std::move(entries));
+}
+
+void ReminderScheduler::arm()
+{
+    while (!m_heap.empty() && !isCurrent(m_heap.top())) {
+        m_heap.pop();
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 next = m_heap.empty() ? m_horizonMs : qMin(m_heap.top().fireAtMs, m_horizonMs);
+    m_timer->start(static_cast<int>(qBound<qint64>(0, next - now, MaxTimerIntervalMs)));
+}
+
+void ReminderScheduler::fire(int taskId, const Reminder &reminder)
+{
+    const QString message = QString("任务 \"%1\" 将于 %2 到期。")
+                                .arg(reminder.title, DateUtils::formatDateTime(reminder.dueDate));
+
+    // 同一截止时间只提醒一次，重启后也不重复；截止时间改动后去重键不同，会再次提醒
+    Notification notification(0, Notification::Deadline, "截止提醒");
+    notification.setMessage(message);
+    notification.setTaskId(taskId);
+    notification.setDedupeKey(DateUtils::toIsoString(reminder.dueDate));
+    NotificationManager::instance().addNotification(notification);
+}
@@ -0,0 +1,78 @@
+#ifndef REMINDER_SCHEDULER_H
+#define REMINDER_SCHEDULER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <functional>
+#include <queue>
+#include <vector>
+#include "../models/task.h"
+
+class QTimer;
+class TaskController;
+
+// 截止提醒调度：按提醒时间维护一个最小堆，只为最近的一个提醒设置单个定时器
+// 启动时按 due_date 索引做一次范围查询，装入接下来一段时间内到期的任务，之后随 TaskController 的信号增量更新
+class ReminderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ReminderScheduler& instance();
+
+    void start();
+    // 数据被整体替换后重新装入
+    void reload();
+    void watch(TaskController *controller);
+    int pendingCount() const;
+
+private slots:
+    void onTaskChanged(const Task &task);
+    void onTaskDeleted(int taskId);
+    void onTaskCompletionChanged(int taskId, bool completed);
+    void onTimeout();
+
+private:
+    // 堆中的条目不原地修改：任务变化时推入新条目，旧条目凭 generation 失效，弹出时跳过
+    struct Entry {
+        qint64 fireAtMs;
+        int taskId;
+        quint32 generation;
+
+        bool operator>(const Entry &other) const
+        {
+            return fireAtMs > other.fireAtMs;
+        }
+    };
+
+    struct Reminder {
+        QString title;
+        QDateTime dueDate;
+        qint64 fireAtMs;
+        quint32 generation;
+    };
+
+    explicit ReminderScheduler(QObject *parent = nullptr);
+    ~ReminderScheduler();
+
+    ReminderScheduler(const ReminderScheduler&) = delete;
+    ReminderScheduler& operator=(const ReminderScheduler&) = delete;
+
+    void schedule(int taskId, const QString &title, const QDateTime &dueDate);
+    void unschedule(int taskId);
+    qint64 loadLimitMs() const;
+    bool isCurrent(const Entry &entry) const;
+    void compact();
+    void arm();
+    void fire(int taskId, const Reminder &reminder);
+
+    QTimer *m_timer;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> m_heap;
+    QHash<int, Reminder> m_reminders;
+    qint64 m_horizonMs;
+    quint32 m_nextGeneration;
+    bool m_started;
+};
+
+#endif // REMINDER_SCHEDULER_H
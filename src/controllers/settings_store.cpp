@@ -0,0 +1,194 @@
+#include "settings_store.h"
+#include "database.h"
+#include "../utils/logger.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include <QDateTime>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlError>
+
+namespace {
+// 同一次操作里连续修改的设置合并到一个事务中写回
+constexpr int FlushDelayMs = 500;
+}
+
+SettingsStore& SettingsStore::instance()
+{
+    static SettingsStore instance;
+    return instance;
+}
+
+SettingsStore::SettingsStore(QObject *parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+    , m_loaded(false)
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &SettingsStore::flush);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &SettingsStore::flush);
+    }
+}
+
+SettingsStore::~SettingsStore()
+{
+}
+
+void SettingsStore::load()
+{
+    // 先写回挂起的修改，避免重新读入时被旧值覆盖
+    flush();
+
+    QHash<QString, QString> values;
+    QSqlQuery query(Database::instance().database());
+    query.setForwardOnly(true);
+    if (query.exec("SELECT key, value FROM settings")) {
+        while (query.next()) {
+            values.insert(query.value(0).toString(), query.value(1).toString());
+        }
+    } else {
+        LOG_WARNING_F("Settings", "Failed to load settings: %1", query.lastError().text());
+    }
+    // 写回被推迟时库里还是旧值，以挂起的修改为准
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        values.insert(it.key(), it.value());
+    }
+
+    const bool notify = m_loaded;
+    const QHash<QString, QString> previous = m_values;
+    m_values = values;
+    m_loaded = true;
+    LOG_DEBUG_F("Settings", "Loaded %1 settings", m_values.size());
+
+    if (!notify) {
+        return;
+    }
+
+    QSet<QString> keys;
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        keys.insert(it.key());
+    }
+    for (auto it = m_values.constBegin(); it != m_values.constEnd(); ++it) {
+        keys.insert(it.key());
+    }
+    for (const QString &key : keys) {
+        if (previous.value(key) != m_values.value(key) || previous.contains(key) != m_values.contains(key)) {
+            emit settingChanged(key);
+        }
+    }
+}
+
+QString SettingsStore::value(const QString &key, const QString &defaultValue)
+{
+    ensureLoaded();
+    auto it = m_values.constFind(key);
+    return it != m_values.constEnd() ? it.value() : defaultValue;
+}
+
+int SettingsStore::intValue(const QString &key, int defaultValue)
+{
+    return value(key, QString::number(defaultValue)).toInt();
+}
+
+bool SettingsStore::boolValue(const QString &key, bool defaultValue)
+{
+    return value(key, defaultValue ? "1" : "0") == "1";
+}
+
+void SettingsStore::setValue(const QString &key, const QString &value)
+{
+    ensureLoaded();
+    auto it = m_values.find(key);
+    if (it != m_values.end() && it.value() == value) {
+        return;
+    }
+
+    m_values.insert(key, value);
+    m_pending.insert(key, value);
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    emit settingChanged(key);
+}
+
+void SettingsStore::setInt(const QString &key, int value)
+{
+    setValue(key, QString::number(value));
+}
+
+void SettingsStore::setBool(const QString &key, bool value)
+{
+    setValue(key, value ? "1" : "0");
+}
+
+bool SettingsStore::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+
+    QSqlDatabase &database = Database::instance().database();
+    if (!database.isOpen()) {
+        return false;
+    }
+    // 替换中途写入的设置会被恢复的数据覆盖，等替换结束再写
+    if (Database::instance().isRestoring()) {
+        m_flushTimer->start();
+        return false;
+    }
+
+    // 只在自己开启的事务里写入。外层事务（任务操作、导入）可能回滚，
+    // 跟着它提交会在回滚时丢掉设置，而内存中仍是新值；这时推迟到下一轮
+    if (!database.transaction()) {
+        LOG_DEBUG_F("Settings", "Deferring settings flush: %1", database.lastError().text());
+        m_flushTimer->start();
+        return false;
+    }
+
+    QSqlQuery query(database);
+    query.prepare("INSERT OR REPLACE INTO settings (key, value, updated_at) VALUES (?, ?, ?)");
+    const QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    bool ok = true;
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        query.addBindValue(it.key());
+        query.addBindValue(it.value());
+        query.addBindValue(now);
+        if (!query.exec()) {
+            LOG_WARNING_F("Settings", "Failed to write setting %1: %2", it.key(), query.lastError().text());
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok) {
+        ok = database.commit();
+        if (!ok) {
+            LOG_WARNING_F("Settings", "Failed to commit settings: %1", database.lastError().text());
+        }
+    }
+    if (!ok) {
+        database.rollback();
+        // 保留挂起的修改，下一次写入时再重试
+        return false;
+    }
+
+    LOG_DEBUG_F("Settings", "Flushed %1 settings", m_pending.size());
+    m_pending.clear();
+    return true;
+}
+
+bool SettingsStore::hasPendingWrites() const
+{
+    return !m_pending.isEmpty();
+}
+
+void SettingsStore::ensureLoaded()
+{
+    if (!m_loaded) {
+        load();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QString>
+
+class QTimer;
+
+// settings 表的内存副本：启动时整体读入一次，读取只查哈希表
+// 写入先更新内存并立即发出 settingChanged，短暂延迟后合并为一个事务写回数据库
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SettingsStore& instance();
+
+    // 重新读入整个 settings 表；数据集被替换后调用，值有变化的键会发出 settingChanged
+    void load();
+
+    QString value(const QString &key, const QString &defaultValue = QString());
+    int intValue(const QString &key, int defaultValue = 0);
+    bool boolValue(const QString &key, bool defaultValue = false);
+
+    void setValue(const QString &key, const QString &value);
+    void setInt(const QString &key, int value);
+    void setBool(const QString &key, bool value);
+
+    // 立即写回所有挂起的修改；其他连接读取数据库文件前需要先调用
+    bool flush();
+    bool hasPendingWrites() const;
+
+signals:
+    void settingChanged(const QString &key);
+
+private:
+    explicit SettingsStore(QObject *parent = nullptr);
+    ~SettingsStore();
+
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    void ensureLoaded();
+
+    QHash<QString, QString> m_values;
+    QMap<QString, QString> m_pending;
+    QTimer *m_flushTimer;
+    bool m_loaded;
+};
+
+#endif // SETTINGS_STORE_H
@@ -1,10 +1,55 @@
 #include "task_controller.h"
 #include "database.h"
+#include "change_journal.h"
+#include "reminder_scheduler.h"
+#include "../utils/logger.h"
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QSqlError>
+
+TaskController::UnitOfWork::UnitOfWork(TaskController *controller)
+    : m_controller(controller)
+    , m_finished(false)
+{
+    m_controller->beginUnit();
+}
+
+TaskController::UnitOfWork::~UnitOfWork()
+{
+    if (!m_finished) {
+        m_controller->endUnit(false);
+    }
+}
+
+bool TaskController::UnitOfWork::commit()
+{
+    if (m_finished) {
+        return false;
+    }
+    m_finished = true;
+    return m_controller->endUnit(true);
+}
+
+void TaskController::UnitOfWork::rollback()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_controller->endUnit(false);
+}
 
 TaskController::TaskController(QObject *parent)
     : QObject(parent)
+    , m_unitDepth(0)
+    , m_inTransaction(false)
+    , m_rollbackOnly(false)
+    , m_tagsDirty(false)
+    , m_dependenciesDirty(false)
+    , m_filesDirty(false)
 {
+    ReminderScheduler::instance().watch(this);
 }
 
 TaskController::~TaskController()
@@ -38,75 +83,162 @@ QList<Task> TaskController::getTaskHierarchy(int rootId)
 
 bool TaskController::addTask(Task &task)
 {
-    if (Database::instance().insertTask(task)) {
-        emit taskAdded(task);
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().insertTask(task)) {
+        return false;
     }
-    return false;
+    pendingChange(task.id()).added = true;
+    return unit.commit();
 }
 
 bool TaskController::updateTask(const Task &task)
 {
-    if (Database::instance().updateTask(task)) {
-        emit taskUpdated(task);
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().updateTask(task)) {
+        return false;
     }
-    return false;
+    pendingChange(task.id()).updated = true;
+    return unit.commit();
 }
 
 bool TaskController::deleteTask(int id)
 {
+    UnitOfWork unit(this);
     Task task = getTaskById(id);
-    if (Database::instance().deleteTask(id)) {
-        emit taskDeleted(id);
-        if (task.parentId() > 0) {
-            updateParentProgress(task.parentId());
-        }
-        return true;
+    if (!Database::instance().deleteTask(id)) {
+        return false;
     }
-    return false;
+    pendingChange(id).deleted = true;
+    if (task.parentId() > 0) {
+        updateParentProgress(task.parentId());
+    }
+    return unit.commit();
 }
 
 bool TaskController::restoreTask(int id)
 {
+    UnitOfWork unit(this);
     Task task = Database::instance().getTaskById(id, true);
-    if (Database::instance().restoreTask(id)) {
-        Task restored = getTaskById(id);
-        if (restored.id() > 0) {
-            emit taskUpdated(restored);
-        }
-        if (task.parentId() > 0) {
-            updateParentProgress(task.parentId());
-        }
-        return true;
+    if (!Database::instance().restoreTask(id)) {
+        return false;
     }
-    return false;
+    PendingChange &change = pendingChange(id);
+    change.deleted = false;
+    change.updated = true;
+    if (task.parentId() > 0) {
+        updateParentProgress(task.parentId());
+    }
+    return unit.commit();
 }
 
 bool TaskController::permanentlyDeleteTask(int id)
 {
+    UnitOfWork unit(this);
     Task task = Database::instance().getTaskById(id, true);
-    if (Database::instance().permanentlyDeleteTask(id)) {
-        emit taskDeleted(id);
-        if (task.parentId() > 0) {
-            updateParentProgress(task.parentId());
-        }
-        return true;
+    if (!Database::instance().permanentlyDeleteTask(id)) {
+        return false;
+    }
+    pendingChange(id).deleted = true;
+    if (task.parentId() > 0) {
+        updateParentProgress(task.parentId());
     }
-    return false;
+    return unit.commit();
 }
 
 bool TaskController::toggleTaskCompletion(int id)
 {
+    UnitOfWork unit(this);
     Task task = getTaskById(id);
     task.setCompleted(!task.isCompleted());
 
-    if (updateTask(task)) {
-        updateProgress(id);
-        emit taskCompletionChanged(id, task.isCompleted());
-        return true;
+    if (!updateTask(task)) {
+        return false;
+    }
+    updateProgress(id);
+    pendingChange(id).completionChanged = true;
+    return unit.commit();
+}
+
+bool TaskController::completeTasks(const QList<int> &ids, bool completed)
+{
+    UnitOfWork unit(this);
+    Database &db = Database::instance();
+    QList<int> changed;
+    QList<int> parents;
+    if (!db.setTasksCompleted(ids, completed, &changed, &parents)) {
+        return false;
+    }
+    for (int id : changed) {
+        PendingChange &change = pendingChange(id);
+        change.updated = true;
+        change.completionChanged = true;
+    }
+    markUpdated(db.refreshProgress(parents));
+    return unit.commit();
+}
+
+bool TaskController::deleteTasks(const QList<int> &ids)
+{
+    UnitOfWork unit(this);
+    Database &db = Database::instance();
+    QList<int> deleted;
+    QList<int> parents;
+    if (!db.deleteTasks(ids, &deleted, &parents)) {
+        return false;
+    }
+    for (int id : deleted) {
+        pendingChange(id).deleted = true;
+    }
+    markUpdated(db.refreshProgress(parents));
+    return unit.commit();
+}
+
+bool TaskController::assignTag(const QList<int> &ids, int tagId)
+{
+    UnitOfWork unit(this);
+    if (!Database::instance().assignTagToTasks(ids, tagId)) {
+        return false;
+    }
+    m_tagsDirty = true;
+    return unit.commit();
+}
+
+bool TaskController::moveToFolder(const QList<int> &ids, int folderId)
+{
+    UnitOfWork unit(this);
+    QList<int> moved;
+    if (!Database::instance().moveTasksToFolder(ids, folderId, &moved)) {
+        return false;
+    }
+    markUpdated(moved);
+    return unit.commit();
+}
+
+bool TaskController::reparentTasks(const QList<int> &ids, int parentId)
+{
+    UnitOfWork unit(this);
+    Database &db = Database::instance();
+    QList<int> moved;
+    QList<int> parents;
+    if (!db.reparentTasks(ids, parentId, &moved, &parents)) {
+        return false;
+    }
+    markUpdated(moved);
+    markUpdated(db.refreshProgress(parents));
+    return unit.commit();
+}
+
+bool TaskController::moveTasks(const QList<int> &ids, int parentId, int previousId, int nextId)
+{
+    UnitOfWork unit(this);
+    Database &db = Database::instance();
+    QList<int> parents;
+    if (!db.moveTasks(ids, parentId, previousId, nextId, &parents)) {
+        return false;
     }
-    return false;
+    markUpdated(ids);
+    markUpdated(db.refreshProgress(parents));
+    return unit.commit();
 }
 
 QList<Tag> TaskController::getAllTags()
@@ -121,65 +253,72 @@ QList<Tag> TaskController::getTagsByTaskId(int taskId)
 
 bool TaskController::addTag(Tag &tag)
 {
-    if (Database::instance().insertTag(tag)) {
-        emit tagsChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().insertTag(tag)) {
+        return false;
     }
-    return false;
+    m_tagsDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::updateTag(const Tag &tag)
 {
-    if (Database::instance().updateTag(tag)) {
-        emit tagsChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().updateTag(tag)) {
+        return false;
     }
-    return false;
+    m_tagsDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::deleteTag(int id)
 {
-    if (Database::instance().deleteTag(id)) {
-        emit tagsChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().deleteTag(id)) {
+        return false;
     }
-    return false;
+    m_tagsDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::assignTagToTask(int taskId, int tagId)
 {
-    if (Database::instance().assignTagToTask(taskId, tagId)) {
-        emit tagsChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().assignTagToTask(taskId, tagId)) {
+        return false;
     }
-    return false;
+    m_tagsDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::removeTagFromTask(int taskId, int tagId)
 {
-    if (Database::instance().removeTagFromTask(taskId, tagId)) {
-        emit tagsChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().removeTagFromTask(taskId, tagId)) {
+        return false;
     }
-    return false;
+    m_tagsDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::addDependency(int taskId, int dependsOnId)
 {
-    if (Database::instance().addDependency(taskId, dependsOnId)) {
-        emit dependenciesChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().addDependency(taskId, dependsOnId)) {
+        return false;
     }
-    return false;
+    m_dependenciesDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::removeDependency(int taskId, int dependsOnId)
 {
-    if (Database::instance().removeDependency(taskId, dependsOnId)) {
-        emit dependenciesChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().removeDependency(taskId, dependsOnId)) {
+        return false;
     }
-    return false;
+    m_dependenciesDirty = true;
+    return unit.commit();
 }
 
 QList<int> TaskController::getDependencyIdsForTask(int taskId)
@@ -204,45 +343,181 @@ QList<Task> TaskController::getCircularDependencies(int taskId)
 
 bool TaskController::addFileToTask(int taskId, const QString &filePath)
 {
+    UnitOfWork unit(this);
     QFileInfo fileInfo(filePath);
-    if (Database::instance().addFileToTask(taskId, filePath, fileInfo.fileName())) {
-        emit filesChanged();
-        return true;
+    if (!Database::instance().addFileToTask(taskId, filePath, fileInfo.fileName())) {
+        return false;
     }
-    return false;
+    m_filesDirty = true;
+    return unit.commit();
 }
 
 bool TaskController::removeFileFromTask(int fileId)
 {
-    if (Database::instance().removeFileFromTask(fileId)) {
-        emit filesChanged();
-        return true;
+    UnitOfWork unit(this);
+    if (!Database::instance().removeFileFromTask(fileId)) {
+        return false;
     }
-    return false;
+    m_filesDirty = true;
+    return unit.commit();
 }
 
 double TaskController::updateProgress(int taskId)
 {
+    UnitOfWork unit(this);
     double progress = Database::instance().calculateProgress(taskId);
     Task updatedTask = getTaskById(taskId);
-    emit taskUpdated(updatedTask);
+    pendingChange(taskId).updated = true;
 
     if (updatedTask.parentId() > 0) {
         updateParentProgress(updatedTask.parentId());
     }
 
+    unit.commit();
     return progress;
 }
 
 double TaskController::updateParentProgress(int taskId)
 {
+    UnitOfWork unit(this);
     double progress = Database::instance().calculateProgress(taskId);
     Task task = getTaskById(taskId);
-    emit taskUpdated(task);
+    pendingChange(taskId).updated = true;
 
     if (task.parentId() > 0) {
         updateParentProgress(task.parentId());
     }
 
+    unit.commit();
     return progress;
 }
+
+void TaskController::beginUnit()
+{
+    if (m_unitDepth++ > 0) {
+        return;
+    }
+
+    m_rollbackOnly = false;
+    QSqlQuery query(Database::instance().database());
+    // IMMEDIATE：先读后写时不会因为其他连接已提交而无法升级写锁
+    m_inTransaction = query.exec("BEGIN IMMEDIATE");
+    if (!m_inTransaction) {
+        LOG_WARNING_F("TaskController", "Failed to begin unit of work, running statements individually: %1",
+                      query.lastError().text());
+    }
+}
+
+bool TaskController::endUnit(bool commit)
+{
+    if (m_unitDepth <= 0) {
+        return false;
+    }
+    if (!commit) {
+        m_rollbackOnly = true;
+    }
+    if (--m_unitDepth > 0) {
+        return commit;
+    }
+
+    bool ok = !m_rollbackOnly;
+    const bool ownTransaction = m_inTransaction;
+    if (m_inTransaction) {
+        QSqlQuery query(Database::instance().database());
+        if (ok && !query.exec("COMMIT")) {
+            LOG_WARNING_F("TaskController", "Failed to commit unit of work: %1", query.lastError().text());
+            ok = false;
+        }
+        if (!ok) {
+            query.exec("ROLLBACK");
+        }
+        m_inTransaction = false;
+    }
+
+    if (ok) {
+        dispatchPendingChanges();
+        // 加入外层事务时记录尚未提交，由外层提交后再通知
+        if (ownTransaction) {
+            ChangeJournal::instance().check();
+        }
+    } else {
+        m_changeOrder.clear();
+        m_pendingChanges.clear();
+        m_tagsDirty = false;
+        m_dependenciesDirty = false;
+        m_filesDirty = false;
+    }
+    return ok;
+}
+
+TaskController::PendingChange &TaskController::pendingChange(int taskId)
+{
+    auto it = m_pendingChanges.find(taskId);
+    if (it == m_pendingChanges.end()) {
+        m_changeOrder.append(taskId);
+        it = m_pendingChanges.insert(taskId, PendingChange());
+    }
+    return it.value();
+}
+
+void TaskController::markUpdated(const QList<int> &taskIds)
+{
+    for (int taskId : taskIds) {
+        pendingChange(taskId).updated = true;
+    }
+}
+
+void TaskController::dispatchPendingChanges()
+{
+    // 先取出再发信号，槽函数里发起的新操作会开启自己的事务
+    const QVector<int> order = std::move(m_changeOrder);
+    const QHash<int, PendingChange> changes = std::move(m_pendingChanges);
+    const bool tagsDirty = m_tagsDirty;
+    const bool dependenciesDirty = m_dependenciesDirty;
+    const bool filesDirty = m_filesDirty;
+    m_changeOrder.clear();
+    m_pendingChanges.clear();
+    m_tagsDirty = false;
+    m_dependenciesDirty = false;
+    m_filesDirty = false;
+
+    if (order.isEmpty() && !tagsDirty && !dependenciesDirty && !filesDirty) {
+        return;
+    }
+
+    for (int taskId : order) {
+        const PendingChange change = changes.value(taskId);
+        if (change.deleted) {
+            // 同一次操作里新建又删除的任务外界从未见过
+            if (!change.added) {
+                emit taskDeleted(taskId);
+            }
+            continue;
+        }
+
+        // 以提交后的状态为准，中间的多次修改只通知一次
+        const Task task = getTaskById(taskId);
+        if (task.id() <= 0) {
+            continue;
+        }
+        if (change.added) {
+            emit taskAdded(task);
+        } else if (change.updated) {
+            emit taskUpdated(task);
+        }
+        if (change.completionChanged) {
+            emit taskCompletionChanged(taskId, task.isCompleted());
+        }
+    }
+
+    if (tagsDirty) {
+        emit tagsChanged();
+    }
+    if (dependenciesDirty) {
+        emit dependenciesChanged();
+    }
+    if (filesDirty) {
+        emit filesChanged();
+    }
+    emit changesCommitted();
+}
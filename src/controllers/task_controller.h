@@ -2,6 +2,8 @@
 #define TASK_CONTROLLER_H
 
 #include <QObject>
+#include <QHash>
+#include <QVector>
 #include "../models/task.h"
 #include "../models/tag.h"
 
@@ -10,6 +12,27 @@ class TaskController : public QObject
     Q_OBJECT
 
 public:
+    // 把一次用户操作中的多条语句放进同一个事务，作用域结束时未提交则回滚
+    // 事务期间的变更信号先记下，提交后每个任务只发出一次，最后发出一次 changesCommitted
+    // 可以嵌套，只有最外层提交时才真正写入
+    class UnitOfWork
+    {
+    public:
+        explicit UnitOfWork(TaskController *controller);
+        ~UnitOfWork();
+
+        bool commit();
+        // 出错后立即回滚并释放写锁，不要等到作用域结束；之后再弹出提示框
+        void rollback();
+
+    private:
+        UnitOfWork(const UnitOfWork&) = delete;
+        UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+        TaskController *m_controller;
+        bool m_finished;
+    };
+
     explicit TaskController(QObject *parent = nullptr);
     ~TaskController();
 
@@ -26,6 +49,15 @@ public:
     bool permanentlyDeleteTask(int id);
     bool toggleTaskCompletion(int id);
 
+    // 多选批量操作：各自在一个事务中用集合语句完成，提交后视图只刷新一次
+    bool completeTasks(const QList<int> &ids, bool completed = true);
+    bool deleteTasks(const QList<int> &ids);
+    bool assignTag(const QList<int> &ids, int tagId);
+    bool moveToFolder(const QList<int> &ids, int folderId);
+    bool reparentTasks(const QList<int> &ids, int parentId);
+    // 拖放排序：放到 parentId 下 previousId 与 nextId 之间，参数含义同 Database::moveTasks
+    bool moveTasks(const QList<int> &ids, int parentId, int previousId, int nextId);
+
     QList<Tag> getAllTags();
     QList<Tag> getTagsByTaskId(int taskId);
     bool addTag(Tag &tag);
@@ -55,6 +87,31 @@ signals:
     void tagsChanged();
     void dependenciesChanged();
     void filesChanged();
+    // 一次操作的全部变更提交后发出；只需整体刷新的视图监听它即可
+    void changesCommitted();
+
+private:
+    struct PendingChange {
+        bool added = false;
+        bool updated = false;
+        bool deleted = false;
+        bool completionChanged = false;
+    };
+
+    void beginUnit();
+    bool endUnit(bool commit);
+    PendingChange &pendingChange(int taskId);
+    void markUpdated(const QList<int> &taskIds);
+    void dispatchPendingChanges();
+
+    int m_unitDepth;
+    bool m_inTransaction;
+    bool m_rollbackOnly;
+    QVector<int> m_changeOrder;
+    QHash<int, PendingChange> m_pendingChanges;
+    bool m_tagsDirty;
+    bool m_dependenciesDirty;
+    bool m_filesDirty;
 };
 
 #endif // TASK_CONTROLLER_H
@@ -0,0 +1,602 @@
+#include "task_search_index.h"
+#include "database.h"
+#include "change_journal.h"
+#include "background_job.h"
+#include "../utils/logger.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+constexpr int CompactThreshold = 1024;
+constexpr int LinearScanLimit = 20000;
+constexpr qint64 MaxRelaxedPostings = 200000;
+constexpr qint64 MillisecondsPerDay = 24LL * 60 * 60 * 1000;
+
+quint64 bigramKey(QChar a, QChar b)
+{
+    return (Q_UINT64_C(1) << 48) | (quint64(a.unicode()) << 16) | quint64(b.unicode());
+}
+
+quint64 trigramKey(QChar a, QChar b, QChar c)
+{
+    return (quint64(a.unicode()) << 32) | (quint64(b.unicode()) << 16) | quint64(c.unicode());
+}
+
+QString foldText(const QString &text)
+{
+    return text.toCaseFolded().simplified();
+}
+
+// 变更日志的一次增量最多两千行，编号直接拼进 SQL，不受绑定参数个数的限制
+QString idList(const QSet<int> &ids)
+{
+    QStringList parts;
+    parts.reserve(ids.size());
+    for (int id : ids) {
+        parts << QString::number(id);
+    }
+    return parts.join(',');
+}
+
+QVector<quint64> textGrams(const QString &text)
+{
+    // 前面补两个空格，单字符/双字符查询可以命中词首
+    const QString padded = QStringLiteral("  ") + text;
+    QVector<quint64> grams;
+    grams.reserve(padded.size() * 2);
+    for (int i = 0; i + 1 < padded.size(); ++i) {
+        grams.append(bigramKey(padded.at(i), padded.at(i + 1)));
+        if (i + 2 < padded.size()) {
+            grams.append(trigramKey(padded.at(i), padded.at(i + 1), padded.at(i + 2)));
+        }
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+QVector<quint64> queryGrams(const QString &query)
+{
+    QVector<quint64> grams;
+    if (query.size() == 1) {
+        grams.append(bigramKey(QLatin1Char(' '), query.at(0)));
+    } else if (query.size() == 2) {
+        grams.append(bigramKey(query.at(0), query.at(1)));
+    } else {
+        for (int i = 0; i + 2 < query.size(); ++i) {
+            grams.append(trigramKey(query.at(i), query.at(i + 1), query.at(i + 2)));
+        }
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+int fuzzyScore(const QString &text, const QString &query)
+{
+    int score = 0;
+    int pos = 0;
+    int previous = -2;
+    int first = -1;
+    for (const QChar &ch : query) {
+        if (ch.isSpace()) {
+            continue;
+        }
+        while (pos < text.size() && text.at(pos) != ch) {
+            ++pos;
+        }
+        if (pos >= text.size()) {
+            return -1;
+        }
+        score += 10;
+        if (pos == previous + 1) {
+            score += 15;
+        }
+        if (pos == 0 || !text.at(pos - 1).isLetterOrNumber()) {
+            score += 20;
+        }
+        if (first < 0) {
+            first = pos;
+        }
+        previous = pos;
+        ++pos;
+    }
+
+    score -= qMin(first, 15);
+    if (text.startsWith(query)) {
+        score += 50;
+    } else if (text.contains(query)) {
+        score += 25;
+    }
+    score -= qMin((text.size() - query.size()) / 4, 10);
+    return score;
+}
+}
+
+TaskSearchIndex::TaskSearchIndex(QObject *parent)
+    : QObject(parent)
+    , m_deadCount(0)
+    , m_built(false)
+    , m_buildJob(new BackgroundJob(this))
+    , m_buildStale(false)
+{
+    // 任意 TaskController 的提交以及其他连接的写入都从变更日志得知
+    ChangeJournal::instance().registerConsumer(this);
+    connect(&ChangeJournal::instance(), &ChangeJournal::changesAvailable, this, &TaskSearchIndex::onJournalChanges);
+    connect(m_buildJob, &BackgroundJob::finished, this, &TaskSearchIndex::onBuildFinished);
+}
+
+TaskSearchIndex::~TaskSearchIndex()
+{
+    m_buildJob->wait();
+}
+
+QList<TaskSearchMatch> TaskSearchIndex::search(const QString &text, int limit)
+{
+    QList<TaskSearchMatch> results;
+    const QString query = foldText(text);
+    if (query.isEmpty() || limit <= 0) {
+        return results;
+    }
+
+    ensureBuilt();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<QPair<int, int>> scored;
+    for (int slot : collectCandidates(query, limit)) {
+        const Entry &entry = m_entries.at(slot);
+        if (!entry.alive) {
+            continue;
+        }
+        const int score = scoreEntry(entry, query, now);
+        if (score >= 0) {
+            scored.append(qMakePair(score, slot));
+        }
+    }
+
+    const int count = qMin(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      [](const QPair<int, int> &a, const QPair<int, int> &b) {
+                          return a.first > b.first;
+                      });
+
+    results.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Entry &entry = m_entries.at(scored.at(i).second);
+        TaskSearchMatch match;
+        match.taskId = entry.taskId;
+        match.title = entry.title;
+        match.priority = entry.priority;
+        match.completed = entry.completed;
+        match.score = scored.at(i).first;
+        results.append(match);
+    }
+    return results;
+}
+
+void TaskSearchIndex::buildInBackground()
+{
+    if (m_buildJob->isRunning()) {
+        // 正在读取的快照可能早于这次重置，读完后再来一轮
+        m_buildStale = true;
+        return;
+    }
+
+    const QString databasePath = Database::instance().database().databaseName();
+    if (databasePath.isEmpty()) {
+        return;
+    }
+
+    m_buildStale = false;
+    m_pendingTaskIds.clear();
+    m_pendingTagIds.clear();
+    m_pendingLinkTaskIds.clear();
+    m_buildResult = Snapshot();
+    m_buildError.clear();
+
+    const QString connectionName = BackgroundJob::connectionName("search_index");
+    m_buildJob->start([this, databasePath, connectionName]() {
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(databasePath);
+            database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1;QSQLITE_OPEN_READONLY").arg(BackgroundJob::BusyTimeoutMs));
+            if (!database.open()) {
+                m_buildError = database.lastError().text();
+            } else {
+                loadSnapshot(database, &m_buildResult, &m_buildError);
+                database.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    });
+}
+
+void TaskSearchIndex::invalidate()
+{
+    m_built = false;
+    buildInBackground();
+}
+
+int TaskSearchIndex::size() const
+{
+    return m_slotByTaskId.size();
+}
+
+void TaskSearchIndex::onJournalChanges()
+{
+    const ChangeJournal::Delta delta = ChangeJournal::instance().pull(this);
+    if (delta.isEmpty()) {
+        return;
+    }
+    if (delta.reset) {
+        invalidate();
+        return;
+    }
+
+    // 后台构建读到的快照可能早于这些变化，先记下，接管结果后再补上
+    if (m_buildJob->isRunning()) {
+        m_pendingTaskIds += delta.rowIds("tasks");
+        m_pendingTagIds += delta.rowIds("tags");
+        m_pendingLinkTaskIds += delta.rowIds("task_tags");
+        return;
+    }
+    if (!m_built) {
+        return;
+    }
+    applyChanges(delta.rowIds("tasks"), delta.rowIds("tags"), delta.rowIds("task_tags"));
+}
+
+void TaskSearchIndex::onBuildFinished()
+{
+    if (m_buildStale) {
+        buildInBackground();
+        return;
+    }
+    if (!m_buildError.isEmpty()) {
+        LOG_WARNING_F("TaskSearchIndex", "Background build failed: %1", m_buildError);
+        m_buildResult = Snapshot();
+        return;
+    }
+
+    adopt(&m_buildResult);
+    LOG_DEBUG_F("TaskSearchIndex", "Indexed %1 tasks in background in %2 ms", m_entries.size(), m_buildJob->elapsedMs());
+
+    const QSet<int> taskIds = m_pendingTaskIds;
+    const QSet<int> tagIds = m_pendingTagIds;
+    const QSet<int> linkTaskIds = m_pendingLinkTaskIds;
+    m_pendingTaskIds.clear();
+    m_pendingTagIds.clear();
+    m_pendingLinkTaskIds.clear();
+    applyChanges(taskIds, tagIds, linkTaskIds);
+}
+
+void TaskSearchIndex::applyChanges(const QSet<int> &taskIds, const QSet<int> &tagIds, const QSet<int> &linkTaskIds)
+{
+    Database &db = Database::instance();
+    QSqlQuery query(db.database());
+    query.setForwardOnly(true);
+    QSet<int> retagged = linkTaskIds;
+
+    // 改名或删除的标签影响所有带它的任务
+    if (!tagIds.isEmpty()) {
+        for (int tagId : tagIds) {
+            m_tagNames.remove(tagId);
+        }
+        if (query.exec(QString("SELECT id, name FROM tags WHERE id IN (%1)").arg(idList(tagIds)))) {
+            while (query.next()) {
+                m_tagNames.insert(query.value(0).toInt(), foldText(query.value(1).toString()));
+            }
+        }
+        if (query.exec(QString("SELECT DISTINCT task_id FROM task_tags WHERE tag_id IN (%1)").arg(idList(tagIds)))) {
+            while (query.next()) {
+                retagged.insert(query.value(0).toInt());
+            }
+        }
+    }
+
+    for (int taskId : taskIds) {
+        // 已删除或移入回收站的任务查不到
+        const Task task = db.getTaskById(taskId);
+        if (task.id() > 0) {
+            updateEntry(task);
+        } else {
+            removeEntry(taskId);
+        }
+    }
+
+    if (retagged.isEmpty()) {
+        return;
+    }
+    QHash<int, QStringList> tagsByTask;
+    if (query.exec(QString("SELECT task_id, tag_id FROM task_tags WHERE task_id IN (%1)").arg(idList(retagged)))) {
+        while (query.next()) {
+            const QString name = m_tagNames.value(query.value(1).toInt());
+            if (!name.isEmpty()) {
+                tagsByTask[query.value(0).toInt()].append(name);
+            }
+        }
+    }
+    for (int taskId : retagged) {
+        setEntryTags(taskId, tagsByTask.value(taskId).join(' '));
+    }
+}
+
+void TaskSearchIndex::updateEntry(const Task &task)
+{
+    auto it = m_slotByTaskId.constFind(task.id());
+    if (it == m_slotByTaskId.constEnd()) {
+        appendEntry(makeEntry(task, QString()));
+        return;
+    }
+
+    Entry &entry = m_entries[it.value()];
+    const QString foldedTitle = foldText(task.title());
+    if (entry.foldedTitle == foldedTitle) {
+        entry.title = task.title();
+        entry.priority = task.priority();
+        entry.completed = task.isCompleted();
+        if (task.updatedAt().isValid()) {
+            entry.updatedAt = task.updatedAt().toMSecsSinceEpoch();
+        }
+        return;
+    }
+
+    const QString foldedTags = entry.foldedTags;
+    removeEntry(task.id());
+    appendEntry(makeEntry(task, foldedTags));
+}
+
+void TaskSearchIndex::setEntryTags(int taskId, const QString &foldedTags)
+{
+    auto it = m_slotByTaskId.constFind(taskId);
+    if (it == m_slotByTaskId.constEnd() || m_entries.at(it.value()).foldedTags == foldedTags) {
+        return;
+    }
+
+    // 倒排列表按槽位有序，改了索引文本的条目只能作废后追加到末尾
+    Entry entry = m_entries.at(it.value());
+    entry.foldedTags = foldedTags;
+    removeEntry(taskId);
+    appendEntry(entry);
+}
+
+void TaskSearchIndex::ensureBuilt()
+{
+    // 启动时的后台构建还没完成就要搜索，等它读完比在界面线程再读一遍快
+    while (m_buildJob->isRunning()) {
+        m_buildJob->waitForFinished();
+    }
+    if (!m_built) {
+        rebuild();
+    }
+}
+
+void TaskSearchIndex::rebuild()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Snapshot snapshot;
+    QString error;
+    if (!loadSnapshot(Database::instance().database(), &snapshot, &error)) {
+        LOG_WARNING_F("TaskSearchIndex", "Failed to build index: %1", error);
+    }
+    adopt(&snapshot);
+
+    LOG_DEBUG_F("TaskSearchIndex", "Indexed %1 tasks in %2 ms", m_entries.size(), timer.elapsed());
+}
+
+bool TaskSearchIndex::loadSnapshot(QSqlDatabase &database, Snapshot *snapshot, QString *error)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name FROM tags")) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        snapshot->tagNames.insert(query.value(0).toInt(), foldText(query.value(1).toString()));
+    }
+
+    QHash<int, QStringList> tagsByTask;
+    if (!query.exec("SELECT task_id, tag_id FROM task_tags")) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        const QString name = snapshot->tagNames.value(query.value(1).toInt());
+        if (!name.isEmpty()) {
+            tagsByTask[query.value(0).toInt()].append(name);
+        }
+    }
+
+    if (!query.exec("SELECT id, title, priority, completed, updated_at FROM tasks WHERE is_deleted = 0")) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        Entry entry;
+        entry.taskId = query.value(0).toInt();
+        entry.title = query.value(1).toString();
+        entry.foldedTitle = foldText(entry.title);
+        entry.foldedTags = tagsByTask.value(entry.taskId).join(' ');
+        entry.priority = query.value(2).toInt();
+        entry.completed = query.value(3).toBool();
+        const QDateTime updatedAt = QDateTime::fromString(query.value(4).toString(), Qt::ISODate);
+        entry.updatedAt = updatedAt.isValid() ? updatedAt.toMSecsSinceEpoch() : 0;
+        entry.alive = true;
+
+        const int slot = snapshot->entries.size();
+        snapshot->entries.append(entry);
+        snapshot->slotByTaskId.insert(entry.taskId, slot);
+        indexEntry(entry, slot, &snapshot->postings);
+    }
+    return true;
+}
+
+void TaskSearchIndex::adopt(Snapshot *snapshot)
+{
+    m_entries.swap(snapshot->entries);
+    m_slotByTaskId.swap(snapshot->slotByTaskId);
+    m_postings.swap(snapshot->postings);
+    m_tagNames.swap(snapshot->tagNames);
+    *snapshot = Snapshot();
+    m_deadCount = 0;
+    m_built = true;
+}
+
+void TaskSearchIndex::appendEntry(const Entry &entry)
+{
+    const int slot = m_entries.size();
+    m_entries.append(entry);
+    m_slotByTaskId.insert(entry.taskId, slot);
+    indexEntry(entry, slot, &m_postings);
+}
+
+void TaskSearchIndex::indexEntry(const Entry &entry, int slot, QHash<quint64, QVector<int>> *postings)
+{
+    // 新条目总是追加在末尾，倒排列表因此保持有序
+    for (quint64 gram : textGrams(entry.foldedTitle + ' ' + entry.foldedTags)) {
+        (*postings)[gram].append(slot);
+    }
+}
+
+void TaskSearchIndex::removeEntry(int taskId)
+{
+    auto it = m_slotByTaskId.find(taskId);
+    if (it == m_slotByTaskId.end()) {
+        return;
+    }
+    m_entries[it.value()].alive = false;
+    m_slotByTaskId.erase(it);
+    ++m_deadCount;
+    compact();
+}
+
+void TaskSearchIndex::compact()
+{
+    if (m_deadCount < CompactThreshold || m_deadCount * 2 < m_entries.size()) {
+        return;
+    }
+
+    QVector<Entry> aliveEntries;
+    aliveEntries.reserve(m_entries.size() - m_deadCount);
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.alive) {
+            aliveEntries.append(entry);
+        }
+    }
+
+    m_entries.clear();
+    m_slotByTaskId.clear();
+    m_postings.clear();
+    m_deadCount = 0;
+    for (const Entry &entry : qAsConst(aliveEntries)) {
+        appendEntry(entry);
+    }
+}
+
+TaskSearchIndex::Entry TaskSearchIndex::makeEntry(const Task &task, const QString &foldedTags) const
+{
+    Entry entry;
+    entry.taskId = task.id();
+    entry.title = task.title();
+    entry.foldedTitle = foldText(task.title());
+    entry.foldedTags = foldedTags;
+    entry.priority = task.priority();
+    entry.updatedAt = task.updatedAt().isValid() ? task.updatedAt().toMSecsSinceEpoch() : 0;
+    entry.completed = task.isCompleted();
+    entry.alive = true;
+    return entry;
+}
+
+QVector<int> TaskSearchIndex::collectCandidates(const QString &query, int limit) const
+{
+    const QVector<quint64> grams = queryGrams(query);
+    QVector<const QVector<int> *> lists;
+    bool allPresent = true;
+    for (quint64 gram : grams) {
+        auto it = m_postings.constFind(gram);
+        if (it == m_postings.constEnd()) {
+            allPresent = false;
+            continue;
+        }
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+        return a->size() < b->size();
+    });
+
+    QVector<int> candidates;
+    if (allPresent && !lists.isEmpty()) {
+        candidates = *lists.first();
+        for (int i = 1; i < lists.size() && !candidates.isEmpty(); ++i) {
+            QVector<int> next;
+            next.reserve(candidates.size());
+            std::set_intersection(candidates.cbegin(), candidates.cend(),
+                                  lists.at(i)->cbegin(), lists.at(i)->cend(),
+                                  std::back_inserter(next));
+            candidates.swap(next);
+        }
+    }
+
+    // 连续片段命中不足时放宽为命中过半的 n-gram，交给子序列打分筛选
+    if (candidates.size() < limit && lists.size() > 1) {
+        qint64 total = 0;
+        for (const QVector<int> *list : qAsConst(lists)) {
+            total += list->size();
+        }
+        if (total <= MaxRelaxedPostings) {
+            const int threshold = (grams.size() + 1) / 2;
+            QHash<int, int> hits;
+            for (const QVector<int> *list : qAsConst(lists)) {
+                for (int slot : *list) {
+                    ++hits[slot];
+                }
+            }
+            const QSet<int> existing(candidates.cbegin(), candidates.cend());
+            for (auto it = hits.cbegin(); it != hits.cend(); ++it) {
+                if (it.value() >= threshold && !existing.contains(it.key())) {
+                    candidates.append(it.key());
+                }
+            }
+        }
+    }
+
+    if (candidates.isEmpty() && m_entries.size() <= LinearScanLimit) {
+        candidates.reserve(m_entries.size());
+        for (int slot = 0; slot < m_entries.size(); ++slot) {
+            candidates.append(slot);
+        }
+    }
+
+    return candidates;
+}
+
+int TaskSearchIndex::scoreEntry(const Entry &entry, const QString &query, qint64 now) const
+{
+    int score = fuzzyScore(entry.foldedTitle, query);
+    if (score < 0) {
+        if (!entry.foldedTags.contains(query)) {
+            return -1;
+        }
+        score = 20;
+    }
+
+    score += entry.priority * 8;
+    if (entry.updatedAt > 0) {
+        const qint64 days = (now - entry.updatedAt) / MillisecondsPerDay;
+        score += static_cast<int>(qBound<qint64>(0, 30 - days, 30));
+    }
+    if (entry.completed) {
+        score -= 30;
+    }
+    return qMax(score, 0);
+}
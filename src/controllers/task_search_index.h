@@ -0,0 +1,94 @@
+#ifndef TASK_SEARCH_INDEX_H
+#define TASK_SEARCH_INDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include "../models/task.h"
+
+class QSqlDatabase;
+class BackgroundJob;
+
+struct TaskSearchMatch
+{
+    int taskId = 0;
+    QString title;
+    int priority = 0;
+    bool completed = false;
+    int score = 0;
+};
+
+class TaskSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TaskSearchIndex(QObject *parent = nullptr);
+    ~TaskSearchIndex();
+
+    QList<TaskSearchMatch> search(const QString &text, int limit = 20);
+    // 启动后在工作线程中用独立连接建立索引；在此之前搜索会等它完成
+    void buildInBackground();
+    void invalidate();
+    int size() const;
+
+private slots:
+    void onJournalChanges();
+    void onBuildFinished();
+
+private:
+    struct Entry {
+        int taskId;
+        QString title;
+        QString foldedTitle;
+        QString foldedTags;
+        int priority;
+        qint64 updatedAt;
+        bool completed;
+        bool alive;
+    };
+
+    struct Snapshot {
+        QVector<Entry> entries;
+        QHash<int, int> slotByTaskId;
+        QHash<quint64, QVector<int>> postings;
+        QHash<int, QString> tagNames;
+    };
+
+    static bool loadSnapshot(QSqlDatabase &database, Snapshot *snapshot, QString *error);
+    static void indexEntry(const Entry &entry, int slot, QHash<quint64, QVector<int>> *postings);
+
+    void ensureBuilt();
+    void rebuild();
+    void adopt(Snapshot *snapshot);
+    void applyChanges(const QSet<int> &taskIds, const QSet<int> &tagIds, const QSet<int> &linkTaskIds);
+    void updateEntry(const Task &task);
+    void setEntryTags(int taskId, const QString &foldedTags);
+    void appendEntry(const Entry &entry);
+    void removeEntry(int taskId);
+    void compact();
+    Entry makeEntry(const Task &task, const QString &foldedTags) const;
+    QVector<int> collectCandidates(const QString &query, int limit) const;
+    int scoreEntry(const Entry &entry, const QString &query, qint64 now) const;
+
+    QVector<Entry> m_entries;
+    QHash<int, int> m_slotByTaskId;
+    QHash<quint64, QVector<int>> m_postings;
+    // 标签编号到折叠后的名称，标签改名时据此重算相关条目
+    QHash<int, QString> m_tagNames;
+    int m_deadCount;
+    bool m_built;
+
+    BackgroundJob *m_buildJob;
+    Snapshot m_buildResult;
+    QString m_buildError;
+    bool m_buildStale;
+    QSet<int> m_pendingTaskIds;
+    QSet<int> m_pendingTagIds;
+    QSet<int> m_pendingLinkTaskIds;
+};
+
+#endif // TASK_SEARCH_INDEX_H
@@ -11,6 +11,9 @@ int main(int argc, char *argv[])
     app.setOrganizationName("GoodIdea");
 
     App appController;
+    if (!appController.claimInstance()) {
+        return 0;
+    }
     appController.init();
 
     return app.exec();
@@ -39,6 +39,10 @@ public:
     QDateTime createdAt() const { return m_createdAt; }
     void setCreatedAt(const QDateTime &createdAt) { m_createdAt = createdAt; }
 
+    // 同一类型、同一任务下去重键相同的通知只保存一条
+    QString dedupeKey() const { return m_dedupeKey; }
+    void setDedupeKey(const QString &dedupeKey) { m_dedupeKey = dedupeKey; }
+
     QString typeString() const;
     QString typeDisplayName() const;
 
@@ -50,6 +54,7 @@ private:
     int m_taskId;
     bool m_read;
     QDateTime m_createdAt;
+    QString m_dedupeKey;
 };
 
 #endif // NOTIFICATION_H
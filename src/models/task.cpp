@@ -1,8 +1,8 @@
 #include "task.h"
 
-Task::Task()
+TaskData::TaskData()
     : m_id(0)
-    , m_priority(Medium)
+    , m_priority(Task::Medium)
     , m_completed(false)
     , m_parentId(0)
     , m_hasChildren(false)
@@ -10,18 +10,19 @@ Task::Task()
 {
 }
 
+Task::Task()
+    : d(new TaskData)
+{
+}
+
 Task::Task(int id, const QString &title)
-    : m_id(id)
-    , m_title(title)
-    , m_priority(Medium)
-    , m_completed(false)
-    , m_parentId(0)
-    , m_hasChildren(false)
-    , m_progress(0.0)
+    : d(new TaskData)
 {
+    d->m_id = id;
+    d->m_title = title;
 }
 
 double Task::progress() const
 {
-    return m_progress;
+    return d->m_progress;
 }
@@ -0,0 +1,142 @@
+#include "task_record.h"
+
+namespace {
+qint64 toEpoch(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toSecsSinceEpoch() : 0;
+}
+
+QDateTime fromEpoch(qint64 seconds)
+{
+    return seconds != 0 ? QDateTime::fromSecsSinceEpoch(seconds) : QDateTime();
+}
+}
+
+void TaskRecordTable::clear()
+{
+    m_records.clear();
+    m_titles.clear();
+    m_idArena.clear();
+    m_internedSpans.clear();
+    m_rowById.clear();
+}
+
+void TaskRecordTable::reserve(int rows)
+{
+    m_records.reserve(rows);
+    m_titles.reserve(rows);
+    m_rowById.reserve(rows);
+}
+
+int TaskRecordTable::append(const Task &task)
+{
+    const TaskRecord record = makeRecord(task);
+    const int row = m_records.size();
+    m_records.append(record);
+    m_titles.append(task.title());
+    m_rowById.insert(record.id, row);
+    return row;
+}
+
+int TaskRecordTable::update(const Task &task)
+{
+    const int row = rowOf(task.id());
+    if (row < 0) {
+        return append(task);
+    }
+    m_records[row] = makeRecord(task);
+    m_titles[row] = task.title();
+    return row;
+}
+
+TaskRecordTable::IdSpan TaskRecordTable::tagIds(int row) const
+{
+    const TaskRecord &r = m_records.at(row);
+    return span(r.tagOffset, r.tagCount);
+}
+
+TaskRecordTable::IdSpan TaskRecordTable::dependencyIds(int row) const
+{
+    const TaskRecord &r = m_records.at(row);
+    return span(r.dependencyOffset, r.dependencyCount);
+}
+
+Task TaskRecordTable::toTask(int row) const
+{
+    const TaskRecord &r = m_records.at(row);
+    Task task(r.id, m_titles.at(row));
+    task.setPriority(r.priority);
+    task.setDueDate(fromEpoch(r.dueDate));
+    task.setCompleted(r.isCompleted());
+    task.setParentId(r.parentId);
+    task.setHasChildren(r.hasChildren());
+    task.setCreatedAt(fromEpoch(r.createdAt));
+    task.setUpdatedAt(fromEpoch(r.updatedAt));
+    task.setProgress(r.progress);
+
+    QList<int> tagIdList;
+    for (qint32 id : tagIds(row)) {
+        tagIdList.append(id);
+    }
+    task.setTagIds(tagIdList);
+
+    QList<int> dependencyIdList;
+    for (qint32 id : dependencyIds(row)) {
+        dependencyIdList.append(id);
+    }
+    task.setDependencyIds(dependencyIdList);
+    return task;
+}
+
+quint32 TaskRecordTable::internIds(const QList<int> &ids)
+{
+    if (ids.isEmpty()) {
+        return 0;
+    }
+
+    // 相同的 id 序列只保存一份
+    QVector<qint32> key;
+    key.reserve(ids.size());
+    for (int id : ids) {
+        key.append(id);
+    }
+    auto it = m_internedSpans.constFind(key);
+    if (it != m_internedSpans.constEnd()) {
+        return it.value();
+    }
+
+    const quint32 offset = static_cast<quint32>(m_idArena.size());
+    m_idArena.append(key);
+    m_internedSpans.insert(key, offset);
+    return offset;
+}
+
+TaskRecord TaskRecordTable::makeRecord(const Task &task)
+{
+    const QList<int> tagIds = task.tagIds();
+    const QList<int> dependencyIds = task.dependencyIds();
+
+    TaskRecord record;
+    record.dueDate = toEpoch(task.dueDate());
+    record.createdAt = toEpoch(task.createdAt());
+    record.updatedAt = toEpoch(task.updatedAt());
+    record.id = task.id();
+    record.parentId = task.parentId();
+    record.tagOffset = internIds(tagIds);
+    record.dependencyOffset = internIds(dependencyIds);
+    record.progress = static_cast<float>(task.progress());
+    record.tagCount = static_cast<quint16>(tagIds.size());
+    record.dependencyCount = static_cast<quint16>(dependencyIds.size());
+    record.priority = static_cast<quint8>(task.priority());
+    record.flags = (task.isCompleted() ? TaskRecord::Completed : 0)
+                 | (task.hasChildren() ? TaskRecord::HasChildren : 0);
+    return record;
+}
+
+TaskRecordTable::IdSpan TaskRecordTable::span(quint32 offset, quint16 count) const
+{
+    if (count == 0) {
+        return IdSpan{nullptr, 0};
+    }
+    return IdSpan{m_idArena.constData() + offset, count};
+}
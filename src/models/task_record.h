@@ -0,0 +1,76 @@
+#ifndef TASK_RECORD_H
+#define TASK_RECORD_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include "task.h"
+
+// 批量视图使用的紧凑任务行：时间以秒级时间戳保存，标签/依赖 id 存放在共享区中
+struct TaskRecord
+{
+    enum Flag : quint8 {
+        Completed = 0x1,
+        HasChildren = 0x2
+    };
+
+    qint64 dueDate;
+    qint64 createdAt;
+    qint64 updatedAt;
+    qint32 id;
+    qint32 parentId;
+    quint32 tagOffset;
+    quint32 dependencyOffset;
+    float progress;
+    quint16 tagCount;
+    quint16 dependencyCount;
+    quint8 priority;
+    quint8 flags;
+
+    bool isCompleted() const { return flags & Completed; }
+    bool hasChildren() const { return flags & HasChildren; }
+};
+
+class TaskRecordTable
+{
+public:
+    struct IdSpan {
+        const qint32 *data;
+        int size;
+
+        const qint32 *begin() const { return data; }
+        const qint32 *end() const { return data + size; }
+        bool isEmpty() const { return size == 0; }
+    };
+
+    void clear();
+    void reserve(int rows);
+    int append(const Task &task);
+    // 已有该任务的行时原地覆盖，否则追加；增量刷新用它避免同一任务占多行
+    int update(const Task &task);
+
+    int size() const { return m_records.size(); }
+    int rowOf(int taskId) const { return m_rowById.value(taskId, -1); }
+    bool contains(int taskId) const { return m_rowById.contains(taskId); }
+
+    const TaskRecord &record(int row) const { return m_records.at(row); }
+    QString title(int row) const { return m_titles.at(row); }
+    IdSpan tagIds(int row) const;
+    IdSpan dependencyIds(int row) const;
+
+    // 还原出的 Task 不含描述与附件路径
+    Task toTask(int row) const;
+
+private:
+    TaskRecord makeRecord(const Task &task);
+    quint32 internIds(const QList<int> &ids);
+    IdSpan span(quint32 offset, quint16 count) const;
+
+    QVector<TaskRecord> m_records;
+    QVector<QString> m_titles;
+    QVector<qint32> m_idArena;
+    QHash<QVector<qint32>, quint32> m_internedSpans;
+    QHash<int, int> m_rowById;
+};
+
+#endif // TASK_RECORD_H
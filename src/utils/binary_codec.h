@@ -0,0 +1,71 @@
+#ifndef BINARY_CODEC_H
+#define BINARY_CODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <array>
+
+// 快照、备份归档和二进制日志共用的编码原语：CRC32（IEEE 多项式）、LEB128 变长整数和 zigzag
+namespace BinaryCodec {
+inline quint32 crc32(const uchar *bytes, int size)
+{
+    static const std::array<quint32, 256> table = []() {
+        std::array<quint32, 256> values{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            values[i] = c;
+        }
+        return values;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (int i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+inline quint32 crc32(const QByteArray &data)
+{
+    return crc32(reinterpret_cast<const uchar *>(data.constData()), data.size());
+}
+
+inline void appendVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+// 从 data[*pos] 开始读取，最多读到 end 之前；数据不完整或超过 64 位时返回 false
+inline bool readVarint(const uchar *data, int end, int *pos, quint64 *value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64 && *pos < end; shift += 7) {
+        const quint8 byte = data[(*pos)++];
+        result |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline quint64 zigzag(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+inline qint64 unzigzag(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+} // namespace BinaryCodec
+
+#endif // BINARY_CODEC_H
@@ -275,3 +275,23 @@ QDateTime DateUtils::parseDateTime(const QString &dateTimeString, const QString
 {
     return QDateTime::fromString(dateTimeString, format);
 }
+
+QString DateUtils::toIsoString(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid()) {
+        return QString();
+    }
+    return dateTime.toUTC().toString(Qt::ISODate);
+}
+
+QDateTime DateUtils::parseIsoString(const QString &value)
+{
+    if (value.trimmed().isEmpty()) {
+        return QDateTime();
+    }
+    QDateTime parsed = QDateTime::fromString(value, Qt::ISODate);
+    if (!parsed.isValid()) {
+        parsed = QDateTime::fromString(value, Qt::ISODateWithMs);
+    }
+    return parsed;
+}
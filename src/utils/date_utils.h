@@ -46,6 +46,10 @@ public:
     static bool isValidDate(const QString &dateString, const QString &format = "yyyy-MM-dd");
     static QDateTime parseDateTime(const QString &dateTimeString, const QString &format = "yyyy-MM-dd HH:mm:ss");
 
+    // 导入导出使用的 UTC ISO 8601 表示，无效时间对应空串
+    static QString toIsoString(const QDateTime &dateTime);
+    static QDateTime parseIsoString(const QString &value);
+
 private:
     DateUtils() = default;
     ~DateUtils() = default;
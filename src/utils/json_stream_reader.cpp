@@ -0,0 +1,424 @@
+#include "json_stream_reader.h"
+#include <QIODevice>
+
+namespace {
+constexpr int ReadBlockSize = 64 * 1024;
+
+void appendUtf8(QByteArray *out, uint codePoint)
+{
+    if (codePoint < 0x80) {
+        out->append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out->append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out->append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out->append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out->append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out->append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out->append(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out->append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out->append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out->append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+int hexValue(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+} // namespace
+
+JsonStreamReader::JsonStreamReader(QIODevice *device)
+    : m_device(device)
+    , m_pos(0)
+    , m_consumed(0)
+    , m_state(ExpectValue)
+    , m_token(Invalid)
+    , m_number(0.0)
+    , m_boolean(false)
+{
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    switch (m_state) {
+        case Failed:
+            return Invalid;
+        case Done:
+            if (peekNonSpace() >= 0) {
+                return fail("Unexpected data after document");
+            }
+            m_token = EndOfDocument;
+            return m_token;
+        case ExpectValue:
+            return readValue();
+        case ExpectValueOrEnd:
+            if (peekNonSpace() == ']') {
+                getChar();
+                return closeContainer(']');
+            }
+            return readValue();
+        case ExpectName:
+        case ExpectNameOrEnd: {
+            const int c = peekNonSpace();
+            if (c == '}' && m_state == ExpectNameOrEnd) {
+                getChar();
+                return closeContainer('}');
+            }
+            if (c != '"') {
+                return fail("Expected member name");
+            }
+            getChar();
+            if (!readString(&m_text)) {
+                return Invalid;
+            }
+            if (peekNonSpace() != ':') {
+                return fail("Expected ':' after member name");
+            }
+            getChar();
+            m_state = ExpectValue;
+            m_token = Name;
+            return m_token;
+        }
+        case ExpectCommaOrEnd: {
+            const int c = peekNonSpace();
+            getChar();
+            if (c == ',') {
+                m_state = m_stack.last() == '{' ? ExpectName : ExpectValue;
+                return next();
+            }
+            if (c == '}' || c == ']') {
+                return closeContainer(static_cast<char>(c));
+            }
+            return fail("Expected ',' or end of container");
+        }
+    }
+    return Invalid;
+}
+
+JsonStreamReader::Token JsonStreamReader::token() const
+{
+    return m_token;
+}
+
+QString JsonStreamReader::text() const
+{
+    return QString::fromUtf8(m_text);
+}
+
+const QByteArray &JsonStreamReader::utf8Text() const
+{
+    return m_text;
+}
+
+double JsonStreamReader::number() const
+{
+    return m_number;
+}
+
+bool JsonStreamReader::boolean() const
+{
+    return m_boolean;
+}
+
+bool JsonStreamReader::isValueStart() const
+{
+    return m_token == BeginObject || m_token == BeginArray || m_token == String
+        || m_token == Number || m_token == Bool || m_token == Null;
+}
+
+bool JsonStreamReader::skipCurrent()
+{
+    if (m_token == Name && next() == Invalid) {
+        return false;
+    }
+    if (m_token != BeginObject && m_token != BeginArray) {
+        return m_token != Invalid;
+    }
+
+    const int depth = m_stack.size();
+    while (m_stack.size() >= depth) {
+        if (next() == Invalid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonStreamReader::hasError() const
+{
+    return m_state == Failed;
+}
+
+QString JsonStreamReader::errorString() const
+{
+    return m_error;
+}
+
+qint64 JsonStreamReader::offset() const
+{
+    return m_consumed + m_pos;
+}
+
+JsonStreamReader::Token JsonStreamReader::readValue()
+{
+    const int c = peekNonSpace();
+    switch (c) {
+        case '{':
+            getChar();
+            m_stack.append('{');
+            m_state = ExpectNameOrEnd;
+            m_token = BeginObject;
+            return m_token;
+        case '[':
+            getChar();
+            m_stack.append('[');
+            m_state = ExpectValueOrEnd;
+            m_token = BeginArray;
+            return m_token;
+        case '"':
+            getChar();
+            if (!readString(&m_text)) {
+                return Invalid;
+            }
+            m_token = String;
+            break;
+        case 't':
+            if (!readLiteral("true")) {
+                return Invalid;
+            }
+            m_boolean = true;
+            m_token = Bool;
+            break;
+        case 'f':
+            if (!readLiteral("false")) {
+                return Invalid;
+            }
+            m_boolean = false;
+            m_token = Bool;
+            break;
+        case 'n':
+            if (!readLiteral("null")) {
+                return Invalid;
+            }
+            m_token = Null;
+            break;
+        default:
+            if (c < 0) {
+                return fail("Unexpected end of data");
+            }
+            if (c != '-' && (c < '0' || c > '9')) {
+                return fail("Unexpected character");
+            }
+            if (!readNumber()) {
+                return Invalid;
+            }
+            m_token = Number;
+            break;
+    }
+
+    afterValue();
+    return m_token;
+}
+
+JsonStreamReader::Token JsonStreamReader::closeContainer(char close)
+{
+    const char expected = m_stack.last() == '{' ? '}' : ']';
+    if (close != expected) {
+        return fail("Mismatched end of container");
+    }
+
+    m_stack.removeLast();
+    afterValue();
+    m_token = close == '}' ? EndObject : EndArray;
+    return m_token;
+}
+
+bool JsonStreamReader::readString(QByteArray *out)
+{
+    out->clear();
+    for (;;) {
+        if (!fill()) {
+            fail("Unterminated string");
+            return false;
+        }
+
+        // 普通字符整段复制，只有转义和结束引号需要逐个处理
+        const char *data = m_buffer.constData();
+        const int size = m_buffer.size();
+        int end = m_pos;
+        while (end < size) {
+            const uchar c = static_cast<uchar>(data[end]);
+            if (c == '"' || c == '\\' || c < 0x20) {
+                break;
+            }
+            ++end;
+        }
+        out->append(data + m_pos, end - m_pos);
+        m_pos = end;
+        if (end == size) {
+            continue;
+        }
+
+        const int c = getChar();
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            fail("Control character in string");
+            return false;
+        }
+
+        const int escaped = getChar();
+        switch (escaped) {
+            case '"':  out->append('"'); break;
+            case '\\': out->append('\\'); break;
+            case '/':  out->append('/'); break;
+            case 'b':  out->append('\b'); break;
+            case 'f':  out->append('\f'); break;
+            case 'n':  out->append('\n'); break;
+            case 'r':  out->append('\r'); break;
+            case 't':  out->append('\t'); break;
+            case 'u': {
+                auto readUnit = [this]() -> int {
+                    int unit = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        const int digit = hexValue(getChar());
+                        if (digit < 0) {
+                            return -1;
+                        }
+                        unit = (unit << 4) | digit;
+                    }
+                    return unit;
+                };
+
+                int unit = readUnit();
+                if (unit < 0) {
+                    fail("Invalid unicode escape");
+                    return false;
+                }
+                uint codePoint = static_cast<uint>(unit);
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    int low = -1;
+                    if (getChar() == '\\' && getChar() == 'u') {
+                        low = readUnit();
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        fail("Invalid surrogate pair");
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((static_cast<uint>(unit) - 0xD800) << 10) + (static_cast<uint>(low) - 0xDC00);
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                fail("Invalid escape sequence");
+                return false;
+        }
+    }
+}
+
+bool JsonStreamReader::readLiteral(const char *literal)
+{
+    for (const char *p = literal; *p; ++p) {
+        if (getChar() != *p) {
+            fail("Invalid literal");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonStreamReader::readNumber()
+{
+    QByteArray digits;
+    for (;;) {
+        const int c = peekChar();
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            digits.append(static_cast<char>(c));
+            ++m_pos;
+        } else {
+            break;
+        }
+    }
+
+    bool ok = false;
+    m_number = digits.toDouble(&ok);
+    if (!ok) {
+        fail("Invalid number");
+        return false;
+    }
+    return true;
+}
+
+void JsonStreamReader::afterValue()
+{
+    m_state = m_stack.isEmpty() ? Done : ExpectCommaOrEnd;
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString &message)
+{
+    if (m_state != Failed) {
+        m_error = QString("%1 at offset %2").arg(message).arg(offset());
+        m_state = Failed;
+    }
+    m_token = Invalid;
+    return m_token;
+}
+
+int JsonStreamReader::peekChar()
+{
+    if (!fill()) {
+        return -1;
+    }
+    return static_cast<uchar>(m_buffer.at(m_pos));
+}
+
+int JsonStreamReader::peekNonSpace()
+{
+    for (;;) {
+        const int c = peekChar();
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return c;
+        }
+        ++m_pos;
+    }
+}
+
+int JsonStreamReader::getChar()
+{
+    const int c = peekChar();
+    if (c >= 0) {
+        ++m_pos;
+    }
+    return c;
+}
+
+bool JsonStreamReader::fill()
+{
+    if (m_pos < m_buffer.size()) {
+        return true;
+    }
+
+    const bool firstBlock = m_consumed == 0 && m_buffer.isEmpty();
+    m_consumed += m_buffer.size();
+    m_buffer = m_device->read(ReadBlockSize);
+    m_pos = 0;
+
+    // 与 QJsonDocument 一致，允许文件以 UTF-8 BOM 开头
+    if (firstBlock && m_buffer.startsWith("\xEF\xBB\xBF")) {
+        m_pos = 3;
+    }
+    return m_pos < m_buffer.size();
+}
@@ -0,0 +1,85 @@
+#ifndef JSON_STREAM_READER_H
+#define JSON_STREAM_READER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+// 按记号顺序读取 JSON，不构建文档树；设备按块读入，内存占用与文件大小无关
+// 对象成员先返回 Name，再返回成员值的记号
+class JsonStreamReader
+{
+public:
+    enum Token {
+        Invalid,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Name,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndOfDocument
+    };
+
+    explicit JsonStreamReader(QIODevice *device);
+
+    Token next();
+    Token token() const;
+
+    // Name 和 String 的文本、Number 和 Bool 的值
+    QString text() const;
+    const QByteArray &utf8Text() const;
+    double number() const;
+    bool boolean() const;
+    bool isValueStart() const;
+
+    // 当前记号是值的开头时跳过整个值，容器会一直读到对应的结束符
+    bool skipCurrent();
+
+    bool hasError() const;
+    QString errorString() const;
+    qint64 offset() const;
+
+private:
+    enum State {
+        ExpectValue,
+        ExpectValueOrEnd,
+        ExpectName,
+        ExpectNameOrEnd,
+        ExpectCommaOrEnd,
+        Done,
+        Failed
+    };
+
+    Token readValue();
+    Token closeContainer(char close);
+    bool readString(QByteArray *out);
+    bool readLiteral(const char *literal);
+    bool readNumber();
+    void afterValue();
+    Token fail(const QString &message);
+
+    int peekChar();
+    int peekNonSpace();
+    int getChar();
+    bool fill();
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_pos;
+    qint64 m_consumed;
+    QVector<char> m_stack;
+    State m_state;
+    Token m_token;
+    QByteArray m_text;
+    double m_number;
+    bool m_boolean;
+    QString m_error;
+};
+
+#endif // JSON_STREAM_READER_H
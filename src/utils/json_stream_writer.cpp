@@ -0,0 +1,147 @@
+#include "json_stream_writer.h"
+#include <QIODevice>
+
+namespace {
+constexpr int BufferFlushSize = 64 * 1024;
+constexpr int IndentWidth = 4;
+} // namespace
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device)
+    : m_device(device)
+    , m_error(false)
+{
+    m_buffer.reserve(BufferFlushSize + 4096);
+}
+
+void JsonStreamWriter::beginObject(const char *name)
+{
+    beginValue(name);
+    m_buffer.append('{');
+    m_hasMembers.append(false);
+}
+
+void JsonStreamWriter::endObject()
+{
+    endContainer('}');
+}
+
+void JsonStreamWriter::beginArray(const char *name)
+{
+    beginValue(name);
+    m_buffer.append('[');
+    m_hasMembers.append(false);
+}
+
+void JsonStreamWriter::endArray()
+{
+    endContainer(']');
+}
+
+void JsonStreamWriter::writeString(const char *name, const QString &value)
+{
+    beginValue(name);
+    appendEscaped(value);
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeInt(const char *name, qint64 value)
+{
+    beginValue(name);
+    m_buffer.append(QByteArray::number(value));
+}
+
+void JsonStreamWriter::writeBool(const char *name, bool value)
+{
+    beginValue(name);
+    m_buffer.append(value ? "true" : "false");
+}
+
+bool JsonStreamWriter::flush()
+{
+    if (!m_error && !m_buffer.isEmpty() && m_device->write(m_buffer) != m_buffer.size()) {
+        m_error = true;
+    }
+    m_buffer.clear();
+    return !m_error;
+}
+
+bool JsonStreamWriter::hasError() const
+{
+    return m_error;
+}
+
+void JsonStreamWriter::beginValue(const char *name)
+{
+    if (!m_hasMembers.isEmpty()) {
+        m_buffer.append(m_hasMembers.last() ? ",\n" : "\n");
+        m_hasMembers.last() = true;
+        m_buffer.append(QByteArray(m_hasMembers.size() * IndentWidth, ' '));
+    }
+
+    if (name) {
+        m_buffer.append('"');
+        m_buffer.append(name);
+        m_buffer.append("\": ");
+    }
+}
+
+void JsonStreamWriter::endContainer(char close)
+{
+    if (m_hasMembers.isEmpty()) {
+        return;
+    }
+
+    if (m_hasMembers.takeLast()) {
+        m_buffer.append('\n');
+        m_buffer.append(QByteArray(m_hasMembers.size() * IndentWidth, ' '));
+    }
+    m_buffer.append(close);
+
+    if (m_hasMembers.isEmpty()) {
+        m_buffer.append('\n');
+    }
+    flushIfFull();
+}
+
+void JsonStreamWriter::appendEscaped(const QString &text)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    const QByteArray utf8 = text.toUtf8();
+    m_buffer.append('"');
+
+    // 多字节 UTF-8 序列原样输出，只转义引号、反斜杠和控制字符
+    int runStart = 0;
+    for (int i = 0; i < utf8.size(); ++i) {
+        const uchar c = static_cast<uchar>(utf8.at(i));
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        m_buffer.append(utf8.constData() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  m_buffer.append("\\\""); break;
+            case '\\': m_buffer.append("\\\\"); break;
+            case '\n': m_buffer.append("\\n"); break;
+            case '\r': m_buffer.append("\\r"); break;
+            case '\t': m_buffer.append("\\t"); break;
+            case '\b': m_buffer.append("\\b"); break;
+            case '\f': m_buffer.append("\\f"); break;
+            default:
+                m_buffer.append("\\u00");
+                m_buffer.append(hexDigits[c >> 4]);
+                m_buffer.append(hexDigits[c & 0x0F]);
+                break;
+        }
+    }
+    m_buffer.append(utf8.constData() + runStart, utf8.size() - runStart);
+    m_buffer.append('"');
+}
+
+void JsonStreamWriter::flushIfFull()
+{
+    if (m_buffer.size() >= BufferFlushSize) {
+        flush();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef JSON_STREAM_WRITER_H
+#define JSON_STREAM_WRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+// 顺序写出缩进格式的 JSON，不构建文档树；缓冲区写满后直接落到设备
+// name 为 nullptr 表示数组元素，否则为当前对象的成员名
+class JsonStreamWriter
+{
+public:
+    explicit JsonStreamWriter(QIODevice *device);
+
+    void beginObject(const char *name = nullptr);
+    void endObject();
+    void beginArray(const char *name = nullptr);
+    void endArray();
+
+    void writeString(const char *name, const QString &value);
+    void writeInt(const char *name, qint64 value);
+    void writeBool(const char *name, bool value);
+
+    bool flush();
+    bool hasError() const;
+
+private:
+    void beginValue(const char *name);
+    void endContainer(char close);
+    void appendEscaped(const QString &text);
+    void flushIfFull();
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    QVector<bool> m_hasMembers;
+    bool m_error;
+};
+
+#endif // JSON_STREAM_WRITER_H
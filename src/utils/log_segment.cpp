@@ -0,0 +1,422 @@
+#include "log_segment.h"
+#include "binary_codec.h"
+#include <QtEndian>
+#include <atomic>
+#include <cstring>
+
+const QString LogSegmentWriter::FILE_EXTENSION = ".tlog";
+
+namespace {
+constexpr quint32 SegmentMagic = 0x54444C42; // "TDLB"
+constexpr quint16 SegmentVersion = 1;
+constexpr int HeaderSize = 32;
+constexpr int SealReserve = 2;
+constexpr int MaxStringBytes = 16 * 1024;
+
+enum RecordKind : quint8 {
+    EndOfData = 0,
+    StringDefinition = 1,
+    Entry = 2,
+    Seal = 3
+};
+
+enum FieldType : quint8 {
+    IntField = 1,
+    DoubleField = 2,
+    StringField = 3
+};
+
+using BinaryCodec::appendVarint;
+using BinaryCodec::unzigzag;
+using BinaryCodec::zigzag;
+
+void appendString(QByteArray &out, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8().left(MaxStringBytes);
+    appendVarint(out, static_cast<quint64>(utf8.size()));
+    out.append(utf8);
+}
+
+void appendRecord(QByteArray &out, RecordKind kind, const QByteArray &payload)
+{
+    out.append(static_cast<char>(kind));
+    appendVarint(out, static_cast<quint64>(payload.size()));
+    out.append(payload);
+}
+
+bool readVarint(const QByteArray &data, int *pos, int end, quint64 *value)
+{
+    return BinaryCodec::readVarint(reinterpret_cast<const uchar *>(data.constData()), end, pos, value);
+}
+
+bool readString(const QByteArray &data, int *pos, int end, QString *text)
+{
+    quint64 length = 0;
+    if (!readVarint(data, pos, end, &length) || length > static_cast<quint64>(end - *pos)) {
+        return false;
+    }
+    *text = QString::fromUtf8(data.constData() + *pos, static_cast<int>(length));
+    *pos += static_cast<int>(length);
+    return true;
+}
+} // namespace
+
+QString formatLogMessage(const QString &format, const QVector<QVariant> &fields)
+{
+    if (format.isEmpty()) {
+        return fields.isEmpty() ? QString() : fields.first().toString();
+    }
+
+    QString text = format;
+    for (const QVariant &field : fields) {
+        switch (field.userType()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Bool:
+            text = text.arg(field.toLongLong());
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            text = text.arg(field.toDouble());
+            break;
+        default:
+            text = text.arg(field.toString());
+            break;
+        }
+    }
+    return text;
+}
+
+QString LogRecord::message() const
+{
+    return formatLogMessage(format, fields);
+}
+
+LogSegmentWriter::LogSegmentWriter(qint64 capacity)
+    : m_data(nullptr)
+    , m_capacity(capacity)
+    , m_pos(0)
+    , m_lastUs(0)
+{
+}
+
+LogSegmentWriter::~LogSegmentWriter()
+{
+    close(false);
+}
+
+bool LogSegmentWriter::open(const QString &path, quint32 sequence, qint64 wallClockMs, quint64 monotonicUs)
+{
+    close(false);
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+
+    // 预分配整段空间后映射，未写入的部分全为 0，读取端遇到 0 即认为到达末尾
+    if (!m_file.resize(m_capacity) || !(m_data = m_file.map(0, m_capacity))) {
+        m_file.close();
+        m_file.remove();
+        return false;
+    }
+
+    qToLittleEndian<quint32>(SegmentMagic, m_data);
+    qToLittleEndian<quint16>(SegmentVersion, m_data + 4);
+    qToLittleEndian<quint16>(0, m_data + 6);
+    qToLittleEndian<quint32>(sequence, m_data + 8);
+    qToLittleEndian<quint32>(0, m_data + 12);
+    qToLittleEndian<qint64>(wallClockMs, m_data + 16);
+    qToLittleEndian<quint64>(monotonicUs, m_data + 24);
+
+    m_pos = HeaderSize;
+    m_lastUs = monotonicUs;
+    m_strings.clear();
+    return true;
+}
+
+void LogSegmentWriter::close(bool sealed)
+{
+    if (!m_data) {
+        return;
+    }
+
+    if (sealed && m_pos + SealReserve <= m_capacity) {
+        m_data[m_pos + 1] = 0;
+        m_data[m_pos] = Seal;
+        m_pos += SealReserve;
+    }
+
+    // 关闭时截掉预分配的空白区域
+    m_file.unmap(m_data);
+    m_data = nullptr;
+    m_file.resize(m_pos);
+    m_file.close();
+}
+
+bool LogSegmentWriter::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool LogSegmentWriter::append(const LogRecord &record)
+{
+    if (!m_data) {
+        return false;
+    }
+
+    m_scratch.clear();
+    QVector<QString> added;
+    const quint64 categoryId = internedId(record.category, &m_scratch, &added);
+    const quint64 formatId = record.format.isEmpty() ? 0 : internedId(record.format, &m_scratch, &added);
+
+    m_payload.clear();
+    m_payload.append(static_cast<char>(record.level));
+    appendVarint(m_payload, zigzag(static_cast<qint64>(record.monotonicUs - m_lastUs)));
+    appendVarint(m_payload, categoryId);
+    appendVarint(m_payload, record.threadId);
+    appendVarint(m_payload, formatId);
+    appendVarint(m_payload, static_cast<quint64>(record.fields.size()));
+    for (const QVariant &field : record.fields) {
+        switch (field.userType()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Bool:
+            m_payload.append(static_cast<char>(IntField));
+            appendVarint(m_payload, zigzag(field.toLongLong()));
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float: {
+            m_payload.append(static_cast<char>(DoubleField));
+            uchar bytes[8];
+            qToLittleEndian<double>(field.toDouble(), bytes);
+            m_payload.append(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+            break;
+        }
+        default:
+            m_payload.append(static_cast<char>(StringField));
+            appendString(m_payload, field.toString());
+            break;
+        }
+    }
+    appendRecord(m_scratch, Entry, m_payload);
+
+    if (m_pos + m_scratch.size() + SealReserve > m_capacity) {
+        for (const QString &text : added) {
+            m_strings.remove(text);
+        }
+        return false;
+    }
+
+    // 先写记录体，最后写首个类型字节，读取端不会看到半条记录
+    std::memcpy(m_data + m_pos + 1, m_scratch.constData() + 1, static_cast<size_t>(m_scratch.size() - 1));
+    std::atomic_thread_fence(std::memory_order_release);
+    m_data[m_pos] = static_cast<uchar>(m_scratch.at(0));
+
+    m_pos += m_scratch.size();
+    m_lastUs = record.monotonicUs;
+    return true;
+}
+
+QString LogSegmentWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+qint64 LogSegmentWriter::bytesUsed() const
+{
+    return m_pos;
+}
+
+QString LogSegmentWriter::errorString() const
+{
+    return m_file.errorString();
+}
+
+quint64 LogSegmentWriter::internedId(const QString &text, QByteArray *definitions, QVector<QString> *added)
+{
+    const auto it = m_strings.constFind(text);
+    if (it != m_strings.constEnd()) {
+        return it.value();
+    }
+
+    const quint64 id = static_cast<quint64>(m_strings.size()) + 1;
+    m_strings.insert(text, id);
+    added->append(text);
+
+    QByteArray payload;
+    appendVarint(payload, id);
+    payload.append(text.toUtf8().left(MaxStringBytes));
+    appendRecord(*definitions, StringDefinition, payload);
+    return id;
+}
+
+LogSegmentReader::LogSegmentReader()
+    : m_dataStart(0)
+    , m_pos(0)
+    , m_sequence(0)
+    , m_baseWallClockMs(0)
+    , m_baseUs(0)
+    , m_lastUs(0)
+    , m_sealed(false)
+{
+}
+
+bool LogSegmentReader::open(const QString &path, QString *error)
+{
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = m_file.errorString();
+        }
+        return false;
+    }
+
+    const QByteArray header = m_file.read(HeaderSize);
+    const uchar *bytes = reinterpret_cast<const uchar *>(header.constData());
+    if (header.size() != HeaderSize || qFromLittleEndian<quint32>(bytes) != SegmentMagic
+        || qFromLittleEndian<quint16>(bytes + 4) != SegmentVersion) {
+        if (error) {
+            *error = QString("Not a log segment: %1").arg(path);
+        }
+        m_file.close();
+        return false;
+    }
+
+    m_sequence = qFromLittleEndian<quint32>(bytes + 8);
+    m_baseWallClockMs = qFromLittleEndian<qint64>(bytes + 16);
+    m_baseUs = qFromLittleEndian<quint64>(bytes + 24);
+    m_lastUs = m_baseUs;
+    m_strings.clear();
+    m_sealed = false;
+    m_dataStart = HeaderSize;
+    m_pos = 0;
+    m_data = m_file.readAll();
+    return true;
+}
+
+bool LogSegmentReader::next(LogRecord *record)
+{
+    while (!m_sealed) {
+        bool isEntry = false;
+        if (!parseRecord(record, &isEntry)) {
+            return false;
+        }
+        if (isEntry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogSegmentReader::refresh()
+{
+    if (m_sealed || !m_file.isOpen()) {
+        return;
+    }
+
+    m_dataStart += m_pos;
+    m_pos = 0;
+    m_data.clear();
+    if (m_file.seek(m_dataStart)) {
+        m_data = m_file.readAll();
+    }
+}
+
+bool LogSegmentReader::isSealed() const
+{
+    return m_sealed;
+}
+
+QString LogSegmentReader::fileName() const
+{
+    return m_file.fileName();
+}
+
+quint32 LogSegmentReader::sequence() const
+{
+    return m_sequence;
+}
+
+// 只有完整的记录才会推进读取位置，写到一半的记录留到下次 refresh
+bool LogSegmentReader::parseRecord(LogRecord *record, bool *isEntry)
+{
+    if (m_pos >= m_data.size()) {
+        return false;
+    }
+
+    const quint8 kind = static_cast<quint8>(m_data.at(m_pos));
+    if (kind == EndOfData) {
+        return false;
+    }
+
+    int pos = m_pos + 1;
+    quint64 length = 0;
+    if (!readVarint(m_data, &pos, m_data.size(), &length) || length > static_cast<quint64>(m_data.size() - pos)) {
+        return false;
+    }
+    const int end = pos + static_cast<int>(length);
+
+    if (kind == Seal) {
+        m_sealed = true;
+    } else if (kind == StringDefinition) {
+        quint64 id = 0;
+        if (readVarint(m_data, &pos, end, &id)) {
+            m_strings.insert(id, QString::fromUtf8(m_data.constData() + pos, end - pos));
+        }
+    } else if (kind == Entry && pos < end) {
+        LogRecord parsed;
+        parsed.level = static_cast<quint8>(m_data.at(pos++));
+
+        quint64 delta = 0;
+        quint64 categoryId = 0;
+        quint64 threadId = 0;
+        quint64 formatId = 0;
+        quint64 fieldCount = 0;
+        bool ok = readVarint(m_data, &pos, end, &delta)
+            && readVarint(m_data, &pos, end, &categoryId)
+            && readVarint(m_data, &pos, end, &threadId)
+            && readVarint(m_data, &pos, end, &formatId)
+            && readVarint(m_data, &pos, end, &fieldCount);
+
+        for (quint64 i = 0; ok && i < fieldCount; ++i) {
+            const quint8 type = pos < end ? static_cast<quint8>(m_data.at(pos++)) : 0;
+            if (type == IntField) {
+                quint64 value = 0;
+                ok = readVarint(m_data, &pos, end, &value);
+                parsed.fields.append(QVariant(unzigzag(value)));
+            } else if (type == DoubleField && end - pos >= 8) {
+                parsed.fields.append(QVariant(qFromLittleEndian<double>(m_data.constData() + pos)));
+                pos += 8;
+            } else if (type == StringField) {
+                QString text;
+                ok = readString(m_data, &pos, end, &text);
+                parsed.fields.append(QVariant(text));
+            } else {
+                ok = false;
+            }
+        }
+
+        if (ok) {
+            m_lastUs += static_cast<quint64>(unzigzag(delta));
+            parsed.monotonicUs = m_lastUs;
+            parsed.wallClockMs = m_baseWallClockMs + static_cast<qint64>(m_lastUs - m_baseUs) / 1000;
+            parsed.threadId = static_cast<quint32>(threadId);
+            parsed.category = m_strings.value(categoryId);
+            parsed.format = m_strings.value(formatId);
+            *record = parsed;
+            *isEntry = true;
+        }
+    }
+
+    // 无法识别的记录按长度跳过，保持向后兼容
+    m_pos = end;
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef LOG_SEGMENT_H
+#define LOG_SEGMENT_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QVariant>
+
+// 一条结构化日志：format 为空时 fields 只含一条完整消息文本
+struct LogRecord
+{
+    int level = 0;
+    quint64 monotonicUs = 0;
+    qint64 wallClockMs = 0;
+    quint32 threadId = 0;
+    QString category;
+    QString format;
+    QVector<QVariant> fields;
+
+    QString message() const;
+};
+
+QString formatLogMessage(const QString &format, const QVector<QVariant> &fields);
+
+// 二进制日志段写入器：预分配固定大小的文件并内存映射，记录按变长编码顺序追加，
+// 分类和格式串在段内去重为整数 id；进程崩溃时已写入的记录仍保留在文件中
+class LogSegmentWriter
+{
+public:
+    explicit LogSegmentWriter(qint64 capacity);
+    ~LogSegmentWriter();
+
+    bool open(const QString &path, quint32 sequence, qint64 wallClockMs, quint64 monotonicUs);
+    // sealed 为 true 时写入段结束标记，读取端据此切换到下一段
+    void close(bool sealed);
+    bool isOpen() const;
+
+    // 段内剩余空间不足时返回 false，由调用方切换新段
+    bool append(const LogRecord &record);
+
+    QString fileName() const;
+    qint64 bytesUsed() const;
+    QString errorString() const;
+
+    static const QString FILE_EXTENSION;
+
+private:
+    quint64 internedId(const QString &text, QByteArray *definitions, QVector<QString> *added);
+
+    QFile m_file;
+    uchar *m_data;
+    qint64 m_capacity;
+    qint64 m_pos;
+    quint64 m_lastUs;
+    QHash<QString, quint64> m_strings;
+    QByteArray m_scratch;
+    QByteArray m_payload;
+};
+
+// 二进制日志段读取器，可对仍在写入的段反复 refresh 实现跟踪
+class LogSegmentReader
+{
+public:
+    LogSegmentReader();
+
+    bool open(const QString &path, QString *error);
+    bool next(LogRecord *record);
+    void refresh();
+    bool isSealed() const;
+
+    QString fileName() const;
+    quint32 sequence() const;
+
+private:
+    bool parseRecord(LogRecord *record, bool *isEntry);
+
+    QFile m_file;
+    QByteArray m_data;
+    qint64 m_dataStart;
+    int m_pos;
+    quint32 m_sequence;
+    qint64 m_baseWallClockMs;
+    quint64 m_baseUs;
+    quint64 m_lastUs;
+    QHash<quint64, QString> m_strings;
+    bool m_sealed;
+};
+
+#endif // LOG_SEGMENT_H
@@ -1,7 +1,102 @@
 #include "logger.h"
+#include "log_segment.h"
 #include <QDir>
-#include <QFileInfo>
 #include <QDebug>
+#include <QThread>
+
+namespace {
+constexpr int QueueCapacity = 8192;
+constexpr int BatchWakeThreshold = 256;
+constexpr unsigned long FlushIntervalMs = 250;
+constexpr unsigned long WrittenWaitSliceMs = 50;
+
+// 进程内的短线程编号，比原生线程句柄更紧凑，按首次写日志的顺序分配
+quint32 currentThreadTag()
+{
+    static std::atomic<quint32> nextTag(1);
+    thread_local const quint32 tag = nextTag.fetch_add(1, std::memory_order_relaxed);
+    return tag;
+}
+} // namespace
+
+// 有界多生产者单消费者队列（Vyukov 算法），满时由调用方决定丢弃
+class LogQueue
+{
+public:
+    explicit LogQueue(int capacity)
+        : m_slots(new Slot[capacity])
+        , m_mask(static_cast<quint64>(capacity) - 1)
+        , m_enqueuePos(0)
+        , m_dequeuePos(0)
+    {
+        for (int i = 0; i < capacity; ++i) {
+            m_slots[i].sequence.store(static_cast<quint64>(i), std::memory_order_relaxed);
+        }
+    }
+
+    ~LogQueue()
+    {
+        delete[] m_slots;
+    }
+
+    quint64 push(LogRecord &&entry)
+    {
+        quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot &slot = m_slots[pos & m_mask];
+            const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+            const qint64 diff = static_cast<qint64>(sequence) - static_cast<qint64>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.entry = std::move(entry);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return pos + 1;
+                }
+            } else if (diff < 0) {
+                return 0;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(LogRecord *entry)
+    {
+        const quint64 pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[pos & m_mask];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<qint64>(sequence) - static_cast<qint64>(pos + 1) < 0) {
+            return false;
+        }
+
+        *entry = std::move(slot.entry);
+        slot.entry = LogRecord();
+        slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_dequeuePos.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    quint64 enqueued() const
+    {
+        return m_enqueuePos.load(std::memory_order_acquire);
+    }
+
+    quint64 dequeued() const
+    {
+        return m_dequeuePos.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence;
+        LogRecord entry;
+    };
+
+    Slot *m_slots;
+    const quint64 m_mask;
+    alignas(64) std::atomic<quint64> m_enqueuePos;
+    alignas(64) std::atomic<quint64> m_dequeuePos;
+};
 
 Logger& Logger::instance()
 {
@@ -12,54 +107,98 @@ Logger& Logger::instance()
 Logger::Logger()
     : m_minLevel(INFO)
     , m_logDirectory(QDir::currentPath() + "/logs")
-    , m_maxFileSize(10 * 1024 * 1024)
+    , m_maxFileSize(4 * 1024 * 1024)
     , m_maxLogFiles(30)
+    , m_queue(new LogQueue(QueueCapacity))
+    , m_segment(new LogSegmentWriter(m_maxFileSize))
+    , m_segmentSequence(0)
+    , m_clockStartMs(0)
+    , m_writerThread(nullptr)
+    , m_writtenTicket(0)
+    , m_stopping(false)
+    , m_droppedCount(0)
+    , m_reportedDropped(0)
 {
     QDir logDir(m_logDirectory);
     if (!logDir.exists()) {
         logDir.mkpath(".");
     }
+
+    m_clockStartMs = QDateTime::currentMSecsSinceEpoch();
+    m_clock.start();
+
+    m_writerThread = QThread::create([this]() { runWriter(); });
+    m_writerThread->start(QThread::LowPriority);
 }
 
 Logger::~Logger()
 {
-    if (m_logFile.isOpen()) {
-        m_logStream.flush();
-        m_logFile.close();
-    }
+    m_stopping.store(true);
+    m_wakeCondition.wakeAll();
+    m_writerThread->wait();
+    delete m_writerThread;
+
+    QMutexLocker locker(&m_fileMutex);
+    drainQueue();
+    m_segment->close(true);
+    delete m_segment;
+    delete m_queue;
 }
 
 void Logger::log(Level level, const QString &category, const QString &message)
 {
-    if (level < m_minLevel) {
+    logFields(level, category, QString(), QVector<QVariant>{QVariant(message)});
+}
+
+void Logger::logFields(Level level, const QString &category, const QString &format, QVector<QVariant> fields)
+{
+    if (!isEnabled(level)) {
         return;
     }
 
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-    QString levelStr = levelToString(level);
-    QString logEntry = QString("[%1] [%2] [%3] %4")
-        .arg(timestamp, levelStr, category, message);
-
-    rotateLogIfNeeded();
+    LogRecord entry;
+    entry.level = level;
+    entry.monotonicUs = static_cast<quint64>(m_clock.nsecsElapsed() / 1000);
+    entry.threadId = currentThreadTag();
+    entry.category = category;
+    entry.format = format;
+    entry.fields = std::move(fields);
 
-    if (!m_logFile.isOpen()) {
-        m_logFile.setFileName(getLogFilePath());
-        if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            qDebug() << "Failed to open log file:" << m_logFile.errorString();
-            return;
+    // 错误级别需要立即回显到控制台，直接在调用线程格式化
+    if (level >= ERROR) {
+        const QString logEntry = QString("[%1] [%2] [%3] %4")
+            .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"),
+                 levelToString(level), category, entry.message());
+        qDebug().noquote() << logEntry;
+        if (level == CRITICAL) {
+            qCritical().noquote() << logEntry;
         }
-        m_logStream.setDevice(&m_logFile);
     }
 
-    m_logStream << logEntry << "\n";
-    m_logStream.flush();
+    enqueue(std::move(entry));
+}
 
-    if (level >= ERROR) {
-        qDebug().noquote() << logEntry;
+void Logger::enqueue(LogRecord &&entry)
+{
+    const Level level = entry.level;
+
+    const bool stopping = m_stopping.load(std::memory_order_acquire);
+    const quint64 ticket = stopping ? 0 : m_queue->push(std::move(entry));
+    if (ticket == 0) {
+        // 队列已满时丢弃低级别日志，CRITICAL 改为同步写入，保证不丢
+        if (level != CRITICAL && !stopping) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        QMutexLocker locker(&m_fileMutex);
+        writeEntry(entry);
+        return;
     }
 
     if (level == CRITICAL) {
-        qCritical().noquote() << logEntry;
+        waitUntilWritten(ticket);
+    } else if (ticket - m_queue->dequeued() == BatchWakeThreshold) {
+        m_wakeCondition.wakeOne();
     }
 }
 
@@ -90,20 +229,20 @@ void Logger::critical(const QString &category, const QString &message)
 
 void Logger::setMinLevel(Level level)
 {
-    m_minLevel = level;
+    m_minLevel.store(level, std::memory_order_relaxed);
 }
 
 Logger::Level Logger::minLevel() const
 {
-    return m_minLevel;
+    return static_cast<Level>(m_minLevel.load(std::memory_order_relaxed));
 }
 
 void Logger::setLogDirectory(const QString &directory)
 {
-    if (m_logFile.isOpen()) {
-        m_logStream.flush();
-        m_logFile.close();
-    }
+    flush();
+
+    QMutexLocker locker(&m_fileMutex);
+    m_segment->close(true);
 
     m_logDirectory = directory;
 
@@ -120,77 +259,154 @@ QString Logger::logDirectory() const
 
 void Logger::clearAllLogs()
 {
+    flush();
+
+    QMutexLocker locker(&m_fileMutex);
+    m_segment->close(false);
+
     QDir logDir(m_logDirectory);
-    QStringList logFiles = logDir.entryList(QStringList() << "*.log", QDir::Files);
+    QStringList logFiles = logDir.entryList(QStringList() << "*" + LogSegmentWriter::FILE_EXTENSION << "*.log", QDir::Files);
 
     for (const QString &logFile : logFiles) {
         logDir.remove(logFile);
     }
-
-    if (m_logFile.isOpen()) {
-        m_logStream.flush();
-        m_logFile.close();
-    }
 }
 
 QString Logger::levelToString(Level level)
 {
     switch (level) {
-        case DEBUG:    return "DEBUG";
-        case INFO:     return "INFO";
-        case WARNING:  return "WARNING";
-        case ERROR:    return "ERROR";
-        case CRITICAL: return "CRITICAL";
-        default:       return "UNKNOWN";
+    case DEBUG:    return "DEBUG";
+    case INFO:     return "INFO";
+    case WARNING:  return "WARNING";
+    case ERROR:    return "ERROR";
+    case CRITICAL: return "CRITICAL";
+    default:       return "UNKNOWN";
     }
 }
 
-Logger::Level Logger::stringToLevel(const QString &levelStr)
+void Logger::flush()
 {
-    QString upper = levelStr.toUpper();
-    if (upper == "DEBUG") return DEBUG;
-    if (upper == "INFO") return INFO;
-    if (upper == "WARNING") return WARNING;
-    if (upper == "ERROR") return ERROR;
-    if (upper == "CRITICAL") return CRITICAL;
-    return INFO;
+    waitUntilWritten(m_queue->enqueued());
 }
 
-void Logger::rotateLogIfNeeded()
+quint64 Logger::droppedCount() const
 {
-    if (!m_logFile.isOpen()) {
-        return;
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+void Logger::runWriter()
+{
+    while (true) {
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            if (!m_stopping.load() && m_queue->dequeued() == m_queue->enqueued()) {
+                m_wakeCondition.wait(&m_wakeMutex, FlushIntervalMs);
+            }
+        }
+
+        {
+            QMutexLocker locker(&m_fileMutex);
+            drainQueue();
+        }
+
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            m_writtenTicket = m_queue->dequeued();
+            m_writtenCondition.wakeAll();
+        }
+
+        if (m_stopping.load() && m_queue->dequeued() == m_queue->enqueued()) {
+            break;
+        }
     }
+}
 
-    m_logFile.flush();
+// 调用方需持有 m_fileMutex；整批写完后只刷新一次
+int Logger::drainQueue()
+{
+    if (m_queue->dequeued() == m_queue->enqueued()) {
+        return 0;
+    }
 
-    QFileInfo fileInfo(m_logFile);
-    if (fileInfo.size() >= m_maxFileSize) {
-        m_logFile.close();
+    const quint64 dropped = m_droppedCount.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDropped) {
+        LogRecord notice;
+        notice.level = WARNING;
+        notice.monotonicUs = static_cast<quint64>(m_clock.nsecsElapsed() / 1000);
+        notice.threadId = currentThreadTag();
+        notice.category = "Logger";
+        notice.format = "Dropped %1 log entries (queue full)";
+        notice.fields.append(QVariant(dropped - m_reportedDropped));
+        writeEntry(notice);
+        m_reportedDropped = dropped;
+    }
 
-        QString date = QDateTime::currentDateTime().toString("yyyyMMdd");
-        QString rotatedFileName = QString("todolist_%1_1.log").arg(date);
+    int written = 0;
+    LogRecord entry;
+    while (m_queue->pop(&entry)) {
+        writeEntry(entry);
+        written++;
+    }
+    return written;
+}
 
-        QString basePath = m_logDirectory + "/todolist_" + date;
-        QString rotatedPath = m_logDirectory + "/" + rotatedFileName;
+void Logger::writeEntry(const LogRecord &entry)
+{
+    if (!m_segment->isOpen() && !openSegment()) {
+        return;
+    }
 
-        int sequence = 1;
-        while (QFile::exists(rotatedPath)) {
-            sequence++;
-            rotatedFileName = QString("todolist_%1_%2.log").arg(date).arg(sequence);
-            rotatedPath = m_logDirectory + "/" + rotatedFileName;
+    if (!m_segment->append(entry)) {
+        // 当前段已满，封存后切换到新段
+        m_segment->close(true);
+        cleanOldLogs();
+        if (openSegment()) {
+            m_segment->append(entry);
         }
+    }
+}
 
-        QFile::rename(m_logFile.fileName(), rotatedPath);
+bool Logger::openSegment()
+{
+    m_segmentSequence++;
+    const QString path = segmentFilePath();
+    if (!m_segment->open(path, m_segmentSequence, m_clockStartMs, 0)) {
+        qDebug() << "Failed to open log segment:" << path << m_segment->errorString();
+        return false;
+    }
+    return true;
+}
 
-        cleanOldLogs();
+void Logger::waitUntilWritten(quint64 ticket)
+{
+    if (QThread::currentThread() == m_writerThread) {
+        return;
+    }
+
+    QMutexLocker locker(&m_wakeMutex);
+    while (m_writtenTicket < ticket && !m_stopping.load()) {
+        m_wakeCondition.wakeOne();
+        m_writtenCondition.wait(&m_wakeMutex, WrittenWaitSliceMs);
     }
 }
 
+Logger::Level Logger::stringToLevel(const QString &levelStr)
+{
+    QString upper = levelStr.toUpper();
+    if (upper == "DEBUG") return DEBUG;
+    if (upper == "INFO") return INFO;
+    if (upper == "WARNING") return WARNING;
+    if (upper == "ERROR") return ERROR;
+    if (upper == "CRITICAL") return CRITICAL;
+    return INFO;
+}
+
 void Logger::cleanOldLogs()
 {
     QDir logDir(m_logDirectory);
-    QStringList logFiles = logDir.entryList(QStringList() << "*.log", QDir::Files, QDir::Time);
+    QStringList logFiles = logDir.entryList(QStringList() << "*" + LogSegmentWriter::FILE_EXTENSION, QDir::Files, QDir::Name | QDir::Reversed);
+    // 改用日志段之前留下的文本日志都比日志段旧，排在最后先被删除
+    logFiles += logDir.entryList(QStringList() << "*.log", QDir::Files, QDir::Time);
 
     while (logFiles.size() > m_maxLogFiles) {
         QString oldestFile = logFiles.takeLast();
@@ -198,8 +414,10 @@ void Logger::cleanOldLogs()
     }
 }
 
-QString Logger::getLogFilePath()
+// 段文件名包含进程启动时间和序号，按文件名排序即为写入顺序
+QString Logger::segmentFilePath() const
 {
-    QString date = QDateTime::currentDateTime().toString("yyyyMMdd");
-    return m_logDirectory + "/todolist_" + date + ".log";
+    const QString started = QDateTime::fromMSecsSinceEpoch(m_clockStartMs).toString("yyyyMMdd_HHmmss");
+    return QString("%1/todolist_%2_%3%4").arg(m_logDirectory, started)
+        .arg(m_segmentSequence, 4, 10, QChar('0')).arg(LogSegmentWriter::FILE_EXTENSION);
 }
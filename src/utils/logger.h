@@ -2,9 +2,27 @@
 #define LOGGER_H
 
 #include <QString>
-#include <QTextStream>
-#include <QFile>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVariant>
+#include <QVector>
+#include <atomic>
+
+// 编译期最低日志级别（0=DEBUG ... 4=CRITICAL），低于该级别的 LOG_* 调用整段被编译器移除
+#ifndef TODOLIST_LOG_MIN_LEVEL
+#ifdef QT_NO_DEBUG
+#define TODOLIST_LOG_MIN_LEVEL 1
+#else
+#define TODOLIST_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+class QThread;
+class LogQueue;
+class LogSegmentWriter;
+struct LogRecord;
 
 class Logger
 {
@@ -20,6 +38,20 @@ public:
     static Logger& instance();
 
     void log(Level level, const QString &category, const QString &message);
+    // 结构化日志：参数按类型原样写入日志段，查看时再代入 format 的 %1、%2...
+    void logFields(Level level, const QString &category, const QString &format, QVector<QVariant> fields);
+
+    bool isEnabled(Level level) const
+    {
+        return level >= m_minLevel.load(std::memory_order_relaxed);
+    }
+
+    template<typename... Args>
+    void logFormat(Level level, const QString &category, const QString &format, const Args &...args)
+    {
+        logFields(level, category, format, QVector<QVariant>{QVariant(args)...});
+    }
+
     void debug(const QString &category, const QString &message);
     void info(const QString &category, const QString &message);
     void warning(const QString &category, const QString &message);
@@ -33,6 +65,8 @@ public:
     QString logDirectory() const;
 
     void clearAllLogs();
+    void flush();
+    quint64 droppedCount() const;
 
     static QString levelToString(Level level);
     static Level stringToLevel(const QString &levelStr);
@@ -44,22 +78,62 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    void rotateLogIfNeeded();
+    void runWriter();
+    void enqueue(LogRecord &&entry);
+    int drainQueue();
+    void writeEntry(const LogRecord &entry);
+    void waitUntilWritten(quint64 ticket);
+    bool openSegment();
     void cleanOldLogs();
-    QString getLogFilePath();
+    QString segmentFilePath() const;
 
-    QFile m_logFile;
-    QTextStream m_logStream;
-    Level m_minLevel;
+    std::atomic<int> m_minLevel;
     QString m_logDirectory;
     qint64 m_maxFileSize;
     int m_maxLogFiles;
+
+    // 生产者只写入无锁队列，编码、换段和落盘都在写线程完成
+    LogQueue *m_queue;
+    LogSegmentWriter *m_segment;
+    quint32 m_segmentSequence;
+    QElapsedTimer m_clock;
+    qint64 m_clockStartMs;
+    QThread *m_writerThread;
+    QMutex m_fileMutex;
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+    QWaitCondition m_writtenCondition;
+    quint64 m_writtenTicket;
+    std::atomic<bool> m_stopping;
+    std::atomic<quint64> m_droppedCount;
+    quint64 m_reportedDropped;
 };
 
-#define LOG_DEBUG(category, message) Logger::instance().debug(category, message)
-#define LOG_INFO(category, message) Logger::instance().info(category, message)
-#define LOG_WARNING(category, message) Logger::instance().warning(category, message)
-#define LOG_ERROR(category, message) Logger::instance().error(category, message)
-#define LOG_CRITICAL(category, message) Logger::instance().critical(category, message)
+// 先判断级别再求值 message，被关闭的级别不会构造或格式化任何字符串
+#define TODOLIST_LOG(level, category, message) \
+    do { \
+        if ((level) >= TODOLIST_LOG_MIN_LEVEL && Logger::instance().isEnabled(level)) { \
+            Logger::instance().log(level, category, message); \
+        } \
+    } while (0)
+
+#define TODOLIST_LOG_FIELDS(level, category, format, ...) \
+    do { \
+        if ((level) >= TODOLIST_LOG_MIN_LEVEL && Logger::instance().isEnabled(level)) { \
+            Logger::instance().logFormat(level, category, QStringLiteral(format), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(category, message) TODOLIST_LOG(Logger::DEBUG, category, message)
+#define LOG_INFO(category, message) TODOLIST_LOG(Logger::INFO, category, message)
+#define LOG_WARNING(category, message) TODOLIST_LOG(Logger::WARNING, category, message)
+#define LOG_ERROR(category, message) TODOLIST_LOG(Logger::ERROR, category, message)
+#define LOG_CRITICAL(category, message) TODOLIST_LOG(Logger::CRITICAL, category, message)
+
+// 不在调用方格式化：LOG_DEBUG_F("Cat", "Loaded %1 tasks in %2 ms", count, elapsed)
+// format 必须是字符串字面量，且至少带一个参数
+#define LOG_DEBUG_F(category, format, ...) TODOLIST_LOG_FIELDS(Logger::DEBUG, category, format, __VA_ARGS__)
+#define LOG_INFO_F(category, format, ...) TODOLIST_LOG_FIELDS(Logger::INFO, category, format, __VA_ARGS__)
+#define LOG_WARNING_F(category, format, ...) TODOLIST_LOG_FIELDS(Logger::WARNING, category, format, __VA_ARGS__)
 
 #endif // LOGGER_H
@@ -0,0 +1,225 @@
+#include "order_key.h"
+
+namespace {
+// 按 ASCII 升序排列，SQLite 的 BINARY 比较与 QString 比较结果一致
+const QString Digits = QStringLiteral("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
+const QChar ZeroDigit('0');
+const QChar LastDigit('z');
+// 整数部分的最小值，不能再往前生成
+const QString SmallestInteger = QStringLiteral("A") + QString(26, ZeroDigit);
+
+int digitValue(QChar c)
+{
+    return Digits.indexOf(c);
+}
+
+// 首字符决定整数部分的长度：a-z 为正数，A-Z 为负数，离 a/Z 越远位数越多
+int integerLength(QChar head)
+{
+    if (head >= QLatin1Char('a') && head <= QLatin1Char('z')) {
+        return head.unicode() - 'a' + 2;
+    }
+    if (head >= QLatin1Char('A') && head <= QLatin1Char('Z')) {
+        return 'Z' - head.unicode() + 2;
+    }
+    return 0;
+}
+
+QString integerPart(const QString &key)
+{
+    const int length = key.isEmpty() ? 0 : integerLength(key.at(0));
+    return length > 0 && length <= key.size() ? key.left(length) : QString();
+}
+
+// 把小数部分看作 base-62 小数，取 a 与 b 之间的一个值；b 为空表示 1
+QString midpoint(const QString &a, const QString &b)
+{
+    if (!b.isEmpty()) {
+        int n = 0;
+        while (n < b.size() && (n < a.size() ? a.at(n) : ZeroDigit) == b.at(n)) {
+            ++n;
+        }
+        if (n > 0) {
+            return b.left(n) + midpoint(a.mid(n), b.mid(n));
+        }
+    }
+
+    const int digitA = a.isEmpty() ? 0 : digitValue(a.at(0));
+    const int digitB = b.isEmpty() ? Digits.size() : digitValue(b.at(0));
+    if (digitB - digitA > 1) {
+        return QString(Digits.at((digitA + digitB + 1) / 2));
+    }
+    if (b.size() > 1) {
+        return b.left(1);
+    }
+    return QString(Digits.at(digitA)) + midpoint(a.mid(1), QString());
+}
+
+QString incrementInteger(const QString &integer)
+{
+    const QChar head = integer.at(0);
+    QString digits = integer.mid(1);
+    bool carry = true;
+    for (int i = digits.size() - 1; carry && i >= 0; --i) {
+        const int value = digitValue(digits.at(i)) + 1;
+        if (value == Digits.size()) {
+            digits[i] = ZeroDigit;
+        } else {
+            digits[i] = Digits.at(value);
+            carry = false;
+        }
+    }
+    if (!carry) {
+        return head + digits;
+    }
+
+    if (head == QLatin1Char('Z')) {
+        return QStringLiteral("a") + ZeroDigit;
+    }
+    if (head == QLatin1Char('z')) {
+        return QString();
+    }
+    const QChar next(head.unicode() + 1);
+    if (next > QLatin1Char('a')) {
+        digits.append(ZeroDigit);
+    } else {
+        digits.chop(1);
+    }
+    return next + digits;
+}
+
+QString decrementInteger(const QString &integer)
+{
+    const QChar head = integer.at(0);
+    QString digits = integer.mid(1);
+    bool borrow = true;
+    for (int i = digits.size() - 1; borrow && i >= 0; --i) {
+        const int value = digitValue(digits.at(i)) - 1;
+        if (value < 0) {
+            digits[i] = LastDigit;
+        } else {
+            digits[i] = Digits.at(value);
+            borrow = false;
+        }
+    }
+    if (!borrow) {
+        return head + digits;
+    }
+
+    if (head == QLatin1Char('a')) {
+        return QStringLiteral("Z") + LastDigit;
+    }
+    if (head == QLatin1Char('A')) {
+        return QString();
+    }
+    const QChar previous(head.unicode() - 1);
+    if (previous < QLatin1Char('Z')) {
+        digits.append(LastDigit);
+    } else {
+        digits.chop(1);
+    }
+    return previous + digits;
+}
+} // namespace
+
+namespace OrderKey {
+bool isValid(const QString &key)
+{
+    const QString integer = integerPart(key);
+    if (integer.isEmpty() || key == SmallestInteger) {
+        return false;
+    }
+    for (int i = 1; i < key.size(); ++i) {
+        if (digitValue(key.at(i)) < 0) {
+            return false;
+        }
+    }
+    // 小数部分末尾的 0 没有意义，允许的话同一位置会有两种写法
+    return key.size() == integer.size() || key.at(key.size() - 1) != ZeroDigit;
+}
+
+QString between(const QString &before, const QString &after)
+{
+    if ((!before.isEmpty() && !isValid(before)) || (!after.isEmpty() && !isValid(after))
+        || (!before.isEmpty() && !after.isEmpty() && before >= after)) {
+        return QString();
+    }
+
+    if (before.isEmpty()) {
+        if (after.isEmpty()) {
+            return QStringLiteral("a") + ZeroDigit;
+        }
+        const QString integer = integerPart(after);
+        if (integer == SmallestInteger) {
+            return integer + midpoint(QString(), after.mid(integer.size()));
+        }
+        if (integer < after) {
+            return integer;
+        }
+        // 最小的整数部分本身不是合法键，后面要带上小数部分
+        const QString previous = decrementInteger(integer);
+        return previous == SmallestInteger ? previous + midpoint(QString(), QString()) : previous;
+    }
+
+    const QString integerBefore = integerPart(before);
+    const QString fractionBefore = before.mid(integerBefore.size());
+    if (after.isEmpty()) {
+        const QString next = incrementInteger(integerBefore);
+        return next.isEmpty() ? integerBefore + midpoint(fractionBefore, QString()) : next;
+    }
+
+    const QString integerAfter = integerPart(after);
+    if (integerBefore == integerAfter) {
+        return integerBefore + midpoint(fractionBefore, after.mid(integerAfter.size()));
+    }
+    const QString next = incrementInteger(integerBefore);
+    if (next.isEmpty()) {
+        return QString();
+    }
+    if (next < after) {
+        return next;
+    }
+    return integerBefore + midpoint(fractionBefore, QString());
+}
+
+QStringList between(const QString &before, const QString &after, int count)
+{
+    QStringList keys;
+    if (count <= 0) {
+        return keys;
+    }
+
+    // 只有一侧有界时逐个递增或递减整数部分，键最短
+    if (after.isEmpty() || before.isEmpty()) {
+        QString key = before.isEmpty() ? after : before;
+        for (int i = 0; i < count; ++i) {
+            key = before.isEmpty() ? between(QString(), key) : between(key, QString());
+            if (key.isEmpty()) {
+                return QStringList();
+            }
+            if (before.isEmpty()) {
+                keys.prepend(key);
+            } else {
+                keys.append(key);
+            }
+        }
+        return keys;
+    }
+
+    // 两侧都有界时先取中点再二分，避免在同一端反复取中点导致键变长
+    const QString middle = between(before, after);
+    if (middle.isEmpty()) {
+        return QStringList();
+    }
+    const int leftCount = count / 2;
+    const QStringList left = between(before, middle, leftCount);
+    const QStringList right = between(middle, after, count - leftCount - 1);
+    if (left.size() != leftCount || right.size() != count - leftCount - 1) {
+        return QStringList();
+    }
+    keys = left;
+    keys.append(middle);
+    keys.append(right);
+    return keys;
+}
+} // namespace OrderKey
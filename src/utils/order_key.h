@@ -0,0 +1,17 @@
+#ifndef ORDER_KEY_H
+#define ORDER_KEY_H
+
+#include <QString>
+#include <QStringList>
+
+// 分数索引排序键：按字节序比较的 base-62 字符串，任意两个键之间总能再生成一个新键
+// 键由变长整数部分和小数部分组成，连续在首尾追加时长度按对数增长
+namespace OrderKey {
+bool isValid(const QString &key);
+// before 为空表示最前，after 为空表示最后；要求 before < after，参数无效时返回空串
+QString between(const QString &before, const QString &after);
+// 在两者之间均匀生成 count 个递增的键，失败时返回空列表
+QStringList between(const QString &before, const QString &after, int count);
+}
+
+#endif // ORDER_KEY_H
@@ -7,12 +7,14 @@ inline constexpr const char *Search = "shortcut_search";
 inline constexpr const char *Save = "shortcut_save";
 inline constexpr const char *DeleteTask = "shortcut_delete";
 inline constexpr const char *ToggleTheme = "shortcut_toggle_theme";
+inline constexpr const char *QuickSwitch = "shortcut_quick_switch";
 
 inline constexpr const char *DefaultNewTask = "Ctrl+N";
 inline constexpr const char *DefaultSearch = "Ctrl+F";
 inline constexpr const char *DefaultSave = "Ctrl+S";
 inline constexpr const char *DefaultDeleteTask = "Delete";
 inline constexpr const char *DefaultToggleTheme = "Ctrl+T";
+inline constexpr const char *DefaultQuickSwitch = "Ctrl+P";
 }
 
 #endif // SHORTCUT_KEYS_H
@@ -0,0 +1,123 @@
+#include "single_instance.h"
+#include "logger.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+
+namespace {
+constexpr int ConnectTimeoutMs = 500;
+constexpr int RetryIntervalMs = 100;
+
+// 套接字名按数据目录区分，不同目录下运行的实例互不影响
+QString serverNameFor(const QString &dataDir)
+{
+    const QByteArray hash = QCryptographicHash::hash(QDir(dataDir).absolutePath().toUtf8(), QCryptographicHash::Sha1);
+    return QString("ToDoList-%1").arg(QString::fromLatin1(hash.toHex().left(16)));
+}
+} // namespace
+
+SingleInstance::SingleInstance(const QString &dataDir, QObject *parent)
+    : QObject(parent)
+    , m_serverName(serverNameFor(dataDir))
+    , m_lockPath(QDir(dataDir).absoluteFilePath("todolist.lock"))
+    , m_lockFile(m_lockPath)
+    , m_server(nullptr)
+{
+    QDir().mkpath(dataDir);
+    // 实例可能运行很久，不能按时间判定锁过期；进程退出后的残留锁由 tryLock 按进程号识别
+    m_lockFile.setStaleLockTime(0);
+}
+
+SingleInstance::~SingleInstance()
+{
+    if (m_server) {
+        m_server->close();
+    }
+}
+
+bool SingleInstance::acquire()
+{
+    m_lastError.clear();
+    if (!m_lockFile.tryLock(0)) {
+        if (m_lockFile.error() == QLockFile::LockFailedError) {
+            return false;
+        }
+        // 数据目录不可写等情况下无法判断是否已有实例，交给调用方决定是否继续
+        m_lastError = m_lockFile.error() == QLockFile::PermissionError
+            ? QString("Permission denied creating %1").arg(m_lockPath)
+            : QString("Unknown error creating %1").arg(m_lockPath);
+        LOG_WARNING_F("SingleInstance", "Failed to create instance lock: %1", m_lastError);
+        return false;
+    }
+
+    // 已经拿到锁，同名套接字只可能是上次异常退出时留下的
+    QLocalServer::removeServer(m_serverName);
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+    if (!m_server->listen(m_serverName)) {
+        LOG_WARNING_F("SingleInstance", "Failed to listen for other instances: %1", m_server->errorString());
+    }
+    return true;
+}
+
+QString SingleInstance::lastError() const
+{
+    return m_lastError;
+}
+
+bool SingleInstance::forward(const QStringList &arguments, int timeoutMs)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << arguments;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (true) {
+        QLocalSocket socket;
+        socket.connectToServer(m_serverName);
+        if (socket.waitForConnected(ConnectTimeoutMs)) {
+            socket.write(payload);
+            if (!socket.waitForBytesWritten(timeoutMs)) {
+                LOG_WARNING_F("SingleInstance", "Failed to forward command: %1", socket.errorString());
+                return false;
+            }
+            socket.disconnectFromServer();
+            if (socket.state() != QLocalSocket::UnconnectedState) {
+                socket.waitForDisconnected(ConnectTimeoutMs);
+            }
+            return true;
+        }
+        if (timer.elapsed() >= timeoutMs) {
+            LOG_WARNING_F("SingleInstance", "Running instance did not respond: %1", socket.errorString());
+            return false;
+        }
+        QThread::msleep(RetryIntervalMs);
+    }
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            QDataStream in(socket);
+            in.setVersion(QDataStream::Qt_5_15);
+            in.startTransaction();
+            QStringList arguments;
+            in >> arguments;
+            // 数据可能分多次到达，没收完整时回滚，等下一次 readyRead
+            if (!in.commitTransaction()) {
+                return;
+            }
+            socket->disconnectFromServer();
+            emit commandReceived(arguments);
+        });
+    }
+}
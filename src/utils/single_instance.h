@@ -0,0 +1,41 @@
+#ifndef SINGLE_INSTANCE_H
+#define SINGLE_INSTANCE_H
+
+#include <QObject>
+#include <QLockFile>
+#include <QStringList>
+
+class QLocalServer;
+
+// 同一个数据目录只允许一个实例运行。首个实例持有锁文件并监听本地套接字，
+// 之后启动的实例把自己的命令行转发过去后退出，避免两个进程争抢数据库写锁
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SingleInstance(const QString &dataDir, QObject *parent = nullptr);
+    ~SingleInstance();
+
+    // 拿到锁并开始监听时返回 true；返回 false 且 lastError 为空表示已有实例在运行，
+    // lastError 不为空表示锁文件无法创建，无法判断是否有其他实例
+    bool acquire();
+    QString lastError() const;
+    // 已运行的实例可能还没开始监听，超时前会重试连接
+    bool forward(const QStringList &arguments, int timeoutMs = 3000);
+
+signals:
+    void commandReceived(const QStringList &arguments);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QString m_serverName;
+    QString m_lockPath;
+    QLockFile m_lockFile;
+    QLocalServer *m_server;
+    QString m_lastError;
+};
+
+#endif // SINGLE_INSTANCE_H
@@ -0,0 +1,201 @@
+#include "text_search.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TEXT_SEARCH_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(TEXT_SEARCH_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define TEXT_SEARCH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TEXT_SEARCH_TARGET_AVX2
+#endif
+
+namespace {
+using FindFunction = int (*)(const ushort *, int, int, const ushort *, int);
+
+inline bool matchesAt(const ushort *haystack, const ushort *needle, int needleLength)
+{
+    return std::memcmp(haystack, needle, size_t(needleLength) * sizeof(ushort)) == 0;
+}
+
+int findScalar(const ushort *haystack, int length, int from, const ushort *needle, int needleLength)
+{
+    const ushort first = needle[0];
+    for (int i = from; i + needleLength <= length; ++i) {
+        if (haystack[i] == first && matchesAt(haystack + i, needle, needleLength)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef TEXT_SEARCH_X86_64
+// 同时比较候选位置的首字符与末字符，两者都命中时再逐字节确认
+int findSse2(const ushort *haystack, int length, int from, const ushort *needle, int needleLength)
+{
+    const __m128i first = _mm_set1_epi16(short(needle[0]));
+    const __m128i last = _mm_set1_epi16(short(needle[needleLength - 1]));
+    int i = from;
+    for (; i + needleLength - 1 + 8 <= length; i += 8) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i + needleLength - 1));
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi16(blockFirst, first), _mm_cmpeq_epi16(blockLast, last));
+        quint32 mask = quint32(_mm_movemask_epi8(eq)) & 0x5555u;
+        while (mask) {
+            const int pos = i + int(qCountTrailingZeroBits(mask)) / 2;
+            if (matchesAt(haystack + pos, needle, needleLength)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(haystack, length, i, needle, needleLength);
+}
+
+TEXT_SEARCH_TARGET_AVX2
+int findAvx2(const ushort *haystack, int length, int from, const ushort *needle, int needleLength)
+{
+    const __m256i first = _mm256_set1_epi16(short(needle[0]));
+    const __m256i last = _mm256_set1_epi16(short(needle[needleLength - 1]));
+    int i = from;
+    for (; i + needleLength - 1 + 16 <= length; i += 16) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i + needleLength - 1));
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi16(blockFirst, first), _mm256_cmpeq_epi16(blockLast, last));
+        quint32 mask = quint32(_mm256_movemask_epi8(eq)) & 0x55555555u;
+        while (mask) {
+            const int pos = i + int(qCountTrailingZeroBits(mask)) / 2;
+            if (matchesAt(haystack + pos, needle, needleLength)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(haystack, length, i, needle, needleLength);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct Kernel {
+    FindFunction find;
+    const char *name;
+};
+
+const Kernel &selectedKernel()
+{
+    static const Kernel kernel = []() -> Kernel {
+#ifdef TEXT_SEARCH_X86_64
+        if (cpuHasAvx2()) {
+            return {findAvx2, "avx2"};
+        }
+        return {findSse2, "sse2"};
+#else
+        return {findScalar, "scalar"};
+#endif
+    }();
+    return kernel;
+}
+}
+
+namespace TextSearch {
+QString fold(const QString &text)
+{
+    QString folded = text.toCaseFolded();
+    folded.remove(QChar(0));
+    return folded;
+}
+
+int indexOf(const ushort *haystack, int length, int from, const ushort *needle, int needleLength)
+{
+    if (needleLength <= 0 || from < 0 || length - from < needleLength) {
+        return -1;
+    }
+    return selectedKernel().find(haystack, length, from, needle, needleLength);
+}
+
+const char *kernelName()
+{
+    return selectedKernel().name;
+}
+}
+
+void FoldedTextColumn::clear()
+{
+    m_units.clear();
+    m_rowStarts.clear();
+}
+
+void FoldedTextColumn::reserve(int rows, int units)
+{
+    m_rowStarts.reserve(rows);
+    m_units.reserve(units);
+}
+
+void FoldedTextColumn::appendRow(const QString &title, const QString &description)
+{
+    m_rowStarts.append(m_units.size());
+    appendField(title);
+    appendField(description);
+}
+
+void FoldedTextColumn::appendField(const QString &text)
+{
+    const QString folded = TextSearch::fold(text);
+    const ushort *data = folded.utf16();
+    for (int i = 0; i < folded.size(); ++i) {
+        m_units.append(data[i]);
+    }
+    m_units.append(0);
+}
+
+QVector<int> FoldedTextColumn::matchingRows(const QString &needle) const
+{
+    QVector<int> rows;
+    const QString folded = TextSearch::fold(needle);
+    if (folded.isEmpty()) {
+        rows.reserve(m_rowStarts.size());
+        for (int row = 0; row < m_rowStarts.size(); ++row) {
+            rows.append(row);
+        }
+        return rows;
+    }
+
+    const ushort *haystack = m_units.constData();
+    const int length = m_units.size();
+    int pos = 0;
+    while ((pos = TextSearch::indexOf(haystack, length, pos, folded.utf16(), folded.size())) >= 0) {
+        const int row = int(std::upper_bound(m_rowStarts.cbegin(), m_rowStarts.cend(), pos) - m_rowStarts.cbegin()) - 1;
+        rows.append(row);
+        // 每行只需命中一次，直接跳到下一行
+        pos = row + 1 < m_rowStarts.size() ? m_rowStarts.at(row + 1) : length;
+    }
+    return rows;
+}
@@ -0,0 +1,30 @@
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include <QString>
+#include <QVector>
+
+namespace TextSearch {
+QString fold(const QString &text);
+int indexOf(const ushort *haystack, int length, int from, const ushort *needle, int needleLength);
+const char *kernelName();
+}
+
+// 预先大小写折叠并连续存放的文本列，每行由若干字段组成，字段之间以 U+0000 分隔
+class FoldedTextColumn
+{
+public:
+    void clear();
+    void reserve(int rows, int units);
+    void appendRow(const QString &title, const QString &description);
+    int rowCount() const { return m_rowStarts.size(); }
+    QVector<int> matchingRows(const QString &needle) const;
+
+private:
+    void appendField(const QString &text);
+
+    QVector<ushort> m_units;
+    QVector<int> m_rowStarts;
+};
+
+#endif // TEXT_SEARCH_H
@@ -5,6 +5,8 @@
 #include "search_widget.h"
 #include "empty_state_widget.h"
 #include "../controllers/task_controller.h"
+#include "../controllers/database.h"
+#include "../models/folder.h"
 #include "../utils/logger.h"
 #include <QMessageBox>
 
@@ -151,8 +153,31 @@ void ContentArea::setSearchText(const QString &text)
     }
 }
 
+void ContentArea::revealTask(int taskId)
+{
+    if (taskId <= 0 || !m_taskTree) {
+        return;
+    }
+    m_taskTree->selectTask(taskId);
+    onTaskSelected(taskId);
+}
+
+TaskController *ContentArea::taskController() const
+{
+    return m_controller;
+}
+
 bool ContentArea::deleteCurrentTask()
 {
+    const QList<int> selectedIds = m_taskTree ? m_taskTree->selectedTaskIds() : QList<int>();
+    if (selectedIds.size() > 1 && m_currentGroup != "回收站") {
+        QMessageBox::StandardButton reply = QMessageBox::question(
+            this, "确认删除",
+            QString("确定要删除选中的 %1 个任务吗？").arg(selectedIds.size()),
+            QMessageBox::Yes | QMessageBox::No);
+        return reply == QMessageBox::Yes && m_controller->deleteTasks(selectedIds);
+    }
+
     if (m_currentTaskId <= 0) {
         return false;
     }
@@ -228,6 +253,12 @@ void ContentArea::onContextMenuRequested(const QPoint &pos, int taskId)
         menu.exec(QCursor::pos());
         return;
     }
+
+    const QList<int> selectedIds = m_taskTree->selectedTaskIds();
+    if (selectedIds.size() > 1 && selectedIds.contains(taskId)) {
+        showBulkContextMenu(selectedIds);
+        return;
+    }
     
     QAction *editAction = new QAction("编辑任务", this);
     connect(editAction, &QAction::triggered, this, [this, taskId]() {
@@ -268,6 +299,78 @@ void ContentArea::onContextMenuRequested(const QPoint &pos, int taskId)
     menu.exec(QCursor::pos());
 }
 
+void ContentArea::showBulkContextMenu(const QList<int> &taskIds)
+{
+    QMenu menu(this);
+    auto reportFailure = [this](bool ok) {
+        if (!ok) {
+            QMessageBox::warning(this, "操作失败", "批量操作未能完成，任务保持不变。");
+        }
+    };
+
+    QAction *completeAction = menu.addAction(QString("标记完成（%1 项）").arg(taskIds.size()));
+    connect(completeAction, &QAction::triggered, this, [this, taskIds, reportFailure]() {
+        reportFailure(m_controller->completeTasks(taskIds, true));
+    });
+
+    QAction *uncompleteAction = menu.addAction("标记未完成");
+    connect(uncompleteAction, &QAction::triggered, this, [this, taskIds, reportFailure]() {
+        reportFailure(m_controller->completeTasks(taskIds, false));
+    });
+
+    QMenu *tagMenu = menu.addMenu("添加标签");
+    const QList<Tag> tags = m_controller->getAllTags();
+    tagMenu->setEnabled(!tags.isEmpty());
+    for (const Tag &tag : tags) {
+        QAction *tagAction = tagMenu->addAction(tag.name());
+        const int tagId = tag.id();
+        connect(tagAction, &QAction::triggered, this, [this, taskIds, tagId, reportFailure]() {
+            const bool ok = m_controller->assignTag(taskIds, tagId);
+            reportFailure(ok);
+            if (ok) {
+                emit tagsChanged();
+            }
+        });
+    }
+
+    QMenu *folderMenu = menu.addMenu("移动到文件夹");
+    for (const Folder &folder : Database::instance().getAllFolders()) {
+        QAction *folderAction = folderMenu->addAction(folder.name());
+        const int folderId = folder.id();
+        folderAction->setEnabled(folderId != m_currentFolderId);
+        connect(folderAction, &QAction::triggered, this, [this, taskIds, folderId, reportFailure]() {
+            reportFailure(m_controller->moveToFolder(taskIds, folderId));
+        });
+    }
+    if (!folderMenu->isEmpty()) {
+        folderMenu->addSeparator();
+    }
+    QAction *removeFolderAction = folderMenu->addAction("移出文件夹");
+    // 文件夹归属的变化由变更日志带到任务树，侧边栏不显示文件夹计数，不必另发信号
+    connect(removeFolderAction, &QAction::triggered, this, [this, taskIds, reportFailure]() {
+        reportFailure(m_controller->moveToFolder(taskIds, 0));
+    });
+
+    QAction *topLevelAction = menu.addAction("移到顶层");
+    connect(topLevelAction, &QAction::triggered, this, [this, taskIds, reportFailure]() {
+        reportFailure(m_controller->reparentTasks(taskIds, 0));
+    });
+
+    menu.addSeparator();
+    QAction *deleteAction = menu.addAction("删除所选任务");
+    connect(deleteAction, &QAction::triggered, this, [this, taskIds, reportFailure]() {
+        QMessageBox::StandardButton reply = QMessageBox::question(
+            this, "确认删除",
+            QString("确定要删除选中的 %1 个任务吗？").arg(taskIds.size()),
+            QMessageBox::Yes | QMessageBox::No);
+        if (reply == QMessageBox::Yes) {
+            reportFailure(m_controller->deleteTasks(taskIds));
+        }
+    });
+
+    menu.exec(QCursor::pos());
+}
+
 void ContentArea::onDetailCollapseRequested()
 {
     collapseTaskDetailPanel();
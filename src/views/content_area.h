@@ -33,6 +33,8 @@ public:
     void loadTasks();
     void setSearchText(const QString &text);
     bool deleteCurrentTask();
+    void revealTask(int taskId);
+    TaskController *taskController() const;
 
 signals:
     void tagsChanged();
@@ -58,6 +60,7 @@ private:
     void showTaskDetailPanel();
     void collapseTaskDetailPanel();
     void updateDetailForTask(int taskId);
+    void showBulkContextMenu(const QList<int> &taskIds);
     void updateTagFilterDisplay();
     void updateEmptyState(int count);
 
@@ -4,6 +4,7 @@
 #include "task_dialog.h"
 #include "notificationpanel.h"
 #include "settingsdialog.h"
+#include "quick_switcher.h"
 #include "../controllers/backupmanager.h"
 #include "../utils/logger.h"
 #include "../utils/theme_manager.h"
@@ -11,6 +12,9 @@
 #include "../controllers/task_controller.h"
 #include "../controllers/database.h"
 #include "../controllers/notificationmanager.h"
+#include "../controllers/reminder_scheduler.h"
+#include "../controllers/settings_store.h"
+#include "../controllers/task_search_index.h"
 #include <QSettings>
 #include <QApplication>
 #include <QScreen>
@@ -39,6 +43,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_notificationPanel(nullptr)
     , m_backupManager(nullptr)
     , m_settingsDialog(nullptr)
+    , m_searchIndex(nullptr)
+    , m_quickSwitcher(nullptr)
     , m_quickTaskInput(nullptr)
     , m_quickAddButton(nullptr)
     , m_themeButton(nullptr)
@@ -48,6 +54,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_shortcutSearch(nullptr)
     , m_shortcutDeleteTask(nullptr)
     , m_shortcutToggleTheme(nullptr)
+    , m_shortcutQuickSwitch(nullptr)
 {
     loadSettings();
     setupUI();
@@ -63,6 +70,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_backupManager, &BackupManager::backupStarted, this, &MainWindow::onBackupStarted);
     connect(m_backupManager, &BackupManager::backupProgressChanged, this, &MainWindow::onBackupProgressChanged);
     connect(m_backupManager, &BackupManager::backupFinished, this, &MainWindow::onBackupFinished);
+    connect(m_backupManager, &BackupManager::datasetReplaced, this, &MainWindow::onDatasetReplaced);
 }
 
 MainWindow::~MainWindow()
@@ -109,6 +117,11 @@ void MainWindow::setupUI()
     connect(m_sidebar, &Sidebar::tagUpdated, m_contentArea, &ContentArea::loadTasks);
     m_contentArea->loadTasks();
 
+    m_searchIndex = new TaskSearchIndex(this);
+    m_searchIndex->buildInBackground();
+    m_quickSwitcher = new QuickSwitcher(m_searchIndex, this);
+    connect(m_quickSwitcher, &QuickSwitcher::taskActivated, m_contentArea, &ContentArea::revealTask);
+
     LOG_INFO("MainWindow", "Main window UI setup complete");
 }
 
@@ -149,22 +162,8 @@ void MainWindow::setupBottomBar()
     m_quickAddButton->setObjectName("quickAddButton");
     m_quickAddButton->setFixedHeight(40);
     connect(m_quickAddButton, &QPushButton::clicked, this, [this]() {
-        QString title = m_quickTaskInput->text().trimmed();
-        if (!title.isEmpty()) {
-            TaskController controller;
-            Task newTask;
-            newTask.setTitle(title);
-            if (!controller.addTask(newTask)) {
-                QMessageBox::critical(this, "保存失败", "快速添加任务失败。");
-                return;
-            }
-            int folderId = m_contentArea ? m_contentArea->currentFolderId() : 0;
-            if (folderId > 0) {
-                Database::instance().assignTaskToFolder(newTask.id(), folderId);
-            }
+        if (addQuickTask(m_quickTaskInput->text())) {
             m_quickTaskInput->clear();
-            refreshTaskList();
-            LOG_INFO("MainWindow", QString("Quick task added: %1").arg(title));
         }
     });
     m_bottomBarLayout->addWidget(m_quickAddButton);
@@ -263,7 +262,7 @@ void MainWindow::loadSettings()
     int y = settings.value("window_y", -1).toInt();
     int sidebarWidth = settings.value("sidebar_width", 280).toInt();
 
-    bool restoreLast = Database::instance().getSetting("settings_restore_last", "1") == "1";
+    bool restoreLast = SettingsStore::instance().boolValue("settings_restore_last", true);
     if (!restoreLast) {
         width = 1280;
         height = 720;
@@ -326,6 +325,56 @@ void MainWindow::onSearchTextChanged(const QString &text)
     }
 }
 
+bool MainWindow::addQuickTask(const QString &text)
+{
+    const QString title = text.trimmed();
+    if (title.isEmpty()) {
+        return false;
+    }
+
+    TaskController controller;
+    TaskController::UnitOfWork unit(&controller);
+    Task newTask;
+    newTask.setTitle(title);
+    bool saved = controller.addTask(newTask);
+    int folderId = m_contentArea ? m_contentArea->currentFolderId() : 0;
+    if (saved && folderId > 0) {
+        saved = Database::instance().assignTaskToFolder(newTask.id(), folderId);
+    }
+    if (saved) {
+        saved = unit.commit();
+    } else {
+        unit.rollback();
+    }
+    if (!saved) {
+        QMessageBox::critical(this, "保存失败", "快速添加任务失败。");
+        return false;
+    }
+    refreshTaskList();
+    LOG_INFO("MainWindow", QString("Quick task added: %1").arg(title));
+    return true;
+}
+
+void MainWindow::setSearchText(const QString &text)
+{
+    if (m_searchBox) {
+        m_searchBox->setText(text);
+        m_searchBox->setFocus();
+        m_searchBox->selectAll();
+    }
+}
+
+void MainWindow::bringToFront()
+{
+    if (isMinimized()) {
+        showNormal();
+    } else {
+        show();
+    }
+    raise();
+    activateWindow();
+}
+
 void MainWindow::onNewTaskClicked()
 {
     LOG_INFO("MainWindow", "New task button clicked");
@@ -403,23 +452,39 @@ void MainWindow::setupShortcuts()
     m_shortcutToggleTheme->setContext(Qt::ApplicationShortcut);
     connect(m_shortcutToggleTheme, &QShortcut::activated, this, &MainWindow::onThemeToggleClicked);
 
+    m_shortcutQuickSwitch = new QShortcut(this);
+    m_shortcutQuickSwitch->setContext(Qt::ApplicationShortcut);
+    connect(m_shortcutQuickSwitch, &QShortcut::activated, this, [this]() {
+        if (m_quickSwitcher) {
+            m_quickSwitcher->popup();
+        }
+    });
+
     reloadShortcuts();
+    connect(&SettingsStore::instance(), &SettingsStore::settingChanged, this, [this](const QString &key) {
+        if (key.startsWith("shortcut_")) {
+            reloadShortcuts();
+        }
+    });
 }
 
 void MainWindow::reloadShortcuts()
 {
-    Database &db = Database::instance();
+    SettingsStore &settings = SettingsStore::instance();
     if (m_shortcutNewTask) {
-        m_shortcutNewTask->setKey(QKeySequence(db.getSetting(ShortcutKeys::NewTask, ShortcutKeys::DefaultNewTask)));
+        m_shortcutNewTask->setKey(QKeySequence(settings.value(ShortcutKeys::NewTask, ShortcutKeys::DefaultNewTask)));
     }
     if (m_shortcutSearch) {
-        m_shortcutSearch->setKey(QKeySequence(db.getSetting(ShortcutKeys::Search, ShortcutKeys::DefaultSearch)));
+        m_shortcutSearch->setKey(QKeySequence(settings.value(ShortcutKeys::Search, ShortcutKeys::DefaultSearch)));
     }
     if (m_shortcutDeleteTask) {
-        m_shortcutDeleteTask->setKey(QKeySequence(db.getSetting(ShortcutKeys::DeleteTask, ShortcutKeys::DefaultDeleteTask)));
+        m_shortcutDeleteTask->setKey(QKeySequence(settings.value(ShortcutKeys::DeleteTask, ShortcutKeys::DefaultDeleteTask)));
     }
     if (m_shortcutToggleTheme) {
-        m_shortcutToggleTheme->setKey(QKeySequence(db.getSetting(ShortcutKeys::ToggleTheme, ShortcutKeys::DefaultToggleTheme)));
+        m_shortcutToggleTheme->setKey(QKeySequence(settings.value(ShortcutKeys::ToggleTheme, ShortcutKeys::DefaultToggleTheme)));
+    }
+    if (m_shortcutQuickSwitch) {
+        m_shortcutQuickSwitch->setKey(QKeySequence(settings.value(ShortcutKeys::QuickSwitch, ShortcutKeys::DefaultQuickSwitch)));
     }
 }
 
@@ -477,13 +542,7 @@ void MainWindow::onSettingsClicked()
 {
     if (!m_settingsDialog) {
         m_settingsDialog = new SettingsDialog(m_backupManager, this);
-        connect(m_settingsDialog, &SettingsDialog::dataImported, this, [this]() {
-            refreshTaskList();
-            if (m_sidebar) {
-                m_sidebar->refreshTags();
-            }
-        });
-        connect(m_settingsDialog, &SettingsDialog::shortcutsChanged, this, &MainWindow::reloadShortcuts);
+        connect(m_settingsDialog, &SettingsDialog::dataImported, this, &MainWindow::onDatasetReplaced);
     }
     m_settingsDialog->show();
     m_settingsDialog->raise();
@@ -529,3 +588,16 @@ void MainWindow::onBackupFinished(bool success, const QString &backupPath, int r
         m_backupDialog->close();
     }
 }
+
+void MainWindow::onDatasetReplaced()
+{
+    // 数据被整体替换后，各视图只在这里统一重新加载一次
+    refreshTaskList();
+    if (m_sidebar) {
+        m_sidebar->reloadData();
+    }
+    SettingsStore::instance().load();
+    NotificationManager::instance().refresh();
+    ReminderScheduler::instance().reload();
+    LOG_INFO("MainWindow", "Dataset replaced, views reloaded");
+}
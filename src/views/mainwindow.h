@@ -19,6 +19,8 @@ class ContentArea;
 class NotificationPanel;
 class BackupManager;
 class SettingsDialog;
+class TaskSearchIndex;
+class QuickSwitcher;
 class QProgressDialog;
 class QShortcut;
 
@@ -30,6 +32,15 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 命令行和其他实例转发的命令
+    bool addQuickTask(const QString &text);
+    void setSearchText(const QString &text);
+    void bringToFront();
+
+public slots:
+    // 数据在其他地方被整体替换或批量清理后，重新加载所有视图
+    void onDatasetReplaced();
+
 private slots:
     void onGroupChanged(const QString &group);
     void onCollapseRequested();
@@ -73,6 +84,8 @@ private:
     NotificationPanel *m_notificationPanel;
     BackupManager *m_backupManager;
     SettingsDialog *m_settingsDialog;
+    TaskSearchIndex *m_searchIndex;
+    QuickSwitcher *m_quickSwitcher;
     
     QLineEdit *m_quickTaskInput;
     QPushButton *m_quickAddButton;
@@ -84,6 +97,7 @@ private:
     QShortcut *m_shortcutSearch;
     QShortcut *m_shortcutDeleteTask;
     QShortcut *m_shortcutToggleTheme;
+    QShortcut *m_shortcutQuickSwitch;
 };
 
 #endif // MAINWINDOW_H
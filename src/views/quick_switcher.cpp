@@ -0,0 +1,129 @@
+#include "quick_switcher.h"
+#include "../controllers/task_search_index.h"
+#include <QVBoxLayout>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QKeyEvent>
+#include <QColor>
+#include <QBrush>
+
+namespace {
+constexpr int MaxResults = 20;
+
+QString priorityBadge(int priority)
+{
+    switch (priority) {
+    case 3:
+        return "[高] ";
+    case 2:
+        return "[中] ";
+    case 1:
+        return "[低] ";
+    default:
+        return QString();
+    }
+}
+}
+
+QuickSwitcher::QuickSwitcher(TaskSearchIndex *index, QWidget *parent)
+    : QDialog(parent)
+    , m_index(index)
+    , m_searchEdit(nullptr)
+    , m_resultList(nullptr)
+{
+    setWindowFlags(Qt::Popup | Qt::FramelessWindowHint);
+    setObjectName("quickSwitcher");
+    setupUI();
+}
+
+void QuickSwitcher::setupUI()
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 8, 8, 8);
+    layout->setSpacing(6);
+
+    m_searchEdit = new QLineEdit(this);
+    m_searchEdit->setPlaceholderText("跳转到任务...");
+    m_searchEdit->setClearButtonEnabled(true);
+    m_searchEdit->installEventFilter(this);
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &QuickSwitcher::onTextChanged);
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &QuickSwitcher::activateCurrent);
+
+    m_resultList = new QListWidget(this);
+    m_resultList->setFocusPolicy(Qt::NoFocus);
+    connect(m_resultList, &QListWidget::itemActivated, this, &QuickSwitcher::onItemActivated);
+    connect(m_resultList, &QListWidget::itemClicked, this, &QuickSwitcher::onItemActivated);
+
+    layout->addWidget(m_searchEdit);
+    layout->addWidget(m_resultList);
+
+    resize(520, 360);
+}
+
+void QuickSwitcher::popup()
+{
+    m_searchEdit->clear();
+    m_resultList->clear();
+
+    if (QWidget *host = parentWidget()) {
+        const QRect hostRect = host->geometry();
+        move(hostRect.left() + (hostRect.width() - width()) / 2, hostRect.top() + 80);
+    }
+
+    show();
+    raise();
+    activateWindow();
+    m_searchEdit->setFocus();
+}
+
+bool QuickSwitcher::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_searchEdit && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent *>(event);
+        const int count = m_resultList->count();
+        if (count > 0 && (keyEvent->key() == Qt::Key_Down || keyEvent->key() == Qt::Key_Up)) {
+            int row = m_resultList->currentRow();
+            row += keyEvent->key() == Qt::Key_Down ? 1 : -1;
+            m_resultList->setCurrentRow(qBound(0, row, count - 1));
+            return true;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+void QuickSwitcher::onTextChanged(const QString &text)
+{
+    m_resultList->clear();
+    if (!m_index) {
+        return;
+    }
+
+    const QList<TaskSearchMatch> matches = m_index->search(text, MaxResults);
+    for (const TaskSearchMatch &match : matches) {
+        auto *item = new QListWidgetItem(priorityBadge(match.priority) + match.title, m_resultList);
+        item->setData(Qt::UserRole, match.taskId);
+        if (match.completed) {
+            item->setForeground(QBrush(QColor("#888888")));
+        }
+    }
+    if (m_resultList->count() > 0) {
+        m_resultList->setCurrentRow(0);
+    }
+}
+
+void QuickSwitcher::onItemActivated(QListWidgetItem *item)
+{
+    if (!item) {
+        return;
+    }
+    const int taskId = item->data(Qt::UserRole).toInt();
+    hide();
+    if (taskId > 0) {
+        emit taskActivated(taskId);
+    }
+}
+
+void QuickSwitcher::activateCurrent()
+{
+    onItemActivated(m_resultList->currentItem());
+}
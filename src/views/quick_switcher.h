@@ -0,0 +1,39 @@
+#ifndef QUICK_SWITCHER_H
+#define QUICK_SWITCHER_H
+
+#include <QDialog>
+
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+class TaskSearchIndex;
+
+class QuickSwitcher : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit QuickSwitcher(TaskSearchIndex *index, QWidget *parent = nullptr);
+
+    void popup();
+
+signals:
+    void taskActivated(int taskId);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void onTextChanged(const QString &text);
+    void onItemActivated(QListWidgetItem *item);
+
+private:
+    void setupUI();
+    void activateCurrent();
+
+    TaskSearchIndex *m_index;
+    QLineEdit *m_searchEdit;
+    QListWidget *m_resultList;
+};
+
+#endif // QUICK_SWITCHER_H
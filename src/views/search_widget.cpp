@@ -11,6 +11,11 @@
 #include <QMenu>
 #include <QAction>
 #include <QLabel>
+#include <QTimer>
+
+namespace {
+constexpr int SearchDebounceMs = 250;
+}
 
 SearchWidget::SearchWidget(TaskController *controller, QWidget *parent)
     : QWidget(parent)
@@ -26,7 +31,12 @@ SearchWidget::SearchWidget(TaskController *controller, QWidget *parent)
     , m_tagButton(nullptr)
     , m_tagMenu(nullptr)
     , m_blockTagSignals(false)
+    , m_searchDebounceTimer(new QTimer(this))
 {
+    m_searchDebounceTimer->setSingleShot(true);
+    m_searchDebounceTimer->setInterval(SearchDebounceMs);
+    connect(m_searchDebounceTimer, &QTimer::timeout, this, &SearchWidget::emitFiltersChanged);
+
     setupUI();
 
     if (m_controller) {
@@ -48,6 +58,7 @@ void SearchWidget::setupUI()
     m_searchEdit->setPlaceholderText("搜索任务...");
     m_searchEdit->setClearButtonEnabled(true);
     connect(m_searchEdit, &QLineEdit::textChanged, this, &SearchWidget::onSearchTextChanged);
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &SearchWidget::emitFiltersChanged);
     topRow->addWidget(m_searchEdit, 1);
 
     m_filterToggleButton = new QPushButton("筛选", this);
@@ -205,8 +216,11 @@ void SearchWidget::clearFilters()
 
 void SearchWidget::onSearchTextChanged(const QString &text)
 {
-    Q_UNUSED(text);
-    emitFiltersChanged();
+    if (text.trimmed().isEmpty()) {
+        emitFiltersChanged();
+        return;
+    }
+    m_searchDebounceTimer->start();
 }
 
 void SearchWidget::onToggleFilters()
@@ -322,5 +336,6 @@ QList<int> SearchWidget::selectedTagIds() const
 
 void SearchWidget::emitFiltersChanged()
 {
+    m_searchDebounceTimer->stop();
     emit filtersChanged(filters());
 }
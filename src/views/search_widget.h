@@ -10,6 +10,7 @@ class QPushButton;
 class QComboBox;
 class QToolButton;
 class QMenu;
+class QTimer;
 class TaskController;
 class Tag;
 
@@ -56,6 +57,7 @@ private:
     QMenu *m_tagMenu;
     QSet<int> m_selectedTagIds;
     bool m_blockTagSignals;
+    QTimer *m_searchDebounceTimer;
 };
 
 #endif // SEARCH_WIDGET_H
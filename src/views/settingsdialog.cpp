@@ -1,6 +1,12 @@
 #include "settingsdialog.h"
 #include "../controllers/backupmanager.h"
+#include "../controllers/binary_snapshot.h"
 #include "../controllers/database.h"
+#include "../controllers/database_snapshot.h"
+#include "../controllers/json_exporter.h"
+#include "../controllers/json_importer.h"
+#include "../controllers/settings_store.h"
+#include "../utils/logger.h"
 #include "../utils/shortcut_keys.h"
 #include "../utils/icon_utils.h"
 #include "../utils/theme_manager.h"
@@ -29,27 +35,22 @@
 #include <QUrl>
 #include <QCoreApplication>
 #include <QFileInfo>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QProgressDialog>
 #include <QElapsedTimer>
 #include <QStandardPaths>
 #include <QKeySequenceEdit>
 #include <QKeySequence>
 #include <QSqlQuery>
-#include <QSqlError>
 #include <QSqlDatabase>
 #include <QDate>
 #include <QRegularExpression>
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
-#include <QHash>
-#include <QSet>
 #include <QVector>
 #include <QShortcut>
 #include <QFont>
+#include <QEventLoop>
 
 namespace {
 const char *KEY_THEME = "settings_theme";
@@ -71,96 +72,9 @@ const char *KEY_DELETE_PARENT_ACTION = "delete_parent_action";
 const char *KEY_DELETE_AUTO_CLEANUP = "delete_auto_cleanup";
 const char *KEY_DELETE_CLEANUP_DAYS = "delete_cleanup_days";
 
-struct ExportOptions {
-    bool tasks = true;
-    bool folders = true;
-    bool settings = true;
-    bool notifications = true;
-};
-
-struct ImportOptions {
-    enum Mode {
-        Merge,
-        Overwrite,
-        Append
-    };
-    enum Conflict {
-        Skip,
-        OverwriteConflict,
-        Regenerate
-    };
-    Mode mode = Merge;
-    Conflict conflict = OverwriteConflict;
-};
-struct ImportSummary {
-    int tasks = 0;
-    int folders = 0;
-    int settings = 0;
-    int notifications = 0;
-    int tags = 0;
-};
-
-struct FileItem {
-    QString path;
-    QString name;
-};
-
-struct StepItem {
-    QString title;
-    bool completed = false;
-    int position = 0;
-};
-
-struct ImportedTask {
-    int originalId = -1;
-    int parentOriginalId = 0;
-    QString title;
-    QString description;
-    int priority = 1;
-    QDateTime dueDate;
-    bool completed = false;
-    int progress = 0;
-    bool isDeleted = false;
-    QDateTime deletedAt;
-    QDateTime createdAt;
-    QDateTime updatedAt;
-    QList<QString> tagNames;
-    QList<int> dependencyIds;
-    QList<FileItem> files;
-    QList<StepItem> steps;
-};
-
-struct ImportedFolder {
-    int originalId = -1;
-    QString name;
-    QString color;
-    int position = 0;
-    QDateTime createdAt;
-    QList<int> taskIds;
-};
-
-struct ImportedTag {
-    int originalId = -1;
-    QString name;
-    QString color;
-    QDateTime createdAt;
-};
+using ExportOptions = JsonExporter::Options;
 
-struct ImportedSetting {
-    QString key;
-    QString value;
-    QDateTime updatedAt;
-};
-
-struct ImportedNotification {
-    int originalId = -1;
-    int type = 0;
-    QString title;
-    QString message;
-    int taskId = 0;
-    bool read = false;
-    QDateTime createdAt;
-};
+using ImportOptions = JsonImporter::Options;
 
 struct ShortcutRowDef {
     const char *key;
@@ -175,7 +89,8 @@ const QVector<ShortcutRowDef> &shortcutRowDefs()
         { ShortcutKeys::Search, "搜索", ShortcutKeys::DefaultSearch },
         { ShortcutKeys::Save, "保存", ShortcutKeys::DefaultSave },
         { ShortcutKeys::DeleteTask, "删除任务", ShortcutKeys::DefaultDeleteTask },
-        { ShortcutKeys::ToggleTheme, "切换主题", ShortcutKeys::DefaultToggleTheme }
+        { ShortcutKeys::ToggleTheme, "切换主题", ShortcutKeys::DefaultToggleTheme },
+        { ShortcutKeys::QuickSwitch, "快速跳转", ShortcutKeys::DefaultQuickSwitch }
     };
     return defs;
 }
@@ -196,26 +111,6 @@ QString displayShortcutText(const QString &sequence)
     return trimmed.isEmpty() ? QString("未设置") : trimmed;
 }
 
-QString isoDateString(const QDateTime &dt)
-{
-    if (!dt.isValid()) {
-        return QString();
-    }
-    return dt.toUTC().toString(Qt::ISODate);
-}
-
-QDateTime parseIsoDate(const QString &value)
-{
-    if (value.trimmed().isEmpty()) {
-        return QDateTime();
-    }
-    QDateTime parsed = QDateTime::fromString(value, Qt::ISODate);
-    if (!parsed.isValid()) {
-        parsed = QDateTime::fromString(value, Qt::ISODateWithMs);
-    }
-    return parsed;
-}
-
 QString formatDurationSeconds(qint64 seconds)
 {
     if (seconds < 0) {
@@ -438,239 +333,6 @@ bool promptImportOptions(QWidget *parent, ImportOptions *options)
     return true;
 }
 
-bool validateJsonTask(const QJsonObject &obj, QString *error)
-{
-    if (!obj.contains("title") || !obj.value("title").isString()) {
-        if (error) {
-            *error = "任务标题缺失或格式不正确";
-        }
-        return false;
-    }
-    if (obj.contains("id") && !obj.value("id").isDouble()) {
-        if (error) {
-            *error = "任务ID必须为数字";
-        }
-        return false;
-    }
-    auto checkArrayOfStrings = [&](const QString &key) {
-        if (!obj.contains(key)) {
-            return true;
-        }
-        if (!obj.value(key).isArray()) {
-            if (error) {
-                *error = QString("字段 %1 必须是数组").arg(key);
-            }
-            return false;
-        }
-        QJsonArray arr = obj.value(key).toArray();
-        for (const QJsonValue &val : arr) {
-            if (!val.isString()) {
-                if (error) {
-                    *error = QString("字段 %1 必须为字符串数组").arg(key);
-                }
-                return false;
-            }
-        }
-        return true;
-    };
-
-    auto checkArrayOfNumbers = [&](const QString &key) {
-        if (!obj.contains(key)) {
-            return true;
-        }
-        if (!obj.value(key).isArray()) {
-            if (error) {
-                *error = QString("字段 %1 必须是数组").arg(key);
-            }
-            return false;
-        }
-        QJsonArray arr = obj.value(key).toArray();
-        for (const QJsonValue &val : arr) {
-            if (!val.isDouble()) {
-                if (error) {
-                    *error = QString("字段 %1 必须为数字数组").arg(key);
-                }
-                return false;
-            }
-        }
-        return true;
-    };
-
-    if (!checkArrayOfStrings("tags")) {
-        return false;
-    }
-    if (!checkArrayOfNumbers("dependencies")) {
-        return false;
-    }
-
-    if (obj.contains("files")) {
-        if (!obj.value("files").isArray()) {
-            if (error) {
-                *error = "files 字段必须为数组";
-            }
-            return false;
-        }
-        QJsonArray files = obj.value("files").toArray();
-        for (const QJsonValue &val : files) {
-            if (!val.isObject()) {
-                if (error) {
-                    *error = "files 数组项必须为对象";
-                }
-                return false;
-            }
-            QJsonObject fileObj = val.toObject();
-            if (!fileObj.contains("path") || !fileObj.value("path").isString()) {
-                if (error) {
-                    *error = "files 项缺少 path";
-                }
-                return false;
-            }
-        }
-    }
-
-    if (obj.contains("steps")) {
-        if (!obj.value("steps").isArray()) {
-            if (error) {
-                *error = "steps 字段必须为数组";
-            }
-            return false;
-        }
-        QJsonArray steps = obj.value("steps").toArray();
-        for (const QJsonValue &val : steps) {
-            if (!val.isObject()) {
-                if (error) {
-                    *error = "steps 数组项必须为对象";
-                }
-                return false;
-            }
-            QJsonObject stepObj = val.toObject();
-            if (!stepObj.contains("title") || !stepObj.value("title").isString()) {
-                if (error) {
-                    *error = "steps 项缺少 title";
-                }
-                return false;
-            }
-        }
-    }
-
-    if (obj.contains("children")) {
-        if (!obj.value("children").isArray()) {
-            if (error) {
-                *error = "children 字段必须为数组";
-            }
-            return false;
-        }
-        QJsonArray children = obj.value("children").toArray();
-        for (const QJsonValue &val : children) {
-            if (!val.isObject()) {
-                if (error) {
-                    *error = "children 数组项必须为对象";
-                }
-                return false;
-            }
-            if (!validateJsonTask(val.toObject(), error)) {
-                return false;
-            }
-        }
-    }
-
-    if (obj.contains("due_date") && !obj.value("due_date").isString() && !obj.value("due_date").isNull()) {
-        if (error) {
-            *error = "due_date 必须为字符串或空";
-        }
-        return false;
-    }
-    if (obj.contains("created_at") && !obj.value("created_at").isString() && !obj.value("created_at").isNull()) {
-        if (error) {
-            *error = "created_at 必须为字符串或空";
-        }
-        return false;
-    }
-    if (obj.contains("updated_at") && !obj.value("updated_at").isString() && !obj.value("updated_at").isNull()) {
-        if (error) {
-            *error = "updated_at 必须为字符串或空";
-        }
-        return false;
-    }
-    if (obj.contains("deleted_at") && !obj.value("deleted_at").isString() && !obj.value("deleted_at").isNull()) {
-        if (error) {
-            *error = "deleted_at 必须为字符串或空";
-        }
-        return false;
-    }
-
-    return true;
-}
-
-bool validateJsonStructure(const QJsonObject &root, QString *error)
-{
-    if (!root.contains("version") || !root.value("version").isString()) {
-        if (error) {
-            *error = "version 字段缺失或格式不正确";
-        }
-        return false;
-    }
-    if (!root.contains("export_date") || !root.value("export_date").isString()) {
-        if (error) {
-            *error = "export_date 字段缺失或格式不正确";
-        }
-        return false;
-    }
-    if (!root.contains("data") || !root.value("data").isObject()) {
-        if (error) {
-            *error = "data 字段缺失或格式不正确";
-        }
-        return false;
-    }
-
-    QJsonObject data = root.value("data").toObject();
-    if (data.contains("tasks")) {
-        if (!data.value("tasks").isArray()) {
-            if (error) {
-                *error = "tasks 字段必须为数组";
-            }
-            return false;
-        }
-        QJsonArray tasks = data.value("tasks").toArray();
-        for (const QJsonValue &val : tasks) {
-            if (!val.isObject()) {
-                if (error) {
-                    *error = "tasks 数组项必须为对象";
-                }
-                return false;
-            }
-            if (!validateJsonTask(val.toObject(), error)) {
-                return false;
-            }
-        }
-    }
-
-    auto ensureArray = [&](const QString &key) {
-        if (data.contains(key) && !data.value(key).isArray()) {
-            if (error) {
-                *error = QString("字段 %1 必须为数组").arg(key);
-            }
-            return false;
-        }
-        return true;
-    };
-
-    if (!ensureArray("folders")) {
-        return false;
-    }
-    if (!ensureArray("settings")) {
-        return false;
-    }
-    if (!ensureArray("notifications")) {
-        return false;
-    }
-    if (!ensureArray("tags")) {
-        return false;
-    }
-
-    return true;
-}
-
 bool validateSqliteFile(const QString &path, QString *error)
 {
     QFileInfo info(path);
@@ -725,44 +387,6 @@ bool validateSqliteFile(const QString &path, QString *error)
     return true;
 }
 
-bool clearAllData(QSqlDatabase &db, QString *error)
-{
-    QStringList tables = {
-        "task_tags",
-        "task_dependencies",
-        "task_files",
-        "task_steps",
-        "task_folders",
-        "notifications",
-        "tasks",
-        "folders",
-        "tags",
-        "settings",
-        "backup_history"
-    };
-
-    QSqlQuery query(db);
-    if (!query.exec("PRAGMA foreign_keys = OFF")) {
-        if (error) {
-            *error = "无法关闭外键约束";
-        }
-        return false;
-    }
-
-    for (const QString &table : tables) {
-        if (!query.exec(QString("DELETE FROM %1").arg(table))) {
-            if (error) {
-                *error = QString("清空表失败：%1").arg(table);
-            }
-            query.exec("PRAGMA foreign_keys = ON");
-            return false;
-        }
-    }
-
-    query.exec("PRAGMA foreign_keys = ON");
-    return true;
-}
-
 QString generateTimestampedSqliteName()
 {
     QString date = QDate::currentDate().toString("yyyyMMdd");
@@ -793,6 +417,7 @@ SettingsDialog::SettingsDialog(BackupManager *backupManager, QWidget *parent)
     , m_backupRetentionSpin(nullptr)
     , m_backupLocationEdit(nullptr)
     , m_backupOnExitCheck(nullptr)
+    , m_backupFormatCombo(nullptr)
     , m_backupNowButton(nullptr)
     , m_databasePathEdit(nullptr)
     , m_parentDeleteCombo(nullptr)
@@ -957,6 +582,12 @@ QWidget *SettingsDialog::buildBackupTab()
     m_backupRetentionSpin->setRange(1, 99);
     form->addRow("保留数量", m_backupRetentionSpin);
 
+    m_backupFormatCombo = new QComboBox(this);
+    m_backupFormatCombo->addItem("完整副本", static_cast<int>(BackupManager::FullCopy));
+    m_backupFormatCombo->addItem("增量（仅保存变化的数据块）", static_cast<int>(BackupManager::Incremental));
+    m_backupFormatCombo->addItem("压缩归档（带校验）", static_cast<int>(BackupManager::Compressed));
+    form->addRow("备份方式", m_backupFormatCombo);
+
     auto *locationLayout = new QHBoxLayout();
     m_backupLocationEdit = new QLineEdit(this);
     m_backupLocationEdit->setReadOnly(true);
@@ -1004,18 +635,24 @@ QWidget *SettingsDialog::buildDataTab()
     auto *importJsonBtn = new QPushButton("导入 JSON", this);
     auto *exportSqlBtn = new QPushButton("导出 SQLite", this);
     auto *importSqlBtn = new QPushButton("导入 SQLite", this);
+    auto *exportSnapshotBtn = new QPushButton("导出快照", this);
+    auto *importSnapshotBtn = new QPushButton("导入快照", this);
     auto *clearCacheBtn = new QPushButton("清理缓存", this);
 
     connect(exportJsonBtn, &QPushButton::clicked, this, &SettingsDialog::onExportJson);
     connect(importJsonBtn, &QPushButton::clicked, this, &SettingsDialog::onImportJson);
     connect(exportSqlBtn, &QPushButton::clicked, this, &SettingsDialog::onExportSqlite);
     connect(importSqlBtn, &QPushButton::clicked, this, &SettingsDialog::onImportSqlite);
+    connect(exportSnapshotBtn, &QPushButton::clicked, this, &SettingsDialog::onExportSnapshot);
+    connect(importSnapshotBtn, &QPushButton::clicked, this, &SettingsDialog::onImportSnapshot);
     connect(clearCacheBtn, &QPushButton::clicked, this, &SettingsDialog::onClearCache);
 
     actionLayout->addWidget(exportJsonBtn);
     actionLayout->addWidget(importJsonBtn);
     actionLayout->addWidget(exportSqlBtn);
     actionLayout->addWidget(importSqlBtn);
+    actionLayout->addWidget(exportSnapshotBtn);
+    actionLayout->addWidget(importSnapshotBtn);
     actionLayout->addWidget(clearCacheBtn);
 
     layout->addLayout(actionLayout);
@@ -1181,12 +818,20 @@ void SettingsDialog::loadSettings()
         m_backupRetentionSpin->setValue(m_backupManager->backupRetention());
         m_backupLocationEdit->setText(m_backupManager->backupLocation());
         m_backupOnExitCheck->setChecked(m_backupManager->backupOnExit());
+        int formatIndex = m_backupFormatCombo->findData(static_cast<int>(m_backupManager->backupFormat()));
+        if (formatIndex >= 0) {
+            m_backupFormatCombo->setCurrentIndex(formatIndex);
+        }
     } else {
         m_backupEnabledCheck->setChecked(getSetting("auto_backup_enabled", "1") == "1");
         m_backupTimeEdit->setTime(QTime::fromString(getSetting("backup_time", "02:00"), "HH:mm"));
         m_backupRetentionSpin->setValue(getSetting("backup_retention", "7").toInt());
         m_backupLocationEdit->setText(getSetting("backup_location", "backup"));
         m_backupOnExitCheck->setChecked(getSetting("backup_on_exit", "0") == "1");
+        int formatIndex = m_backupFormatCombo->findData(getSetting("backup_format", "0").toInt());
+        if (formatIndex >= 0) {
+            m_backupFormatCombo->setCurrentIndex(formatIndex);
+        }
     }
 
     m_databasePathEdit->setText(m_database->database().databaseName());
@@ -1248,6 +893,7 @@ bool SettingsDialog::applySettings()
             ok &= m_backupManager->setBackupLocation(m_backupLocationEdit->text().trimmed());
         }
         ok &= m_backupManager->setBackupOnExit(m_backupOnExitCheck->isChecked());
+        ok &= m_backupManager->setBackupFormat(static_cast<BackupManager::BackupFormat>(m_backupFormatCombo->currentData().toInt()));
     } else {
         ok &= setSetting("auto_backup_enabled", m_backupEnabledCheck->isChecked() ? "1" : "0");
         ok &= setSetting("backup_frequency", QString::number(m_backupFrequencyCombo->currentData().toInt()));
@@ -1255,6 +901,7 @@ bool SettingsDialog::applySettings()
         ok &= setSetting("backup_retention", QString::number(m_backupRetentionSpin->value()));
         ok &= setSetting("backup_location", m_backupLocationEdit->text().trimmed());
         ok &= setSetting("backup_on_exit", m_backupOnExitCheck->isChecked() ? "1" : "0");
+        ok &= setSetting("backup_format", QString::number(m_backupFormatCombo->currentData().toInt()));
     }
 
     ok &= setSetting(KEY_DELETE_PARENT_ACTION, QString::number(m_parentDeleteCombo->currentIndex()));
@@ -1275,6 +922,8 @@ bool SettingsDialog::applySettings()
     appFont.setPointSize(m_fontSizeSpin->value());
     qApp->setFont(appFont);
 
+    // 所有修改合并在一个事务里写回，写入失败时提示用户
+    ok &= SettingsStore::instance().flush();
     return ok;
 }
 
@@ -1306,12 +955,13 @@ void SettingsDialog::refreshShortcutsTable()
 
 QString SettingsDialog::getSetting(const QString &key, const QString &defaultValue) const
 {
-    return m_database->getSetting(key, defaultValue);
+    return SettingsStore::instance().value(key, defaultValue);
 }
 
 bool SettingsDialog::setSetting(const QString &key, const QString &value)
 {
-    return m_database->setSetting(key, value);
+    SettingsStore::instance().setValue(key, value);
+    return true;
 }
 
 void SettingsDialog::onBrowseBackupLocation()
@@ -1375,1149 +1025,166 @@ void SettingsDialog::onExportJson()
         return;
     }
 
-    QProgressDialog progress("正在导出数据...", QString(), 0, 100, this);
+    QProgressDialog progress("正在导出数据...", "取消", 0, 100, this);
     progress.setWindowModality(Qt::WindowModal);
     progress.setAutoClose(false);
     progress.setAutoReset(false);
-    progress.setCancelButton(nullptr);
     progress.show();
 
     QElapsedTimer timer;
     timer.start();
 
-    QSqlDatabase db = m_database->database();
-    QSqlQuery query(db);
-
-    auto countTable = [&](const QString &table) -> int {
-        QSqlQuery countQuery(db);
-        if (countQuery.exec(QString("SELECT COUNT(*) FROM %1").arg(table)) && countQuery.next()) {
-            return countQuery.value(0).toInt();
+    // 导出在工作线程中流式写出，这里只负责刷新进度和转发取消
+    JsonExporter exporter;
+    QEventLoop loop;
+    bool exported = false;
+    connect(&progress, &QProgressDialog::canceled, &exporter, &JsonExporter::cancel);
+    connect(&exporter, &JsonExporter::progressChanged, &progress, [&](int processed, int total) {
+        updateProgress(&progress, &timer, processed, total, "正在导出数据...", true);
+    });
+    connect(&exporter, &JsonExporter::finished, &loop, [&](bool success, const QString &exportError) {
+        exported = success;
+        if (!success) {
+            LOG_WARNING_F("SettingsDialog", "JSON export failed: %1", exportError);
         }
-        return 0;
-    };
+        loop.quit();
+    });
 
-    int totalItems = 0;
-    if (options.tasks) {
-        totalItems += countTable("tasks");
-        totalItems += countTable("task_steps");
-        totalItems += countTable("task_files");
-        totalItems += countTable("task_dependencies");
-        totalItems += countTable("task_tags");
-        totalItems += countTable("tags");
-    }
-    if (options.folders) {
-        totalItems += countTable("folders");
-        totalItems += countTable("task_folders");
-    }
-    if (options.settings) {
-        totalItems += countTable("settings");
-    }
-    if (options.notifications) {
-        totalItems += countTable("notifications");
+    if (exporter.start(filePath, options)) {
+        loop.exec();
+    } else {
+        LOG_WARNING_F("SettingsDialog", "JSON export failed: %1", exporter.lastError());
     }
-    if (totalItems <= 0) {
-        totalItems = 1;
+
+    if (!exported) {
+        progress.close();
+        if (!exporter.wasCancelled()) {
+            QMessageBox::warning(this, "导出 JSON", "无法写入 JSON 文件。");
+        }
+        return;
     }
 
-    int processed = 0;
+    LOG_INFO_F("SettingsDialog", "Exported %1 tasks to JSON in %2 ms", exporter.exportedTasks(), exporter.elapsedMs());
+    updateProgress(&progress, &timer, 100, 100, "导出完成", false);
+    progress.close();
 
-    QJsonObject root;
-    QString version = QCoreApplication::applicationVersion();
-    if (version.isEmpty()) {
-        version = "1.0.0";
+    QMessageBox msgBox(this);
+    msgBox.setWindowTitle("导出 JSON");
+    msgBox.setText(QString("导出完成。\n%1").arg(filePath));
+    QPushButton *openButton = msgBox.addButton("打开所在文件夹", QMessageBox::AcceptRole);
+    msgBox.addButton(QMessageBox::Ok);
+    msgBox.exec();
+    if (msgBox.clickedButton() == openButton) {
+        QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo(filePath).absolutePath()));
     }
-    root["version"] = version;
-    root["export_date"] = isoDateString(QDateTime::currentDateTimeUtc());
-
-    QJsonObject data;
-
-    if (options.tasks) {
-        QHash<int, QJsonObject> taskObjects;
-        QHash<int, QList<int>> childrenMap;
-        QList<int> rootIds;
-        QHash<int, QString> tagIdToName;
-
-        QJsonArray tagsArray;
-        if (query.exec("SELECT id, name, color, created_at FROM tags ORDER BY created_at ASC")) {
-            while (query.next()) {
-                QJsonObject tagObj;
-                int tagId = query.value(0).toInt();
-                QString tagName = query.value(1).toString();
-                tagObj["id"] = tagId;
-                tagObj["name"] = tagName;
-                tagObj["color"] = query.value(2).toString();
-                QDateTime createdAt = parseIsoDate(query.value(3).toString());
-                tagObj["created_at"] = isoDateString(createdAt);
-                tagsArray.append(tagObj);
-                tagIdToName.insert(tagId, tagName);
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
-        if (!tagsArray.isEmpty()) {
-            data["tags"] = tagsArray;
-        }
+}
 
-        if (query.exec("SELECT id, title, description, priority, due_date, completed, progress, parent_id, is_deleted, deleted_at, created_at, updated_at, file_path FROM tasks ORDER BY created_at ASC")) {
-            while (query.next()) {
-                QJsonObject taskObj;
-                int taskId = query.value(0).toInt();
-                taskObj["id"] = taskId;
-                taskObj["title"] = query.value(1).toString();
-                taskObj["description"] = query.value(2).toString();
-                taskObj["priority"] = query.value(3).toInt();
-
-                QDateTime dueDate = parseIsoDate(query.value(4).toString());
-                taskObj["due_date"] = isoDateString(dueDate);
-                taskObj["completed"] = query.value(5).toInt() == 1;
-                taskObj["progress"] = static_cast<int>(query.value(6).toDouble());
-                taskObj["parent_id"] = query.value(7).toInt();
-                taskObj["is_deleted"] = query.value(8).toInt() == 1;
-
-                QDateTime deletedAt = parseIsoDate(query.value(9).toString());
-                taskObj["deleted_at"] = isoDateString(deletedAt);
-
-                QDateTime createdAt = parseIsoDate(query.value(10).toString());
-                QDateTime updatedAt = parseIsoDate(query.value(11).toString());
-                taskObj["created_at"] = isoDateString(createdAt);
-                taskObj["updated_at"] = isoDateString(updatedAt);
-                taskObj["file_path"] = query.value(12).toString();
-
-                taskObj["tags"] = QJsonArray();
-                taskObj["tag_ids"] = QJsonArray();
-                taskObj["dependencies"] = QJsonArray();
-                taskObj["files"] = QJsonArray();
-                taskObj["steps"] = QJsonArray();
-                taskObj["children"] = QJsonArray();
-
-                taskObjects.insert(taskId, taskObj);
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
 
-        if (query.exec("SELECT id, task_id, title, completed, position, created_at FROM task_steps ORDER BY position ASC")) {
-            while (query.next()) {
-                int taskId = query.value(1).toInt();
-                if (taskObjects.contains(taskId)) {
-                    QJsonObject stepObj;
-                    stepObj["id"] = query.value(0).toInt();
-                    stepObj["title"] = query.value(2).toString();
-                    stepObj["completed"] = query.value(3).toInt() == 1;
-                    stepObj["position"] = query.value(4).toInt();
-                    QDateTime createdAt = parseIsoDate(query.value(5).toString());
-                    stepObj["created_at"] = isoDateString(createdAt);
-                    QJsonArray steps = taskObjects[taskId]["steps"].toArray();
-                    steps.append(stepObj);
-                    taskObjects[taskId]["steps"] = steps;
-                }
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
+void SettingsDialog::onImportJson()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "导入 JSON", "", "JSON 文件 (*.json)");
+    if (filePath.isEmpty()) {
+        return;
+    }
 
-        if (query.exec("SELECT task_id, depends_on_id FROM task_dependencies ORDER BY created_at ASC")) {
-            while (query.next()) {
-                int taskId = query.value(0).toInt();
-                if (taskObjects.contains(taskId)) {
-                    QJsonArray deps = taskObjects[taskId]["dependencies"].toArray();
-                    deps.append(query.value(1).toInt());
-                    taskObjects[taskId]["dependencies"] = deps;
-                }
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile() || !fileInfo.isReadable()) {
+        QMessageBox::warning(this, "导入 JSON", "无法读取 JSON 文件。");
+        return;
+    }
 
-        if (query.exec("SELECT task_id, tag_id FROM task_tags")) {
-            while (query.next()) {
-                int taskId = query.value(0).toInt();
-                int tagId = query.value(1).toInt();
-                if (taskObjects.contains(taskId)) {
-                    QJsonArray tagIds = taskObjects[taskId]["tag_ids"].toArray();
-                    tagIds.append(tagId);
-                    taskObjects[taskId]["tag_ids"] = tagIds;
-
-                    QString tagName = tagIdToName.value(tagId);
-                    if (!tagName.isEmpty()) {
-                        QJsonArray tags = taskObjects[taskId]["tags"].toArray();
-                        tags.append(tagName);
-                        taskObjects[taskId]["tags"] = tags;
-                    }
-                }
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
+    // 同一文件上次没有导完时，可以从最后一次暂存的位置继续
+    ImportOptions options;
+    bool resume = false;
+    if (JsonImporter::findResumableImport(filePath, &options)) {
+        auto response = QMessageBox::question(this,
+                                              "导入 JSON",
+                                              "检测到该文件有未完成的导入，是否从上次中断处继续？",
+                                              QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel,
+                                              QMessageBox::Yes);
+        if (response == QMessageBox::Cancel) {
+            return;
         }
-
-        if (query.exec("SELECT task_id, file_path, file_name, created_at FROM task_files ORDER BY created_at ASC")) {
-            while (query.next()) {
-                int taskId = query.value(0).toInt();
-                if (taskObjects.contains(taskId)) {
-                    QJsonObject fileObj;
-                    fileObj["path"] = query.value(1).toString();
-                    fileObj["name"] = query.value(2).toString();
-                    QDateTime createdAt = parseIsoDate(query.value(3).toString());
-                    fileObj["created_at"] = isoDateString(createdAt);
-                    QJsonArray files = taskObjects[taskId]["files"].toArray();
-                    files.append(fileObj);
-                    taskObjects[taskId]["files"] = files;
-                }
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
+        resume = response == QMessageBox::Yes;
+        if (!resume) {
+            options = ImportOptions();
         }
+    }
 
-        for (auto it = taskObjects.begin(); it != taskObjects.end(); ++it) {
-            QString primaryFile = it.value().value("file_path").toString();
-            if (!primaryFile.isEmpty()) {
-                QJsonArray files = it.value().value("files").toArray();
-                bool exists = false;
-                for (const QJsonValue &fileVal : files) {
-                    if (fileVal.isObject()) {
-                        if (fileVal.toObject().value("path").toString() == primaryFile) {
-                            exists = true;
-                            break;
-                        }
-                    }
-                }
-                if (!exists) {
-                    QJsonObject fileObj;
-                    fileObj["path"] = primaryFile;
-                    fileObj["name"] = QFileInfo(primaryFile).fileName();
-                    files.append(fileObj);
-                    it.value()["files"] = files;
-                }
-            }
-            it.value().remove("file_path");
+    if (!resume) {
+        if (!promptImportOptions(this, &options)) {
+            return;
         }
 
-        for (auto it = taskObjects.begin(); it != taskObjects.end(); ++it) {
-            int parentId = it.value().value("parent_id").toInt();
-            if (parentId > 0 && taskObjects.contains(parentId)) {
-                childrenMap[parentId].append(it.key());
-            } else {
-                rootIds.append(it.key());
+        if (options.mode == ImportOptions::Overwrite) {
+            auto response = QMessageBox::warning(this,
+                                                 "导入 JSON",
+                                                 "此操作会清空现有数据，是否继续？",
+                                                 QMessageBox::Yes | QMessageBox::No,
+                                                 QMessageBox::No);
+            if (response != QMessageBox::Yes) {
+                return;
             }
         }
-
-        auto buildTree = [&](auto &&self, int taskId) -> QJsonObject {
-            QJsonObject obj = taskObjects.value(taskId);
-            QJsonArray children;
-            for (int childId : childrenMap.value(taskId)) {
-                children.append(self(self, childId));
-            }
-            obj["children"] = children;
-            return obj;
-        };
-
-        QJsonArray tasksArray;
-        for (int rootId : rootIds) {
-            tasksArray.append(buildTree(buildTree, rootId));
-        }
-        data["tasks"] = tasksArray;
-    }
-
-    if (options.folders) {
-        QJsonArray foldersArray;
-        if (query.exec("SELECT id, name, color, position, created_at FROM folders ORDER BY position ASC")) {
-            while (query.next()) {
-                QJsonObject folderObj;
-                int folderId = query.value(0).toInt();
-                folderObj["id"] = folderId;
-                folderObj["name"] = query.value(1).toString();
-                folderObj["color"] = query.value(2).toString();
-                folderObj["position"] = query.value(3).toInt();
-                QDateTime createdAt = parseIsoDate(query.value(4).toString());
-                folderObj["created_at"] = isoDateString(createdAt);
-
-                QJsonArray taskIds;
-                QSqlQuery taskQuery(db);
-                taskQuery.prepare("SELECT task_id FROM task_folders WHERE folder_id = ?");
-                taskQuery.addBindValue(folderId);
-                if (taskQuery.exec()) {
-                    while (taskQuery.next()) {
-                        taskIds.append(taskQuery.value(0).toInt());
-                        processed++;
-                        updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-                    }
-                }
-                folderObj["task_ids"] = taskIds;
-                foldersArray.append(folderObj);
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
-        data["folders"] = foldersArray;
-    }
-
-    if (options.settings) {
-        QJsonArray settingsArray;
-        if (query.exec("SELECT key, value, updated_at FROM settings")) {
-            while (query.next()) {
-                QJsonObject settingObj;
-                settingObj["key"] = query.value(0).toString();
-                settingObj["value"] = query.value(1).toString();
-                QDateTime updatedAt = parseIsoDate(query.value(2).toString());
-                settingObj["updated_at"] = isoDateString(updatedAt);
-                settingsArray.append(settingObj);
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
-        data["settings"] = settingsArray;
-    }
-
-    if (options.notifications) {
-        QJsonArray notificationsArray;
-        if (query.exec("SELECT id, type, title, message, task_id, read, created_at FROM notifications ORDER BY created_at DESC")) {
-            while (query.next()) {
-                QJsonObject notificationObj;
-                notificationObj["id"] = query.value(0).toInt();
-                notificationObj["type"] = query.value(1).toInt();
-                notificationObj["title"] = query.value(2).toString();
-                notificationObj["message"] = query.value(3).toString();
-                notificationObj["task_id"] = query.value(4).toInt();
-                notificationObj["read"] = query.value(5).toInt() == 1;
-                QDateTime createdAt = parseIsoDate(query.value(6).toString());
-                notificationObj["created_at"] = isoDateString(createdAt);
-                notificationsArray.append(notificationObj);
-                processed++;
-                updateProgress(&progress, &timer, processed, totalItems, "正在导出数据...", true);
-            }
-        }
-        data["notifications"] = notificationsArray;
-    }
-
-    root["data"] = data;
-    QJsonDocument doc(root);
-
-    QFile outFile(filePath);
-    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        progress.close();
-        QMessageBox::warning(this, "导出 JSON", "无法写入 JSON 文件。");
-        return;
     }
-    outFile.write(doc.toJson(QJsonDocument::Indented));
-    outFile.close();
 
-    updateProgress(&progress, &timer, totalItems, totalItems, "导出完成", false);
-    progress.close();
-
-    QMessageBox msgBox(this);
-    msgBox.setWindowTitle("导出 JSON");
-    msgBox.setText(QString("导出完成。\n%1").arg(filePath));
-    QPushButton *openButton = msgBox.addButton("打开所在文件夹", QMessageBox::AcceptRole);
-    msgBox.addButton(QMessageBox::Ok);
-    msgBox.exec();
-    if (msgBox.clickedButton() == openButton) {
-        QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo(filePath).absolutePath()));
-    }
-}
-
-
-void SettingsDialog::onImportJson()
-{
-    QString filePath = QFileDialog::getOpenFileName(this, "导入 JSON", "", "JSON 文件 (*.json)");
-    if (filePath.isEmpty()) {
-        return;
-    }
-
-    QFile inFile(filePath);
-    if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "导入 JSON", "无法读取 JSON 文件。");
-        return;
-    }
-    QByteArray jsonData = inFile.readAll();
-    inFile.close();
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-        QMessageBox::warning(this, "导入 JSON", "JSON 格式不正确。");
-        return;
-    }
-
-    QJsonObject root = doc.object();
-    QString validationError;
-    if (!validateJsonStructure(root, &validationError)) {
-        QMessageBox::warning(this, "导入 JSON", validationError);
-        return;
-    }
-
-    ImportOptions options;
-    if (!promptImportOptions(this, &options)) {
-        return;
-    }
-
-    if (options.mode == ImportOptions::Overwrite) {
-        auto response = QMessageBox::warning(this,
-                                             "导入 JSON",
-                                             "此操作会清空现有数据，是否继续？",
-                                             QMessageBox::Yes | QMessageBox::No,
-                                             QMessageBox::No);
-        if (response != QMessageBox::Yes) {
-            return;
-        }
-    }
-
-    QProgressDialog progress("正在导入数据...", QString(), 0, 100, this);
+    QProgressDialog progress("正在导入数据...", "取消", 0, 100, this);
     progress.setWindowModality(Qt::WindowModal);
     progress.setAutoClose(false);
     progress.setAutoReset(false);
-    progress.setCancelButton(nullptr);
     progress.show();
 
     QElapsedTimer timer;
     timer.start();
 
-    QJsonObject data = root.value("data").toObject();
-    bool hasFolderData = data.contains("folders");
-
-    QList<ImportedTag> importedTags;
-    QHash<int, QString> importedTagIdToName;
-    if (data.contains("tags")) {
-        QJsonArray tagsArray = data.value("tags").toArray();
-        for (const QJsonValue &val : tagsArray) {
-            if (!val.isObject()) {
-                continue;
-            }
-            QJsonObject tagObj = val.toObject();
-            ImportedTag tag;
-            tag.originalId = tagObj.value("id").toInt(-1);
-            tag.name = tagObj.value("name").toString();
-            tag.color = tagObj.value("color").toString();
-            tag.createdAt = parseIsoDate(tagObj.value("created_at").toString());
-            if (!tag.name.trimmed().isEmpty()) {
-                importedTags.append(tag);
-                if (tag.originalId > 0) {
-                    importedTagIdToName.insert(tag.originalId, tag.name);
-                }
-            }
-        }
-    }
-
-    QList<ImportedFolder> importedFolders;
-    if (data.contains("folders")) {
-        QJsonArray foldersArray = data.value("folders").toArray();
-        for (const QJsonValue &val : foldersArray) {
-            if (!val.isObject()) {
-                continue;
-            }
-            QJsonObject folderObj = val.toObject();
-            ImportedFolder folder;
-            folder.originalId = folderObj.value("id").toInt(-1);
-            folder.name = folderObj.value("name").toString();
-            folder.color = folderObj.value("color").toString();
-            folder.position = folderObj.value("position").toInt(0);
-            folder.createdAt = parseIsoDate(folderObj.value("created_at").toString());
-            QJsonArray taskIds = folderObj.value("task_ids").toArray();
-            for (const QJsonValue &taskVal : taskIds) {
-                if (taskVal.isDouble()) {
-                    folder.taskIds.append(taskVal.toInt());
-                }
-            }
-            if (!folder.name.trimmed().isEmpty()) {
-                importedFolders.append(folder);
-            }
-        }
-    }
-
-    QList<ImportedSetting> importedSettings;
-    if (data.contains("settings")) {
-        QJsonArray settingsArray = data.value("settings").toArray();
-        for (const QJsonValue &val : settingsArray) {
-            if (!val.isObject()) {
-                continue;
-            }
-            QJsonObject settingObj = val.toObject();
-            ImportedSetting setting;
-            setting.key = settingObj.value("key").toString();
-            setting.value = settingObj.value("value").toString();
-            setting.updatedAt = parseIsoDate(settingObj.value("updated_at").toString());
-            if (!setting.key.trimmed().isEmpty()) {
-                importedSettings.append(setting);
-            }
-        }
-    }
-
-    QList<ImportedNotification> importedNotifications;
-    if (data.contains("notifications")) {
-        QJsonArray notificationsArray = data.value("notifications").toArray();
-        for (const QJsonValue &val : notificationsArray) {
-            if (!val.isObject()) {
-                continue;
-            }
-            QJsonObject notificationObj = val.toObject();
-            ImportedNotification notification;
-            notification.originalId = notificationObj.value("id").toInt(-1);
-            notification.type = notificationObj.value("type").toInt(0);
-            notification.title = notificationObj.value("title").toString();
-            notification.message = notificationObj.value("message").toString();
-            notification.taskId = notificationObj.value("task_id").toInt(0);
-            notification.read = notificationObj.value("read").toBool(false);
-            notification.createdAt = parseIsoDate(notificationObj.value("created_at").toString());
-            importedNotifications.append(notification);
+    // 导入在工作线程中边解析边写入，这里只负责刷新进度和转发取消
+    JsonImporter importer;
+    QEventLoop loop;
+    bool imported = false;
+    connect(&progress, &QProgressDialog::canceled, &importer, &JsonImporter::cancel);
+    connect(&importer, &JsonImporter::progressChanged, &progress, [&](qint64 bytesRead, qint64 totalBytes) {
+        updateProgress(&progress, &timer, static_cast<int>(bytesRead * 1000 / totalBytes), 1000, "正在导入数据...", true);
+    });
+    connect(&importer, &JsonImporter::finished, &loop, [&](bool success, const QString &importError) {
+        imported = success;
+        if (!success) {
+            LOG_WARNING_F("SettingsDialog", "JSON import failed: %1", importError);
         }
-    }
-    QList<ImportedTask> importedTasks;
-    bool taskParseError = false;
-    QString taskError;
-    if (data.contains("tasks")) {
-        QJsonArray tasksArray = data.value("tasks").toArray();
-        auto parseTasks = [&](auto &&self, const QJsonArray &array, int parentId) -> void {
-            for (const QJsonValue &val : array) {
-                if (!val.isObject()) {
-                    continue;
-                }
-                QJsonObject taskObj = val.toObject();
-                ImportedTask task;
-                task.originalId = taskObj.value("id").toInt(-1);
-                if (parentId > 0) {
-                    task.parentOriginalId = parentId;
-                } else {
-                    task.parentOriginalId = taskObj.value("parent_id").toInt(0);
-                }
-                task.title = taskObj.value("title").toString();
-                task.description = taskObj.value("description").toString();
-                task.priority = taskObj.value("priority").toInt(1);
-                task.completed = taskObj.value("completed").toBool(false);
-                task.progress = taskObj.value("progress").toInt(0);
-                task.isDeleted = taskObj.value("is_deleted").toBool(false);
-
-                QString dueDateStr = taskObj.value("due_date").toString();
-                task.dueDate = parseIsoDate(dueDateStr);
-                if (!dueDateStr.trimmed().isEmpty() && !task.dueDate.isValid()) {
-                    taskParseError = true;
-                    taskError = "任务日期格式不正确";
-                    return;
-                }
-                QString deletedAtStr = taskObj.value("deleted_at").toString();
-                task.deletedAt = parseIsoDate(deletedAtStr);
-                QString createdAtStr = taskObj.value("created_at").toString();
-                task.createdAt = parseIsoDate(createdAtStr);
-                QString updatedAtStr = taskObj.value("updated_at").toString();
-                task.updatedAt = parseIsoDate(updatedAtStr);
-
-                if (taskObj.contains("tags") && taskObj.value("tags").isArray()) {
-                    QJsonArray tags = taskObj.value("tags").toArray();
-                    for (const QJsonValue &tagVal : tags) {
-                        if (tagVal.isString()) {
-                            task.tagNames.append(tagVal.toString());
-                        }
-                    }
-                } else if (taskObj.contains("tag_ids") && taskObj.value("tag_ids").isArray()) {
-                    QJsonArray tagIds = taskObj.value("tag_ids").toArray();
-                    for (const QJsonValue &tagVal : tagIds) {
-                        int tagId = tagVal.toInt(-1);
-                        if (importedTagIdToName.contains(tagId)) {
-                            task.tagNames.append(importedTagIdToName.value(tagId));
-                        }
-                    }
-                }
-
-                if (taskObj.contains("dependencies") && taskObj.value("dependencies").isArray()) {
-                    QJsonArray deps = taskObj.value("dependencies").toArray();
-                    for (const QJsonValue &depVal : deps) {
-                        if (depVal.isDouble()) {
-                            task.dependencyIds.append(depVal.toInt());
-                        }
-                    }
-                }
-
-                if (taskObj.contains("files") && taskObj.value("files").isArray()) {
-                    QJsonArray files = taskObj.value("files").toArray();
-                    for (const QJsonValue &fileVal : files) {
-                        if (!fileVal.isObject()) {
-                            continue;
-                        }
-                        QJsonObject fileObj = fileVal.toObject();
-                        FileItem fileItem;
-                        fileItem.path = fileObj.value("path").toString();
-                        fileItem.name = fileObj.value("name").toString();
-                        if (!fileItem.path.trimmed().isEmpty()) {
-                            task.files.append(fileItem);
-                        }
-                    }
-                }
-
-                if (taskObj.contains("steps") && taskObj.value("steps").isArray()) {
-                    QJsonArray steps = taskObj.value("steps").toArray();
-                    for (const QJsonValue &stepVal : steps) {
-                        if (!stepVal.isObject()) {
-                            continue;
-                        }
-                        QJsonObject stepObj = stepVal.toObject();
-                        StepItem step;
-                        step.title = stepObj.value("title").toString();
-                        step.completed = stepObj.value("completed").toBool(false);
-                        step.position = stepObj.value("position").toInt(0);
-                        if (!step.title.trimmed().isEmpty()) {
-                            task.steps.append(step);
-                        }
-                    }
-                }
-
-                if (!task.title.trimmed().isEmpty()) {
-                    importedTasks.append(task);
-                }
-
-                if (taskObj.contains("children") && taskObj.value("children").isArray()) {
-                    if (task.originalId <= 0) {
-                        taskParseError = true;
-                        taskError = "包含子任务的任务必须提供 ID";
-                        return;
-                    }
-                    self(self, taskObj.value("children").toArray(), task.originalId);
-                    if (taskParseError) {
-                        return;
-                    }
-                }
-            }
-        };
-        parseTasks(parseTasks, tasksArray, 0);
-    }
-
-    if (taskParseError) {
-        QMessageBox::warning(this, "导入 JSON", taskError);
-        return;
-    }
-    int totalItems = importedTasks.size() + importedFolders.size() + importedSettings.size() +
-                     importedNotifications.size() + importedTags.size();
+        loop.quit();
+    });
 
-    for (const ImportedTask &task : importedTasks) {
-        totalItems += task.steps.size();
-        totalItems += task.files.size();
-        totalItems += task.dependencyIds.size();
-        totalItems += task.tagNames.size();
-    }
-    for (const ImportedFolder &folder : importedFolders) {
-        totalItems += folder.taskIds.size();
-    }
-    if (totalItems <= 0) {
-        totalItems = 1;
+    if (importer.start(filePath, options, resume)) {
+        loop.exec();
+    } else {
+        LOG_WARNING_F("SettingsDialog", "JSON import failed: %1", importer.lastError());
     }
 
-    int processed = 0;
-
-    QSqlDatabase db = m_database->database();
-    if (!db.transaction()) {
+    if (!imported) {
         progress.close();
-        QMessageBox::warning(this, "导入 JSON", "无法开始数据库事务。");
-        return;
-    }
 
-    QString dbError;
-    if (options.mode == ImportOptions::Overwrite) {
-        if (!clearAllData(db, &dbError)) {
-            db.rollback();
-            progress.close();
-            QMessageBox::warning(this, "导入 JSON", dbError);
-            return;
-        }
-    }
-
-    QSet<int> existingTaskIds;
-    QHash<QString, int> existingTagNameToId;
-    QHash<QString, int> existingFolderNameToId;
-    {
-        QSqlQuery existingQuery(db);
-        if (existingQuery.exec("SELECT id FROM tasks")) {
-            while (existingQuery.next()) {
-                existingTaskIds.insert(existingQuery.value(0).toInt());
-            }
-        }
-        if (existingQuery.exec("SELECT id, name FROM tags")) {
-            while (existingQuery.next()) {
-                existingTagNameToId.insert(existingQuery.value(1).toString(), existingQuery.value(0).toInt());
-            }
-        }
-        if (existingQuery.exec("SELECT id, name FROM folders")) {
-            while (existingQuery.next()) {
-                existingFolderNameToId.insert(existingQuery.value(1).toString(), existingQuery.value(0).toInt());
-            }
-        }
-    }
-
-    for (const ImportedTag &tag : importedTags) {
-        QString name = tag.name.trimmed();
-        if (name.isEmpty()) {
-            continue;
-        }
-        int actualId = -1;
-        if (existingTagNameToId.contains(name)) {
-            actualId = existingTagNameToId.value(name);
-            if (options.mode != ImportOptions::Append && options.conflict == ImportOptions::OverwriteConflict) {
-                QSqlQuery updateQuery(db);
-                updateQuery.prepare("UPDATE tags SET color = ? WHERE id = ?");
-                updateQuery.addBindValue(tag.color.isEmpty() ? "#3B82F6" : tag.color);
-                updateQuery.addBindValue(actualId);
-                updateQuery.exec();
+        // 导入完成前不会改动现有数据；已解析的部分留在暂存库中，下次可以接着导入
+        const bool resumable = JsonImporter::findResumableImport(filePath, nullptr);
+        const QString resumeHint = "现有数据未被修改，再次导入该文件时可以从中断处继续。";
+        if (importer.wasCancelled()) {
+            if (resumable) {
+                QMessageBox::information(this, "导入 JSON", QString("导入已取消。\n%1").arg(resumeHint));
             }
         } else {
-            QSqlQuery insertQuery(db);
-            insertQuery.prepare("INSERT INTO tags (name, color, created_at) VALUES (?, ?, ?)");
-            insertQuery.addBindValue(name);
-            insertQuery.addBindValue(tag.color.isEmpty() ? "#3B82F6" : tag.color);
-            insertQuery.addBindValue(isoDateString(tag.createdAt.isValid() ? tag.createdAt : QDateTime::currentDateTimeUtc()));
-            if (!insertQuery.exec()) {
-                db.rollback();
-                progress.close();
-                QMessageBox::warning(this, "导入 JSON", "导入标签失败。");
-                return;
-            }
-            actualId = insertQuery.lastInsertId().toInt();
-            existingTagNameToId.insert(name, actualId);
-        }
-        processed++;
-        updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-    }
-
-    QHash<int, int> folderIdMap;
-    QSet<QString> folderNames = existingFolderNameToId.keys().toSet();
-    for (const ImportedFolder &folder : importedFolders) {
-        QString name = folder.name.trimmed();
-        if (name.isEmpty()) {
-            continue;
-        }
-
-        int actualId = -1;
-        if (existingFolderNameToId.contains(name)) {
-            actualId = existingFolderNameToId.value(name);
-            if (options.mode != ImportOptions::Append && options.conflict == ImportOptions::OverwriteConflict) {
-                QSqlQuery updateQuery(db);
-                updateQuery.prepare("UPDATE folders SET color = ?, position = ? WHERE id = ?");
-                updateQuery.addBindValue(folder.color.isEmpty() ? "#64748B" : folder.color);
-                updateQuery.addBindValue(folder.position);
-                updateQuery.addBindValue(actualId);
-                updateQuery.exec();
-            } else if (options.conflict == ImportOptions::Regenerate) {
-                QString baseName = name + " (imported)";
-                QString newName = baseName;
-                int counter = 1;
-                while (folderNames.contains(newName)) {
-                    newName = QString("%1 %2").arg(baseName).arg(counter++);
-                }
-                QSqlQuery insertQuery(db);
-                insertQuery.prepare("INSERT INTO folders (name, color, position, created_at) VALUES (?, ?, ?, ?)");
-                insertQuery.addBindValue(newName);
-                insertQuery.addBindValue(folder.color.isEmpty() ? "#64748B" : folder.color);
-                insertQuery.addBindValue(folder.position);
-                insertQuery.addBindValue(isoDateString(folder.createdAt.isValid() ? folder.createdAt : QDateTime::currentDateTimeUtc()));
-                if (!insertQuery.exec()) {
-                    db.rollback();
-                    progress.close();
-                    QMessageBox::warning(this, "导入 JSON", "导入文件夹失败。");
-                    return;
-                }
-                actualId = insertQuery.lastInsertId().toInt();
-                existingFolderNameToId.insert(newName, actualId);
-                folderNames.insert(newName);
-            }
-        } else {
-            QSqlQuery insertQuery(db);
-            insertQuery.prepare("INSERT INTO folders (name, color, position, created_at) VALUES (?, ?, ?, ?)");
-            insertQuery.addBindValue(name);
-            insertQuery.addBindValue(folder.color.isEmpty() ? "#64748B" : folder.color);
-            insertQuery.addBindValue(folder.position);
-            insertQuery.addBindValue(isoDateString(folder.createdAt.isValid() ? folder.createdAt : QDateTime::currentDateTimeUtc()));
-            if (!insertQuery.exec()) {
-                db.rollback();
-                progress.close();
-                QMessageBox::warning(this, "导入 JSON", "导入文件夹失败。");
-                return;
-            }
-            actualId = insertQuery.lastInsertId().toInt();
-            existingFolderNameToId.insert(name, actualId);
-            folderNames.insert(name);
-        }
-
-        if (folder.originalId > 0 && actualId > 0) {
-            folderIdMap.insert(folder.originalId, actualId);
-        }
-
-        processed++;
-        updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-    }
-    QHash<int, int> taskIdMap;
-    QVector<int> finalTaskIds;
-    QVector<bool> taskUpdateRelations;
-    finalTaskIds.resize(importedTasks.size());
-    taskUpdateRelations.resize(importedTasks.size());
-
-    for (int i = 0; i < importedTasks.size(); ++i) {
-        const ImportedTask &task = importedTasks.at(i);
-        int parentId = 0;
-        if (task.parentOriginalId > 0) {
-            if (taskIdMap.contains(task.parentOriginalId)) {
-                parentId = taskIdMap.value(task.parentOriginalId);
-            } else if (existingTaskIds.contains(task.parentOriginalId)) {
-                parentId = task.parentOriginalId;
+            QString message = importer.lastError().isEmpty() ? QString("导入 JSON 失败。")
+                                                             : QString("导入失败：%1").arg(importer.lastError());
+            if (resumable) {
+                message += "\n" + resumeHint;
             }
+            QMessageBox::warning(this, "导入 JSON", message);
         }
-
-        bool hasId = task.originalId > 0;
-        bool exists = hasId && existingTaskIds.contains(task.originalId);
-        bool shouldUpdate = false;
-        int finalId = -1;
-
-        auto insertTask = [&](bool withId, int idValue) -> bool {
-            QSqlQuery insertQuery(db);
-            if (withId) {
-                insertQuery.prepare("INSERT INTO tasks (id, title, description, file_path, priority, due_date, completed, progress, parent_id, is_deleted, deleted_at, created_at, updated_at) "
-                                    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                insertQuery.addBindValue(idValue);
-            } else {
-                insertQuery.prepare("INSERT INTO tasks (title, description, file_path, priority, due_date, completed, progress, parent_id, is_deleted, deleted_at, created_at, updated_at) "
-                                    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-            }
-
-            QString primaryFilePath = task.files.isEmpty() ? QString() : task.files.first().path;
-            QString createdAt = isoDateString(task.createdAt.isValid() ? task.createdAt : QDateTime::currentDateTimeUtc());
-            QString updatedAt = isoDateString(task.updatedAt.isValid() ? task.updatedAt : QDateTime::currentDateTimeUtc());
-
-            insertQuery.addBindValue(task.title);
-            insertQuery.addBindValue(task.description);
-            insertQuery.addBindValue(primaryFilePath);
-            insertQuery.addBindValue(task.priority);
-            insertQuery.addBindValue(isoDateString(task.dueDate));
-            insertQuery.addBindValue(task.completed ? 1 : 0);
-            insertQuery.addBindValue(task.progress);
-            insertQuery.addBindValue(parentId);
-            insertQuery.addBindValue(task.isDeleted ? 1 : 0);
-            insertQuery.addBindValue(isoDateString(task.deletedAt));
-            insertQuery.addBindValue(createdAt);
-            insertQuery.addBindValue(updatedAt);
-
-            if (!insertQuery.exec()) {
-                return false;
-            }
-            finalId = withId ? idValue : insertQuery.lastInsertId().toInt();
-            return true;
-        };
-
-        auto updateTask = [&]() -> bool {
-            QSqlQuery updateQuery(db);
-            updateQuery.prepare("UPDATE tasks SET title = ?, description = ?, file_path = ?, priority = ?, due_date = ?, completed = ?, progress = ?, parent_id = ?, is_deleted = ?, deleted_at = ?, updated_at = ? WHERE id = ?");
-            QString primaryFilePath = task.files.isEmpty() ? QString() : task.files.first().path;
-            updateQuery.addBindValue(task.title);
-            updateQuery.addBindValue(task.description);
-            updateQuery.addBindValue(primaryFilePath);
-            updateQuery.addBindValue(task.priority);
-            updateQuery.addBindValue(isoDateString(task.dueDate));
-            updateQuery.addBindValue(task.completed ? 1 : 0);
-            updateQuery.addBindValue(task.progress);
-            updateQuery.addBindValue(parentId);
-            updateQuery.addBindValue(task.isDeleted ? 1 : 0);
-            updateQuery.addBindValue(isoDateString(task.deletedAt));
-            updateQuery.addBindValue(isoDateString(task.updatedAt.isValid() ? task.updatedAt : QDateTime::currentDateTimeUtc()));
-            updateQuery.addBindValue(task.originalId);
-            return updateQuery.exec();
-        };
-
-        if (options.mode == ImportOptions::Overwrite) {
-            if (hasId) {
-                if (!insertTask(true, task.originalId)) {
-                    db.rollback();
-                    progress.close();
-                    QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                    return;
-                }
-                finalId = task.originalId;
-            } else if (!insertTask(false, -1)) {
-                db.rollback();
-                progress.close();
-                QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                return;
-            }
-            shouldUpdate = true;
-        } else if (exists) {
-            if (options.conflict == ImportOptions::Skip) {
-                finalId = task.originalId;
-                shouldUpdate = false;
-            } else if (options.conflict == ImportOptions::OverwriteConflict) {
-                if (!updateTask()) {
-                    db.rollback();
-                    progress.close();
-                    QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                    return;
-                }
-                finalId = task.originalId;
-                shouldUpdate = true;
-            } else {
-                if (!insertTask(false, -1)) {
-                    db.rollback();
-                    progress.close();
-                    QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                    return;
-                }
-                shouldUpdate = true;
-            }
-        } else {
-            if (hasId) {
-                if (!insertTask(true, task.originalId)) {
-                    db.rollback();
-                    progress.close();
-                    QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                    return;
-                }
-                finalId = task.originalId;
-            } else if (!insertTask(false, -1)) {
-                db.rollback();
-                progress.close();
-                QMessageBox::warning(this, "导入 JSON", "导入任务失败。");
-                return;
-            }
-            shouldUpdate = true;
-        }
-
-        if (finalId > 0 && hasId) {
-            taskIdMap.insert(task.originalId, finalId);
-        }
-        if (finalId > 0 && !hasId) {
-            taskIdMap.insert(i + 1000000, finalId);
-        }
-
-        if (finalId > 0) {
-            existingTaskIds.insert(finalId);
-        }
-
-        finalTaskIds[i] = finalId;
-        taskUpdateRelations[i] = shouldUpdate;
-        processed++;
-        updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-    }
-
-    auto clearTaskRelations = [&](int taskId) {
-        QSqlQuery clearQuery(db);
-        clearQuery.prepare("DELETE FROM task_tags WHERE task_id = ?");
-        clearQuery.addBindValue(taskId);
-        clearQuery.exec();
-        clearQuery.prepare("DELETE FROM task_dependencies WHERE task_id = ?");
-        clearQuery.addBindValue(taskId);
-        clearQuery.exec();
-        clearQuery.prepare("DELETE FROM task_files WHERE task_id = ?");
-        clearQuery.addBindValue(taskId);
-        clearQuery.exec();
-        clearQuery.prepare("DELETE FROM task_steps WHERE task_id = ?");
-        clearQuery.addBindValue(taskId);
-        clearQuery.exec();
-        if (hasFolderData) {
-            clearQuery.prepare("DELETE FROM task_folders WHERE task_id = ?");
-            clearQuery.addBindValue(taskId);
-            clearQuery.exec();
-        }
-    };
-
-    for (int i = 0; i < importedTasks.size(); ++i) {
-        if (!taskUpdateRelations[i]) {
-            continue;
-        }
-        int taskId = finalTaskIds[i];
-        if (taskId <= 0) {
-            continue;
-        }
-        clearTaskRelations(taskId);
-
-        const ImportedTask &task = importedTasks.at(i);
-
-        for (const StepItem &step : task.steps) {
-            QSqlQuery stepQuery(db);
-            stepQuery.prepare("INSERT INTO task_steps (task_id, title, completed, position, created_at) VALUES (?, ?, ?, ?, ?)");
-            stepQuery.addBindValue(taskId);
-            stepQuery.addBindValue(step.title);
-            stepQuery.addBindValue(step.completed ? 1 : 0);
-            stepQuery.addBindValue(step.position);
-            stepQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-            stepQuery.exec();
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-
-        for (const FileItem &file : task.files) {
-            QSqlQuery fileQuery(db);
-            fileQuery.prepare("INSERT INTO task_files (task_id, file_path, file_name, created_at) VALUES (?, ?, ?, ?)");
-            fileQuery.addBindValue(taskId);
-            fileQuery.addBindValue(file.path);
-            QString fileName = file.name.isEmpty() ? QFileInfo(file.path).fileName() : file.name;
-            fileQuery.addBindValue(fileName);
-            fileQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-            fileQuery.exec();
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-
-        for (const QString &tagName : task.tagNames) {
-            QString trimmed = tagName.trimmed();
-            if (trimmed.isEmpty()) {
-                continue;
-            }
-            int tagId = -1;
-            if (existingTagNameToId.contains(trimmed)) {
-                tagId = existingTagNameToId.value(trimmed);
-            } else {
-                QSqlQuery insertQuery(db);
-                insertQuery.prepare("INSERT INTO tags (name, color, created_at) VALUES (?, ?, ?)");
-                insertQuery.addBindValue(trimmed);
-                insertQuery.addBindValue("#3B82F6");
-                insertQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-                if (insertQuery.exec()) {
-                    tagId = insertQuery.lastInsertId().toInt();
-                    existingTagNameToId.insert(trimmed, tagId);
-                }
-            }
-            if (tagId > 0) {
-                QSqlQuery tagQuery(db);
-                tagQuery.prepare("INSERT OR IGNORE INTO task_tags (task_id, tag_id) VALUES (?, ?)");
-                tagQuery.addBindValue(taskId);
-                tagQuery.addBindValue(tagId);
-                tagQuery.exec();
-            }
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-    }
-
-    for (int i = 0; i < importedTasks.size(); ++i) {
-        if (!taskUpdateRelations[i]) {
-            continue;
-        }
-        int taskId = finalTaskIds[i];
-        if (taskId <= 0) {
-            continue;
-        }
-
-        const ImportedTask &task = importedTasks.at(i);
-        for (int depId : task.dependencyIds) {
-            int mappedDep = -1;
-            if (taskIdMap.contains(depId)) {
-                mappedDep = taskIdMap.value(depId);
-            } else if (existingTaskIds.contains(depId)) {
-                mappedDep = depId;
-            }
-            if (mappedDep > 0 && mappedDep != taskId) {
-                QSqlQuery depQuery(db);
-                depQuery.prepare("INSERT OR IGNORE INTO task_dependencies (task_id, depends_on_id, created_at) VALUES (?, ?, ?)");
-                depQuery.addBindValue(taskId);
-                depQuery.addBindValue(mappedDep);
-                depQuery.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-                depQuery.exec();
-            }
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-    }
-
-    for (const ImportedFolder &folder : importedFolders) {
-        int folderId = folderIdMap.value(folder.originalId, -1);
-        if (folderId <= 0) {
-            continue;
-        }
-        for (int taskOriginalId : folder.taskIds) {
-            int mappedTaskId = -1;
-            if (taskIdMap.contains(taskOriginalId)) {
-                mappedTaskId = taskIdMap.value(taskOriginalId);
-            } else if (existingTaskIds.contains(taskOriginalId)) {
-                mappedTaskId = taskOriginalId;
-            }
-            if (mappedTaskId > 0) {
-                QSqlQuery folderQuery(db);
-                folderQuery.prepare("INSERT OR IGNORE INTO task_folders (task_id, folder_id) VALUES (?, ?)");
-                folderQuery.addBindValue(mappedTaskId);
-                folderQuery.addBindValue(folderId);
-                folderQuery.exec();
-            }
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-    }
-
-    if (options.mode != ImportOptions::Append) {
-        for (const ImportedSetting &setting : importedSettings) {
-            QSqlQuery settingQuery(db);
-            settingQuery.prepare("INSERT OR REPLACE INTO settings (key, value, updated_at) VALUES (?, ?, ?)");
-            settingQuery.addBindValue(setting.key);
-            settingQuery.addBindValue(setting.value);
-            settingQuery.addBindValue(isoDateString(setting.updatedAt.isValid() ? setting.updatedAt : QDateTime::currentDateTimeUtc()));
-            settingQuery.exec();
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-    }
-
-    if (options.mode != ImportOptions::Append) {
-        QSet<int> existingNotificationIds;
-        QSqlQuery notifQuery(db);
-        if (notifQuery.exec("SELECT id FROM notifications")) {
-            while (notifQuery.next()) {
-                existingNotificationIds.insert(notifQuery.value(0).toInt());
-            }
-        }
-
-        for (const ImportedNotification &notification : importedNotifications) {
-            int taskId = 0;
-            if (notification.taskId > 0) {
-                if (taskIdMap.contains(notification.taskId)) {
-                    taskId = taskIdMap.value(notification.taskId);
-                } else if (existingTaskIds.contains(notification.taskId)) {
-                    taskId = notification.taskId;
-                }
-            }
-
-            bool hasId = notification.originalId > 0;
-            bool exists = hasId && existingNotificationIds.contains(notification.originalId);
-            if (options.mode == ImportOptions::Overwrite || !exists || options.conflict == ImportOptions::Regenerate) {
-                QSqlQuery insertQuery(db);
-                if (hasId && (options.mode == ImportOptions::Overwrite || !exists)) {
-                    insertQuery.prepare("INSERT INTO notifications (id, type, title, message, task_id, read, created_at) VALUES (?, ?, ?, ?, ?, ?, ?)");
-                    insertQuery.addBindValue(notification.originalId);
-                } else {
-                    insertQuery.prepare("INSERT INTO notifications (type, title, message, task_id, read, created_at) VALUES (?, ?, ?, ?, ?, ?)");
-                }
-                insertQuery.addBindValue(notification.type);
-                insertQuery.addBindValue(notification.title);
-                insertQuery.addBindValue(notification.message);
-                insertQuery.addBindValue(taskId);
-                insertQuery.addBindValue(notification.read ? 1 : 0);
-                insertQuery.addBindValue(isoDateString(notification.createdAt.isValid() ? notification.createdAt : QDateTime::currentDateTimeUtc()));
-                insertQuery.exec();
-            } else if (options.conflict == ImportOptions::OverwriteConflict && exists) {
-                QSqlQuery updateQuery(db);
-                updateQuery.prepare("UPDATE notifications SET type = ?, title = ?, message = ?, task_id = ?, read = ?, created_at = ? WHERE id = ?");
-                updateQuery.addBindValue(notification.type);
-                updateQuery.addBindValue(notification.title);
-                updateQuery.addBindValue(notification.message);
-                updateQuery.addBindValue(taskId);
-                updateQuery.addBindValue(notification.read ? 1 : 0);
-                updateQuery.addBindValue(isoDateString(notification.createdAt.isValid() ? notification.createdAt : QDateTime::currentDateTimeUtc()));
-                updateQuery.addBindValue(notification.originalId);
-                updateQuery.exec();
-            }
-            processed++;
-            updateProgress(&progress, &timer, processed, totalItems, "正在导入数据...", false);
-        }
-    }
-
-    QSqlQuery rebuildQuery(db);
-    rebuildQuery.exec("INSERT INTO tasks_fts(tasks_fts) VALUES('rebuild')");
-
-    if (!db.commit()) {
-        db.rollback();
-        progress.close();
-        QMessageBox::warning(this, "导入 JSON", "提交数据失败。");
         return;
     }
 
-    updateProgress(&progress, &timer, totalItems, totalItems, "导入完成", false);
+    LOG_INFO_F("SettingsDialog", "Imported JSON in %1 ms, %2 tasks/s", importer.elapsedMs(), qRound(importer.tasksPerSecond()));
+    updateProgress(&progress, &timer, 1000, 1000, "导入完成", false);
     progress.close();
 
-    ImportSummary summary;
-    summary.tasks = importedTasks.size();
-    summary.folders = importedFolders.size();
-    summary.settings = (options.mode == ImportOptions::Append) ? 0 : importedSettings.size();
-    summary.notifications = (options.mode == ImportOptions::Append) ? 0 : importedNotifications.size();
-    summary.tags = importedTags.size();
-
+    const JsonImporter::Summary summary = importer.summary();
     QMessageBox::information(this,
                              "导入 JSON",
                              QString("导入完成。\n任务：%1\n文件夹：%2\n标签：%3\n设置：%4\n通知：%5")
@@ -2556,23 +1223,6 @@ void SettingsDialog::onExportSqlite()
         return;
     }
 
-    m_database->vacuum();
-
-    QString sourcePath = m_database->database().databaseName();
-    QFile sourceFile(sourcePath);
-    if (!sourceFile.open(QIODevice::ReadOnly)) {
-        QMessageBox::warning(this, "导出 SQLite", "无法读取数据库文件。");
-        return;
-    }
-
-    QFile destFile(filePath);
-    if (!destFile.open(QIODevice::WriteOnly)) {
-        sourceFile.close();
-        QMessageBox::warning(this, "导出 SQLite", "无法写入目标文件。");
-        return;
-    }
-
-    qint64 totalBytes = sourceFile.size();
     QProgressDialog progress("正在导出数据库...", QString(), 0, 100, this);
     progress.setWindowModality(Qt::WindowModal);
     progress.setAutoClose(false);
@@ -2582,32 +1232,32 @@ void SettingsDialog::onExportSqlite()
     QElapsedTimer timer;
     timer.start();
 
-    const qint64 chunkSize = 1024 * 1024;
-    qint64 copied = 0;
-    QByteArray buffer;
-    buffer.resize(static_cast<int>(chunkSize));
-
-    while (!sourceFile.atEnd()) {
-        qint64 bytesRead = sourceFile.read(buffer.data(), chunkSize);
-        if (bytesRead <= 0) {
-            break;
-        }
-        qint64 bytesWritten = destFile.write(buffer.constData(), bytesRead);
-        if (bytesWritten != bytesRead) {
-            sourceFile.close();
-            destFile.close();
-            destFile.remove();
-            progress.close();
-            QMessageBox::warning(this, "导出 SQLite", "导出数据库失败。");
-            return;
-        }
-        copied += bytesWritten;
-        int percent = totalBytes > 0 ? static_cast<int>((copied * 100) / totalBytes) : 100;
+    // 快照在工作线程中生成，这里只负责刷新进度
+    DatabaseSnapshot snapshot;
+    QEventLoop loop;
+    bool exported = false;
+    connect(&snapshot, &DatabaseSnapshot::progressChanged, &progress, [&](int percent) {
         updateProgress(&progress, &timer, percent, 100, "正在导出数据库...", true);
+    });
+    connect(&snapshot, &DatabaseSnapshot::finished, &loop, [&](bool success, const QString &snapshotError) {
+        exported = success;
+        if (!success) {
+            LOG_WARNING_F("SettingsDialog", "SQLite export failed: %1", snapshotError);
+        }
+        loop.quit();
+    });
+
+    if (snapshot.start(filePath)) {
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    } else {
+        LOG_WARNING_F("SettingsDialog", "SQLite export failed: %1", snapshot.lastError());
     }
 
-    sourceFile.close();
-    destFile.close();
+    if (!exported) {
+        progress.close();
+        QMessageBox::warning(this, "导出 SQLite", "导出数据库失败。");
+        return;
+    }
 
     updateProgress(&progress, &timer, 100, 100, "导出完成", false);
     progress.close();
@@ -2647,38 +1297,168 @@ void SettingsDialog::onImportSqlite()
     }
 
     QString dbPath = m_database->database().databaseName();
-    QString tempPath = QFileInfo(dbPath).absolutePath() + "/temp_import.db";
+    if (!m_database->replaceContentsFrom(filePath, dbPath + ".bak")) {
+        LOG_WARNING_F("SettingsDialog", "SQLite import failed: %1", m_database->lastError());
+        QMessageBox::warning(this, "导入 SQLite", "替换数据库失败。");
+        return;
+    }
+
+    QMessageBox::information(this, "导入 SQLite", "导入完成。");
+    emit dataImported();
+}
 
-    m_database->close();
 
-    if (QFile::exists(tempPath)) {
-        QFile::remove(tempPath);
+void SettingsDialog::onExportSnapshot()
+{
+    QString defaultName = QString("todolist_snapshot_%1%2").arg(QDate::currentDate().toString("yyyyMMdd"),
+                                                                BinarySnapshot::FILE_EXTENSION);
+    QString filePath = QFileDialog::getSaveFileName(
+        this,
+        "导出快照",
+        QDir(defaultExportDirectory()).filePath(defaultName),
+        "ToDoList 快照 (*.tdls)");
+    if (filePath.isEmpty()) {
+        return;
     }
 
-    if (!QFile::copy(filePath, tempPath)) {
-        m_database->open();
-        QMessageBox::warning(this, "导入 SQLite", "复制数据库失败。");
+    if (!filePath.endsWith(BinarySnapshot::FILE_EXTENSION, Qt::CaseInsensitive)) {
+        filePath += BinarySnapshot::FILE_EXTENSION;
+    }
+
+    QString error;
+    if (!ensureWritableExportLocation(this, filePath, &error)) {
+        if (error != "用户取消") {
+            QMessageBox::warning(this, "导出快照", error);
+        }
         return;
     }
 
-    if (QFile::exists(dbPath)) {
-        QFile::remove(dbPath + ".bak");
-        QFile::rename(dbPath, dbPath + ".bak");
+    QProgressDialog progress("正在导出快照...", "取消", 0, 100, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoClose(false);
+    progress.setAutoReset(false);
+    progress.show();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    BinarySnapshot snapshot;
+    QEventLoop loop;
+    bool exported = false;
+    connect(&progress, &QProgressDialog::canceled, &snapshot, &BinarySnapshot::cancel);
+    connect(&snapshot, &BinarySnapshot::progressChanged, &progress, [&](int processed, int total) {
+        updateProgress(&progress, &timer, processed, total, "正在导出快照...", true);
+    });
+    connect(&snapshot, &BinarySnapshot::finished, &loop, [&](bool success, const QString &snapshotError) {
+        exported = success;
+        if (!success) {
+            LOG_WARNING_F("SettingsDialog", "Snapshot export failed: %1", snapshotError);
+        }
+        loop.quit();
+    });
+
+    if (snapshot.startExport(filePath)) {
+        loop.exec();
+    } else {
+        LOG_WARNING_F("SettingsDialog", "Snapshot export failed: %1", snapshot.lastError());
     }
 
-    bool success = QFile::rename(tempPath, dbPath);
-    if (!success) {
-        if (QFile::exists(dbPath + ".bak")) {
-            QFile::rename(dbPath + ".bak", dbPath);
+    if (!exported) {
+        progress.close();
+        if (!snapshot.wasCancelled()) {
+            QMessageBox::warning(this, "导出快照", "无法写入快照文件。");
         }
-        m_database->open();
-        QMessageBox::warning(this, "导入 SQLite", "替换数据库失败。");
         return;
     }
 
-    m_database->open();
+    LOG_INFO_F("SettingsDialog", "Exported %1 tasks to snapshot in %2 ms", snapshot.taskCount(), snapshot.elapsedMs());
+    updateProgress(&progress, &timer, 100, 100, "导出完成", false);
+    progress.close();
 
-    QMessageBox::information(this, "导入 SQLite", "导入完成。");
+    QMessageBox msgBox(this);
+    msgBox.setWindowTitle("导出快照");
+    msgBox.setText(QString("导出完成，共 %1 个任务。\n%2").arg(snapshot.taskCount()).arg(filePath));
+    QPushButton *openButton = msgBox.addButton("打开所在文件夹", QMessageBox::AcceptRole);
+    msgBox.addButton(QMessageBox::Ok);
+    msgBox.exec();
+    if (msgBox.clickedButton() == openButton) {
+        QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo(filePath).absolutePath()));
+    }
+}
+
+
+void SettingsDialog::onImportSnapshot()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "导入快照", "", "ToDoList 快照 (*.tdls)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    auto response = QMessageBox::warning(this,
+                                         "导入快照",
+                                         "此操作将替换当前数据库，是否继续？",
+                                         QMessageBox::Yes | QMessageBox::No,
+                                         QMessageBox::No);
+    if (response != QMessageBox::Yes) {
+        return;
+    }
+
+    QProgressDialog progress("正在读取快照...", "取消", 0, 100, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoClose(false);
+    progress.setAutoReset(false);
+    progress.show();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 解码和校验在工作线程中写入临时数据库，全部通过后才替换当前数据
+    const QString dbPath = m_database->database().databaseName();
+    const QString decodedPath = dbPath + ".snapshot";
+    BinarySnapshot snapshot;
+    QEventLoop loop;
+    bool decoded = false;
+    QString decodeError;
+    connect(&progress, &QProgressDialog::canceled, &snapshot, &BinarySnapshot::cancel);
+    connect(&snapshot, &BinarySnapshot::progressChanged, &progress, [&](int processed, int total) {
+        updateProgress(&progress, &timer, processed, total, "正在读取快照...", true);
+    });
+    connect(&snapshot, &BinarySnapshot::finished, &loop, [&](bool success, const QString &snapshotError) {
+        decoded = success;
+        decodeError = snapshotError;
+        loop.quit();
+    });
+
+    if (snapshot.startImport(filePath, decodedPath)) {
+        loop.exec();
+    } else {
+        decodeError = snapshot.lastError();
+    }
+
+    if (!decoded) {
+        progress.close();
+        LOG_WARNING_F("SettingsDialog", "Snapshot import failed: %1", decodeError);
+        if (!snapshot.wasCancelled()) {
+            QMessageBox::warning(this, "导入快照", QString("快照校验失败：%1").arg(decodeError));
+        }
+        return;
+    }
+
+    progress.setCancelButton(nullptr);
+    progress.setLabelText("正在替换数据库...");
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+
+    const bool replaced = m_database->replaceContentsFrom(decodedPath, dbPath + ".bak");
+    QFile::remove(decodedPath);
+    progress.close();
+    if (!replaced) {
+        LOG_WARNING_F("SettingsDialog", "Snapshot import failed: %1", m_database->lastError());
+        QMessageBox::warning(this, "导入快照", "替换数据库失败。");
+        return;
+    }
+
+    LOG_INFO_F("SettingsDialog", "Imported %1 tasks from snapshot in %2 ms", snapshot.taskCount(), timer.elapsed());
+    QMessageBox::information(this, "导入快照", QString("导入完成，共 %1 个任务。").arg(snapshot.taskCount()));
     emit dataImported();
 }
 
@@ -2784,7 +1564,8 @@ void SettingsDialog::onCustomizeShortcut()
         }
     }
 
-    if (!setSetting(key, sequence)) {
+    setSetting(key, sequence);
+    if (!SettingsStore::instance().flush()) {
         QMessageBox::warning(this, "保存失败", "无法保存快捷键设置。请检查权限或数据库状态。");
         return;
     }
@@ -2793,8 +1574,6 @@ void SettingsDialog::onCustomizeShortcut()
     if (key == ShortcutKeys::Save && m_saveShortcut) {
         m_saveShortcut->setKey(QKeySequence(sequence));
     }
-
-    emit shortcutsChanged();
 }
 
 
@@ -2810,7 +1589,6 @@ void SettingsDialog::onResetShortcuts()
         m_saveShortcut->setKey(QKeySequence(getSetting(ShortcutKeys::Save, ShortcutKeys::DefaultSave)));
     }
 
-    emit shortcutsChanged();
     QMessageBox::information(this, "快捷键", "已恢复默认快捷键。");
 }
 
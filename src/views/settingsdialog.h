@@ -25,7 +25,6 @@ public:
 
 signals:
     void dataImported();
-    void shortcutsChanged();
 
 private slots:
     void onBrowseBackupLocation();
@@ -35,6 +34,8 @@ private slots:
     void onImportJson();
     void onExportSqlite();
     void onImportSqlite();
+    void onExportSnapshot();
+    void onImportSnapshot();
     void onClearCache();
     void onCustomizeShortcut();
     void onResetShortcuts();
@@ -86,6 +87,7 @@ private:
     QSpinBox *m_backupRetentionSpin;
     QLineEdit *m_backupLocationEdit;
     QCheckBox *m_backupOnExitCheck;
+    QComboBox *m_backupFormatCombo;
     QPushButton *m_backupNowButton;
 
     QLineEdit *m_databasePathEdit;
@@ -1,6 +1,7 @@
 #include "sidebar.h"
 #include "../utils/logger.h"
 #include "../controllers/database.h"
+#include "../controllers/change_journal.h"
 #include "../models/folder.h"
 #include "../models/tag.h"
 #include <QListWidgetItem>
@@ -35,6 +36,8 @@ Sidebar::Sidebar(QWidget *parent)
     setMaximumWidth(500);
     setMinimumHeight(400);
     setupUI();
+    ChangeJournal::instance().registerConsumer(this);
+    connect(&ChangeJournal::instance(), &ChangeJournal::changesAvailable, this, &Sidebar::onJournalChanges);
     LOG_INFO("Sidebar", "Sidebar widget created");
 }
 
@@ -229,6 +232,23 @@ void Sidebar::refreshTags()
     loadTags();
 }
 
+void Sidebar::reloadData()
+{
+    loadFolders();
+    loadTags();
+}
+
+void Sidebar::onJournalChanges()
+{
+    const ChangeJournal::Delta delta = ChangeJournal::instance().pull(this);
+    if (delta.touches({"folders"})) {
+        loadFolders();
+    }
+    if (delta.touches({"tags"})) {
+        loadTags();
+    }
+}
+
 void Sidebar::onItemClicked(QListWidgetItem *item)
 {
     if (!item) {
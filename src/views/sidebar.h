@@ -24,6 +24,7 @@ public:
     int sidebarWidth() const;
     void setSidebarWidth(int width);
     void refreshTags();
+    void reloadData();
 
 signals:
     void groupChanged(const QString &group);
@@ -36,6 +37,7 @@ signals:
 private slots:
     void onItemClicked(QListWidgetItem *item);
     void onNewFolderClicked();
+    void onJournalChanges();
 
 private:
     void setupUI();
@@ -1,6 +1,6 @@
 #include "task_card_widget.h"
 #include "task_dialog.h"
-#include "../controllers/database.h"
+#include "../controllers/settings_store.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
@@ -27,7 +27,7 @@ TaskCardWidget::~TaskCardWidget()
 
 void TaskCardWidget::setupUI()
 {
-    int cardStyle = Database::instance().getSetting("appearance_card_style", "0").toInt();
+    int cardStyle = SettingsStore::instance().intValue("appearance_card_style", 0);
     int margin = 16;
     int spacing = 12;
     if (cardStyle == 1) {
@@ -1,5 +1,6 @@
 #include "task_dialog.h"
 #include "../controllers/database.h"
+#include "../controllers/settings_store.h"
 #include "../utils/file_utils.h"
 #include "../utils/shortcut_keys.h"
 #include <QMessageBox>
@@ -72,7 +73,7 @@ void TaskDialog::setupUI()
     connect(saveButton, &QPushButton::clicked, this, &TaskDialog::onSaveClicked);
     connect(cancelButton, &QPushButton::clicked, this, &TaskDialog::onCancelClicked);
 
-    auto *saveShortcut = new QShortcut(QKeySequence(Database::instance().getSetting(ShortcutKeys::Save, ShortcutKeys::DefaultSave)), this);
+    auto *saveShortcut = new QShortcut(QKeySequence(SettingsStore::instance().value(ShortcutKeys::Save, ShortcutKeys::DefaultSave)), this);
     saveShortcut->setContext(Qt::WidgetWithChildrenShortcut);
     connect(saveShortcut, &QShortcut::activated, saveButton, &QPushButton::click);
 }
@@ -468,14 +469,18 @@ void TaskDialog::onSaveClicked()
     Task task = getTask();
     bool isNewTask = (m_taskId == -1);
 
+    // 任务、子任务、标签、附件和依赖在同一个事务中保存
+    TaskController::UnitOfWork unit(m_controller);
     if (isNewTask) {
         if (!m_controller->addTask(task)) {
+            unit.rollback();
             QMessageBox::critical(this, "错误", "任务创建失败");
             return;
         }
         m_taskId = task.id();
     } else {
         if (!m_controller->updateTask(task)) {
+            unit.rollback();
             QMessageBox::critical(this, "错误", "任务更新失败");
             return;
         }
@@ -543,6 +548,14 @@ void TaskDialog::onSaveClicked()
 
     m_controller->updateProgress(m_taskId);
 
+    if (!unit.commit()) {
+        if (isNewTask) {
+            m_taskId = -1;
+        }
+        QMessageBox::critical(this, "错误", isNewTask ? "任务创建失败" : "任务更新失败");
+        return;
+    }
+
     QMessageBox::information(this, "成功", isNewTask ? "任务创建成功" : "任务更新成功");
     accept();
 }
@@ -1,6 +1,7 @@
 #include "task_list_widget.h"
 #include "task_card_widget.h"
-#include "../controllers/database.h"
+#include "../controllers/settings_store.h"
+#include "../utils/logger.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QScrollArea>
@@ -8,10 +9,12 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QLayoutItem>
+#include <QElapsedTimer>
 
 TaskListWidget::TaskListWidget(TaskController *controller, QWidget *parent)
     : QWidget(parent)
     , m_controller(controller)
+    , m_searchColumnDirty(true)
 {
     setupUI();
     refreshTasks();
@@ -68,7 +71,7 @@ void TaskListWidget::setupTaskList()
 
     m_taskListContainer = new QWidget();
     m_taskListLayout = new QVBoxLayout(m_taskListContainer);
-    int cardStyle = Database::instance().getSetting("appearance_card_style", "0").toInt();
+    int cardStyle = SettingsStore::instance().intValue("appearance_card_style", 0);
     int spacing = 12;
     if (cardStyle == 1) {
         spacing = 8;
@@ -90,6 +93,7 @@ void TaskListWidget::refreshTasks()
 
     m_allTasks = m_controller->getAllTasks();
     m_filteredTasks = m_allTasks;
+    m_searchColumnDirty = true;
 
     for (const Task &task : m_filteredTasks) {
         if (task.parentId() == 0) {
@@ -110,6 +114,7 @@ void TaskListWidget::onTaskAdded(const Task &task)
         m_taskCards.append(card);
     }
     m_allTasks.append(task);
+    m_searchColumnDirty = true;
 }
 
 void TaskListWidget::onTaskUpdated(const Task &task)
@@ -118,6 +123,13 @@ void TaskListWidget::onTaskUpdated(const Task &task)
     if (card) {
         card->updateTask(task);
     }
+    for (Task &existing : m_allTasks) {
+        if (existing.id() == task.id()) {
+            existing = task;
+            m_searchColumnDirty = true;
+            break;
+        }
+    }
 }
 
 void TaskListWidget::onTaskDeleted(int taskId)
@@ -128,6 +140,13 @@ void TaskListWidget::onTaskDeleted(int taskId)
         m_taskCards.removeOne(card);
         delete card;
     }
+    for (int i = 0; i < m_allTasks.size(); ++i) {
+        if (m_allTasks.at(i).id() == taskId) {
+            m_allTasks.removeAt(i);
+            m_searchColumnDirty = true;
+            break;
+        }
+    }
 }
 
 void TaskListWidget::onTaskCompletionChanged(int taskId, bool completed)
@@ -150,18 +169,28 @@ TaskCardWidget* TaskListWidget::findTaskCard(int taskId)
 
 void TaskListWidget::filterTasks()
 {
-    QString searchText = m_searchEdit->text().trimmed().toLower();
+    QString searchText = m_searchEdit->text().trimmed();
 
     if (searchText.isEmpty()) {
         m_filteredTasks = m_allTasks;
     } else {
-        m_filteredTasks.clear();
-        for (const Task &task : m_allTasks) {
-            if (task.title().toLower().contains(searchText) ||
-                task.description().toLower().contains(searchText)) {
-                m_filteredTasks.append(task);
+        if (m_searchColumnDirty) {
+            m_searchColumn.clear();
+            m_searchColumn.reserve(m_allTasks.size(), 0);
+            for (const Task &task : qAsConst(m_allTasks)) {
+                m_searchColumn.appendRow(task.title(), task.description());
             }
+            m_searchColumnDirty = false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        m_filteredTasks.clear();
+        for (int row : m_searchColumn.matchingRows(searchText)) {
+            m_filteredTasks.append(m_allTasks.at(row));
         }
+        LOG_DEBUG_F("TaskListWidget", "Filtered %1 tasks with %2 kernel in %3 us",
+                    m_allTasks.size(), TextSearch::kernelName(), timer.nsecsElapsed() / 1000);
     }
 
     qDeleteAll(m_taskCards);
@@ -6,6 +6,7 @@
 #include <QVBoxLayout>
 #include <QLayout>
 #include "../controllers/task_controller.h"
+#include "../utils/text_search.h"
 
 class TaskCardWidget;
 class QLabel;
@@ -43,6 +44,8 @@ private:
     QList<Task> m_allTasks;
     QList<Task> m_filteredTasks;
     QList<TaskCardWidget*> m_taskCards;
+    FoldedTextColumn m_searchColumn;
+    bool m_searchColumnDirty;
 };
 
 #endif // TASK_LIST_WIDGET_H
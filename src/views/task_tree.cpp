@@ -2,6 +2,7 @@
 #include "../models/task.h"
 #include "../controllers/database.h"
 #include "../controllers/task_controller.h"
+#include "../controllers/change_journal.h"
 #include <QHeaderView>
 #include <QDragEnterEvent>
 #include <QDropEvent>
@@ -19,14 +20,41 @@
 #include <functional>
 #include <QRegularExpression>
 #include <QSqlError>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QSqlDriver>
+#include <QMutexLocker>
+#include "../controllers/background_job.h"
+#include "../utils/logger.h"
 #include "../utils/theme_manager.h"
 #include "../utils/theme_utils.h"
 
+#ifdef TODOLIST_HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
 namespace {
 constexpr int RoleTaskId = Qt::UserRole;
 constexpr int RoleCompleted = Qt::UserRole + 1;
 constexpr int RoleHasChildren = Qt::UserRole + 2;
 constexpr int RoleSourceInfo = Qt::UserRole + 3;
+constexpr qint64 PopulateSliceBudgetMs = 4;
+const char *TaskIdsMimeType = "application/x-todolist-task-ids";
+
+QList<int> decodeTaskIds(const QMimeData *data)
+{
+    QList<int> ids;
+    if (!data || !data->hasFormat(TaskIdsMimeType)) {
+        return ids;
+    }
+    for (const QByteArray &part : data->data(TaskIdsMimeType).split(',')) {
+        const int id = part.toInt();
+        if (id > 0 && !ids.contains(id)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
 
 QString buildFtsQuery(const QString &text)
 {
@@ -41,6 +69,281 @@ QString buildFtsQuery(const QString &text)
     }
     return terms.join(" AND ");
 }
+
+// 分组对应的筛选条件；不认识的分组返回空，按完整层级显示
+QString groupCondition(const QString &group)
+{
+    if (group == "今天") {
+        return "date(t.created_at) = date('now', 'localtime')";
+    } else if (group == "本周") {
+        return "strftime('%Y-%W', t.created_at) = strftime('%Y-%W', 'now', 'localtime')";
+    } else if (group == "本月") {
+        return "strftime('%Y-%m', t.created_at) = strftime('%Y-%m', 'now', 'localtime')";
+    } else if (group == "已过期") {
+        return "t.due_date < datetime('now', 'localtime') AND t.completed = 0";
+    } else if (group == "高优先级") {
+        return "t.priority = 3";
+    } else if (group == "中优先级") {
+        return "t.priority = 2";
+    } else if (group == "低优先级") {
+        return "t.priority = 1";
+    } else if (group == "已完成") {
+        return "t.completed = 1";
+    } else if (group == "未完成") {
+        return "t.completed = 0";
+    } else if (group == "进行中") {
+        return "t.completed = 0 AND t.progress > 0";
+    } else if (group == "所有任务") {
+        return "1=1";
+    }
+    return QString();
+}
+
+// 列顺序与视图查询的 SELECT 一致
+Task taskFromRow(const QSqlQuery &query)
+{
+    Task task;
+    task.setId(query.value(0).toInt());
+    task.setTitle(query.value(1).toString());
+    task.setDescription(query.value(2).toString());
+    task.setPriority(query.value(3).toInt());
+    task.setDueDate(QDateTime::fromString(query.value(4).toString(), Qt::ISODate));
+    task.setCompleted(query.value(5).toBool());
+    task.setProgress(query.value(6).toDouble());
+    task.setParentId(query.value(7).toInt());
+    task.setCreatedAt(QDateTime::fromString(query.value(8).toString(), Qt::ISODate));
+    task.setUpdatedAt(QDateTime::fromString(query.value(9).toString(), Qt::ISODate));
+    task.setHasChildren(query.value(10).toBool());
+    return task;
+}
+
+const char *TaskColumns =
+    "t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at, "
+    "CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = t.id AND child.is_deleted = 0) THEN 1 ELSE 0 END";
+
+QString placeholders(int count)
+{
+    QStringList marks;
+    for (int i = 0; i < count; ++i) {
+        marks << "?";
+    }
+    return marks.join(",");
+}
+
+bool matchesFtsTerms(const Task &task, const QString &text)
+{
+    // 与 FTS5 前缀查询一致：每个词都要匹配标题或描述中某个词的前缀
+    static const QRegularExpression separator(R"([^\p{L}\p{N}]+)");
+    QString cleaned = text;
+    cleaned.replace(QRegularExpression(R"(["':*])"), " ");
+    const QStringList terms = cleaned.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    const QStringList words = (task.title() + ' ' + task.description()).split(separator, Qt::SkipEmptyParts);
+    for (const QString &term : terms) {
+        bool found = false;
+        for (const QString &word : words) {
+            if (word.startsWith(term, Qt::CaseInsensitive)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 条件视图的查询参数，按值交给工作线程
+struct ViewQuery
+{
+    QString group;
+    int tagId;
+    int folderId;
+    TaskSearchFilters filters;
+};
+
+// Qt 的 SQLite 驱动通过 handle() 暴露底层连接；没有链接 SQLite 时无法打断语句，只能等它结束后丢弃结果
+void *interruptHandle(const QSqlDatabase &database)
+{
+#ifdef TODOLIST_HAVE_SQLITE3
+    const QVariant handle = database.driver()->handle();
+    if (handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0) {
+        return *static_cast<sqlite3 *const *>(handle.constData());
+    }
+#else
+    Q_UNUSED(database);
+#endif
+    return nullptr;
+}
+
+void interruptStatement(void *handle)
+{
+#ifdef TODOLIST_HAVE_SQLITE3
+    sqlite3_interrupt(static_cast<sqlite3 *>(handle));
+#else
+    Q_UNUSED(handle);
+#endif
+}
+
+// cancelled 置位后不再读取剩余的行，也不再退回 LIKE 重试
+bool queryViewTasks(const QSqlDatabase &database, const ViewQuery &view, const QList<int> &onlyIds, QList<Task> *tasks,
+                    bool *usedFts, QString *error, const std::atomic<bool> *cancelled)
+{
+    const TaskSearchFilters &filters = view.filters;
+    const bool isRecycleBin = (view.group == "回收站");
+    // 回收站和按标签、文件夹查看时分组本身不附加条件
+    const QString groupClause = isRecycleBin || groupCondition(view.group).isEmpty() ? QString("1=1")
+                                                                                     : groupCondition(view.group);
+
+    QStringList joins;
+    QStringList conditions;
+    QVariantList bindValues;
+    conditions << groupClause;
+    
+    QList<int> tagIds = filters.tagIds;
+    if (view.tagId > 0) {
+        tagIds = {view.tagId};
+    }
+    if (!tagIds.isEmpty()) {
+        joins << "INNER JOIN task_tags tt ON tt.task_id = t.id";
+        conditions << QString("tt.tag_id IN (%1)").arg(placeholders(tagIds.size()));
+        for (int id : tagIds) {
+            bindValues << id;
+        }
+    }
+
+    if (view.folderId > 0) {
+        joins << "INNER JOIN task_folders tf ON tf.task_id = t.id";
+        conditions << "tf.folder_id = ?";
+        bindValues << view.folderId;
+    }
+
+    if (!onlyIds.isEmpty()) {
+        conditions << QString("t.id IN (%1)").arg(placeholders(onlyIds.size()));
+        for (int id : onlyIds) {
+            bindValues << id;
+        }
+    }
+    
+    if (filters.priority > 0) {
+        conditions << "t.priority = ?";
+        bindValues << filters.priority;
+    }
+    
+    switch (filters.status) {
+    case TaskSearchStatusFilter::Completed:
+        conditions << "t.completed = 1";
+        break;
+    case TaskSearchStatusFilter::Incomplete:
+        conditions << "t.completed = 0";
+        break;
+    case TaskSearchStatusFilter::InProgress:
+        conditions << "t.completed = 0 AND t.progress > 0";
+        break;
+    default:
+        break;
+    }
+    
+    switch (filters.date) {
+    case TaskSearchDateFilter::Today:
+        conditions << "date(t.due_date) = date('now', 'localtime')";
+        break;
+    case TaskSearchDateFilter::ThisWeek:
+        conditions << "strftime('%Y-%W', t.due_date) = strftime('%Y-%W', 'now', 'localtime')";
+        break;
+    case TaskSearchDateFilter::ThisMonth:
+        conditions << "strftime('%Y-%m', t.due_date) = strftime('%Y-%m', 'now', 'localtime')";
+        break;
+    case TaskSearchDateFilter::Overdue:
+        conditions << "t.due_date < datetime('now', 'localtime') AND t.completed = 0";
+        break;
+    default:
+        break;
+    }
+    
+    const QString rawText = filters.text.trimmed();
+    const QString ftsQuery = buildFtsQuery(rawText);
+    const bool hasText = !rawText.isEmpty();
+    const bool useFts = hasText && !ftsQuery.isEmpty();
+    const bool useLike = hasText && !useFts;
+    
+    auto buildOrderClause = [&filters]() -> QString {
+        switch (filters.sort) {
+        case TaskSearchSort::CreatedDesc:
+            return "ORDER BY t.created_at DESC";
+        case TaskSearchSort::DueDateAsc:
+            return "ORDER BY CASE WHEN t.due_date IS NULL OR t.due_date = '' THEN 1 ELSE 0 END, t.due_date ASC";
+        case TaskSearchSort::DueDateDesc:
+            return "ORDER BY CASE WHEN t.due_date IS NULL OR t.due_date = '' THEN 1 ELSE 0 END, t.due_date DESC";
+        case TaskSearchSort::PriorityDesc:
+            return "ORDER BY t.priority DESC, t.created_at DESC";
+        case TaskSearchSort::PriorityAsc:
+            return "ORDER BY t.priority ASC, t.created_at DESC";
+        case TaskSearchSort::Manual:
+        default:
+            return "ORDER BY t.sort_key, t.created_at DESC";
+        }
+    };
+    
+    auto runQuery = [&](bool ftsMode, bool likeMode) -> bool {
+        QStringList queryJoins = joins;
+        QStringList queryConditions = conditions;
+        QVariantList queryBinds = bindValues;
+        
+        if (ftsMode) {
+            queryJoins << "INNER JOIN tasks_fts f ON f.rowid = t.id";
+            queryConditions << "f MATCH ?";
+            queryBinds << ftsQuery;
+        } else if (likeMode) {
+            queryConditions << "(lower(t.title) LIKE ? OR lower(t.description) LIKE ?)";
+            const QString pattern = "%" + rawText.toLower() + "%";
+            queryBinds << pattern << pattern;
+        }
+        
+        const QString orderClause = buildOrderClause();
+        const QString deletedPredicate = isRecycleBin ? "t.is_deleted = 1" : "t.is_deleted = 0";
+        const QString distinctClause = !tagIds.isEmpty() ? "DISTINCT " : "";
+        const QString joinClause = queryJoins.join(" ");
+        const QString whereClauseCombined = queryConditions.join(" AND ");
+        const QString queryStr = QString(R"(
+            SELECT %1%2
+            FROM tasks t
+            %3
+            WHERE %4 AND %5
+            %6
+        )").arg(distinctClause, QString(TaskColumns), joinClause, deletedPredicate, whereClauseCombined, orderClause);
+        
+        QSqlQuery query(database);
+        query.setForwardOnly(true);
+        query.prepare(queryStr);
+        for (const QVariant &value : queryBinds) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        
+        tasks->clear();
+        while (query.next()) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                return false;
+            }
+            tasks->append(taskFromRow(query));
+        }
+        return true;
+    };
+
+    *usedFts = useFts;
+    if (runQuery(useFts, useLike)) {
+        return true;
+    }
+    if (!useFts || (cancelled && cancelled->load())) {
+        return false;
+    }
+    *usedFts = false;
+    return runQuery(false, true);
+}
 }
 
 TaskTreeItemDelegate::TaskTreeItemDelegate(QObject *parent)
@@ -272,6 +575,88 @@ bool TaskTreeItemDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
     return QStyledItemDelegate::editorEvent(event, model, option, index);
 }
 
+TaskTreeModel::TaskTreeModel(QObject *parent)
+    : QStandardItemModel(parent)
+{
+}
+
+QStringList TaskTreeModel::mimeTypes() const
+{
+    return QStringList() << TaskIdsMimeType;
+}
+
+QMimeData *TaskTreeModel::mimeData(const QModelIndexList &indexes) const
+{
+    QList<QByteArray> ids;
+    for (const QModelIndex &index : indexes) {
+        const int id = index.data(RoleTaskId).toInt();
+        if (id > 0) {
+            ids.append(QByteArray::number(id));
+        }
+    }
+    if (ids.isEmpty()) {
+        return nullptr;
+    }
+
+    auto *data = new QMimeData();
+    data->setData(TaskIdsMimeType, ids.join(','));
+    return data;
+}
+
+Qt::DropActions TaskTreeModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+bool TaskTreeModel::canDropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
+                                    const QModelIndex &parent) const
+{
+    Q_UNUSED(row);
+    Q_UNUSED(column);
+    const QList<int> ids = decodeTaskIds(data);
+    if (action != Qt::MoveAction || ids.isEmpty()) {
+        return false;
+    }
+    // 落点本身或它的祖先被拖动时会形成环，拖动过程中就显示为不可放置
+    for (QModelIndex ancestor = parent; ancestor.isValid(); ancestor = ancestor.parent()) {
+        if (ids.contains(ancestor.data(RoleTaskId).toInt())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskTreeModel::dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
+                                 const QModelIndex &parent)
+{
+    if (!canDropMimeData(data, action, row, column, parent)) {
+        return false;
+    }
+    const QList<int> ids = decodeTaskIds(data);
+    const int parentId = parent.isValid() ? parent.data(RoleTaskId).toInt() : 0;
+
+    int previousId = 0;
+    int nextId = 0;
+    if (row >= 0) {
+        for (int r = row - 1; r >= 0 && previousId == 0; --r) {
+            const int id = index(r, 0, parent).data(RoleTaskId).toInt();
+            if (id > 0 && !ids.contains(id)) {
+                previousId = id;
+            }
+        }
+        for (int r = row; r < rowCount(parent) && nextId == 0; ++r) {
+            const int id = index(r, 0, parent).data(RoleTaskId).toInt();
+            if (id > 0 && !ids.contains(id)) {
+                nextId = id;
+            }
+        }
+    }
+
+    emit tasksDropped(ids, parentId, previousId, nextId);
+    // 不接受这次放置，视图就不会自己移动或删除源行
+    return false;
+}
+
 TaskTree::TaskTree(TaskController *controller, QWidget *parent)
     : QWidget(parent)
     , m_controller(controller)
@@ -282,20 +667,36 @@ TaskTree::TaskTree(TaskController *controller, QWidget *parent)
     , m_currentTagId(0)
     , m_currentFolderId(0)
     , m_searchFilters()
+    , m_populateTimer(new QTimer(this))
+    , m_pendingIndex(0)
+    , m_pendingAttachPass(false)
+    , m_restoreViewState(false)
+    , m_restoreSelectedId(-1)
+    , m_restoreScrollValue(-1)
+    , m_lastQueryUsedFts(false)
+    , m_queryJob(new BackgroundJob(this))
+    , m_queryGeneration(0)
+    , m_queryRestart(false)
+    , m_queryCancelled(false)
+    , m_queryHandle(nullptr)
 {
+    m_populateTimer->setSingleShot(true);
+    m_populateTimer->setInterval(0);
+    connect(m_populateTimer, &QTimer::timeout, this, &TaskTree::populateNextSlice);
+    connect(m_queryJob, &BackgroundJob::finished, this, &TaskTree::onFilterQueryFinished);
+
     setupUI();
     setupContextMenu();
-    connect(m_controller, &TaskController::taskAdded, this, &TaskTree::refreshTasks);
-    connect(m_controller, &TaskController::taskUpdated, this, &TaskTree::refreshTasks);
-    connect(m_controller, &TaskController::taskDeleted, this, [this](int taskId) {
-        Q_UNUSED(taskId);
-        refreshTasks();
-    });
-    connect(m_controller, &TaskController::taskCompletionChanged, this, &TaskTree::refreshTasks);
+    // 本进程的提交、维护清理和外部写入都经由变更日志通知；只更新变化的行，日志有缺口时才整体重建
+    ChangeJournal::instance().registerConsumer(this);
+    connect(&ChangeJournal::instance(), &ChangeJournal::changesAvailable, this, &TaskTree::onJournalChanges);
 }
 
 TaskTree::~TaskTree()
 {
+    cancelPopulate();
+    cancelFilterQuery();
+    m_queryJob->wait();
 }
 
 void TaskTree::setupUI()
@@ -308,7 +709,7 @@ void TaskTree::setupUI()
     m_treeView->setObjectName("taskTreeView");
     m_treeView->setContextMenuPolicy(Qt::CustomContextMenu);
     
-    m_treeModel = new QStandardItemModel(this);
+    m_treeModel = new TaskTreeModel(this);
     m_treeModel->setHorizontalHeaderLabels(QStringList() << "任务");
     
     m_treeView->setModel(m_treeModel);
@@ -318,7 +719,7 @@ void TaskTree::setupUI()
     m_treeView->setExpandsOnDoubleClick(false);
     m_treeView->setRootIsDecorated(false);
     m_treeView->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    m_treeView->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_treeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_treeView->setDragEnabled(true);
     m_treeView->setAcceptDrops(true);
     m_treeView->setDropIndicatorShown(true);
@@ -339,6 +740,8 @@ void TaskTree::setupUI()
     connect(m_treeView, &QTreeView::customContextMenuRequested, this, &TaskTree::onContextMenu);
     connect(m_treeView, &QTreeView::expanded, this, &TaskTree::onExpandItem);
     connect(m_treeView, &QTreeView::collapsed, this, &TaskTree::onCollapseItem);
+    // 等拖放事件处理完再写库和重建模型
+    connect(m_treeModel, &TaskTreeModel::tasksDropped, this, &TaskTree::onTasksDropped, Qt::QueuedConnection);
     
     layout->addWidget(m_treeView);
 }
@@ -459,307 +862,368 @@ void TaskTree::loadChildTasks(int parentId, QStandardItem *parentItem)
     for (const Task &task : subtasks) {
         QStandardItem *childItem = createTaskItem(task);
         parentItem->appendRow(childItem);
-        m_tasksCache[task.id()] = task;
-        
+        m_itemsById.insert(task.id(), childItem);
+        m_taskRecords.update(task);
     }
 }
 
 void TaskTree::loadAllTasks()
 {
-    m_treeModel->clear();
-        m_treeModel->setHorizontalHeaderLabels(QStringList() << "任务");
-    m_tasksCache.clear();
-    
+    cancelFilterQuery();
+    m_lastQueryKey.clear();
+    m_lastQueryTasks.clear();
+
     QList<Task> allTasks = m_controller->getTaskHierarchy(0);
-    
-    QMap<int, QStandardItem*> itemMap;
-    
+
+    // 父任务不存在或已删除时，子任务连同它的后代都不显示，与增量更新时的处理一致
+    QHash<int, int> parentOf;
+    parentOf.reserve(allTasks.size());
     for (const Task &task : allTasks) {
-        QStandardItem *item = createTaskItem(task);
-        m_tasksCache[task.id()] = task;
-        itemMap[task.id()] = item;
-        
-        if (task.parentId() == 0 || task.parentId() == -1) {
-            m_treeModel->appendRow(item);
-        }
+        parentOf.insert(task.id(), task.parentId());
     }
-    
+    QHash<int, bool> reachable;
+    std::function<bool(int)> isReachable = [&](int id) {
+        auto it = reachable.constFind(id);
+        if (it != reachable.constEnd()) {
+            return it.value();
+        }
+        // 先记为不可达，父子关系成环时不会无限递归
+        reachable.insert(id, false);
+        const int parentId = parentOf.value(id);
+        const bool result = parentId <= 0 || (parentOf.contains(parentId) && isReachable(parentId));
+        reachable.insert(id, result);
+        return result;
+    };
+
+    QList<PendingTaskRow> rows;
+    rows.reserve(allTasks.size());
     for (const Task &task : allTasks) {
-        if (task.parentId() > 0 && itemMap.contains(task.parentId())) {
-            QStandardItem *parentItem = itemMap[task.parentId()];
-            QStandardItem *childItem = itemMap[task.id()];
-            parentItem->appendRow(childItem);
+        if (isReachable(task.id())) {
+            rows.append(PendingTaskRow{task, QString(), QString()});
         }
     }
-
-    emit taskCountChanged(m_treeModel->rowCount());
+    beginPopulate(rows);
 }
 
-void TaskTree::loadFilteredTasks(const QString &group, int tagId, const TaskSearchFilters &filters, int folderId)
+void TaskTree::loadFilteredTasks()
 {
-    m_treeModel->clear();
-    m_treeModel->setHorizontalHeaderLabels(QStringList() << "任务");
-    m_tasksCache.clear();
-    
+    const QString rawText = m_searchFilters.text.trimmed();
+    const bool hasText = !rawText.isEmpty();
+    const QString queryKey = filterQueryKey();
+
+    // 新关键词是上一次关键词的延伸时，结果必然是上一次结果的子集，直接在内存中筛选
+    static const QRegularExpression plainFtsText(R"(^[\p{L}\p{N}\s"':*]*$)");
+    const bool canRefine = hasText && !m_lastQueryKey.isEmpty() && queryKey == m_lastQueryKey
+        && rawText.length() > m_lastQueryText.length()
+        && rawText.startsWith(m_lastQueryText, Qt::CaseInsensitive)
+        && (!m_lastQueryUsedFts || plainFtsText.match(rawText).hasMatch());
+    if (!canRefine) {
+        startFilterQuery();
+        return;
+    }
+
+    // 内存筛选的结果比还在执行的查询更新
+    cancelFilterQuery();
     QList<Task> tasks;
-    QString whereClause;
-    bool showDeleted = false;
-    bool isRecycleBin = (group == "回收站");
-    
-    if (group == "今天") {
-        whereClause = "date(t.created_at) = date('now', 'localtime')";
-    } else if (group == "本周") {
-        whereClause = "strftime('%Y-%W', t.created_at) = strftime('%Y-%W', 'now', 'localtime')";
-    } else if (group == "本月") {
-        whereClause = "strftime('%Y-%m', t.created_at) = strftime('%Y-%m', 'now', 'localtime')";
-    } else if (group == "已过期") {
-        whereClause = "t.due_date < datetime('now', 'localtime') AND t.completed = 0";
-    } else if (group == "高优先级") {
-        whereClause = "t.priority = 3";
-    } else if (group == "中优先级") {
-        whereClause = "t.priority = 2";
-    } else if (group == "低优先级") {
-        whereClause = "t.priority = 1";
-    } else if (group == "已完成") {
-        whereClause = "t.completed = 1";
-    } else if (group == "未完成") {
-        whereClause = "t.completed = 0";
-    } else if (group == "进行中") {
-        whereClause = "t.completed = 0 AND t.progress > 0";
-    } else if (group == "所有任务") {
-        whereClause = "1=1";
+    if (m_lastQueryUsedFts) {
+        for (const Task &task : qAsConst(m_lastQueryTasks)) {
+            if (matchesFtsTerms(task, rawText)) {
+                tasks.append(task);
+            }
+        }
     } else {
-        if (tagId <= 0 && folderId <= 0 && !isRecycleBin) {
-            loadAllTasks();
-            return;
+        for (int row : m_lastQueryColumn.matchingRows(rawText)) {
+            tasks.append(m_lastQueryTasks.at(row));
         }
-        whereClause = "1=1";
     }
+    showFilteredTasks(tasks, true, m_lastQueryUsedFts, queryKey, rawText);
+}
 
-    if (isRecycleBin) {
-        whereClause = "1=1";
-        showDeleted = true;
+QString TaskTree::filterQueryKey() const
+{
+    QList<int> tagIds = m_searchFilters.tagIds;
+    if (m_currentTagId > 0) {
+        tagIds = {m_currentTagId};
     }
+    QStringList keyParts;
+    keyParts << m_currentGroup << QString::number(m_currentFolderId) << QString::number(m_searchFilters.priority)
+             << QString::number(static_cast<int>(m_searchFilters.status))
+             << QString::number(static_cast<int>(m_searchFilters.date))
+             << QString::number(static_cast<int>(m_searchFilters.sort));
+    for (int id : tagIds) {
+        keyParts << QString::number(id);
+    }
+    return keyParts.join('|');
+}
 
-    QStringList joins;
-    QStringList conditions;
-    QVariantList bindValues;
-    
-    if (!whereClause.isEmpty()) {
-        conditions << whereClause;
+void TaskTree::showFilteredTasks(const QList<Task> &tasks, bool queryOk, bool usedFts, const QString &queryKey,
+                                 const QString &rawText)
+{
+    if (!rawText.isEmpty() && queryOk) {
+        m_lastQueryKey = queryKey;
+        m_lastQueryText = rawText;
+        m_lastQueryUsedFts = usedFts;
+        m_lastQueryTasks = tasks;
+        m_lastQueryColumn.clear();
+        if (!usedFts) {
+            m_lastQueryColumn.reserve(tasks.size(), 0);
+            for (const Task &task : tasks) {
+                m_lastQueryColumn.appendRow(task.title(), task.description());
+            }
+        }
+    } else {
+        m_lastQueryKey.clear();
+        m_lastQueryTasks.clear();
+        m_lastQueryColumn.clear();
     }
     
-    QList<int> tagIds = filters.tagIds;
-    if (tagId > 0) {
-        tagIds.clear();
-        tagIds.append(tagId);
-    }
-    if (!tagIds.isEmpty()) {
-        joins << "INNER JOIN task_tags tt ON tt.task_id = t.id";
-        QStringList placeholders;
-        for (int i = 0; i < tagIds.size(); ++i) {
-            placeholders << "?";
-        }
-        conditions << QString("tt.tag_id IN (%1)").arg(placeholders.join(","));
-        for (int id : tagIds) {
-            bindValues << id;
-        }
-    }
-
-    if (folderId > 0) {
-        joins << "INNER JOIN task_folders tf ON tf.task_id = t.id";
-        conditions << "tf.folder_id = ?";
-        bindValues << folderId;
-    }
-    
-    if (filters.priority > 0) {
-        conditions << "t.priority = ?";
-        bindValues << filters.priority;
-    }
-    
-    switch (filters.status) {
-    case TaskSearchStatusFilter::Completed:
-        conditions << "t.completed = 1";
-        break;
-    case TaskSearchStatusFilter::Incomplete:
-        conditions << "t.completed = 0";
-        break;
-    case TaskSearchStatusFilter::InProgress:
-        conditions << "t.completed = 0 AND t.progress > 0";
-        break;
-    default:
-        break;
-    }
-    
-    switch (filters.date) {
-    case TaskSearchDateFilter::Today:
-        conditions << "date(t.due_date) = date('now', 'localtime')";
-        break;
-    case TaskSearchDateFilter::ThisWeek:
-        conditions << "strftime('%Y-%W', t.due_date) = strftime('%Y-%W', 'now', 'localtime')";
-        break;
-    case TaskSearchDateFilter::ThisMonth:
-        conditions << "strftime('%Y-%m', t.due_date) = strftime('%Y-%m', 'now', 'localtime')";
-        break;
-    case TaskSearchDateFilter::Overdue:
-        conditions << "t.due_date < datetime('now', 'localtime') AND t.completed = 0";
-        break;
-    default:
-        break;
-    }
-    
-    const QString rawText = filters.text.trimmed();
-    const QString ftsQuery = buildFtsQuery(rawText);
-    const bool hasText = !rawText.isEmpty();
-    bool useFts = hasText && !ftsQuery.isEmpty();
-    bool useLike = hasText && !useFts;
-    
-    auto buildOrderClause = [&filters]() -> QString {
-        switch (filters.sort) {
-        case TaskSearchSort::CreatedDesc:
-            return "ORDER BY t.created_at DESC";
-        case TaskSearchSort::DueDateAsc:
-            return "ORDER BY CASE WHEN t.due_date IS NULL OR t.due_date = '' THEN 1 ELSE 0 END, t.due_date ASC";
-        case TaskSearchSort::DueDateDesc:
-            return "ORDER BY CASE WHEN t.due_date IS NULL OR t.due_date = '' THEN 1 ELSE 0 END, t.due_date DESC";
-        case TaskSearchSort::PriorityDesc:
-            return "ORDER BY t.priority DESC, t.created_at DESC";
-        case TaskSearchSort::PriorityAsc:
-            return "ORDER BY t.priority ASC, t.created_at DESC";
-        case TaskSearchSort::Manual:
-        default:
-            return "ORDER BY t.created_at DESC";
-        }
-    };
-    
-    auto runQuery = [&](bool ftsMode, bool likeMode) -> bool {
-        QStringList queryJoins = joins;
-        QStringList queryConditions = conditions;
-        QVariantList queryBinds = bindValues;
-        
-        if (ftsMode) {
-            queryJoins << "INNER JOIN tasks_fts f ON f.rowid = t.id";
-            queryConditions << "f MATCH ?";
-            queryBinds << ftsQuery;
-        } else if (likeMode) {
-            queryConditions << "(lower(t.title) LIKE ? OR lower(t.description) LIKE ?)";
-            const QString pattern = "%" + rawText.toLower() + "%";
-            queryBinds << pattern << pattern;
-        }
-        
-        const QString orderClause = buildOrderClause();
-        const QString deletedPredicate = showDeleted ? "t.is_deleted = 1" : "t.is_deleted = 0";
-        const bool useDistinct = !tagIds.isEmpty();
-        const QString distinctClause = useDistinct ? "DISTINCT " : "";
-        const QString joinClause = queryJoins.join(" ");
-        const QString whereClauseCombined = queryConditions.isEmpty() ? QString("1=1") : queryConditions.join(" AND ");
-        const QString queryStr = QString(R"(
-            SELECT %1t.id, t.title, t.description, t.priority, t.due_date, t.completed, t.progress, t.parent_id, t.created_at, t.updated_at,
-                   CASE WHEN EXISTS(SELECT 1 FROM tasks child WHERE child.parent_id = t.id AND child.is_deleted = 0) THEN 1 ELSE 0 END as has_children
-            FROM tasks t
-            %2
-            WHERE %3 AND %4
-            %5
-        )").arg(distinctClause, joinClause, deletedPredicate, whereClauseCombined, orderClause);
-        
-        QSqlQuery query(Database::instance().database());
-        query.prepare(queryStr);
-        for (const QVariant &value : queryBinds) {
-            query.addBindValue(value);
-        }
-        if (!query.exec()) {
-            return false;
-        }
-        
-        tasks.clear();
-        while (query.next()) {
-            Task task;
-            task.setId(query.value(0).toInt());
-            task.setTitle(query.value(1).toString());
-            task.setDescription(query.value(2).toString());
-            task.setPriority(query.value(3).toInt());
-            task.setDueDate(QDateTime::fromString(query.value(4).toString(), Qt::ISODate));
-            task.setCompleted(query.value(5).toBool());
-            task.setProgress(query.value(6).toDouble());
-            task.setParentId(query.value(7).toInt());
-            task.setCreatedAt(QDateTime::fromString(query.value(8).toString(), Qt::ISODate));
-            task.setUpdatedAt(QDateTime::fromString(query.value(9).toString(), Qt::ISODate));
-            task.setHasChildren(query.value(10).toBool());
-            tasks.append(task);
-        }
-        return true;
-    };
-    
-    if (!runQuery(useFts, useLike) && useFts) {
-        runQuery(false, true);
-    }
-    
-    QMap<int, QStandardItem*> itemMap;
     QSet<int> taskIds;
     for (const Task &task : tasks) {
         taskIds.insert(task.id());
     }
     
     QMap<int, Task> parentCache;
-    auto buildSourceInfo = [&](int parentId, QString *tooltipOut) -> QString {
-        if (parentId <= 0) {
-            return QString();
-        }
-        Task parentTask;
-        if (parentCache.contains(parentId)) {
-            parentTask = parentCache.value(parentId);
-        } else {
-            parentTask = m_controller->getTaskById(parentId);
-            parentCache.insert(parentId, parentTask);
-        }
-        if (parentTask.id() <= 0) {
-            return QString();
-        }
-        QString timeStr;
-        if (parentTask.createdAt().isValid()) {
-            timeStr = parentTask.createdAt().toString("yyyy-MM-dd HH:mm");
+    QList<PendingTaskRow> rows;
+    rows.reserve(tasks.size());
+    for (const Task &task : tasks) {
+        QString sourceInfo;
+        QString sourceTooltip;
+        if (task.parentId() > 0 && !taskIds.contains(task.parentId())) {
+            sourceInfo = buildSourceInfo(task.parentId(), &parentCache, &sourceTooltip);
         }
-        if (tooltipOut) {
-            if (timeStr.isEmpty()) {
-                *tooltipOut = QString("父任务：%1").arg(parentTask.title());
+        rows.append(PendingTaskRow{task, sourceInfo, sourceTooltip});
+    }
+    beginPopulate(rows);
+}
+
+// 查询在工作线程的只读连接上执行，期间界面照常响应；新的查询到来时打断旧的语句
+void TaskTree::startFilterQuery()
+{
+    ++m_queryGeneration;
+    if (m_queryJob->isRunning()) {
+        m_queryRestart = true;
+        interruptFilterQuery();
+        return;
+    }
+
+    const QString databasePath = Database::instance().database().databaseName();
+    const ViewQuery view{m_currentGroup, m_currentTagId, m_currentFolderId, m_searchFilters};
+    const QString connectionName = BackgroundJob::connectionName("task_filter");
+    m_queryCancelled = false;
+    m_queryResult = FilterQueryResult();
+    m_queryResult.generation = m_queryGeneration;
+    m_queryResult.key = filterQueryKey();
+    m_queryResult.text = m_searchFilters.text.trimmed();
+
+    m_queryJob->start([this, databasePath, view, connectionName]() {
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(databasePath);
+            database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1;QSQLITE_OPEN_READONLY").arg(BackgroundJob::BusyTimeoutMs));
+            if (!database.open()) {
+                m_queryResult.error = database.lastError().text();
             } else {
-                *tooltipOut = QString("父任务：%1\n创建时间：%2").arg(parentTask.title(), timeStr);
+                {
+                    QMutexLocker locker(&m_queryHandleMutex);
+                    m_queryHandle = interruptHandle(database);
+                }
+                if (!m_queryCancelled) {
+                    m_queryResult.ok = queryViewTasks(database, view, QList<int>(), &m_queryResult.tasks,
+                                                      &m_queryResult.usedFts, &m_queryResult.error, &m_queryCancelled);
+                }
+                {
+                    QMutexLocker locker(&m_queryHandleMutex);
+                    m_queryHandle = nullptr;
+                }
+                database.close();
             }
         }
+        QSqlDatabase::removeDatabase(connectionName);
+    }, QThread::NormalPriority);
+}
+
+// 切换到层级视图或改用内存筛选后，正在执行的查询结果不再需要
+void TaskTree::cancelFilterQuery()
+{
+    ++m_queryGeneration;
+    m_queryRestart = false;
+    if (m_queryJob->isRunning()) {
+        interruptFilterQuery();
+    }
+}
+
+void TaskTree::interruptFilterQuery()
+{
+    m_queryCancelled = true;
+    QMutexLocker locker(&m_queryHandleMutex);
+    if (m_queryHandle) {
+        interruptStatement(m_queryHandle);
+    }
+}
+
+void TaskTree::onFilterQueryFinished()
+{
+    if (m_queryRestart) {
+        m_queryRestart = false;
+        startFilterQuery();
+        return;
+    }
+    if (m_queryResult.generation != m_queryGeneration) {
+        m_queryResult = FilterQueryResult();
+        return;
+    }
+
+    const FilterQueryResult result = m_queryResult;
+    m_queryResult = FilterQueryResult();
+    if (!result.ok) {
+        LOG_WARNING_F("TaskTree", "Filter query failed: %1", result.error);
+    }
+    showFilteredTasks(result.ok ? result.tasks : QList<Task>(), result.ok, result.usedFts, result.key, result.text);
+}
+
+bool TaskTree::queryFilteredTasks(const QList<int> &onlyIds, QList<Task> *tasks, bool *usedFts)
+{
+    const ViewQuery view{m_currentGroup, m_currentTagId, m_currentFolderId, m_searchFilters};
+    QString error;
+    return queryViewTasks(Database::instance().database(), view, onlyIds, tasks, usedFts, &error, nullptr);
+}
+
+QString TaskTree::buildSourceInfo(int parentId, QMap<int, Task> *cache, QString *tooltipOut)
+{
+    if (parentId <= 0) {
+        return QString();
+    }
+    Task parentTask;
+    if (cache->contains(parentId)) {
+        parentTask = cache->value(parentId);
+    } else {
+        parentTask = m_controller->getTaskById(parentId);
+        cache->insert(parentId, parentTask);
+    }
+    if (parentTask.id() <= 0) {
+        return QString();
+    }
+    QString timeStr;
+    if (parentTask.createdAt().isValid()) {
+        timeStr = parentTask.createdAt().toString("yyyy-MM-dd HH:mm");
+    }
+    if (tooltipOut) {
         if (timeStr.isEmpty()) {
-            return parentTask.title();
+            *tooltipOut = QString("父任务：%1").arg(parentTask.title());
+        } else {
+            *tooltipOut = QString("父任务：%1\n创建时间：%2").arg(parentTask.title(), timeStr);
         }
-        return QString("%1 / %2").arg(timeStr, parentTask.title());
-    };
-    
-    for (const Task &task : tasks) {
-        QString sourceInfo;
-        QString sourceTooltip;
-        if (task.parentId() > 0 && !taskIds.contains(task.parentId())) {
-            sourceInfo = buildSourceInfo(task.parentId(), &sourceTooltip);
+    }
+    if (timeStr.isEmpty()) {
+        return parentTask.title();
+    }
+    return QString("%1 / %2").arg(timeStr, parentTask.title());
+}
+
+void TaskTree::beginPopulate(const QList<PendingTaskRow> &rows)
+{
+    cancelPopulate();
+
+    m_treeModel->clear();
+    m_treeModel->setHorizontalHeaderLabels(QStringList() << "任务");
+    m_taskRecords.clear();
+    m_taskRecords.reserve(rows.size());
+
+    m_pendingRows = rows;
+    for (const PendingTaskRow &row : m_pendingRows) {
+        m_pendingTaskIds.insert(row.task.id());
+    }
+
+    // 小数据量在第一个时间片内即可完成，不会产生闪烁
+    populateNextSlice();
+}
+
+void TaskTree::populateNextSlice()
+{
+    QElapsedTimer budget;
+    budget.start();
+
+    QList<QStandardItem*> rootItems;
+    while (!m_pendingAttachPass && m_pendingIndex < m_pendingRows.size()
+           && budget.elapsed() < PopulateSliceBudgetMs) {
+        const PendingTaskRow &row = m_pendingRows.at(m_pendingIndex++);
+        QStandardItem *item = createTaskItem(row.task, row.sourceInfo, row.sourceTooltip);
+        m_taskRecords.append(row.task);
+        m_itemsById.insert(row.task.id(), item);
+        if (row.task.parentId() <= 0 || !m_pendingTaskIds.contains(row.task.parentId())) {
+            rootItems.append(item);
         }
-        QStandardItem *item = createTaskItem(task, sourceInfo, sourceTooltip);
-        m_tasksCache[task.id()] = task;
-        itemMap[task.id()] = item;
     }
-    
-    for (const Task &task : tasks) {
-        if (task.parentId() <= 0 || !itemMap.contains(task.parentId())) {
-            m_treeModel->appendRow(itemMap[task.id()]);
+    if (!rootItems.isEmpty()) {
+        m_treeModel->invisibleRootItem()->appendRows(rootItems);
+    }
+
+    if (!m_pendingAttachPass && m_pendingIndex >= m_pendingRows.size()) {
+        m_pendingAttachPass = true;
+        m_pendingIndex = 0;
+    }
+
+    while (m_pendingAttachPass && m_pendingIndex < m_pendingRows.size()
+           && budget.elapsed() < PopulateSliceBudgetMs) {
+        const Task &task = m_pendingRows.at(m_pendingIndex++).task;
+        if (task.parentId() > 0 && m_itemsById.contains(task.parentId())) {
+            m_itemsById.value(task.parentId())->appendRow(m_itemsById.value(task.id()));
         }
     }
-    
-    for (const Task &task : tasks) {
-        if (task.parentId() > 0 && itemMap.contains(task.parentId())) {
-            QStandardItem *parentItem = itemMap[task.parentId()];
-            QStandardItem *childItem = itemMap[task.id()];
-            parentItem->appendRow(childItem);
+
+    if (m_pendingAttachPass && m_pendingIndex >= m_pendingRows.size()) {
+        finishPopulate();
+        return;
+    }
+
+    m_populateTimer->start();
+}
+
+void TaskTree::finishPopulate()
+{
+    m_pendingRows.clear();
+    m_pendingTaskIds.clear();
+    m_pendingIndex = 0;
+    m_pendingAttachPass = false;
+
+    if (m_restoreViewState) {
+        restoreExpandedTaskIds(m_restoreExpandedIds);
+        if (m_restoreSelectedId > 0) {
+            selectTask(m_restoreSelectedId);
+        }
+        if (m_restoreScrollValue >= 0) {
+            m_treeView->doItemsLayout();
+            m_treeView->verticalScrollBar()->setValue(m_restoreScrollValue);
         }
     }
-    
+    m_restoreViewState = false;
+    m_restoreExpandedIds.clear();
+    m_restoreSelectedId = -1;
+    m_restoreScrollValue = -1;
+
     emit taskCountChanged(m_treeModel->rowCount());
 }
 
+void TaskTree::cancelPopulate()
+{
+    m_populateTimer->stop();
+
+    // 尚未挂到模型上的条目不归模型所有，需要手动释放；已挂上的随后随模型一起清空
+    QList<QStandardItem*> detachedItems;
+    for (QStandardItem *item : qAsConst(m_itemsById)) {
+        if (!item->model() && !item->parent()) {
+            detachedItems.append(item);
+        }
+    }
+    qDeleteAll(detachedItems);
+
+    m_pendingRows.clear();
+    m_itemsById.clear();
+    m_pendingTaskIds.clear();
+    m_pendingIndex = 0;
+    m_pendingAttachPass = false;
+}
+
 void TaskTree::loadTasks()
 {
     loadTasks("所有任务", 0, TaskSearchFilters(), 0);
@@ -786,33 +1250,56 @@ void TaskTree::loadTasks(const QString &group, int tagId, const TaskSearchFilter
     m_currentTagId = tagId;
     m_currentFolderId = folderId;
     m_searchFilters = filters;
+    m_restoreViewState = false;
+
+    loadCurrentTasks();
+}
 
-    if (group == "所有任务" && tagId <= 0 && folderId <= 0 && !filters.hasActiveFilters()) {
+void TaskTree::loadCurrentTasks()
+{
+    if (showsHierarchy()) {
         loadAllTasks();
         return;
     }
 
-    loadFilteredTasks(group, tagId, filters, folderId);
+    loadFilteredTasks();
 }
 
-void TaskTree::refreshTasks()
+// 查询结果到达并且分批构建完成之前，模型里还不是当前视图的内容
+bool TaskTree::isLoading() const
 {
-    QSet<int> expandedIds = collectExpandedTaskIds();
-    int selectedId = -1;
-    QModelIndex currentIndex = m_treeView->currentIndex();
-    if (currentIndex.isValid()) {
-        selectedId = currentIndex.data(RoleTaskId).toInt();
-    }
+    return m_populateTimer->isActive() || m_queryJob->isRunning();
+}
 
-    loadTasks(m_currentGroup, m_currentTagId, m_searchFilters, m_currentFolderId);
-    restoreExpandedTaskIds(expandedIds);
+// 未筛选的“所有任务”和不认识的分组显示完整层级，其余视图按条件查询
+bool TaskTree::showsHierarchy() const
+{
+    if (m_currentTagId > 0 || m_currentFolderId > 0) {
+        return false;
+    }
+    if (m_currentGroup == "所有任务") {
+        return !m_searchFilters.hasActiveFilters();
+    }
+    return m_currentGroup != "回收站" && groupCondition(m_currentGroup).isEmpty();
+}
 
-    if (selectedId > 0) {
-        QModelIndex idx = findIndexByTaskId(selectedId);
-        if (idx.isValid()) {
-            m_treeView->setCurrentIndex(idx);
+void TaskTree::refreshTasks()
+{
+    // 上一次构建尚未完成时模型只是部分数据，沿用之前记录的视图状态
+    if (!m_populateTimer->isActive()) {
+        m_restoreExpandedIds = collectExpandedTaskIds();
+        m_restoreSelectedId = -1;
+        QModelIndex currentIndex = m_treeView->currentIndex();
+        if (currentIndex.isValid()) {
+            m_restoreSelectedId = currentIndex.data(RoleTaskId).toInt();
         }
+        m_restoreScrollValue = m_treeView->verticalScrollBar()->value();
     }
+    m_restoreViewState = true;
+    m_lastQueryKey.clear();
+    m_lastQueryTasks.clear();
+
+    loadCurrentTasks();
 }
 
 void TaskTree::expandAll()
@@ -834,6 +1321,41 @@ void TaskTree::clearSelection()
     m_treeView->setCurrentIndex(QModelIndex());
 }
 
+void TaskTree::selectTask(int taskId)
+{
+    if (isLoading()) {
+        m_restoreViewState = true;
+        m_restoreSelectedId = taskId;
+        m_restoreScrollValue = -1;
+        return;
+    }
+
+    QModelIndex idx = findIndexByTaskId(taskId);
+    if (!idx.isValid()) {
+        return;
+    }
+    for (QModelIndex parent = idx.parent(); parent.isValid(); parent = parent.parent()) {
+        m_treeView->expand(parent);
+    }
+    m_treeView->setCurrentIndex(idx);
+    m_treeView->scrollTo(idx);
+}
+
+QList<int> TaskTree::selectedTaskIds() const
+{
+    QList<int> ids;
+    if (!m_treeView || !m_treeView->selectionModel()) {
+        return ids;
+    }
+    for (const QModelIndex &index : m_treeView->selectionModel()->selectedRows()) {
+        const int id = index.data(RoleTaskId).toInt();
+        if (id > 0) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
 Task TaskTree::getTaskFromIndex(const QModelIndex &index) const
 {
     if (!index.isValid()) {
@@ -846,8 +1368,9 @@ Task TaskTree::getTaskFromIndex(const QModelIndex &index) const
     }
     
     int taskId = item->data(RoleTaskId).toInt();
-    if (m_tasksCache.contains(taskId)) {
-        return m_tasksCache[taskId];
+    const int row = m_taskRecords.rowOf(taskId);
+    if (row >= 0) {
+        return m_taskRecords.toTask(row);
     }
     
     return m_controller->getTaskById(taskId);
@@ -909,35 +1432,8 @@ void TaskTree::restoreExpandedTaskIds(const QSet<int> &ids)
 
 QModelIndex TaskTree::findIndexByTaskId(int taskId) const
 {
-    if (!m_treeModel || taskId <= 0) {
-        return QModelIndex();
-    }
-
-    std::function<QModelIndex(QStandardItem*)> findInItem = [&](QStandardItem *item) -> QModelIndex {
-        if (!item) {
-            return QModelIndex();
-        }
-        int id = item->data(RoleTaskId).toInt();
-        if (id == taskId) {
-            return item->index();
-        }
-        for (int i = 0; i < item->rowCount(); ++i) {
-            QModelIndex found = findInItem(item->child(i));
-            if (found.isValid()) {
-                return found;
-            }
-        }
-        return QModelIndex();
-    };
-
-    for (int row = 0; row < m_treeModel->rowCount(); ++row) {
-        QModelIndex found = findInItem(m_treeModel->item(row));
-        if (found.isValid()) {
-            return found;
-        }
-    }
-
-    return QModelIndex();
+    QStandardItem *item = m_itemsById.value(taskId);
+    return item ? item->index() : QModelIndex();
 }
 
 void TaskTree::onItemDoubleClicked(const QModelIndex &index)
@@ -974,7 +1470,12 @@ void TaskTree::onContextMenu(const QPoint &pos)
 {
     QModelIndex index = m_treeView->indexAt(pos);
     if (index.isValid()) {
-        m_treeView->setCurrentIndex(index);
+        // 在已选中的行上右键时保留多选，菜单作用于整个选区
+        if (m_treeView->selectionModel()->isSelected(index)) {
+            m_treeView->selectionModel()->setCurrentIndex(index, QItemSelectionModel::NoUpdate);
+        } else {
+            m_treeView->setCurrentIndex(index);
+        }
         Task task = getTaskFromIndex(index);
         if (task.id() > 0) {
             emit contextMenuRequested(pos, task.id());
@@ -1004,8 +1505,252 @@ void TaskTree::onCollapseItem(const QModelIndex &index)
     Q_UNUSED(index);
 }
 
-void TaskTree::onDropData(const QMimeData *data, const QModelIndex &index)
+void TaskTree::onJournalChanges()
 {
-    Q_UNUSED(data);
-    Q_UNUSED(index);
+    const ChangeJournal::Delta delta = ChangeJournal::instance().pull(this);
+    // 标签、文件夹本身的改动不影响行的内容，删除它们时关联表里的行会一起记入日志
+    QSet<int> taskIds = delta.rowIds("tasks");
+    taskIds.unite(delta.rowIds("task_tags"));
+    taskIds.unite(delta.rowIds("task_folders"));
+
+    // 日志有缺口、数据被整体替换或者树还在查询、分批构建时，只能整体重新加载
+    if (delta.reset || (!taskIds.isEmpty() && isLoading())) {
+        refreshTasks();
+        return;
+    }
+    if (!taskIds.isEmpty()) {
+        applyTaskChanges(taskIds);
+    }
+}
+
+bool TaskTree::queryHierarchyTasks(const QList<int> &onlyIds, QList<Task> *tasks)
+{
+    QSqlQuery query(Database::instance().database());
+    query.prepare(QString("SELECT %1 FROM tasks t WHERE t.is_deleted = 0 AND t.id IN (%2)")
+                      .arg(QString(TaskColumns), placeholders(onlyIds.size())));
+    for (int id : onlyIds) {
+        query.addBindValue(id);
+    }
+    if (!query.exec()) {
+        return false;
+    }
+    while (query.next()) {
+        tasks->append(taskFromRow(query));
+    }
+    return true;
+}
+
+// 层级视图里某个父任务下子任务的先后顺序，走 idx_tasks_parent_sort，只读这一层
+QHash<int, int> TaskTree::querySiblingOrder(int parentId)
+{
+    QHash<int, int> order;
+    QSqlQuery query(Database::instance().database());
+    query.setForwardOnly(true);
+    if (parentId > 0) {
+        query.prepare("SELECT id FROM tasks WHERE parent_id = ? AND is_deleted = 0 ORDER BY sort_key, created_at");
+        query.addBindValue(parentId);
+    } else {
+        query.prepare("SELECT id FROM tasks WHERE (parent_id IS NULL OR parent_id = 0) AND is_deleted = 0 "
+                      "ORDER BY sort_key, created_at");
+    }
+    if (query.exec()) {
+        while (query.next()) {
+            order.insert(query.value(0).toInt(), order.size());
+        }
+    }
+    return order;
+}
+
+// 条件视图的排序由查询决定，只比较两行：把两个 id 交给同一条查询，看谁排在前面
+bool TaskTree::precedesInView(int firstId, int secondId)
+{
+    QList<Task> tasks;
+    bool usedFts = false;
+    if (!queryFilteredTasks({firstId, secondId}, &tasks, &usedFts) || tasks.isEmpty()) {
+        return true;
+    }
+    return tasks.first().id() == firstId;
+}
+
+void TaskTree::updateTaskItem(QStandardItem *item, const Task &task, const QString &sourceInfo, const QString &sourceTooltip)
+{
+    item->setText(task.title());
+    item->setData(task.isCompleted(), RoleCompleted);
+    item->setData(task.hasChildren(), RoleHasChildren);
+    item->setData(sourceInfo.isEmpty() ? QVariant() : QVariant(sourceInfo), RoleSourceInfo);
+    item->setToolTip(sourceTooltip);
+    item->setData(task.isCompleted() ? QVariant(QBrush(QColor("#888888"))) : QVariant(), Qt::ForegroundRole);
+}
+
+// 按变更日志里的任务逐行增删改，其余行和展开、选中、滚动状态保持不动
+void TaskTree::applyTaskChanges(const QSet<int> &taskIds)
+{
+    const bool hierarchy = showsHierarchy();
+    const QList<int> ids = taskIds.values();
+    QList<Task> matches;
+    bool usedFts = false;
+    const bool ok = hierarchy ? queryHierarchyTasks(ids, &matches) : queryFilteredTasks(ids, &matches, &usedFts);
+    if (!ok) {
+        refreshTasks();
+        return;
+    }
+
+    // 关键词缓存的结果已经过期
+    m_lastQueryKey.clear();
+    m_lastQueryTasks.clear();
+    m_lastQueryColumn.clear();
+
+    QHash<int, QStandardItem*> &items = m_itemsById;
+    QHash<int, Task> pending;
+    for (const Task &task : qAsConst(matches)) {
+        pending.insert(task.id(), task);
+    }
+    QSet<int> touchedParents;
+    auto parentItemOf = [this](QStandardItem *item) {
+        return item->parent() ? item->parent() : m_treeModel->invisibleRootItem();
+    };
+    auto removeItem = [&](QStandardItem *item) {
+        std::function<void(QStandardItem*)> forget = [&](QStandardItem *node) {
+            items.remove(node->data(RoleTaskId).toInt());
+            for (int i = 0; i < node->rowCount(); ++i) {
+                forget(node->child(i));
+            }
+        };
+        forget(item);
+        touchedParents.insert(item->parent() ? item->parent()->data(RoleTaskId).toInt() : 0);
+        parentItemOf(item)->removeRow(item->row());
+    };
+
+    for (int id : ids) {
+        QStandardItem *item = items.value(id);
+        if (pending.contains(id) || !item) {
+            continue;
+        }
+        // 条件视图里子任务可能仍满足条件，要改挂到根下并补上来源，这种情况整体重建
+        if (!hierarchy && item->rowCount() > 0) {
+            refreshTasks();
+            return;
+        }
+        removeItem(item);
+    }
+
+    // 同级行已按视图顺序排列，不计它自己二分查找排在它之后的第一行，就是它应在的位置
+    QHash<int, QHash<int, int>> siblingOrders;
+    auto targetRow = [&](QStandardItem *parent, QStandardItem *self, int taskId) {
+        const int skipRow = self && parentItemOf(self) == parent ? self->row() : -1;
+        auto siblingId = [&](int index) {
+            return parent->child(skipRow >= 0 && index >= skipRow ? index + 1 : index)->data(RoleTaskId).toInt();
+        };
+        std::function<bool(int)> precedes;
+        if (hierarchy) {
+            const int parentId = parent == m_treeModel->invisibleRootItem() ? 0 : parent->data(RoleTaskId).toInt();
+            auto it = siblingOrders.find(parentId);
+            if (it == siblingOrders.end()) {
+                it = siblingOrders.insert(parentId, querySiblingOrder(parentId));
+            }
+            const QHash<int, int> &order = it.value();
+            const int rank = order.value(taskId, -1);
+            precedes = [&order, rank](int siblingId) { return order.value(siblingId, -1) <= rank; };
+        } else {
+            precedes = [this, taskId](int siblingId) { return precedesInView(siblingId, taskId); };
+        }
+
+        int low = 0;
+        int high = parent->rowCount() - (skipRow >= 0 ? 1 : 0);
+        while (low < high) {
+            const int middle = (low + high) / 2;
+            if (precedes(siblingId(middle))) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+
+    // 父任务也在这一批里时先放父任务；每轮至少放下一行，否则剩下的父任务不在视图中
+    QMap<int, Task> parentCache;
+    bool progressed = true;
+    while (!pending.isEmpty() && progressed) {
+        progressed = false;
+        for (auto it = pending.begin(); it != pending.end();) {
+            const Task &task = it.value();
+            const int parentId = task.parentId();
+            if (parentId > 0 && !items.contains(parentId) && pending.contains(parentId)) {
+                ++it;
+                continue;
+            }
+
+            QStandardItem *item = items.value(task.id());
+            QStandardItem *parent = parentId > 0 ? items.value(parentId) : nullptr;
+            if (!parent && parentId > 0 && hierarchy) {
+                // 层级视图里父任务不可见时子任务也不显示
+                if (item) {
+                    removeItem(item);
+                }
+                it = pending.erase(it);
+                progressed = true;
+                continue;
+            }
+            if (!parent) {
+                parent = m_treeModel->invisibleRootItem();
+            }
+
+            QString sourceInfo;
+            QString sourceTooltip;
+            if (!hierarchy && parentId > 0 && parent == m_treeModel->invisibleRootItem()) {
+                sourceInfo = buildSourceInfo(parentId, &parentCache, &sourceTooltip);
+            }
+
+            if (!item) {
+                item = createTaskItem(task, sourceInfo, sourceTooltip);
+                parent->insertRow(targetRow(parent, nullptr, task.id()), item);
+                items.insert(task.id(), item);
+            } else {
+                updateTaskItem(item, task, sourceInfo, sourceTooltip);
+                QStandardItem *oldParent = parentItemOf(item);
+                const int row = targetRow(parent, item, task.id());
+                if (oldParent != parent || row != item->row()) {
+                    // takeRow 连同子树一起取下，挂到新位置后子任务保持原样
+                    touchedParents.insert(item->parent() ? item->parent()->data(RoleTaskId).toInt() : 0);
+                    const QList<QStandardItem*> taken = oldParent->takeRow(item->row());
+                    parent->insertRow(row, taken);
+                }
+            }
+            touchedParents.insert(parentId);
+            m_taskRecords.update(task);
+            it = pending.erase(it);
+            progressed = true;
+        }
+    }
+
+    // 子任务增减后父任务的“有子任务”标记跟着变
+    touchedParents.remove(0);
+    if (!touchedParents.isEmpty()) {
+        QSqlQuery query(Database::instance().database());
+        query.prepare("SELECT EXISTS(SELECT 1 FROM tasks WHERE parent_id = ? AND is_deleted = 0)");
+        for (int parentId : qAsConst(touchedParents)) {
+            QStandardItem *item = items.value(parentId);
+            if (!item) {
+                continue;
+            }
+            query.bindValue(0, parentId);
+            if (query.exec() && query.next()) {
+                item->setData(query.value(0).toBool(), RoleHasChildren);
+            }
+        }
+    }
+
+    emit taskCountChanged(m_treeModel->rowCount());
+}
+
+void TaskTree::onTasksDropped(const QList<int> &taskIds, int parentId, int previousId, int nextId)
+{
+    // 其他排序方式下行的位置由排序字段决定，拖放只改变层级
+    const bool ok = m_searchFilters.sort == TaskSearchSort::Manual
+                        ? m_controller->moveTasks(taskIds, parentId, previousId, nextId)
+                        : m_controller->reparentTasks(taskIds, parentId);
+    if (!ok) {
+        QMessageBox::warning(this, "移动失败", "任务未能移动，任务不能放到它自己的子任务下面。");
+    }
 }
@@ -8,10 +8,19 @@
 #include <QMenu>
 #include <QAction>
 #include <QSet>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
 #include <QStyledItemDelegate>
+#include <QMutex>
+#include <atomic>
 #include "../models/task.h"
 #include "../models/task_search_filters.h"
+#include "../models/task_record.h"
 #include "../controllers/task_controller.h"
+#include "../utils/text_search.h"
+
+class BackgroundJob;
 
 class TaskTreeItemDelegate : public QStyledItemDelegate
 {
@@ -31,6 +40,25 @@ private:
     QRect checkboxRect(const QStyleOptionViewItem &option) const;
 };
 
+// 拖放时只把任务 ID 和落点交给 TaskTree 写入数据库，行的位置由随后的刷新决定
+class TaskTreeModel : public QStandardItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit TaskTreeModel(QObject *parent = nullptr);
+
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    Qt::DropActions supportedDropActions() const override;
+    bool canDropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent) override;
+
+signals:
+    // previousId/nextId 为落点前后相邻的任务，不含被拖动的任务；放在某一项上时两者都为 0
+    void tasksDropped(const QList<int> &taskIds, int parentId, int previousId, int nextId);
+};
+
 class TaskTree : public QWidget
 {
     Q_OBJECT
@@ -48,6 +76,8 @@ public:
     void expandAll();
     void collapseAll();
     void clearSelection();
+    void selectTask(int taskId);
+    QList<int> selectedTaskIds() const;
 
 signals:
     void taskSelected(int taskId);
@@ -61,15 +91,54 @@ private slots:
     void onContextMenu(const QPoint &pos);
     void onExpandItem(const QModelIndex &index);
     void onCollapseItem(const QModelIndex &index);
-    void onDropData(const QMimeData *data, const QModelIndex &index);
+    void onTasksDropped(const QList<int> &taskIds, int parentId, int previousId, int nextId);
+    void onJournalChanges();
+    void onFilterQueryFinished();
 
 private:
+    struct PendingTaskRow {
+        Task task;
+        QString sourceInfo;
+        QString sourceTooltip;
+    };
+
+    struct FilterQueryResult {
+        quint64 generation = 0;
+        bool ok = false;
+        bool usedFts = false;
+        QString key;
+        QString text;
+        QString error;
+        QList<Task> tasks;
+    };
+
     void setupUI();
     void setupContextMenu();
     QStandardItem* createTaskItem(const Task &task, const QString &sourceInfo = QString(), const QString &sourceTooltip = QString());
     void loadChildTasks(int parentId, QStandardItem *parentItem);
+    void loadCurrentTasks();
     void loadAllTasks();
-    void loadFilteredTasks(const QString &group, int tagId, const TaskSearchFilters &filters, int folderId);
+    void loadFilteredTasks();
+    QString filterQueryKey() const;
+    void showFilteredTasks(const QList<Task> &tasks, bool queryOk, bool usedFts, const QString &queryKey,
+                           const QString &rawText);
+    void startFilterQuery();
+    void cancelFilterQuery();
+    void interruptFilterQuery();
+    // 按当前视图的条件查询；onlyIds 非空时只查这些任务，供增量更新判断它们是否仍在视图中
+    bool queryFilteredTasks(const QList<int> &onlyIds, QList<Task> *tasks, bool *usedFts);
+    bool queryHierarchyTasks(const QList<int> &onlyIds, QList<Task> *tasks);
+    QHash<int, int> querySiblingOrder(int parentId);
+    bool precedesInView(int firstId, int secondId);
+    bool showsHierarchy() const;
+    bool isLoading() const;
+    QString buildSourceInfo(int parentId, QMap<int, Task> *cache, QString *tooltipOut);
+    void updateTaskItem(QStandardItem *item, const Task &task, const QString &sourceInfo, const QString &sourceTooltip);
+    void applyTaskChanges(const QSet<int> &taskIds);
+    void beginPopulate(const QList<PendingTaskRow> &rows);
+    void populateNextSlice();
+    void finishPopulate();
+    void cancelPopulate();
     Task getTaskFromIndex(const QModelIndex &index) const;
     QSet<int> collectExpandedTaskIds() const;
     void restoreExpandedTaskIds(const QSet<int> &ids);
@@ -77,7 +146,7 @@ private:
 
     TaskController *m_controller;
     QTreeView *m_treeView;
-    QStandardItemModel *m_treeModel;
+    TaskTreeModel *m_treeModel;
     QMenu *m_contextMenu;
     QAction *m_expandAction;
     QAction *m_collapseAction;
@@ -86,11 +155,39 @@ private:
     QAction *m_deleteAction;
     QAction *m_completeAction;
     
-    QMap<int, Task> m_tasksCache;
+    TaskRecordTable m_taskRecords;
     QString m_currentGroup;
     int m_currentTagId;
     int m_currentFolderId;
     TaskSearchFilters m_searchFilters;
+
+    QTimer *m_populateTimer;
+    QList<PendingTaskRow> m_pendingRows;
+    // 视图中全部条目，分批构建时填入，增量更新时随增删维护
+    QHash<int, QStandardItem*> m_itemsById;
+    QSet<int> m_pendingTaskIds;
+    int m_pendingIndex;
+    bool m_pendingAttachPass;
+    bool m_restoreViewState;
+    QSet<int> m_restoreExpandedIds;
+    int m_restoreSelectedId;
+    int m_restoreScrollValue;
+
+    QString m_lastQueryKey;
+    QString m_lastQueryText;
+    bool m_lastQueryUsedFts;
+    QList<Task> m_lastQueryTasks;
+    FoldedTextColumn m_lastQueryColumn;
+
+    // 每次发起或作废条件查询时代数加一，代数不符的结果直接丢弃
+    BackgroundJob *m_queryJob;
+    quint64 m_queryGeneration;
+    bool m_queryRestart;
+    std::atomic<bool> m_queryCancelled;
+    FilterQueryResult m_queryResult;
+    // 工作线程连接的 sqlite3 句柄，供界面线程调用 sqlite3_interrupt
+    QMutex m_queryHandleMutex;
+    void *m_queryHandle;
 };
 
 #endif // TASK_TREE_H
@@ -0,0 +1,143 @@
+#include "../../src/utils/logger.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// 本工具以 TODOLIST_LOG_MIN_LEVEL=1 编译，LOG_DEBUG 在这里与发布版一样被整段移除
+#if TODOLIST_LOG_MIN_LEVEL < 1
+#error "todolist-logbench must be built with DEBUG compiled out"
+#endif
+
+namespace {
+const QString Category = QStringLiteral("Bench");
+
+struct Task {
+    int id;
+    QString title;
+    qint64 dueMs;
+};
+
+// 取多轮中最快的一轮，减少调度抖动的影响
+template <typename Function>
+double bestNsPerCall(int repeats, int iterations, Function function)
+{
+    qint64 best = -1;
+    for (int i = 0; i < repeats; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        function(iterations);
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return double(best) / iterations;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("todolist-logbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the cost of log calls inside a hot loop with DEBUG disabled.");
+    parser.addHelpOption();
+    QCommandLineOption iterationOption(QStringList() << "n" << "iterations", "Loop iterations (default 1000000).",
+                                       "count", "1000000");
+    QCommandLineOption repeatOption(QStringList() << "r" << "repeat", "Runs per measurement (default 5).", "count", "5");
+    parser.addOption(iterationOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value(iterationOption).toInt());
+    const int repeats = qMax(1, parser.value(repeatOption).toInt());
+
+    QTemporaryDir logDirectory;
+    if (!logDirectory.isValid()) {
+        QTextStream(stderr) << "Cannot create a temporary log directory\n";
+        return 1;
+    }
+    Logger &logger = Logger::instance();
+    logger.setLogDirectory(logDirectory.path());
+    logger.setMinLevel(Logger::INFO);
+
+    const Task task{42, QStringLiteral("Prepare quarterly report"), 1717200000000};
+    qint64 sink = 0;
+
+    // 循环本身的开销，其余各项都应与它比较
+    const double emptyNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+        }
+    });
+    // 改动前的写法：先格式化消息，再由 Logger::log 判断级别后丢弃
+    const double eagerNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            logger.log(Logger::DEBUG, Category,
+                       QString("Scheduled task %1 (%2) at %3, pass %4").arg(task.id).arg(task.title).arg(task.dueMs).arg(i));
+        }
+    });
+    const double compiledOutNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            LOG_DEBUG(Category,
+                      QString("Scheduled task %1 (%2) at %3, pass %4").arg(task.id).arg(task.title).arg(task.dueMs).arg(i));
+        }
+    });
+    const double compiledOutFieldsNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            LOG_DEBUG_F(Category, "Scheduled task %1 (%2) at %3, pass %4", task.id, task.title, task.dueMs, i);
+        }
+    });
+
+    // 编译进来但在运行时关闭的级别：只剩一次原子读
+    logger.setMinLevel(Logger::WARNING);
+    const double runtimeOffNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            LOG_INFO(Category,
+                     QString("Scheduled task %1 (%2) at %3, pass %4").arg(task.id).arg(task.title).arg(task.dueMs).arg(i));
+        }
+    });
+
+    // 打开的级别：调用方格式化与交给写线程格式化的入队开销
+    logger.setMinLevel(Logger::INFO);
+    const double enabledNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            LOG_INFO(Category,
+                     QString("Scheduled task %1 (%2) at %3, pass %4").arg(task.id).arg(task.title).arg(task.dueMs).arg(i));
+        }
+    });
+    logger.flush();
+    const double enabledFieldsNs = bestNsPerCall(repeats, iterations, [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sink += i ^ task.id;
+            LOG_INFO_F(Category, "Scheduled task %1 (%2) at %3, pass %4", task.id, task.title, task.dueMs, i);
+        }
+    });
+    logger.flush();
+
+    QTextStream out(stdout);
+    out << "iterations: " << iterations << ", compile-time min level: " << TODOLIST_LOG_MIN_LEVEL << '\n';
+    const auto row = [&out, emptyNs](const QString &name, double nsPerCall) {
+        out << QString("%1 %2 ns/iter %3 ns over empty loop\n")
+                   .arg(name, -34)
+                   .arg(nsPerCall, 9, 'f', 2)
+                   .arg(qMax(0.0, nsPerCall - emptyNs), 9, 'f', 2);
+    };
+    row("empty loop", emptyNs);
+    row("DEBUG, formatted before level check", eagerNs);
+    row("LOG_DEBUG, compiled out", compiledOutNs);
+    row("LOG_DEBUG_F, compiled out", compiledOutFieldsNs);
+    row("LOG_INFO, disabled at runtime", runtimeOffNs);
+    row("LOG_INFO, enabled", enabledNs);
+    row("LOG_INFO_F, enabled", enabledFieldsNs);
+    out << "dropped records: " << logger.droppedCount() << ", checksum: " << sink << '\n';
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "../../src/utils/log_segment.h"
+#include "../../src/utils/logger.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+
+namespace {
+constexpr unsigned long FollowIntervalMs = 200;
+
+struct Filter {
+    int minLevel = Logger::DEBUG;
+    QSet<QString> categories;
+};
+
+QStringList segmentsIn(const QString &directory)
+{
+    QStringList segments;
+    const QFileInfoList files = QDir(directory).entryInfoList(
+        QStringList() << "*" + LogSegmentWriter::FILE_EXTENSION, QDir::Files, QDir::Name);
+    for (const QFileInfo &fileInfo : files) {
+        segments.append(fileInfo.absoluteFilePath());
+    }
+    return segments;
+}
+
+void printRecords(LogSegmentReader &reader, const Filter &filter, QTextStream &out)
+{
+    LogRecord record;
+    while (reader.next(&record)) {
+        if (record.level < filter.minLevel
+            || (!filter.categories.isEmpty() && !filter.categories.contains(record.category))) {
+            continue;
+        }
+
+        out << '[' << QDateTime::fromMSecsSinceEpoch(record.wallClockMs).toString("yyyy-MM-dd HH:mm:ss.zzz")
+            << "] [" << Logger::levelToString(static_cast<Logger::Level>(record.level))
+            << "] [" << record.category
+            << "] [t" << record.threadId
+            << "] " << record.message() << '\n';
+    }
+    out.flush();
+}
+
+// 跟踪最新的段；写入端总是先封存旧段再创建新段，出现更新的段即可切换过去
+int follow(const QString &directory, QString current, const Filter &filter, QTextStream &out)
+{
+    LogSegmentReader reader;
+    bool opened = !current.isEmpty() && reader.open(current, nullptr);
+
+    while (true) {
+        if (opened) {
+            printRecords(reader, filter, out);
+        }
+
+        QString newer;
+        for (const QString &segment : segmentsIn(directory)) {
+            if (segment > current) {
+                newer = segment;
+                break;
+            }
+        }
+
+        if (!newer.isEmpty()) {
+            if (opened) {
+                reader.refresh();
+                printRecords(reader, filter, out);
+            }
+            current = newer;
+            opened = reader.open(current, nullptr);
+            continue;
+        }
+
+        QThread::msleep(FollowIntervalMs);
+        reader.refresh();
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("todolist-logcat");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Decode ToDoList binary log segments (*.tlog).");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Segment files or log directories (default: ./logs).", "[paths...]");
+    QCommandLineOption levelOption(QStringList() << "l" << "level",
+                                   "Show entries at or above <level> (DEBUG, INFO, WARNING, ERROR, CRITICAL).", "level");
+    QCommandLineOption categoryOption(QStringList() << "c" << "category",
+                                      "Show only <category>; may be repeated.", "category");
+    QCommandLineOption followOption(QStringList() << "f" << "follow",
+                                    "Keep reading the newest segment as it grows.");
+    parser.addOption(levelOption);
+    parser.addOption(categoryOption);
+    parser.addOption(followOption);
+    parser.process(app);
+
+    Filter filter;
+    if (parser.isSet(levelOption)) {
+        filter.minLevel = Logger::stringToLevel(parser.value(levelOption));
+    }
+    for (const QString &category : parser.values(categoryOption)) {
+        filter.categories.insert(category);
+    }
+
+    QStringList paths = parser.positionalArguments();
+    if (paths.isEmpty()) {
+        paths.append("logs");
+    }
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    QStringList segments;
+    QString followDirectory;
+    for (const QString &path : paths) {
+        const QFileInfo fileInfo(path);
+        if (fileInfo.isDir()) {
+            segments.append(segmentsIn(fileInfo.absoluteFilePath()));
+            followDirectory = fileInfo.absoluteFilePath();
+        } else {
+            segments.append(fileInfo.absoluteFilePath());
+            followDirectory = fileInfo.absolutePath();
+        }
+    }
+
+    const bool following = parser.isSet(followOption);
+    const QString last = segments.isEmpty() ? QString() : segments.last();
+    int exitCode = 0;
+    for (const QString &segment : segments) {
+        if (following && segment == last) {
+            break;
+        }
+
+        LogSegmentReader reader;
+        QString error;
+        if (!reader.open(segment, &error)) {
+            err << error << '\n';
+            exitCode = 1;
+            continue;
+        }
+        printRecords(reader, filter, out);
+    }
+
+    if (following) {
+        return follow(followDirectory, last, filter, out);
+    }
+    return exitCode;
+}
@@ -0,0 +1,204 @@
+#include "../../src/utils/order_key.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+namespace {
+class Checker
+{
+public:
+    explicit Checker(QTextStream &out)
+        : m_out(out)
+        , m_failures(0)
+    {
+    }
+
+    int failures() const
+    {
+        return m_failures;
+    }
+
+    // 生成的键必须合法，并且严格落在两侧邻居之间
+    bool expectBetween(const QString &name, const QString &before, const QString &after, const QString &key)
+    {
+        if (OrderKey::isValid(key) && (before.isEmpty() || before < key) && (after.isEmpty() || key < after)) {
+            return true;
+        }
+        fail(name, QString("between(\"%1\", \"%2\") returned \"%3\"").arg(before, after, key));
+        return false;
+    }
+
+    void expect(const QString &name, bool condition, const QString &detail)
+    {
+        if (!condition) {
+            fail(name, detail);
+        }
+    }
+
+    void report(const QString &name, int keys, int maxLength)
+    {
+        m_out << QString("%1 %2 keys, longest %3\n").arg(name, -24).arg(keys, 7).arg(maxLength, 4);
+    }
+
+private:
+    void fail(const QString &name, const QString &detail)
+    {
+        // 同一类错误只打印前几条，避免刷屏
+        if (++m_failures <= 20) {
+            m_out << "FAIL " << name << ": " << detail << '\n';
+        }
+    }
+
+    QTextStream &m_out;
+    int m_failures;
+};
+
+int longest(const QStringList &keys)
+{
+    int length = 0;
+    for (const QString &key : keys) {
+        length = qMax(length, key.size());
+    }
+    return length;
+}
+
+// 逐个追加到末尾或插到开头，模拟新建任务和拖到顶部
+void checkEnds(Checker &checker, int count)
+{
+    QStringList appended;
+    QStringList prepended;
+    for (int i = 0; i < count; ++i) {
+        const QString last = appended.isEmpty() ? QString() : appended.last();
+        const QString next = OrderKey::between(last, QString());
+        if (!checker.expectBetween("append", last, QString(), next)) {
+            break;
+        }
+        appended.append(next);
+    }
+    for (int i = 0; i < count; ++i) {
+        const QString first = prepended.isEmpty() ? QString() : prepended.first();
+        const QString previous = OrderKey::between(QString(), first);
+        if (!checker.expectBetween("prepend", QString(), first, previous)) {
+            break;
+        }
+        prepended.prepend(previous);
+    }
+    checker.report("append", appended.size(), longest(appended));
+    checker.report("prepend", prepended.size(), longest(prepended));
+}
+
+// 反复插到同一位置，是键长增长最快的情况
+void checkSameSpot(Checker &checker, int count)
+{
+    QStringList keys{OrderKey::between(QString(), QString())};
+    keys.append(OrderKey::between(keys.first(), QString()));
+    for (int i = 0; i < count; ++i) {
+        const QString key = OrderKey::between(keys.at(0), keys.at(1));
+        if (!checker.expectBetween("same spot", keys.at(0), keys.at(1), key)) {
+            break;
+        }
+        keys.insert(1, key);
+    }
+    checker.report("same spot", keys.size(), longest(keys));
+}
+
+void checkRandom(Checker &checker, int count, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QStringList keys;
+    for (int i = 0; i < count; ++i) {
+        const int position = random.bounded(keys.size() + 1);
+        const QString before = position > 0 ? keys.at(position - 1) : QString();
+        const QString after = position < keys.size() ? keys.at(position) : QString();
+
+        // 多选拖动时一次生成一批键
+        const int batch = random.bounded(4) == 0 ? 1 + random.bounded(8) : 1;
+        const QStringList inserted = OrderKey::between(before, after, batch);
+        if (inserted.size() != batch) {
+            checker.expect("random batch", false, QString("between(\"%1\", \"%2\", %3) returned %4 keys")
+                                                      .arg(before, after).arg(batch).arg(inserted.size()));
+            break;
+        }
+        QString previous = before;
+        for (const QString &key : inserted) {
+            checker.expectBetween("random", previous, after, key);
+            previous = key;
+        }
+        for (int k = 0; k < inserted.size(); ++k) {
+            keys.insert(position + k, inserted.at(k));
+        }
+    }
+    checker.report("random", keys.size(), longest(keys));
+}
+
+// 整数部分取到两端极值时仍要生成合法的键
+void checkBoundaries(Checker &checker)
+{
+    const QString smallest = QStringLiteral("A") + QString(26, QChar('0'));
+    const QString largest = QStringLiteral("z") + QString(26, QChar('z'));
+    checker.expect("boundaries", !OrderKey::isValid(smallest), "the smallest integer must not be a valid key");
+
+    QString key = smallest.left(26) + QChar('1');
+    for (int i = 0; i < 200; ++i) {
+        const QString previous = OrderKey::between(QString(), key);
+        if (!checker.expectBetween("prepend at minimum", QString(), key, previous)) {
+            break;
+        }
+        key = previous;
+    }
+
+    key = largest;
+    for (int i = 0; i < 200; ++i) {
+        const QString next = OrderKey::between(key, QString());
+        if (!checker.expectBetween("append at maximum", key, QString(), next)) {
+            break;
+        }
+        key = next;
+    }
+}
+
+// 参数无效时返回空串，而不是一个位置不对的键
+void checkInvalidArguments(Checker &checker)
+{
+    const QStringList invalid{"a", "a0!", "a00", "b0", QStringLiteral("A") + QString(26, QChar('0'))};
+    for (const QString &key : invalid) {
+        checker.expect("invalid key", !OrderKey::isValid(key), QString("\"%1\" accepted").arg(key));
+        checker.expect("invalid key", OrderKey::between(key, QString()).isEmpty(),
+                       QString("between(\"%1\", \"\") returned a key").arg(key));
+    }
+    checker.expect("invalid order", OrderKey::between("a1", "a0").isEmpty(), "between(\"a1\", \"a0\") returned a key");
+    checker.expect("invalid order", OrderKey::between("a0", "a0").isEmpty(), "between(\"a0\", \"a0\") returned a key");
+    checker.expect("invalid count", OrderKey::between("a0", "a1", 0).isEmpty(), "count 0 returned keys");
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("todolist-orderkeycheck");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Check the ordering, validity and length growth of generated sort keys.");
+    parser.addHelpOption();
+    QCommandLineOption countOption(QStringList() << "n" << "count", "Keys per scenario (default 10000).", "count",
+                                   "10000");
+    QCommandLineOption seedOption(QStringList() << "s" << "seed", "Seed for the random scenario (default 1).", "seed",
+                                  "1");
+    parser.addOption(countOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    const int count = qMax(1, parser.value(countOption).toInt());
+    QTextStream out(stdout);
+    Checker checker(out);
+
+    checkEnds(checker, count);
+    checkSameSpot(checker, qMin(count, 1000));
+    checkRandom(checker, count, parser.value(seedOption).toUInt());
+    checkBoundaries(checker);
+    checkInvalidArguments(checker);
+
+    out << (checker.failures() == 0 ? QString("ok\n") : QString("%1 failures\n").arg(checker.failures()));
+    return checker.failures() == 0 ? 0 : 1;
+}
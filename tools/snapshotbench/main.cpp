@@ -0,0 +1,251 @@
+#include "../../src/controllers/database.h"
+#include "../../src/controllers/binary_snapshot.h"
+#include "../../src/controllers/json_exporter.h"
+#include "../../src/controllers/json_importer.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <functional>
+
+namespace {
+constexpr int TagCount = 50;
+
+// 标题和描述混合英文与中文，接近真实任务的字符分布
+const char *const Words[] = {
+    "Review", "quarterly", "report", "Fix", "login", "bug", "Call", "supplier", "Update", "roadmap",
+    "会议", "整理", "文档", "项目", "预算", "需求", "测试", "发布", "客户", "周报"
+};
+constexpr int WordCount = int(sizeof(Words) / sizeof(Words[0]));
+
+QString sentence(QRandomGenerator &random, int words)
+{
+    QStringList parts;
+    for (int i = 0; i < words; ++i) {
+        parts << QString::fromUtf8(Words[random.bounded(WordCount)]);
+    }
+    return parts.join(' ');
+}
+
+bool exec(QSqlQuery &query, QString *error)
+{
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 每五个任务里有一个子任务，约一半任务带截止日期和一个标签
+bool populate(int taskCount, QString *error)
+{
+    QSqlDatabase &database = Database::instance().database();
+    QRandomGenerator random(20240601);
+    const QDateTime base(QDate(2024, 1, 1), QTime(9, 0));
+
+    QSqlQuery query(database);
+    if (!query.exec("BEGIN")) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    QSqlQuery tagQuery(database);
+    tagQuery.prepare("INSERT INTO tags (name, color) VALUES (?, '#3B82F6')");
+    for (int i = 1; i <= TagCount; ++i) {
+        tagQuery.addBindValue(QString("tag-%1").arg(i));
+        if (!exec(tagQuery, error)) {
+            return false;
+        }
+    }
+
+    QSqlQuery taskQuery(database);
+    taskQuery.prepare("INSERT INTO tasks (id, title, description, priority, due_date, completed, parent_id, "
+                      "created_at, updated_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    QSqlQuery taskTagQuery(database);
+    taskTagQuery.prepare("INSERT INTO task_tags (task_id, tag_id) VALUES (?, ?)");
+    for (int id = 1; id <= taskCount; ++id) {
+        const QDateTime created = base.addSecs(id * 37);
+        taskQuery.addBindValue(id);
+        taskQuery.addBindValue(QString("%1 #%2").arg(sentence(random, 4)).arg(id));
+        taskQuery.addBindValue(sentence(random, 12));
+        taskQuery.addBindValue(random.bounded(4));
+        taskQuery.addBindValue(random.bounded(2) ? created.addDays(7).toString("yyyy-MM-dd HH:mm:ss") : QVariant());
+        taskQuery.addBindValue(random.bounded(3) == 0 ? 1 : 0);
+        taskQuery.addBindValue(id % 5 == 0 ? QVariant(id - 1) : QVariant());
+        taskQuery.addBindValue(created.toString("yyyy-MM-dd HH:mm:ss"));
+        taskQuery.addBindValue(created.toString("yyyy-MM-dd HH:mm:ss"));
+        if (!exec(taskQuery, error)) {
+            return false;
+        }
+        if (random.bounded(2)) {
+            taskTagQuery.addBindValue(id);
+            taskTagQuery.addBindValue(1 + random.bounded(TagCount));
+            if (!exec(taskTagQuery, error)) {
+                return false;
+            }
+        }
+    }
+
+    if (!query.exec("COMMIT")) {
+        *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QString sqliteVersion()
+{
+    QSqlQuery query(Database::instance().database());
+    return query.exec("SELECT sqlite_version()") && query.next() ? query.value(0).toString() : QString("unknown");
+}
+
+int taskCount()
+{
+    QSqlQuery query(Database::instance().database());
+    return query.exec("SELECT COUNT(*) FROM tasks") && query.next() ? query.value(0).toInt() : -1;
+}
+
+// 在本地事件循环里等后台任务结束，返回从启动到结束的耗时，失败时返回 -1
+template <typename Job>
+qint64 runJob(Job &job, const std::function<bool()> &start, QString *error)
+{
+    QEventLoop loop;
+    bool succeeded = false;
+    QObject::connect(&job, &Job::finished, &loop, [&](bool success, const QString &jobError) {
+        succeeded = success;
+        *error = jobError;
+        loop.quit();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!start()) {
+        *error = job.lastError();
+        return -1;
+    }
+    loop.exec();
+    return succeeded ? timer.elapsed() : -1;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("todolist-snapshotbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare JSON and binary snapshot export/import on a synthetic database.");
+    parser.addHelpOption();
+    QCommandLineOption tasksOption(QStringList() << "n" << "tasks", "Number of synthetic tasks (default 1000000).",
+                                   "tasks", "1000000");
+    parser.addOption(tasksOption);
+    parser.process(app);
+
+    const int tasks = qMax(1, parser.value(tasksOption).toInt());
+    QTextStream out(stdout);
+
+    // 数据库、暂存库和日志都放在临时目录里，不碰当前目录下的真实数据
+    QTemporaryDir workDirectory;
+    if (!workDirectory.isValid() || !QDir::setCurrent(workDirectory.path())) {
+        out << "Cannot create a temporary working directory\n";
+        return 1;
+    }
+    if (!Database::instance().open()) {
+        out << "Cannot open database: " << Database::instance().lastError() << '\n';
+        return 1;
+    }
+
+    QString error;
+    QElapsedTimer populateTimer;
+    populateTimer.start();
+    if (!populate(tasks, &error)) {
+        out << "Cannot populate database: " << error << '\n';
+        return 1;
+    }
+    // 结果随 Qt 和 SQLite 版本变化，记录数字时一并附上
+    out << "Qt " << qVersion() << ", SQLite " << sqliteVersion() << '\n';
+    out << "tasks: " << tasks << ", populate: " << populateTimer.elapsed() << " ms\n";
+
+    const QString jsonPath = workDirectory.filePath("bench.json");
+    const QString snapshotPath = workDirectory.filePath("bench" + BinarySnapshot::FILE_EXTENSION);
+    const QString decodedPath = workDirectory.filePath("bench.decoded.db");
+
+    JsonExporter jsonExporter;
+    const qint64 jsonExportMs = runJob(jsonExporter, [&]() {
+        return jsonExporter.start(jsonPath, JsonExporter::Options());
+    }, &error);
+    if (jsonExportMs < 0) {
+        out << "JSON export failed: " << error << '\n';
+        return 1;
+    }
+
+    BinarySnapshot snapshotExporter;
+    const qint64 snapshotExportMs = runJob(snapshotExporter, [&]() {
+        return snapshotExporter.startExport(snapshotPath);
+    }, &error);
+    if (snapshotExportMs < 0) {
+        out << "Snapshot export failed: " << error << '\n';
+        return 1;
+    }
+
+    // 快照导入包括解码到临时库和整体替换两步，与设置对话框中的流程一致
+    BinarySnapshot snapshotImporter;
+    qint64 snapshotImportMs = runJob(snapshotImporter, [&]() {
+        return snapshotImporter.startImport(snapshotPath, decodedPath);
+    }, &error);
+    if (snapshotImportMs >= 0) {
+        QElapsedTimer replaceTimer;
+        replaceTimer.start();
+        if (Database::instance().replaceContentsFrom(decodedPath)) {
+            snapshotImportMs += replaceTimer.elapsed();
+        } else {
+            error = Database::instance().lastError();
+            snapshotImportMs = -1;
+        }
+    }
+    if (snapshotImportMs < 0 || taskCount() != tasks) {
+        out << "Snapshot import failed: " << error << '\n';
+        return 1;
+    }
+
+    JsonImporter::Options importOptions;
+    importOptions.mode = JsonImporter::Options::Overwrite;
+    JsonImporter jsonImporter;
+    const qint64 jsonImportMs = runJob(jsonImporter, [&]() {
+        return jsonImporter.start(jsonPath, importOptions, false);
+    }, &error);
+    if (jsonImportMs < 0 || taskCount() != tasks) {
+        out << "JSON import failed: " << error << '\n';
+        return 1;
+    }
+
+    const auto row = [&out](const QString &name, qint64 jsonValue, qint64 snapshotValue) {
+        out << QString("%1 %2 %3 %4x\n")
+                   .arg(name, -16)
+                   .arg(jsonValue, 14)
+                   .arg(snapshotValue, 14)
+                   .arg(double(jsonValue) / qMax<qint64>(1, snapshotValue), 8, 'f', 1);
+    };
+    out << QString("%1 %2 %3 %4\n").arg("", -16).arg("json", 14).arg("snapshot", 14).arg("speedup", 9);
+    row("export ms", jsonExportMs, snapshotExportMs);
+    row("import ms", jsonImportMs, snapshotImportMs);
+    row("bytes", QFileInfo(jsonPath).size(), QFileInfo(snapshotPath).size());
+    // 吞吐量按整个数据集计算，与设置对话框日志中的 tasks/s 可直接比较
+    const auto tasksPerSecond = [tasks](qint64 ms) {
+        return qRound64(tasks * 1000.0 / qMax<qint64>(1, ms));
+    };
+    out << QString("%1 %2 %3\n").arg("export tasks/s", -16).arg(tasksPerSecond(jsonExportMs), 14)
+               .arg(tasksPerSecond(snapshotExportMs), 14);
+    out << QString("%1 %2 %3\n").arg("import tasks/s", -16).arg(tasksPerSecond(jsonImportMs), 14)
+               .arg(tasksPerSecond(snapshotImportMs), 14);
+    Database::instance().close();
+    return 0;
+}
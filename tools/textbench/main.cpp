@@ -0,0 +1,154 @@
+#include "../../src/utils/text_search.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+// 标题和描述混合英文与中文，接近真实任务的字符分布
+const char *const Words[] = {
+    "Review", "quarterly", "report", "Fix", "login", "bug", "Call", "supplier", "Update", "roadmap",
+    "Prepare", "slides", "Deploy", "build", "Email", "team", "Refactor", "parser", "Plan", "sprint",
+    "会议", "整理", "文档", "项目", "预算", "需求", "测试", "发布", "客户", "周报"
+};
+constexpr int WordCount = int(sizeof(Words) / sizeof(Words[0]));
+
+struct Row {
+    QString title;
+    QString description;
+};
+
+QString sentence(QRandomGenerator &random, int words)
+{
+    QStringList parts;
+    for (int i = 0; i < words; ++i) {
+        parts << QString::fromUtf8(Words[random.bounded(WordCount)]);
+    }
+    return parts.join(' ');
+}
+
+QVector<Row> generateRows(int count)
+{
+    QRandomGenerator random(20240601);
+    QVector<Row> rows;
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        rows.append({QString("%1 #%2").arg(sentence(random, 4)).arg(i), sentence(random, 12)});
+    }
+    return rows;
+}
+
+// 改动前 TaskListWidget::filterTasks 的写法：每行每次都转小写后查找
+int lowerContainsLoop(const QVector<Row> &rows, const QString &needle)
+{
+    const QString lowered = needle.toLower();
+    int matches = 0;
+    for (const Row &row : rows) {
+        if (row.title.toLower().contains(lowered) || row.description.toLower().contains(lowered)) {
+            ++matches;
+        }
+    }
+    return matches;
+}
+
+int caseInsensitiveLoop(const QVector<Row> &rows, const QString &needle)
+{
+    int matches = 0;
+    for (const Row &row : rows) {
+        if (row.title.contains(needle, Qt::CaseInsensitive) || row.description.contains(needle, Qt::CaseInsensitive)) {
+            ++matches;
+        }
+    }
+    return matches;
+}
+
+// 取多轮中最快的一轮，减少调度抖动的影响
+template <typename Function>
+double bestMs(int repeats, int *result, Function function)
+{
+    qint64 best = -1;
+    for (int i = 0; i < repeats; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        *result = function();
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best / 1e6;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("todolist-textbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare the folded-column substring filter with the QString::contains loop.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("needles", "Search strings (default: a built-in mix).", "[needles...]");
+    QCommandLineOption rowsOption(QStringList() << "n" << "rows", "Number of synthetic tasks (default 1000000).", "rows",
+                                  "1000000");
+    QCommandLineOption repeatOption(QStringList() << "r" << "repeat", "Runs per measurement (default 5).", "count", "5");
+    parser.addOption(rowsOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    const int rowCount = qMax(1, parser.value(rowsOption).toInt());
+    const int repeats = qMax(1, parser.value(repeatOption).toInt());
+    QStringList needles = parser.positionalArguments();
+    if (needles.isEmpty()) {
+        needles << "bug" << "ROADMAP" << "quarterly report" << QString::fromUtf8("周报") << "#999999" << "zzz";
+    }
+
+    QTextStream out(stdout);
+    const QVector<Row> rows = generateRows(rowCount);
+
+    QElapsedTimer buildTimer;
+    buildTimer.start();
+    FoldedTextColumn column;
+    column.reserve(rows.size(), 0);
+    for (const Row &row : rows) {
+        column.appendRow(row.title, row.description);
+    }
+    out << "rows: " << rowCount << ", kernel: " << TextSearch::kernelName()
+        << ", column build: " << buildTimer.elapsed() << " ms\n";
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg("needle", -20).arg("matches", 9).arg("column ms", 11).arg("ci loop ms", 11).arg("lower loop ms", 14);
+
+    int exitCode = 0;
+    for (const QString &needle : qAsConst(needles)) {
+        int columnMatches = 0;
+        int caseInsensitiveMatches = 0;
+        int lowerMatches = 0;
+        const double columnMs = bestMs(repeats, &columnMatches, [&]() {
+            return column.matchingRows(needle).size();
+        });
+        const double caseInsensitiveMs = bestMs(repeats, &caseInsensitiveMatches, [&]() {
+            return caseInsensitiveLoop(rows, needle);
+        });
+        const double lowerMs = bestMs(repeats, &lowerMatches, [&]() {
+            return lowerContainsLoop(rows, needle);
+        });
+
+        out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(needle, -20)
+                   .arg(columnMatches, 9)
+                   .arg(columnMs, 11, 'f', 2)
+                   .arg(caseInsensitiveMs, 11, 'f', 2)
+                   .arg(lowerMs, 14, 'f', 2);
+        // 三种写法必须命中相同的行数，否则计时没有可比性
+        if (columnMatches != caseInsensitiveMatches || columnMatches != lowerMatches) {
+            out << "  mismatch: column " << columnMatches << ", ci loop " << caseInsensitiveMatches
+                << ", lower loop " << lowerMatches << '\n';
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}